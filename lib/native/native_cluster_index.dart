@@ -0,0 +1,160 @@
+import 'dart:ffi';
+
+import 'package:ffi/ffi.dart';
+
+import 'native_yolo_engine.dart' show openYoloEngineLibrary;
+
+/// A marker at the queried zoom: one point when [count] is 1, otherwise a
+/// cluster. [point] is the position, in the list given to
+/// [NativeClusterIndex.load], of the lone point or one cluster member.
+class NativeCluster {
+  final double latitude;
+  final double longitude;
+  final int count;
+  final int point;
+  final int expansionZoom;
+
+  const NativeCluster({
+    required this.latitude,
+    required this.longitude,
+    required this.count,
+    required this.point,
+    required this.expansionZoom,
+  });
+
+  bool get isCluster => count > 1;
+}
+
+/// Spatial index with zoom-level clustering in native code
+/// (`cluster_index_api.h`). Points are clustered once per load for every
+/// zoom up to [maxZoom]; queries then return only the clusters and points
+/// inside a viewport. Use one index from one isolate.
+class NativeClusterIndex {
+  NativeClusterIndex._(this._bindings, this._handle);
+
+  final _ClusterBindings _bindings;
+  Pointer<Void> _handle;
+
+  /// Creates an index that merges points closer than [radiusPx] on screen.
+  /// Returns null when the native library is unavailable.
+  static NativeClusterIndex? create({
+    double radiusPx = 48,
+    int tilePx = 256,
+    int maxZoom = 16,
+  }) {
+    final _ClusterBindings bindings;
+    try {
+      bindings = _ClusterBindings(openYoloEngineLibrary());
+    } on Object {
+      return null;
+    }
+    final handle = bindings.create(radiusPx, tilePx, maxZoom);
+    return handle == nullptr ? null : NativeClusterIndex._(bindings, handle);
+  }
+
+  /// Replaces the indexed points; [coordinates] holds latitude/longitude
+  /// pairs.
+  void load(List<(double, double)> coordinates) {
+    final Pointer<Double> buffer = malloc<Double>(coordinates.length * 2 + 1);
+    try {
+      final values = buffer.asTypedList(coordinates.length * 2);
+      for (var i = 0; i < coordinates.length; ++i) {
+        values[2 * i] = coordinates[i].$1;
+        values[2 * i + 1] = coordinates[i].$2;
+      }
+      final status = _bindings.load(_handle, buffer, coordinates.length);
+      if (status != 0) {
+        throw Exception('Native cluster index load failed: status=$status');
+      }
+    } finally {
+      malloc.free(buffer);
+    }
+  }
+
+  /// Clusters and points inside the box at [zoom]. A box across the
+  /// antimeridian may have [west] above [east], or longitudes past 180.
+  List<NativeCluster> query({
+    required double west,
+    required double south,
+    required double east,
+    required double north,
+    required int zoom,
+  }) {
+    final Pointer<Pointer<_YoloCluster>> out = calloc<Pointer<_YoloCluster>>();
+    try {
+      final count = _bindings.query(_handle, west, south, east, north, zoom, out);
+      if (count < 0) {
+        throw Exception('Native cluster index query failed: status=$count');
+      }
+      final clusters = out.value;
+      return List<NativeCluster>.generate(count, (i) {
+        final cluster = (clusters + i).ref;
+        return NativeCluster(
+          latitude: cluster.latitude,
+          longitude: cluster.longitude,
+          count: cluster.count,
+          point: cluster.point,
+          expansionZoom: cluster.expansionZoom,
+        );
+      });
+    } finally {
+      calloc.free(out);
+    }
+  }
+
+  void dispose() {
+    if (_handle == nullptr) {
+      return;
+    }
+    _bindings.destroy(_handle);
+    _handle = nullptr;
+  }
+}
+
+class _ClusterBindings {
+  _ClusterBindings(DynamicLibrary library)
+      : create = library.lookupFunction<_IndexCreateNative, _IndexCreateDart>(
+            'YoloClusterIndexCreate'),
+        destroy = library.lookupFunction<_IndexDestroyNative, _IndexDestroyDart>(
+            'YoloClusterIndexDestroy'),
+        load = library.lookupFunction<_IndexLoadNative, _IndexLoadDart>('YoloClusterIndexLoad'),
+        query =
+            library.lookupFunction<_IndexQueryNative, _IndexQueryDart>('YoloClusterIndexQuery');
+
+  final _IndexCreateDart create;
+  final _IndexDestroyDart destroy;
+  final _IndexLoadDart load;
+  final _IndexQueryDart query;
+}
+
+base class _YoloCluster extends Struct {
+  @Double()
+  external double latitude;
+
+  @Double()
+  external double longitude;
+
+  @Int32()
+  external int count;
+
+  @Int32()
+  external int point;
+
+  @Int32()
+  external int expansionZoom;
+}
+
+typedef _IndexCreateNative = Pointer<Void> Function(Float radiusPx, Int32 tilePx, Int32 maxZoom);
+typedef _IndexCreateDart = Pointer<Void> Function(double radiusPx, int tilePx, int maxZoom);
+
+typedef _IndexDestroyNative = Void Function(Pointer<Void> index);
+typedef _IndexDestroyDart = void Function(Pointer<Void> index);
+
+typedef _IndexLoadNative = Int32 Function(
+    Pointer<Void> index, Pointer<Double> coordinates, Int32 count);
+typedef _IndexLoadDart = int Function(Pointer<Void> index, Pointer<Double> coordinates, int count);
+
+typedef _IndexQueryNative = Int32 Function(Pointer<Void> index, Double west, Double south,
+    Double east, Double north, Int32 zoom, Pointer<Pointer<_YoloCluster>> out);
+typedef _IndexQueryDart = int Function(Pointer<Void> index, double west, double south,
+    double east, double north, int zoom, Pointer<Pointer<_YoloCluster>> out);
@@ -0,0 +1,244 @@
+import 'dart:convert';
+import 'dart:ffi';
+import 'dart:typed_data';
+
+import 'package:ffi/ffi.dart';
+
+import 'native_yolo_engine.dart' show openYoloEngineLibrary;
+
+/// Fields kept uncompressed next to each stored record, so list and map
+/// queries can filter and sort without decoding payloads.
+class NativeStoreRecord {
+  final int createdAtUs;
+  final double? latitude;
+  final double? longitude;
+  final double? accuracyMeters;
+  final int? classIndex;
+
+  const NativeStoreRecord({
+    required this.createdAtUs,
+    this.latitude,
+    this.longitude,
+    this.accuracyMeters,
+    this.classIndex,
+  });
+
+  bool get hasLocation => latitude != null && longitude != null;
+}
+
+/// Append-only record log in native code (`observation_store_api.h`). A put
+/// appends one record, so saving costs the same however much is stored, and
+/// a later put under the same key replaces the earlier record. Reads walk a
+/// memory mapping of the file. Flushing to disk, index checkpoints and
+/// compaction happen on a native background thread.
+///
+/// Calls are synchronous and cheap; use one store from one isolate.
+class NativeObservationStore {
+  NativeObservationStore._(this._bindings, this._handle);
+
+  final _StoreBindings _bindings;
+  Pointer<Void> _handle;
+  Pointer<Uint8> _scratch = nullptr;
+  int _scratchBytes = 0;
+
+  /// Opens or creates the store at [path]. Returns null when the native
+  /// library is unavailable on this platform or the file cannot be opened.
+  static NativeObservationStore? open(String path) {
+    final _StoreBindings bindings;
+    try {
+      bindings = _StoreBindings(openYoloEngineLibrary());
+    } on Object {
+      return null;
+    }
+    final Pointer<Utf8> pathPtr = path.toNativeUtf8();
+    try {
+      final handle = bindings.open(pathPtr);
+      return handle == nullptr ? null : NativeObservationStore._(bindings, handle);
+    } finally {
+      calloc.free(pathPtr);
+    }
+  }
+
+  bool get isOpen => _handle != nullptr;
+
+  void put(String key, NativeStoreRecord record, Uint8List payload) {
+    final keyBytes = utf8.encode(key);
+    final buffer = _reserve(keyBytes.length + payload.length);
+    buffer.asTypedList(keyBytes.length).setAll(0, keyBytes);
+    final Pointer<Uint8> payloadPtr = buffer + keyBytes.length;
+    payloadPtr.asTypedList(payload.length).setAll(0, payload);
+    final Pointer<_YoloStoreRecord> recordPtr = calloc<_YoloStoreRecord>();
+    try {
+      final native = recordPtr.ref;
+      native.createdAtUs = record.createdAtUs;
+      native.latitude = record.latitude ?? 0;
+      native.longitude = record.longitude ?? 0;
+      native.accuracyMeters = record.accuracyMeters ?? double.nan;
+      native.classIndex = record.classIndex ?? 0;
+      native.flags = (record.hasLocation ? _hasLocation : 0) |
+          (record.classIndex != null ? _hasClassIndex : 0);
+      final status =
+          _bindings.put(_handle, buffer, keyBytes.length, recordPtr, payloadPtr, payload.length);
+      if (status != 0) {
+        throw Exception('Native store put failed: status=$status');
+      }
+    } finally {
+      calloc.free(recordPtr);
+    }
+  }
+
+  void erase(String key) {
+    final keyBytes = utf8.encode(key);
+    final buffer = _reserve(keyBytes.length);
+    buffer.asTypedList(keyBytes.length).setAll(0, keyBytes);
+    final status = _bindings.erase(_handle, buffer, keyBytes.length);
+    if (status != 0) {
+      throw Exception('Native store erase failed: status=$status');
+    }
+  }
+
+  void clear() {
+    final status = _bindings.clear(_handle);
+    if (status != 0) {
+      throw Exception('Native store clear failed: status=$status');
+    }
+  }
+
+  /// Decodes the live records, oldest first; with [locatedOnly] the native
+  /// side skips records without a location before any payload is touched.
+  /// The payload handed to [decode] is a view of the mapping and is only
+  /// valid during the call.
+  List<T> read<T>(
+    T Function(NativeStoreRecord record, Uint8List payload) decode, {
+    bool locatedOnly = false,
+  }) {
+    final Pointer<Pointer<_YoloStoreEntry>> entriesPtr = calloc<Pointer<_YoloStoreEntry>>();
+    try {
+      final count = _bindings.acquire(_handle, locatedOnly ? _hasLocation : 0, entriesPtr);
+      if (count < 0) {
+        throw Exception('Native store read failed: status=$count');
+      }
+      final entries = entriesPtr.value;
+      final results = <T>[];
+      for (var i = 0; i < count; ++i) {
+        final entry = (entries + i).ref;
+        final native = entry.record;
+        final located = native.flags & _hasLocation != 0;
+        final record = NativeStoreRecord(
+          createdAtUs: native.createdAtUs,
+          latitude: located ? native.latitude : null,
+          longitude: located ? native.longitude : null,
+          accuracyMeters: native.accuracyMeters.isNaN ? null : native.accuracyMeters,
+          classIndex: native.flags & _hasClassIndex != 0 ? native.classIndex : null,
+        );
+        results.add(decode(record, entry.payload.asTypedList(entry.payloadBytes)));
+      }
+      return results;
+    } finally {
+      calloc.free(entriesPtr);
+    }
+  }
+
+  /// Waits for native background work, writes the index and closes the
+  /// file. The store is unusable afterwards.
+  void close() {
+    if (_handle == nullptr) {
+      return;
+    }
+    _bindings.close(_handle);
+    _handle = nullptr;
+    if (_scratch != nullptr) {
+      malloc.free(_scratch);
+      _scratch = nullptr;
+      _scratchBytes = 0;
+    }
+  }
+
+  /// Native memory for a key and payload, grown as needed and reused.
+  Pointer<Uint8> _reserve(int bytes) {
+    if (bytes > _scratchBytes) {
+      if (_scratch != nullptr) {
+        malloc.free(_scratch);
+      }
+      _scratchBytes = bytes < 4096 ? 4096 : bytes;
+      _scratch = malloc<Uint8>(_scratchBytes);
+    }
+    return _scratch;
+  }
+}
+
+const int _hasLocation = 1;
+const int _hasClassIndex = 2;
+
+class _StoreBindings {
+  _StoreBindings(DynamicLibrary library)
+      : open = library.lookupFunction<_StoreOpenNative, _StoreOpenDart>('YoloStoreOpen'),
+        close = library.lookupFunction<_StoreCloseNative, _StoreCloseDart>('YoloStoreClose'),
+        put = library.lookupFunction<_StorePutNative, _StorePutDart>('YoloStorePut'),
+        erase = library.lookupFunction<_StoreEraseNative, _StoreEraseDart>('YoloStoreErase'),
+        clear = library.lookupFunction<_StoreClearNative, _StoreClearDart>('YoloStoreClear'),
+        acquire = library.lookupFunction<_StoreAcquireNative, _StoreAcquireDart>('YoloStoreAcquire');
+
+  final _StoreOpenDart open;
+  final _StoreCloseDart close;
+  final _StorePutDart put;
+  final _StoreEraseDart erase;
+  final _StoreClearDart clear;
+  final _StoreAcquireDart acquire;
+}
+
+base class _YoloStoreRecord extends Struct {
+  @Int64()
+  external int createdAtUs;
+
+  @Double()
+  external double latitude;
+
+  @Double()
+  external double longitude;
+
+  @Double()
+  external double accuracyMeters;
+
+  @Int32()
+  external int classIndex;
+
+  @Uint32()
+  external int flags;
+}
+
+base class _YoloStoreEntry extends Struct {
+  external _YoloStoreRecord record;
+
+  external Pointer<Uint8> key;
+
+  external Pointer<Uint8> payload;
+
+  @Int32()
+  external int keyBytes;
+
+  @Int32()
+  external int payloadBytes;
+}
+
+typedef _StoreOpenNative = Pointer<Void> Function(Pointer<Utf8> path);
+typedef _StoreOpenDart = Pointer<Void> Function(Pointer<Utf8> path);
+
+typedef _StoreCloseNative = Void Function(Pointer<Void> store);
+typedef _StoreCloseDart = void Function(Pointer<Void> store);
+
+typedef _StorePutNative = Int32 Function(Pointer<Void> store, Pointer<Uint8> key, Int32 keyBytes,
+    Pointer<_YoloStoreRecord> record, Pointer<Uint8> payload, Int32 payloadBytes);
+typedef _StorePutDart = int Function(Pointer<Void> store, Pointer<Uint8> key, int keyBytes,
+    Pointer<_YoloStoreRecord> record, Pointer<Uint8> payload, int payloadBytes);
+
+typedef _StoreEraseNative = Int32 Function(Pointer<Void> store, Pointer<Uint8> key, Int32 keyBytes);
+typedef _StoreEraseDart = int Function(Pointer<Void> store, Pointer<Uint8> key, int keyBytes);
+
+typedef _StoreClearNative = Int32 Function(Pointer<Void> store);
+typedef _StoreClearDart = int Function(Pointer<Void> store);
+
+typedef _StoreAcquireNative = Int32 Function(
+    Pointer<Void> store, Uint32 requiredFlags, Pointer<Pointer<_YoloStoreEntry>> out);
+typedef _StoreAcquireDart = int Function(
+    Pointer<Void> store, int requiredFlags, Pointer<Pointer<_YoloStoreEntry>> out);
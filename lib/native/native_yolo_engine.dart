@@ -3,11 +3,20 @@ import 'dart:ffi';
 import 'dart:io';
 import 'dart:isolate';
 import 'dart:typed_data';
+import 'dart:ui' show Rect;
 
 import 'package:camera/camera.dart';
 import 'package:ffi/ffi.dart';
 import 'package:flutter/foundation.dart';
 
+/// One second-stage classifier candidate for a detection.
+class NativeSpeciesScore {
+  final int classIndex;
+  final double score;
+
+  const NativeSpeciesScore({required this.classIndex, required this.score});
+}
+
 class NativeDetection {
   final double left;
   final double top;
@@ -16,6 +25,10 @@ class NativeDetection {
   final double score;
   final int classIndex;
 
+  /// Crop classifier top-K, best first. Empty without a classifier model or
+  /// when this box was not classified.
+  final List<NativeSpeciesScore> species;
+
   const NativeDetection({
     required this.left,
     required this.top,
@@ -23,9 +36,11 @@ class NativeDetection {
     required this.bottom,
     required this.score,
     required this.classIndex,
+    this.species = const <NativeSpeciesScore>[],
   });
 
   factory NativeDetection.fromMap(Map<dynamic, dynamic> data) {
+    final species = data['species'] as List<dynamic>?;
     return NativeDetection(
       left: (data['left'] as num).toDouble(),
       top: (data['top'] as num).toDouble(),
@@ -33,6 +48,575 @@ class NativeDetection {
       bottom: (data['bottom'] as num).toDouble(),
       score: (data['score'] as num).toDouble(),
       classIndex: data['classIndex'] as int,
+      species: species == null
+          ? const <NativeSpeciesScore>[]
+          : <NativeSpeciesScore>[
+              for (int i = 0; i + 1 < species.length; i += 2)
+                NativeSpeciesScore(
+                  classIndex: species[i] as int,
+                  score: (species[i + 1] as num).toDouble(),
+                ),
+            ],
+    );
+  }
+}
+
+class NativeStageStats {
+  final int count;
+  final double meanUs;
+  final double p50Us;
+  final double p90Us;
+  final double p99Us;
+  final double maxUs;
+
+  const NativeStageStats({
+    required this.count,
+    required this.meanUs,
+    required this.p50Us,
+    required this.p90Us,
+    required this.p99Us,
+    required this.maxUs,
+  });
+
+  factory NativeStageStats.fromMap(Map<dynamic, dynamic> data) {
+    return NativeStageStats(
+      count: data['count'] as int,
+      meanUs: (data['meanUs'] as num).toDouble(),
+      p50Us: (data['p50Us'] as num).toDouble(),
+      p90Us: (data['p90Us'] as num).toDouble(),
+      p99Us: (data['p99Us'] as num).toDouble(),
+      maxUs: (data['maxUs'] as num).toDouble(),
+    );
+  }
+}
+
+class NativeEngineStats {
+  final Map<String, NativeStageStats> stages;
+  final int framesProcessed;
+  final int framesDropped;
+  final int candidatesPreNms;
+  final int candidatesPostNms;
+  final int allocations;
+
+  /// Frames dropped because they were older than [NativeYoloConfig.maxFrameAge]
+  /// when the engine reached them (included in [framesDropped]).
+  final int framesExpired;
+
+  /// Frames answered by moving the previous boxes with optical flow instead
+  /// of running the model (included in [framesProcessed]).
+  final int framesTracked;
+
+  /// Crops run through the second-stage classifier, and detections that
+  /// reused a remembered classification instead.
+  final int cropsClassified;
+  final int classificationCacheHits;
+
+  /// Frames failing the quality gate; with [NativeQualityGate.skip] they are
+  /// also counted in [framesDropped].
+  final int framesLowQuality;
+
+  /// Inferred frames that ran on a region of interest rather than the whole
+  /// frame.
+  final int framesZoomed;
+
+  /// Frames the cadence governor held back from inference, tracked or
+  /// skipped, and its latest state; see [NativeYoloConfig.cadence].
+  final int framesGoverned;
+  final NativeGovernorState governor;
+
+  /// Where the engine's threads run; see [NativeYoloConfig.corePlacement].
+  final NativeThreadPlacement placement;
+
+  const NativeEngineStats({
+    required this.stages,
+    required this.framesProcessed,
+    required this.framesDropped,
+    required this.candidatesPreNms,
+    required this.candidatesPostNms,
+    required this.allocations,
+    required this.framesExpired,
+    required this.framesTracked,
+    required this.cropsClassified,
+    required this.classificationCacheHits,
+    required this.framesLowQuality,
+    required this.framesZoomed,
+    required this.framesGoverned,
+    required this.governor,
+    required this.placement,
+  });
+
+  factory NativeEngineStats.fromMap(Map<dynamic, dynamic> data) {
+    final stages = (data['stages'] as Map<dynamic, dynamic>).map(
+      (dynamic key, dynamic value) => MapEntry(
+        key as String,
+        NativeStageStats.fromMap(value as Map<dynamic, dynamic>),
+      ),
+    );
+    return NativeEngineStats(
+      stages: stages,
+      framesProcessed: data['framesProcessed'] as int,
+      framesDropped: data['framesDropped'] as int,
+      candidatesPreNms: data['candidatesPreNms'] as int,
+      candidatesPostNms: data['candidatesPostNms'] as int,
+      allocations: data['allocations'] as int,
+      framesExpired: data['framesExpired'] as int,
+      framesTracked: data['framesTracked'] as int,
+      cropsClassified: data['cropsClassified'] as int,
+      classificationCacheHits: data['classificationCacheHits'] as int,
+      framesLowQuality: data['framesLowQuality'] as int,
+      framesZoomed: data['framesZoomed'] as int? ?? 0,
+      framesGoverned: data['framesGoverned'] as int? ?? 0,
+      governor: NativeGovernorState.fromMap(data['governor'] as Map<dynamic, dynamic>),
+      placement: NativeThreadPlacement.fromMap(data['placement'] as Map<dynamic, dynamic>),
+    );
+  }
+}
+
+/// Inference budget for the native cadence governor. Caps left null are
+/// off; the tightest of the rest sets how far apart inferences are spaced.
+class NativeCadenceBudget {
+  final double? maxFps;
+
+  /// Share of wall time spent preprocessing, inferring and decoding.
+  final double? maxDutyCycle;
+
+  /// Process CPU time per second of wall time, in milliseconds.
+  final double? maxCpuMsPerSecond;
+
+  /// With nothing detected for [idleAfter], inference drops to [idleFps]
+  /// until something appears.
+  final Duration idleAfter;
+  final double idleFps;
+
+  const NativeCadenceBudget({
+    this.maxFps,
+    this.maxDutyCycle,
+    this.maxCpuMsPerSecond,
+    this.idleAfter = const Duration(seconds: 3),
+    this.idleFps = 2,
+  });
+}
+
+/// `YoloGovernorMode`.
+enum NativeGovernorMode {
+  off,
+  active,
+
+  /// Nothing detected recently; running at [NativeCadenceBudget.idleFps].
+  idle,
+
+  /// Invoke latency drifted above its baseline, taken as thermal
+  /// throttling; inferences are spaced further apart to match.
+  throttled,
+}
+
+/// `YoloGovernorLimit`: which budget sets the current spacing.
+enum NativeGovernorLimit { none, maxFps, dutyCycle, cpuTime, idle, thermal }
+
+class NativeGovernorState {
+  final NativeGovernorMode mode;
+  final NativeGovernorLimit limit;
+
+  /// Spacing enforced between inferences; 0 infers every frame.
+  final double intervalMs;
+
+  /// Smoothed wall-clock cost of one inferred frame.
+  final double inferenceMs;
+
+  /// What inference actually consumed at the recent cadence.
+  final double dutyCycle;
+  final double cpuMsPerSecond;
+
+  /// Recent invoke latency over the best since the model was loaded.
+  final double invokeDrift;
+  final int modeChanges;
+
+  const NativeGovernorState({
+    required this.mode,
+    required this.limit,
+    required this.intervalMs,
+    required this.inferenceMs,
+    required this.dutyCycle,
+    required this.cpuMsPerSecond,
+    required this.invokeDrift,
+    required this.modeChanges,
+  });
+
+  factory NativeGovernorState.fromMap(Map<dynamic, dynamic> data) {
+    return NativeGovernorState(
+      mode: NativeGovernorMode.values[data['mode'] as int],
+      limit: NativeGovernorLimit.values[data['limit'] as int],
+      intervalMs: (data['intervalMs'] as num).toDouble(),
+      inferenceMs: (data['inferenceMs'] as num).toDouble(),
+      dutyCycle: (data['dutyCycle'] as num).toDouble(),
+      cpuMsPerSecond: (data['cpuMsPerSecond'] as num).toDouble(),
+      invokeDrift: (data['invokeDrift'] as num).toDouble(),
+      modeChanges: data['modeChanges'] as int,
+    );
+  }
+}
+
+/// Which CPUs the engine's threads run on (`YoloCorePlacement`).
+enum NativeCorePlacement {
+  off,
+
+  /// The fastest cores, enough for [NativeYoloConfig.threads] where the
+  /// device has them and never its slowest cluster. Symmetric CPUs are left
+  /// alone.
+  auto,
+
+  /// Exactly [NativeYoloConfig.coreMask].
+  mask,
+}
+
+class NativeThreadPlacement {
+  final NativeCorePlacement mode;
+  final int nice;
+
+  /// CPUs the engine's threads are held to as a bit mask; 0 when unpinned.
+  final int cpuMask;
+
+  /// Distinct core capacities found; 1 on a symmetric CPU.
+  final int coreClasses;
+
+  /// Preprocessing workers placed as asked, and whether the frame thread got
+  /// the mask and priority on its last frame.
+  final int workersPinned;
+  final bool frameThreadPinned;
+  final bool priorityApplied;
+
+  const NativeThreadPlacement({
+    required this.mode,
+    required this.nice,
+    required this.cpuMask,
+    required this.coreClasses,
+    required this.workersPinned,
+    required this.frameThreadPinned,
+    required this.priorityApplied,
+  });
+
+  factory NativeThreadPlacement.fromMap(Map<dynamic, dynamic> data) {
+    return NativeThreadPlacement(
+      mode: NativeCorePlacement.values[data['mode'] as int],
+      nice: data['nice'] as int,
+      cpuMask: data['cpuMask'] as int,
+      coreClasses: data['coreClasses'] as int,
+      workersPinned: data['workersPinned'] as int,
+      frameThreadPinned: data['frameThreadPinned'] as bool,
+      priorityApplied: data['priorityApplied'] as bool,
+    );
+  }
+}
+
+/// How the native quality gate treats blurred or badly exposed frames
+/// (`YoloQualityGate`).
+enum NativeQualityGate {
+  off,
+
+  /// Report [NativeFrameQuality] for every frame but infer them all.
+  flag,
+
+  /// Skip inference on frames that fail the check.
+  skip,
+}
+
+/// Why a frame failed the quality gate.
+enum NativeQualityIssue { blurred, tooDark, tooBright }
+
+/// Blur and exposure measurements of one frame, taken on a decimated luma
+/// grid before any preprocessing.
+class NativeFrameQuality {
+  /// Laplacian variance at the detector's input scale; higher is sharper.
+  final double sharpness;
+
+  /// Mean luma, 0-255.
+  final double meanLuma;
+
+  /// Share of samples crushed to black or blown to white.
+  final double darkFraction;
+  final double brightFraction;
+
+  /// The reason the frame failed the gate, or null when it passed.
+  final NativeQualityIssue? issue;
+
+  const NativeFrameQuality({
+    required this.sharpness,
+    required this.meanLuma,
+    required this.darkFraction,
+    required this.brightFraction,
+    this.issue,
+  });
+
+  bool get lowQuality => issue != null;
+
+  factory NativeFrameQuality.fromMap(Map<dynamic, dynamic> data) {
+    final int? issue = data['issue'] as int?;
+    return NativeFrameQuality(
+      sharpness: (data['sharpness'] as num).toDouble(),
+      meanLuma: (data['meanLuma'] as num).toDouble(),
+      darkFraction: (data['darkFraction'] as num).toDouble(),
+      brightFraction: (data['brightFraction'] as num).toDouble(),
+      issue: issue == null ? null : NativeQualityIssue.values[issue],
+    );
+  }
+}
+
+/// Capture-to-result timeline of one frame, in nanoseconds on the engine's
+/// monotonic clock ([NativeYoloEngine.nowNs]).
+class NativeFrameTiming {
+  final int captureTimeNs;
+  final int receiveTimeNs;
+  final int inferenceStartNs;
+  final int decodeEndNs;
+
+  /// When the result reached the UI isolate.
+  final int deliveredNs;
+
+  /// The engine dropped the frame because its deadline had passed.
+  final bool expired;
+
+  /// The boxes were propagated from the last inferred frame by the tracker;
+  /// [inferenceStartNs] is 0 and [decodeEndNs] marks the end of tracking.
+  final bool predicted;
+
+  /// Tracker confidence for this frame, 0 when it did not run.
+  final double trackConfidence;
+
+  /// Blur/exposure measurements; null when the quality gate is off.
+  final NativeFrameQuality? quality;
+
+  /// The quality gate skipped this frame before inference.
+  final bool lowQualitySkipped;
+
+  /// Region the model ran on, normalized to the upright frame; null for
+  /// whole-frame and tracked frames.
+  final Rect? roi;
+
+  const NativeFrameTiming({
+    required this.captureTimeNs,
+    required this.receiveTimeNs,
+    required this.inferenceStartNs,
+    required this.decodeEndNs,
+    required this.deliveredNs,
+    required this.expired,
+    this.predicted = false,
+    this.trackConfidence = 0,
+    this.quality,
+    this.lowQualitySkipped = false,
+    this.roi,
+  });
+
+  factory NativeFrameTiming.fromMap(Map<dynamic, dynamic> data, int deliveredNs) {
+    return NativeFrameTiming(
+      captureTimeNs: data['captureTimeNs'] as int,
+      receiveTimeNs: data['receiveTimeNs'] as int,
+      inferenceStartNs: data['inferenceStartNs'] as int,
+      decodeEndNs: data['decodeEndNs'] as int,
+      deliveredNs: deliveredNs,
+      expired: data['expired'] as bool,
+      predicted: data['predicted'] as bool? ?? false,
+      trackConfidence: (data['trackConfidence'] as num? ?? 0).toDouble(),
+      quality: data['quality'] == null
+          ? null
+          : NativeFrameQuality.fromMap(data['quality'] as Map<dynamic, dynamic>),
+      lowQualitySkipped: data['lowQualitySkipped'] as bool? ?? false,
+      roi: data['roi'] == null ? null : _rectFromList(data['roi'] as List<dynamic>),
+    );
+  }
+
+  /// The model ran on a crop of the frame (see [NativeYoloConfig.autoZoom]).
+  bool get zoomed => roi != null;
+
+  static Rect _rectFromList(List<dynamic> values) {
+    return Rect.fromLTRB(
+      (values[0] as num).toDouble(),
+      (values[1] as num).toDouble(),
+      (values[2] as num).toDouble(),
+      (values[3] as num).toDouble(),
+    );
+  }
+
+  /// Time the frame spent queued before the engine picked it up.
+  Duration get queueLatency => _between(captureTimeNs, receiveTimeNs);
+
+  /// Inference plus decode.
+  Duration get inferenceLatency => _between(inferenceStartNs, decodeEndNs);
+
+  /// Camera callback to boxes available on the UI isolate.
+  Duration get glassToBox => _between(captureTimeNs, deliveredNs);
+
+  static Duration _between(int startNs, int endNs) {
+    if (startNs <= 0 || endNs < startNs) {
+      return Duration.zero;
+    }
+    return Duration(microseconds: (endNs - startNs) ~/ 1000);
+  }
+}
+
+class NativeMemoryStats {
+  final int scratchBytes;
+  final int scratchPeakBytes;
+  final int tensorArenaBytes;
+  final int modelBytes;
+  final int steadyStateBytes;
+  final int peakBytes;
+  final int processResidentBytes;
+
+  /// Between [NativeYoloEngine.suspend] and [NativeYoloEngine.resume].
+  final bool suspended;
+
+  /// The last suspend, and the drop in [processResidentBytes] it caused.
+  final Duration suspendTime;
+  final int suspendReleasedBytes;
+
+  /// The last resume, warm-up invoke included.
+  final Duration resumeTime;
+
+  const NativeMemoryStats({
+    required this.scratchBytes,
+    required this.scratchPeakBytes,
+    required this.tensorArenaBytes,
+    required this.modelBytes,
+    required this.steadyStateBytes,
+    required this.peakBytes,
+    required this.processResidentBytes,
+    this.suspended = false,
+    this.suspendTime = Duration.zero,
+    this.suspendReleasedBytes = 0,
+    this.resumeTime = Duration.zero,
+  });
+
+  factory NativeMemoryStats.fromMap(Map<dynamic, dynamic> data) {
+    return NativeMemoryStats(
+      scratchBytes: data['scratchBytes'] as int,
+      scratchPeakBytes: data['scratchPeakBytes'] as int,
+      tensorArenaBytes: data['tensorArenaBytes'] as int,
+      modelBytes: data['modelBytes'] as int,
+      steadyStateBytes: data['steadyStateBytes'] as int,
+      peakBytes: data['peakBytes'] as int,
+      processResidentBytes: data['processResidentBytes'] as int,
+      suspended: data['suspended'] as bool? ?? false,
+      suspendTime: _millis(data['suspendMs']),
+      suspendReleasedBytes: data['suspendReleasedBytes'] as int? ?? 0,
+      resumeTime: _millis(data['resumeMs']),
+    );
+  }
+
+  static Duration _millis(dynamic value) {
+    return Duration(microseconds: ((value as num? ?? 0) * 1000).round());
+  }
+}
+
+/// Progress of the latest [NativeYoloEngine.swapModel] call.
+class NativeModelSwapInfo {
+  static const List<String> _stateNames = <String>['idle', 'loading', 'ready', 'done', 'failed'];
+
+  final int state;
+  final int swapsCompleted;
+
+  /// Reading the model and building its interpreter, off the frame thread.
+  final double loadMs;
+
+  /// First invoke of the new interpreter, off the frame thread.
+  final double warmupMs;
+
+  /// Time the frame thread spent switching interpreters.
+  final double switchUs;
+
+  /// From the swap request to the first frame served by the new model.
+  final double requestToSwitchMs;
+
+  /// Freeing the old interpreter, off the frame thread.
+  final double releaseMs;
+
+  const NativeModelSwapInfo({
+    required this.state,
+    required this.swapsCompleted,
+    required this.loadMs,
+    required this.warmupMs,
+    required this.switchUs,
+    required this.requestToSwitchMs,
+    required this.releaseMs,
+  });
+
+  String get stateName => state >= 0 && state < _stateNames.length ? _stateNames[state] : 'unknown';
+
+  factory NativeModelSwapInfo.fromMap(Map<dynamic, dynamic> data) {
+    return NativeModelSwapInfo(
+      state: data['state'] as int,
+      swapsCompleted: data['swapsCompleted'] as int,
+      loadMs: (data['loadMs'] as num).toDouble(),
+      warmupMs: (data['warmupMs'] as num).toDouble(),
+      switchUs: (data['switchUs'] as num).toDouble(),
+      requestToSwitchMs: (data['requestToSwitchMs'] as num).toDouble(),
+      releaseMs: (data['releaseMs'] as num).toDouble(),
+    );
+  }
+}
+
+/// Progress of the current or last [NativeYoloEngine.startRecording].
+class NativeRecordingInfo {
+  static const List<String> _stateNames = <String>['idle', 'recording', 'full', 'failed'];
+
+  final int state;
+  final int framesRecorded;
+
+  /// Frames left out because the writer fell behind, the size limit was
+  /// reached or a write failed.
+  final int framesDropped;
+  final int bytesWritten;
+
+  /// Native memory held for frames waiting to be written.
+  final int bufferBytes;
+
+  const NativeRecordingInfo({
+    required this.state,
+    required this.framesRecorded,
+    required this.framesDropped,
+    required this.bytesWritten,
+    required this.bufferBytes,
+  });
+
+  String get stateName => state >= 0 && state < _stateNames.length ? _stateNames[state] : 'unknown';
+
+  factory NativeRecordingInfo.fromMap(Map<dynamic, dynamic> data) {
+    return NativeRecordingInfo(
+      state: data['state'] as int,
+      framesRecorded: data['framesRecorded'] as int,
+      framesDropped: data['framesDropped'] as int,
+      bytesWritten: data['bytesWritten'] as int,
+      bufferBytes: data['bufferBytes'] as int,
+    );
+  }
+}
+
+class NativeTuningInfo {
+  static const List<String> _delegateNames = <String>['cpu', 'xnnpack', 'gpu'];
+
+  final int delegate;
+  final int threads;
+  final double invokeUs;
+  final bool fromCache;
+  final int candidatesTested;
+
+  const NativeTuningInfo({
+    required this.delegate,
+    required this.threads,
+    required this.invokeUs,
+    required this.fromCache,
+    required this.candidatesTested,
+  });
+
+  String get delegateName =>
+      delegate >= 0 && delegate < _delegateNames.length ? _delegateNames[delegate] : 'unknown';
+
+  factory NativeTuningInfo.fromMap(Map<dynamic, dynamic> data) {
+    return NativeTuningInfo(
+      delegate: data['delegate'] as int,
+      threads: data['threads'] as int,
+      invokeUs: (data['invokeUs'] as num).toDouble(),
+      fromCache: data['fromCache'] as bool,
+      candidatesTested: data['candidatesTested'] as int,
     );
   }
 }
@@ -48,6 +632,69 @@ class NativeYoloConfig {
   final bool useGpu;
   final bool allowFp16;
 
+  /// Benchmark delegates and thread counts (up to [threads]) on first launch
+  /// and persist the fastest accurate choice to [tuningCachePath] for later
+  /// launches with the same settings.
+  final bool autoTune;
+  final String? tuningCachePath;
+
+  /// Frames older than this when the engine reaches them are dropped before
+  /// any preprocessing or inference. Null disables the deadline.
+  final Duration? maxFrameAge;
+
+  /// Run the model on every Nth frame and move the last boxes with optical
+  /// flow in between. 1 infers every frame. A frame whose tracking
+  /// confidence is below [minTrackConfidence] is inferred regardless.
+  final int inferenceInterval;
+  final double minTrackConfidence;
+
+  /// Optional species classifier run on crops of detections scoring at least
+  /// [classifierMinScore]. It only runs for new or changed boxes; results
+  /// appear as [NativeDetection.species].
+  final String? classifierModelPath;
+  final int classifierTopK;
+  final double classifierMinScore;
+
+  /// Recent inferred frames with detections kept at full resolution so
+  /// [NativeYoloEngine.captureStill] can pick the sharpest one. Each costs
+  /// one upright RGB frame of native memory; 0 disables the ring.
+  final int frameRingSize;
+
+  /// Blur/exposure pre-check run before preprocessing. A frame fails when
+  /// its sharpness is below [minSharpness] or more than
+  /// [maxClippedFraction] of it is crushed to black or blown to white.
+  final NativeQualityGate qualityGate;
+  final double minSharpness;
+  final double maxClippedFraction;
+
+  /// Once the best detection has held still for a few inferred frames,
+  /// alternate whole-frame passes with passes on a crop centred on it, so
+  /// the subject reaches the model at several times its whole-frame
+  /// resolution for the same inference cost. Frames submitted with their own
+  /// `roi` are left alone.
+  final bool autoZoom;
+
+  /// Deliver results through shared native memory instead of isolate
+  /// messages: read them with [NativeYoloEngine.acquireResults], typically
+  /// once per vsync, and [NativeYoloEngine.detections] stays silent.
+  final bool resultChannel;
+
+  /// Space inferences to fit a battery/thermal budget instead of running
+  /// the model on every frame it can; overrides [inferenceInterval]. Frames
+  /// in between are tracked when there are boxes to move. Null runs
+  /// uncapped.
+  final NativeCadenceBudget? cadence;
+
+  /// Keep the engine's threads (the worker isolate's thread while it is in
+  /// the engine, preprocessing workers and interpreter threads) on the
+  /// performance cores rather than wherever the scheduler puts them, which
+  /// mostly tightens the latency tail. [coreMask] is used with
+  /// [NativeCorePlacement.mask]. A non-zero [threadNice] (-20 to 19, lower
+  /// is more urgent) is applied to the same threads.
+  final NativeCorePlacement corePlacement;
+  final int coreMask;
+  final int threadNice;
+
   const NativeYoloConfig({
     required this.modelPath,
     required this.inputWidth,
@@ -58,6 +705,24 @@ class NativeYoloConfig {
     this.iouThreshold = 0.45,
     this.useGpu = false,
     this.allowFp16 = true,
+    this.autoTune = false,
+    this.tuningCachePath,
+    this.maxFrameAge,
+    this.inferenceInterval = 1,
+    this.minTrackConfidence = 0.5,
+    this.classifierModelPath,
+    this.classifierTopK = 3,
+    this.classifierMinScore = 0.5,
+    this.frameRingSize = 0,
+    this.qualityGate = NativeQualityGate.off,
+    this.minSharpness = 30,
+    this.maxClippedFraction = 0.5,
+    this.autoZoom = false,
+    this.resultChannel = false,
+    this.cadence,
+    this.corePlacement = NativeCorePlacement.off,
+    this.coreMask = 0,
+    this.threadNice = 0,
   });
 
   Map<String, dynamic> toMessage() {
@@ -71,6 +736,128 @@ class NativeYoloConfig {
       'iouThreshold': iouThreshold,
       'useGpu': useGpu,
       'allowFp16': allowFp16,
+      'autoTune': autoTune,
+      'tuningCachePath': tuningCachePath,
+      'inferenceInterval': inferenceInterval,
+      'minTrackConfidence': minTrackConfidence,
+      'classifierModelPath': classifierModelPath,
+      'classifierTopK': classifierTopK,
+      'classifierMinScore': classifierMinScore,
+      'frameRingSize': frameRingSize,
+      'qualityGate': qualityGate.index,
+      'minSharpness': minSharpness,
+      'maxClippedFraction': maxClippedFraction,
+      'autoZoom': autoZoom,
+      'resultChannel': resultChannel,
+      if (cadence != null)
+        'cadence': <String, dynamic>{
+          'maxFps': cadence!.maxFps ?? 0,
+          'maxDutyCycle': cadence!.maxDutyCycle ?? 0,
+          'maxCpuMsPerSecond': cadence!.maxCpuMsPerSecond ?? 0,
+          'idleAfterMs': cadence!.idleAfter.inMilliseconds,
+          'idleFps': cadence!.idleFps,
+        },
+      'corePlacement': corePlacement.index,
+      'coreMask': coreMask,
+      'threadNice': threadNice,
+    };
+  }
+}
+
+/// The newest frame the engine published to its result channel, read in
+/// place from native memory. The contents stay put until the next
+/// [NativeYoloEngine.acquireResults] call, which reuses this object, so read
+/// what you need before calling it again. Disposing the engine frees that
+/// memory and invalidates the frame: every read after it throws a
+/// [StateError].
+class NativeResultFrame {
+  NativeResultFrame._(this._frame);
+
+  Pointer<_YoloResultFrame> _frame;
+
+  /// False once the engine has been disposed.
+  bool get isValid => _frame != nullptr;
+
+  _YoloResultFrame get _ref {
+    if (_frame == nullptr) {
+      throw StateError('Result frame read after the engine was disposed');
+    }
+    return _frame.ref;
+  }
+
+  void _invalidate() {
+    _frame = nullptr;
+  }
+
+  /// Counts published frames from 1; unchanged means nothing new arrived.
+  int get sequence => _ref.sequence;
+  int get count => _ref.count;
+
+  /// The boxes were propagated by the tracker instead of inferred.
+  bool get predicted => _ref.predicted != 0;
+  int get captureTimeNs => _ref.captureTimeNs;
+  int get decodeEndNs => _ref.decodeEndNs;
+
+  NativeDetection detectionAt(int index) {
+    final _YoloResultFrame frame = _ref;
+    final _YoloDetection detection = frame.detections[index];
+    List<NativeSpeciesScore> species = const <NativeSpeciesScore>[];
+    if (frame.hasClassifications != 0) {
+      final _YoloClassification classification = frame.classifications[index];
+      species = <NativeSpeciesScore>[
+        for (int k = 0; k < classification.count; k++)
+          NativeSpeciesScore(
+            classIndex: classification.classIndex[k],
+            score: classification.score[k],
+          ),
+      ];
+    }
+    return NativeDetection(
+      left: detection.left,
+      top: detection.top,
+      right: detection.right,
+      bottom: detection.bottom,
+      score: detection.score,
+      classIndex: detection.classIndex,
+      species: species,
+    );
+  }
+
+  List<NativeDetection> toDetections() {
+    return List<NativeDetection>.generate(count, detectionAt, growable: false);
+  }
+}
+
+/// Decode settings that can change while the stream runs; see
+/// [NativeYoloEngine.updateDecodeConfig].
+class NativeDecodeConfig {
+  final double confidenceThreshold;
+  final double iouThreshold;
+  final int maxDetections;
+
+  /// Thresholds for particular classes; the rest use [confidenceThreshold].
+  final Map<int, double> classThresholds;
+
+  /// When set, only these classes are decoded. The others are skipped during
+  /// the native class-score reduction, so they never cross the isolate
+  /// boundary and cannot hide an enabled class on the same box.
+  final Set<int>? enabledClasses;
+
+  const NativeDecodeConfig({
+    required this.confidenceThreshold,
+    this.iouThreshold = 0.45,
+    this.maxDetections = 100,
+    this.classThresholds = const <int, double>{},
+    this.enabledClasses,
+  });
+
+  Map<String, dynamic> toMessage() {
+    return <String, dynamic>{
+      'confidenceThreshold': confidenceThreshold,
+      'iouThreshold': iouThreshold,
+      'maxDetections': maxDetections,
+      'classThresholds': classThresholds,
+      'enabledClasses': enabledClasses?.toList(growable: false),
     };
   }
 }
@@ -80,27 +867,51 @@ class NativeYoloEngine {
     required SendPort workerSendPort,
     required StreamSubscription<dynamic> subscription,
     required Isolate isolate,
+    Duration? maxFrameAge,
   })  : _workerSendPort = workerSendPort,
         _subscription = subscription,
-        _isolate = isolate;
+        _isolate = isolate,
+        _maxFrameAgeNs = maxFrameAge == null ? null : maxFrameAge.inMicroseconds * 1000;
 
   final SendPort _workerSendPort;
   final StreamSubscription<dynamic> _subscription;
   final Isolate _isolate;
+  final int? _maxFrameAgeNs;
 
   final StreamController<List<NativeDetection>> _detectionsController = StreamController.broadcast();
   final StreamController<String> _errorsController = StreamController.broadcast();
+  final StreamController<NativeFrameTiming> _timingsController = StreamController.broadcast();
+  final StreamController<NativeFrameQuality> _qualityController = StreamController.broadcast();
   final Completer<void> _readyCompleter = Completer<void>();
   final Completer<void> _disposedCompleter = Completer<void>();
 
-  static const double _minDisplayConfidence = 0.45;
+  final Map<int, Completer<dynamic>> _pendingRequests = <int, Completer<dynamic>>{};
+  int _nextRequestId = 0;
 
   bool _disposed = false;
+  bool _suspended = false;
+  Pointer<Void> _resultsHandle = nullptr;
+  NativeResultFrame? _resultFrame;
   bool _frameInFlight = false;
+  _FramePacket? _inFlightFrame;
   _FramePacket? _pendingFrame;
+  final _PixelBufferPool _pixelBuffers = _PixelBufferPool();
 
+  /// Detections of every processed frame, unless the engine was created
+  /// with [NativeYoloConfig.resultChannel].
   Stream<List<NativeDetection>> get detections => _detectionsController.stream;
   Stream<String> get errors => _errorsController.stream;
+
+  /// Per-frame capture-to-result timings, including frames the engine
+  /// dropped for missing their deadline.
+  Stream<NativeFrameTiming> get timings => _timingsController.stream;
+
+  /// Blur/exposure measurements of every frame the quality gate checked,
+  /// including those it skipped; delivered before that frame's detections.
+  Stream<NativeFrameQuality> get frameQuality => _qualityController.stream;
+
+  /// Current time on the clock the engine uses for frame timestamps.
+  static int nowNs() => _engineNowNs();
   Future<void> get ready => _readyCompleter.future;
 
   static Future<NativeYoloEngine> create(NativeYoloConfig config) async {
@@ -133,16 +944,28 @@ class NativeYoloEngine {
       workerSendPort: workerSendPort,
       subscription: subscription,
       isolate: isolate,
+      maxFrameAge: config.maxFrameAge,
     );
 
     await engine.ready;
     return engine;
   }
 
-  void submitCameraImage(CameraImage image, {required int rotationDegrees}) {
-    if (_disposed) return;
+  /// Queues [image] for inference. [roi], normalized to the upright frame,
+  /// restricts the model to that region at its full input resolution; boxes
+  /// still come back in whole-frame coordinates.
+  void submitCameraImage(CameraImage image, {required int rotationDegrees, Rect? roi}) {
+    if (_disposed || _suspended) return;
     try {
-      final packet = _FramePacket.fromCameraImage(image, rotationDegrees);
+      final int captureTimeNs = _engineNowNs();
+      final packet = _FramePacket.fromCameraImage(
+        image,
+        rotationDegrees,
+        captureTimeNs: captureTimeNs,
+        deadlineNs: _maxFrameAgeNs == null ? 0 : captureTimeNs + _maxFrameAgeNs,
+        roi: roi,
+        pixelBuffers: _pixelBuffers,
+      );
       _pendingFrame?.dispose();
       _pendingFrame = packet;
       _pushPendingFrame();
@@ -151,14 +974,223 @@ class NativeYoloEngine {
     }
   }
 
+  /// Newest published frame, read straight from native memory with no
+  /// message passing or copying, so it can be polled every vsync however
+  /// fast inference runs. Null unless [NativeYoloConfig.resultChannel] is
+  /// set, and until the first frame has been published. Call from one
+  /// isolate only.
+  NativeResultFrame? acquireResults() {
+    if (_disposed || _resultsHandle == nullptr) {
+      return null;
+    }
+    final Pointer<_YoloResultFrame> frame = _acquireResults(_resultsHandle);
+    if (frame == nullptr || frame.ref.sequence == 0) {
+      return null;
+    }
+    final NativeResultFrame? current = _resultFrame;
+    if (current == null) {
+      return _resultFrame = NativeResultFrame._(frame);
+    }
+    current._frame = frame;
+    return current;
+  }
+
+  /// Snapshot of the native per-stage latency histograms and counters.
+  /// When [reset] is true the native counters are cleared after reading.
+  Future<NativeEngineStats> fetchStats({bool reset = false}) async {
+    final result = await _request('stats', <String, dynamic>{'reset': reset});
+    return NativeEngineStats.fromMap(result as Map<dynamic, dynamic>);
+  }
+
+  /// Native memory held by the engine (scratch arena, tensor arena, model).
+  Future<NativeMemoryStats> fetchMemoryStats() async {
+    final result = await _request('memoryStats', const <String, dynamic>{});
+    return NativeMemoryStats.fromMap(result as Map<dynamic, dynamic>);
+  }
+
+  /// Delegate and thread count the engine settled on, including whether the
+  /// auto-tuner reused a cached decision.
+  Future<NativeTuningInfo> fetchTuningInfo() async {
+    final result = await _request('tuningInfo', const <String, dynamic>{});
+    return NativeTuningInfo.fromMap(result as Map<dynamic, dynamic>);
+  }
+
+  /// Loads [modelPath] in the background while the current model keeps
+  /// serving frames, then switches over between two frames. The new model
+  /// must take the same input size. Returns false if a previous swap is still
+  /// pending; follow progress with [fetchModelSwapInfo].
+  Future<bool> swapModel(String modelPath) async {
+    final result = await _request('swapModel', <String, dynamic>{'modelPath': modelPath});
+    return result as bool;
+  }
+
+  /// Replaces the thresholds and class filter from the next frame on, without
+  /// recreating the engine. The native side swaps the settings in lock-free
+  /// at a frame boundary.
+  Future<void> updateDecodeConfig(NativeDecodeConfig config) async {
+    await _request('updateDecodeConfig', config.toMessage());
+  }
+
+  /// Frees the interpreter's tensor arena and every per-stream buffer while
+  /// keeping the model, delegate and tuning decision, so [resume] is far
+  /// cheaper than recreating the engine. Frames submitted in between are
+  /// dropped. Returns false while a model swap is loading.
+  Future<bool> suspend() async {
+    _suspended = true;
+    _pendingFrame?.dispose();
+    _pendingFrame = null;
+    final result = await _request('suspend', const <String, dynamic>{});
+    if (result != true) {
+      _suspended = false;
+    }
+    return result as bool;
+  }
+
+  /// Rebuilds what [suspend] freed. Returns false if the interpreter could
+  /// not be rebuilt; the engine then stays suspended.
+  Future<bool> resume() async {
+    final result = await _request('resume', const <String, dynamic>{});
+    if (result == true) {
+      _suspended = false;
+    }
+    return result as bool;
+  }
+
+  Future<NativeModelSwapInfo> fetchModelSwapInfo() async {
+    final result = await _request('modelSwapInfo', const <String, dynamic>{});
+    return NativeModelSwapInfo.fromMap(result as Map<dynamic, dynamic>);
+  }
+
+  /// Saves a still of [box] (detector input coordinates; [Rect.zero] for
+  /// the whole frame) from the next processed frame as PNG at [cropPath],
+  /// with an optional thumbnail. The stream keeps running: the engine copies
+  /// the crop's full-resolution pixels and encodes on a native writer thread.
+  /// Completes with false if the capture failed or did not finish within
+  /// [timeout]; an unfinished capture is then cancelled and leaves no files.
+  ///
+  /// With [bestWithin] and a frame ring configured, the still instead comes
+  /// from the sharpest buffered frame of that period whose detection of
+  /// class [classIndex] (any class when negative) overlaps [box].
+  Future<bool> captureStill({
+    required Rect box,
+    required String cropPath,
+    String? thumbnailPath,
+    int classIndex = -1,
+    Duration? bestWithin,
+    double margin = 0.1,
+    int cropMaxSide = 1600,
+    int thumbnailMaxSide = 360,
+    Duration timeout = const Duration(seconds: 3),
+  }) async {
+    final id = await _request('requestCapture', <String, dynamic>{
+      'left': box.left,
+      'top': box.top,
+      'right': box.right,
+      'bottom': box.bottom,
+      'classIndex': classIndex,
+      'windowMs': bestWithin?.inMilliseconds,
+      'margin': margin,
+      'cropMaxSide': cropMaxSide,
+      'thumbnailMaxSide': thumbnailMaxSide,
+      'cropPath': cropPath,
+      'thumbnailPath': thumbnailPath,
+    }) as int;
+    if (id <= 0) {
+      return false;
+    }
+    final deadline = DateTime.now().add(timeout);
+    while (DateTime.now().isBefore(deadline)) {
+      await Future<void>.delayed(const Duration(milliseconds: 20));
+      final status = await _request('captureStatus', <String, dynamic>{'id': id}) as int;
+      if (status != _capturePending) {
+        return status == _captureDone;
+      }
+    }
+    // Stops the native side writing files nobody will pick up; a capture
+    // that finished in the meantime still counts.
+    final status = await _request('cancelCapture', <String, dynamic>{'id': id}) as int;
+    return status == _captureDone;
+  }
+
+  /// Starts recording per-stage pipeline spans into a preallocated native
+  /// buffer holding up to [maxEvents] spans.
+  Future<void> startTrace({int maxEvents = 65536}) async {
+    await _request('startTrace', <String, dynamic>{'maxEvents': maxEvents});
+  }
+
+  Future<void> stopTrace() async {
+    await _request('stopTrace', const <String, dynamic>{});
+  }
+
+  /// Writes the recorded spans to [path] as Chrome/Perfetto trace-event JSON
+  /// and returns the number of spans written.
+  Future<int> dumpTrace(String path) async {
+    final result = await _request('dumpTrace', <String, dynamic>{'path': path});
+    return result as int;
+  }
+
+  /// Records every submitted frame and the detections it was answered with
+  /// to [path], for replaying the session off the device with the native
+  /// `yolo_replay` tool. Frames are written on a background thread and left
+  /// out rather than delaying the stream; the recording ends once the file
+  /// would pass [maxBytes] (0 for no limit). Returns false when the file
+  /// cannot be created.
+  Future<bool> startRecording(String path, {int maxBytes = 0}) async {
+    final result = await _request('startRecording', <String, dynamic>{
+      'path': path,
+      'maxBytes': maxBytes,
+    });
+    return result as bool;
+  }
+
+  /// Writes out queued frames, closes the recording and reports on it.
+  Future<NativeRecordingInfo> stopRecording() async {
+    await _request('stopRecording', const <String, dynamic>{});
+    return fetchRecordingInfo();
+  }
+
+  Future<NativeRecordingInfo> fetchRecordingInfo() async {
+    final result = await _request('recordingInfo', const <String, dynamic>{});
+    return NativeRecordingInfo.fromMap(result as Map<dynamic, dynamic>);
+  }
+
+  Future<dynamic> _request(String type, Map<String, dynamic> arguments) {
+    if (_disposed) {
+      return Future<dynamic>.error(StateError('Engine disposed'));
+    }
+    final id = _nextRequestId++;
+    final completer = Completer<dynamic>();
+    _pendingRequests[id] = completer;
+    _workerSendPort.send(<String, dynamic>{
+      'type': 'request',
+      'id': id,
+      'request': type,
+      'arguments': arguments,
+    });
+    return completer.future;
+  }
+
   Future<void> dispose() async {
     if (_disposed) return;
     _disposed = true;
+    // The frame points into the engine, which the worker is about to free.
+    _resultFrame?._invalidate();
+    _resultFrame = null;
+    for (final request in _pendingRequests.values) {
+      request.completeError(StateError('Engine disposed'));
+    }
+    _pendingRequests.clear();
     _pendingFrame?.dispose();
     _pendingFrame = null;
     try {
       _workerSendPort.send({'type': 'dispose'});
       await _disposedCompleter.future.timeout(const Duration(seconds: 2));
+      // The worker handles messages in order, so the frame in flight is done
+      // with its pixels. After a timeout the engine may still read them and
+      // they are left allocated.
+      _inFlightFrame?.dispose();
+      _inFlightFrame = null;
+      _pixelBuffers.dispose();
     } catch (_) {
       // Ignore and force-stop isolate.
     }
@@ -166,6 +1198,8 @@ class NativeYoloEngine {
     _isolate.kill(priority: Isolate.immediate);
     await _detectionsController.close();
     await _errorsController.close();
+    await _timingsController.close();
+    await _qualityController.close();
   }
 
   void _pushPendingFrame() {
@@ -175,18 +1209,42 @@ class NativeYoloEngine {
     final packet = _pendingFrame!;
     _pendingFrame = null;
     _frameInFlight = true;
+    _inFlightFrame = packet;
     _workerSendPort.send({
       'type': 'frame',
       'frame': packet.serialize(),
     });
   }
 
-  void _handleWorkerMessage(dynamic message) {
-    if (_disposed) return;
-    if (message is! Map) return;
-    final type = message['type'] as String?;
-    switch (type) {
+  void _addTiming(dynamic timing) {
+    if (timing is Map) {
+      final frameTiming = NativeFrameTiming.fromMap(timing, _engineNowNs());
+      final NativeFrameQuality? quality = frameTiming.quality;
+      if (quality != null) {
+        _qualityController.add(quality);
+      }
+      _timingsController.add(frameTiming);
+    }
+  }
+
+  /// The worker is done with the frame in flight, and with its pixels.
+  void _finishFrame() {
+    _frameInFlight = false;
+    _inFlightFrame?.dispose();
+    _inFlightFrame = null;
+  }
+
+  void _handleWorkerMessage(dynamic message) {
+    if (message is! Map) return;
+    final type = message['type'] as String?;
+    // Only the worker's acknowledgement matters once disposal has begun.
+    if (_disposed && type != 'disposed') return;
+    switch (type) {
       case 'ready':
+        final int? resultsHandle = message['resultsHandle'] as int?;
+        if (resultsHandle != null) {
+          _resultsHandle = Pointer<Void>.fromAddress(resultsHandle);
+        }
         if (!_readyCompleter.isCompleted) {
           _readyCompleter.complete();
         }
@@ -195,17 +1253,42 @@ class NativeYoloEngine {
         final items = (message['items'] as List<dynamic>)
             .map((dynamic e) => NativeDetection.fromMap(e as Map<dynamic, dynamic>))
             .toList(growable: false);
-        final filtered = items
-            .where((d) => d.score >= _minDisplayConfidence)
-            .toList(growable: false); // Gate detections so only >= 0.45 reach UI.
-        _detectionsController.add(filtered);
-        _frameInFlight = false;
+        // Timing first, so listeners already know a frame's quality flag when
+        // its detections arrive.
+        _addTiming(message['timing']);
+        _detectionsController.add(items);
+        _finishFrame();
+        _pushPendingFrame();
+        break;
+      case 'published':
+      case 'expired':
+      case 'lowQuality':
+        _addTiming(message['timing']);
+        _finishFrame();
+        _pushPendingFrame();
+        break;
+      case 'governed':
+        _finishFrame();
         _pushPendingFrame();
         break;
+      case 'suspended':
+        _finishFrame();
+        break;
+      case 'reply':
+        final completer = _pendingRequests.remove(message['id'] as int);
+        if (completer != null) {
+          final error = message['error'] as String?;
+          if (error != null) {
+            completer.completeError(Exception(error));
+          } else {
+            completer.complete(message['result']);
+          }
+        }
+        break;
       case 'error':
         final error = (message['message'] ?? 'Native engine error') as String;
         _errorsController.add(error);
-        _frameInFlight = false;
+        _finishFrame();
         _pushPendingFrame();
         if (!(message['recoverable'] as bool? ?? true) && !_readyCompleter.isCompleted) {
           _readyCompleter.completeError(Exception(error));
@@ -222,8 +1305,18 @@ class NativeYoloEngine {
   }
 }
 
+/// Pixel formats understood by `YoloEngineProcessFrame` (`YoloPixelFormat`).
+abstract final class _PixelFormat {
+  static const int yuv420 = 0;
+  static const int rgb = 1;
+  static const int rgba = 2;
+  static const int bgra = 3;
+  static const int bgr = 4;
+}
+
 class _FramePacket {
   _FramePacket({
+    required this.format,
     required this.width,
     required this.height,
     required this.rotationDegrees,
@@ -233,8 +1326,14 @@ class _FramePacket {
     required this.yData,
     required this.uData,
     required this.vData,
+    required this.captureTimeNs,
+    required this.deadlineNs,
+    this.roi,
+    this.pixels,
+    this.pixelBuffers,
   });
 
+  final int format;
   final int width;
   final int height;
   final int rotationDegrees;
@@ -244,16 +1343,59 @@ class _FramePacket {
   final TransferableTypedData yData;
   final TransferableTypedData uData;
   final TransferableTypedData vData;
+  final int captureTimeNs;
+  final int deadlineNs;
+  final Rect? roi;
+
+  /// Native copy of a packed frame, rows padded as the camera delivered
+  /// them; returned to [pixelBuffers] by [dispose].
+  _PixelBuffer? pixels;
+  final _PixelBufferPool? pixelBuffers;
 
-  factory _FramePacket.fromCameraImage(CameraImage image, int rotationDegrees) {
+  factory _FramePacket.fromCameraImage(
+    CameraImage image,
+    int rotationDegrees, {
+    required int captureTimeNs,
+    required int deadlineNs,
+    required _PixelBufferPool pixelBuffers,
+    Rect? roi,
+  }) {
+    // iOS streams single-plane BGRA8888. Its one copy goes straight into
+    // native memory, and the engine reads that in place with the plane's
+    // row stride, so the worker passes the address on without copying.
+    if (image.format.group == ImageFormatGroup.bgra8888 && image.planes.length == 1) {
+      final Plane plane = image.planes[0];
+      final _PixelBuffer pixels = pixelBuffers.acquire(plane.bytes.length);
+      pixels.pointer.asTypedList(plane.bytes.length).setAll(0, plane.bytes);
+      return _FramePacket(
+        format: _PixelFormat.bgra,
+        width: image.width,
+        height: image.height,
+        rotationDegrees: rotationDegrees,
+        yRowStride: plane.bytesPerRow,
+        uvRowStride: 0,
+        uvPixelStride: 0,
+        yData: TransferableTypedData.fromList(const []),
+        uData: TransferableTypedData.fromList(const []),
+        vData: TransferableTypedData.fromList(const []),
+        captureTimeNs: captureTimeNs,
+        deadlineNs: deadlineNs,
+        roi: roi,
+        pixels: pixels,
+        pixelBuffers: pixelBuffers,
+      );
+    }
     if (image.planes.length < 3) {
-      throw ArgumentError('Expected YUV420 image with 3 planes');
+      throw ArgumentError(
+        'Unsupported camera image: ${image.format.group} with ${image.planes.length} planes',
+      );
     }
     final Plane yPlane = image.planes[0];
     final Plane uPlane = image.planes[1];
     final Plane vPlane = image.planes[2];
 
     return _FramePacket(
+      format: _PixelFormat.yuv420,
       width: image.width,
       height: image.height,
       rotationDegrees: rotationDegrees,
@@ -263,11 +1405,15 @@ class _FramePacket {
       yData: TransferableTypedData.fromList([yPlane.bytes]),
       uData: TransferableTypedData.fromList([uPlane.bytes]),
       vData: TransferableTypedData.fromList([vPlane.bytes]),
+      captureTimeNs: captureTimeNs,
+      deadlineNs: deadlineNs,
+      roi: roi,
     );
   }
 
   Map<String, dynamic> serialize() {
     return <String, dynamic>{
+      'format': format,
       'width': width,
       'height': height,
       'rotation': rotationDegrees,
@@ -277,10 +1423,55 @@ class _FramePacket {
       'yData': yData,
       'uData': uData,
       'vData': vData,
+      'captureTimeNs': captureTimeNs,
+      'deadlineNs': deadlineNs,
+      if (roi != null) 'roi': <double>[roi!.left, roi!.top, roi!.right, roi!.bottom],
+      if (pixels != null) 'pixels': pixels!.pointer.address,
     };
   }
 
-  void dispose() {}
+  void dispose() {
+    final _PixelBuffer? buffer = pixels;
+    if (buffer != null) {
+      pixels = null;
+      pixelBuffers?.release(buffer);
+    }
+  }
+}
+
+class _PixelBuffer {
+  _PixelBuffer(this.pointer, this.capacity);
+
+  final Pointer<Uint8> pointer;
+  final int capacity;
+}
+
+/// Native buffers for packed frames, reused across frames. One frame is in
+/// flight and one waits, so the pool rarely holds more than two. Owned by
+/// the UI isolate; the worker only reads a buffer while its frame is in
+/// flight.
+class _PixelBufferPool {
+  final List<_PixelBuffer> _free = <_PixelBuffer>[];
+
+  _PixelBuffer acquire(int length) {
+    for (int i = 0; i < _free.length; i++) {
+      if (_free[i].capacity >= length) {
+        return _free.removeAt(i);
+      }
+    }
+    return _PixelBuffer(malloc<Uint8>(length), length);
+  }
+
+  void release(_PixelBuffer buffer) {
+    _free.add(buffer);
+  }
+
+  void dispose() {
+    for (final _PixelBuffer buffer in _free) {
+      malloc.free(buffer.pointer);
+    }
+    _free.clear();
+  }
 }
 
 void _nativeYoloIsolateEntry(Map<String, dynamic> message) async {
@@ -292,7 +1483,7 @@ void _nativeYoloIsolateEntry(Map<String, dynamic> message) async {
   final worker = _NativeYoloWorker(config);
   try {
     await worker.initialize();
-    mainPort.send({'type': 'ready'});
+    mainPort.send({'type': 'ready', 'resultsHandle': worker.resultsHandle});
   } catch (e) {
     mainPort.send({'type': 'error', 'message': 'Native init failed: $e', 'recoverable': false});
     return;
@@ -306,11 +1497,18 @@ void _nativeYoloIsolateEntry(Map<String, dynamic> message) async {
     if (type == 'frame') {
       final frameMap = (raw['frame'] as Map<dynamic, dynamic>).cast<String, dynamic>();
       try {
-        final detections = worker.processFrame(frameMap);
-        mainPort.send({'type': 'detections', 'items': detections});
+        mainPort.send(worker.processFrame(frameMap));
       } catch (e) {
         mainPort.send({'type': 'error', 'message': e.toString(), 'recoverable': true});
       }
+    } else if (type == 'request') {
+      final arguments = (raw['arguments'] as Map<dynamic, dynamic>).cast<String, dynamic>();
+      try {
+        final result = worker.handleRequest(raw['request'] as String, arguments);
+        mainPort.send({'type': 'reply', 'id': raw['id'], 'result': result});
+      } catch (e) {
+        mainPort.send({'type': 'reply', 'id': raw['id'], 'error': e.toString()});
+      }
     } else if (type == 'dispose') {
       await worker.dispose();
       mainPort.send({'type': 'disposed'});
@@ -327,79 +1525,529 @@ class _NativeYoloWorker {
   late final _NativeBindings _bindings;
   Pointer<Void>? _handle;
 
+  /// Engine address for [NativeYoloEngine.acquireResults] on the UI isolate;
+  /// null unless the result channel is on.
+  int? get resultsHandle => _resultChannel ? _handle?.address : null;
+
+  bool get _resultChannel => _config['resultChannel'] as bool? ?? false;
+
   Future<void> initialize() async {
-    final lib = _openLibrary();
+    final lib = openYoloEngineLibrary();
     _bindings = _NativeBindings(lib);
     final Pointer<Utf8> modelPathPtr = (_config['modelPath'] as String).toNativeUtf8();
-    _handle = _bindings.create(
-      modelPathPtr,
-      _config['inputWidth'] as int,
-      _config['inputHeight'] as int,
-      _config['threads'] as int,
-      _config['maxDetections'] as int,
-      (_config['confidenceThreshold'] as num).toDouble(),
-      (_config['iouThreshold'] as num).toDouble(),
-      (_config['useGpu'] as bool? ?? false) ? 1 : 0,
-      (_config['allowFp16'] as bool? ?? true) ? 1 : 0,
-    );
+    final String? tuningCachePath = _config['tuningCachePath'] as String?;
+    final Pointer<Utf8> tuningCachePtr =
+        tuningCachePath == null ? nullptr : tuningCachePath.toNativeUtf8();
+    final String? classifierModelPath = _config['classifierModelPath'] as String?;
+    final Pointer<Utf8> classifierPtr =
+        classifierModelPath == null ? nullptr : classifierModelPath.toNativeUtf8();
+    final Pointer<_YoloEngineConfig> configPtr = calloc<_YoloEngineConfig>();
+    _bindings.configInitDefault(configPtr);
+    configPtr.ref
+      ..modelPath = modelPathPtr
+      ..inputWidth = _config['inputWidth'] as int
+      ..inputHeight = _config['inputHeight'] as int
+      ..numThreads = _config['threads'] as int
+      ..maxDetections = _config['maxDetections'] as int
+      ..confidenceThreshold = (_config['confidenceThreshold'] as num).toDouble()
+      ..iouThreshold = (_config['iouThreshold'] as num).toDouble()
+      ..useGpu = (_config['useGpu'] as bool? ?? false) ? 1 : 0
+      ..allowFp16 = (_config['allowFp16'] as bool? ?? true) ? 1 : 0
+      ..autoTune = (_config['autoTune'] as bool? ?? false) ? 1 : 0
+      ..tuningCachePath = tuningCachePtr
+      ..inferenceInterval = _config['inferenceInterval'] as int? ?? 1
+      ..minTrackConfidence = (_config['minTrackConfidence'] as num? ?? 0.5).toDouble()
+      ..classifierModelPath = classifierPtr
+      ..classifierTopK = _config['classifierTopK'] as int? ?? 3
+      ..classifierMinScore = (_config['classifierMinScore'] as num? ?? 0.5).toDouble()
+      ..frameRingSize = _config['frameRingSize'] as int? ?? 0
+      ..qualityGate = _config['qualityGate'] as int? ?? 0
+      ..minSharpness = (_config['minSharpness'] as num? ?? 30).toDouble()
+      ..maxClippedFraction = (_config['maxClippedFraction'] as num? ?? 0.5).toDouble()
+      ..autoZoom = (_config['autoZoom'] as bool? ?? false) ? 1 : 0
+      ..resultChannel = _resultChannel ? 1 : 0
+      ..corePlacement = _config['corePlacement'] as int? ?? 0
+      ..coreMask = _config['coreMask'] as int? ?? 0
+      ..threadNice = _config['threadNice'] as int? ?? 0;
+    final Map<dynamic, dynamic>? cadence = _config['cadence'] as Map<dynamic, dynamic>?;
+    if (cadence != null) {
+      configPtr.ref
+        ..governor = 1
+        ..governorMaxFps = (cadence['maxFps'] as num).toDouble()
+        ..governorMaxDutyCycle = (cadence['maxDutyCycle'] as num).toDouble()
+        ..governorMaxCpuMsPerS = (cadence['maxCpuMsPerSecond'] as num).toDouble()
+        ..governorIdleAfterMs = cadence['idleAfterMs'] as int
+        ..governorIdleFps = (cadence['idleFps'] as num).toDouble();
+    }
+    _handle = _bindings.createWithConfig(configPtr);
+    calloc.free(configPtr);
     calloc.free(modelPathPtr);
+    if (tuningCachePtr != nullptr) {
+      calloc.free(tuningCachePtr);
+    }
+    if (classifierPtr != nullptr) {
+      calloc.free(classifierPtr);
+    }
     if (_handle == null || _handle == nullptr) {
       throw Exception('Failed to create YOLO engine');
     }
   }
 
-  List<Map<String, dynamic>> processFrame(Map<String, dynamic> message) {
+  /// Runs one frame and returns the message for the UI isolate:
+  /// `detections` (`published` when the result channel carries them),
+  /// `expired` or `lowQuality`, all carrying the frame's timing.
+  Map<String, dynamic> processFrame(Map<String, dynamic> message) {
     if (_handle == null) {
       throw StateError('Native engine not initialized');
     }
     final frame = _NativeFrame.fromMessage(message);
-    final Pointer<Uint8> yPtr = calloc<Uint8>(frame.yBytes.length);
-    final Pointer<Uint8> uPtr = calloc<Uint8>(frame.uBytes.length);
-    final Pointer<Uint8> vPtr = calloc<Uint8>(frame.vBytes.length);
-    yPtr.asTypedList(frame.yBytes.length).setAll(0, frame.yBytes);
-    uPtr.asTypedList(frame.uBytes.length).setAll(0, frame.uBytes);
-    vPtr.asTypedList(frame.vBytes.length).setAll(0, frame.vBytes);
+    // Packed frames arrive in native memory the UI isolate owns until this
+    // call returns, and are read where they are.
+    final bool inPlace = frame.pixelsAddress != 0;
+    final Pointer<Uint8> yPtr;
+    if (inPlace) {
+      yPtr = Pointer<Uint8>.fromAddress(frame.pixelsAddress);
+    } else {
+      yPtr = calloc<Uint8>(frame.yBytes.length);
+      yPtr.asTypedList(frame.yBytes.length).setAll(0, frame.yBytes);
+    }
+    final _ChromaBuffers? chroma =
+        frame.format == _PixelFormat.yuv420 ? _ChromaBuffers.copy(frame) : null;
+
+    final Pointer<_YoloFrameDescriptor> descriptorPtr = calloc<_YoloFrameDescriptor>();
+    final _YoloFrameDescriptor descriptor = descriptorPtr.ref
+      ..format = frame.format
+      ..width = frame.width
+      ..height = frame.height
+      ..rotationDegrees = frame.rotation
+      ..captureTimeNs = frame.captureTimeNs
+      ..deadlineNs = frame.deadlineNs;
+    final List<double>? roi = frame.roi;
+    if (roi != null) {
+      descriptor
+        ..roiLeft = roi[0]
+        ..roiTop = roi[1]
+        ..roiRight = roi[2]
+        ..roiBottom = roi[3];
+    }
+    descriptor.planes[0] = yPtr;
+    descriptor.rowStrides[0] = frame.yRowStride;
+    descriptor.pixelStrides[0] = 1;
+    if (chroma != null) {
+      descriptor.planes[1] = chroma.u;
+      descriptor.planes[2] = chroma.v;
+      descriptor.rowStrides[1] = frame.uvRowStride;
+      descriptor.rowStrides[2] = frame.uvRowStride;
+      descriptor.pixelStrides[1] = frame.uvPixelStride;
+      descriptor.pixelStrides[2] = frame.uvPixelStride;
+    }
 
     final Pointer<_YoloDetections> detectionsPtr = calloc<_YoloDetections>();
-    final int status = _bindings.process(
-      _handle!,
-      yPtr,
-      uPtr,
-      vPtr,
-      frame.yRowStride,
-      frame.uvRowStride,
-      frame.uvPixelStride,
-      frame.width,
-      frame.height,
-      frame.rotation,
-      detectionsPtr,
-    );
-    calloc.free(yPtr);
-    calloc.free(uPtr);
-    calloc.free(vPtr);
+    final int status = _bindings.process(_handle!, descriptorPtr, detectionsPtr);
+    calloc.free(descriptorPtr);
+    if (!inPlace) {
+      calloc.free(yPtr);
+    }
+    chroma?.free();
+    final _YoloDetections result = detectionsPtr.ref;
+    final bool expired = status == _frameExpiredStatus;
+    final bool lowQualitySkipped = status == _frameLowQualityStatus;
+    final timing = <String, dynamic>{
+      'captureTimeNs': result.captureTimeNs,
+      'receiveTimeNs': result.receiveTimeNs,
+      'inferenceStartNs': result.inferenceStartNs,
+      'decodeEndNs': result.decodeEndNs,
+      'expired': expired,
+      'predicted': result.predicted != 0,
+      'trackConfidence': result.trackConfidence,
+      'lowQualitySkipped': lowQualitySkipped,
+      if (result.roiLeft > 0 || result.roiTop > 0 || result.roiRight < 1 || result.roiBottom < 1)
+        'roi': <double>[result.roiLeft, result.roiTop, result.roiRight, result.roiBottom],
+      if ((_config['qualityGate'] as int? ?? 0) != 0 && !expired) 'quality': _qualityToMap(result),
+    };
     if (status != 0) {
       _bindings.releaseDetections(detectionsPtr);
       calloc.free(detectionsPtr);
+      if (expired) {
+        return <String, dynamic>{'type': 'expired', 'timing': timing};
+      }
+      if (lowQualitySkipped) {
+        return <String, dynamic>{'type': 'lowQuality', 'timing': timing};
+      }
+      if (status == _frameSuspendedStatus) {
+        return <String, dynamic>{'type': 'suspended'};
+      }
+      if (status == _frameGovernedStatus) {
+        return <String, dynamic>{'type': 'governed'};
+      }
       throw Exception('Native processFrame failed: status=$status');
     }
 
+    if (_resultChannel) {
+      // The boxes are already in the shared result channel.
+      _bindings.releaseDetections(detectionsPtr);
+      calloc.free(detectionsPtr);
+      return <String, dynamic>{'type': 'published', 'timing': timing};
+    }
+
     final detections = <Map<String, dynamic>>[];
     final Pointer<_YoloDetection> items = detectionsPtr.ref.detections;
+    final Pointer<_YoloClassification> classifications = detectionsPtr.ref.classifications;
     final int count = detectionsPtr.ref.count;
     for (int i = 0; i < count; i++) {
       final detection = items[i];
-      detections.add({
+      final item = <String, dynamic>{
         'left': detection.left,
         'top': detection.top,
         'right': detection.right,
         'bottom': detection.bottom,
         'score': detection.score,
         'classIndex': detection.classIndex,
-      });
+      };
+      if (classifications != nullptr) {
+        // Flattened (classIndex, score) pairs keep the isolate message small.
+        final classification = classifications[i];
+        item['species'] = <num>[
+          for (int k = 0; k < classification.count; k++) ...<num>[
+            classification.classIndex[k],
+            classification.score[k],
+          ],
+        ];
+      }
+      detections.add(item);
     }
     _bindings.releaseDetections(detectionsPtr);
     calloc.free(detectionsPtr);
-    return detections;
+    return <String, dynamic>{'type': 'detections', 'items': detections, 'timing': timing};
+  }
+
+  void updateDecodeConfig(Map<String, dynamic> arguments) {
+    final thresholds = (arguments['classThresholds'] as Map<dynamic, dynamic>).map(
+      (dynamic key, dynamic value) => MapEntry(key as int, (value as num).toDouble()),
+    );
+    final enabled = (arguments['enabledClasses'] as List<dynamic>?)?.cast<int>();
+    int classCount = 0;
+    for (final int classIndex in <int>[...thresholds.keys, ...?enabled]) {
+      if (classIndex >= classCount) {
+        classCount = classIndex + 1;
+      }
+    }
+    final Pointer<_YoloDecodeConfig> configPtr = calloc<_YoloDecodeConfig>();
+    final Pointer<Float> thresholdsPtr =
+        thresholds.isEmpty ? nullptr : calloc<Float>(classCount);
+    final Pointer<Uint8> enabledPtr = enabled == null ? nullptr : calloc<Uint8>(classCount);
+    try {
+      thresholds.forEach((int classIndex, double threshold) {
+        if (classIndex >= 0) {
+          thresholdsPtr[classIndex] = threshold;
+        }
+      });
+      if (enabled != null) {
+        for (final int classIndex in enabled) {
+          if (classIndex >= 0) {
+            enabledPtr[classIndex] = 1;
+          }
+        }
+      }
+      configPtr.ref
+        ..confidenceThreshold = (arguments['confidenceThreshold'] as num).toDouble()
+        ..iouThreshold = (arguments['iouThreshold'] as num).toDouble()
+        ..maxDetections = arguments['maxDetections'] as int
+        ..classCount = classCount
+        ..classThresholds = thresholdsPtr
+        ..classEnabled = enabledPtr;
+      if (_bindings.updateDecodeConfig(_handle!, configPtr) != 0) {
+        throw Exception('Native updateDecodeConfig failed');
+      }
+    } finally {
+      calloc.free(configPtr);
+      if (thresholdsPtr != nullptr) {
+        calloc.free(thresholdsPtr);
+      }
+      if (enabledPtr != nullptr) {
+        calloc.free(enabledPtr);
+      }
+    }
+  }
+
+  Map<String, dynamic> _qualityToMap(_YoloDetections result) {
+    // The native gate only reports pass/fail; name the likely reason so the
+    // UI can tell the user what to fix.
+    final double maxClipped = (_config['maxClippedFraction'] as num? ?? 0.5).toDouble();
+    NativeQualityIssue? issue;
+    if (result.lowQuality != 0) {
+      if (result.darkFraction > maxClipped) {
+        issue = NativeQualityIssue.tooDark;
+      } else if (result.brightFraction > maxClipped) {
+        issue = NativeQualityIssue.tooBright;
+      } else {
+        issue = NativeQualityIssue.blurred;
+      }
+    }
+    return <String, dynamic>{
+      'sharpness': result.sharpness,
+      'meanLuma': result.meanLuma,
+      'darkFraction': result.darkFraction,
+      'brightFraction': result.brightFraction,
+      'issue': issue?.index,
+    };
+  }
+
+  dynamic handleRequest(String request, Map<String, dynamic> arguments) {
+    if (_handle == null) {
+      throw StateError('Native engine not initialized');
+    }
+    switch (request) {
+      case 'stats':
+        return readStats(reset: arguments['reset'] as bool? ?? false);
+      case 'memoryStats':
+        final Pointer<_YoloMemoryStats> memoryPtr = calloc<_YoloMemoryStats>();
+        try {
+          if (_bindings.getMemoryStats(_handle!, memoryPtr) != 0) {
+            throw Exception('Native getMemoryStats failed');
+          }
+          final memory = memoryPtr.ref;
+          return <String, dynamic>{
+            'scratchBytes': memory.scratchBytes,
+            'scratchPeakBytes': memory.scratchPeakBytes,
+            'tensorArenaBytes': memory.tensorArenaBytes,
+            'modelBytes': memory.modelBytes,
+            'steadyStateBytes': memory.steadyStateBytes,
+            'peakBytes': memory.peakBytes,
+            'processResidentBytes': memory.processResidentBytes,
+            'suspended': memory.suspended != 0,
+            'suspendMs': memory.suspendMs,
+            'suspendReleasedBytes': memory.suspendReleasedBytes,
+            'resumeMs': memory.resumeMs,
+          };
+        } finally {
+          calloc.free(memoryPtr);
+        }
+      case 'tuningInfo':
+        final Pointer<_YoloTuningInfo> infoPtr = calloc<_YoloTuningInfo>();
+        try {
+          if (_bindings.getTuningInfo(_handle!, infoPtr) != 0) {
+            throw Exception('Native getTuningInfo failed');
+          }
+          final info = infoPtr.ref;
+          return <String, dynamic>{
+            'delegate': info.delegate,
+            'threads': info.numThreads,
+            'invokeUs': info.invokeUs,
+            'fromCache': info.fromCache != 0,
+            'candidatesTested': info.candidatesTested,
+          };
+        } finally {
+          calloc.free(infoPtr);
+        }
+      case 'updateDecodeConfig':
+        updateDecodeConfig(arguments);
+        return null;
+      case 'suspend':
+        final int suspendStatus = _bindings.suspend(_handle!);
+        if (suspendStatus == -1) {
+          throw Exception('Native suspend failed');
+        }
+        return suspendStatus == 0;
+      case 'resume':
+        final int resumeStatus = _bindings.resume(_handle!);
+        if (resumeStatus == -1) {
+          throw Exception('Native resume failed');
+        }
+        return resumeStatus == 0;
+      case 'swapModel':
+        final Pointer<Utf8> modelPathPtr = (arguments['modelPath'] as String).toNativeUtf8();
+        try {
+          final status = _bindings.swapModel(_handle!, modelPathPtr);
+          if (status == -1) {
+            throw Exception('Native swapModel failed');
+          }
+          return status == 0;
+        } finally {
+          calloc.free(modelPathPtr);
+        }
+      case 'modelSwapInfo':
+        final Pointer<_YoloModelSwapInfo> swapPtr = calloc<_YoloModelSwapInfo>();
+        try {
+          if (_bindings.getModelSwapInfo(_handle!, swapPtr) != 0) {
+            throw Exception('Native getModelSwapInfo failed');
+          }
+          final swap = swapPtr.ref;
+          return <String, dynamic>{
+            'state': swap.state,
+            'swapsCompleted': swap.swapsCompleted,
+            'loadMs': swap.loadMs,
+            'warmupMs': swap.warmupMs,
+            'switchUs': swap.switchUs,
+            'requestToSwitchMs': swap.requestToSwitchMs,
+            'releaseMs': swap.releaseMs,
+          };
+        } finally {
+          calloc.free(swapPtr);
+        }
+      case 'requestCapture':
+        final Pointer<_YoloCaptureRequest> requestPtr = calloc<_YoloCaptureRequest>();
+        final Pointer<Utf8> cropPathPtr = (arguments['cropPath'] as String).toNativeUtf8();
+        final String? thumbnailPath = arguments['thumbnailPath'] as String?;
+        final Pointer<Utf8> thumbnailPathPtr =
+            thumbnailPath == null ? nullptr : thumbnailPath.toNativeUtf8();
+        try {
+          final request = requestPtr.ref
+            ..margin = (arguments['margin'] as num).toDouble()
+            ..cropMaxSide = arguments['cropMaxSide'] as int
+            ..thumbnailMaxSide = arguments['thumbnailMaxSide'] as int
+            ..cropPath = cropPathPtr
+            ..thumbnailPath = thumbnailPathPtr;
+          request.box
+            ..left = (arguments['left'] as num).toDouble()
+            ..top = (arguments['top'] as num).toDouble()
+            ..right = (arguments['right'] as num).toDouble()
+            ..bottom = (arguments['bottom'] as num).toDouble()
+            ..classIndex = arguments['classIndex'] as int? ?? -1;
+          final int? windowMs = arguments['windowMs'] as int?;
+          final id = windowMs == null
+              ? _bindings.requestCapture(_handle!, requestPtr)
+              : _bindings.captureBest(_handle!, requestPtr, windowMs);
+          if (id == -1) {
+            throw Exception('Native requestCapture failed');
+          }
+          return id;
+        } finally {
+          calloc.free(requestPtr);
+          calloc.free(cropPathPtr);
+          if (thumbnailPathPtr != nullptr) {
+            calloc.free(thumbnailPathPtr);
+          }
+        }
+      case 'captureStatus':
+        return _bindings.getCaptureStatus(_handle!, arguments['id'] as int);
+      case 'cancelCapture':
+        return _bindings.cancelCapture(_handle!, arguments['id'] as int);
+      case 'startTrace':
+        if (_bindings.startTrace(_handle!, arguments['maxEvents'] as int) != 0) {
+          throw Exception('Native startTrace failed');
+        }
+        return null;
+      case 'stopTrace':
+        _bindings.stopTrace(_handle!);
+        return null;
+      case 'dumpTrace':
+        final Pointer<Utf8> pathPtr = (arguments['path'] as String).toNativeUtf8();
+        try {
+          final written = _bindings.dumpTrace(_handle!, pathPtr);
+          if (written < 0) {
+            throw Exception('Native dumpTrace failed: status=$written');
+          }
+          return written;
+        } finally {
+          calloc.free(pathPtr);
+        }
+      case 'startRecording':
+        final Pointer<Utf8> pathPtr = (arguments['path'] as String).toNativeUtf8();
+        try {
+          final status = _bindings.startRecording(_handle!, pathPtr, arguments['maxBytes'] as int);
+          if (status == -1) {
+            throw Exception('Native startRecording failed');
+          }
+          return status == 0;
+        } finally {
+          calloc.free(pathPtr);
+        }
+      case 'stopRecording':
+        _bindings.stopRecording(_handle!);
+        return null;
+      case 'recordingInfo':
+        final Pointer<_YoloRecordingInfo> infoPtr = calloc<_YoloRecordingInfo>();
+        try {
+          if (_bindings.getRecordingInfo(_handle!, infoPtr) != 0) {
+            throw Exception('Native getRecordingInfo failed');
+          }
+          final info = infoPtr.ref;
+          return <String, dynamic>{
+            'state': info.state,
+            'framesRecorded': info.framesRecorded,
+            'framesDropped': info.framesDropped,
+            'bytesWritten': info.bytesWritten,
+            'bufferBytes': info.bufferBytes,
+          };
+        } finally {
+          calloc.free(infoPtr);
+        }
+      default:
+        throw UnsupportedError('Unknown engine request: $request');
+    }
+  }
+
+  Map<String, dynamic> readStats({required bool reset}) {
+    final Pointer<_YoloEngineStats> statsPtr = calloc<_YoloEngineStats>();
+    try {
+      if (_bindings.getStats(_handle!, statsPtr) != 0) {
+        throw Exception('Native getStats failed');
+      }
+      final stats = statsPtr.ref;
+      if (reset) {
+        _bindings.resetStats(_handle!);
+      }
+      return <String, dynamic>{
+        'stages': <String, dynamic>{
+          'yuvToRgb': _stageToMap(stats.yuvToRgb),
+          'rotate': _stageToMap(stats.rotate),
+          'resize': _stageToMap(stats.resize),
+          'invoke': _stageToMap(stats.invoke),
+          'decode': _stageToMap(stats.decode),
+          'total': _stageToMap(stats.total),
+          'queueWait': _stageToMap(stats.queueWait),
+          'captureToResult': _stageToMap(stats.captureToResult),
+          'track': _stageToMap(stats.track),
+          'classify': _stageToMap(stats.classify),
+          'quality': _stageToMap(stats.quality),
+        },
+        'framesProcessed': stats.framesProcessed,
+        'framesDropped': stats.framesDropped,
+        'candidatesPreNms': stats.candidatesPreNms,
+        'candidatesPostNms': stats.candidatesPostNms,
+        'allocations': stats.allocations,
+        'framesExpired': stats.framesExpired,
+        'framesTracked': stats.framesTracked,
+        'cropsClassified': stats.cropsClassified,
+        'classificationCacheHits': stats.classificationCacheHits,
+        'framesLowQuality': stats.framesLowQuality,
+        'framesZoomed': stats.framesZoomed,
+        'framesGoverned': stats.framesGoverned,
+        'governor': <String, dynamic>{
+          'mode': stats.governor.mode,
+          'limit': stats.governor.limit,
+          'intervalMs': stats.governor.intervalMs,
+          'inferenceMs': stats.governor.inferenceMs,
+          'dutyCycle': stats.governor.dutyCycle,
+          'cpuMsPerSecond': stats.governor.cpuMsPerS,
+          'invokeDrift': stats.governor.invokeDrift,
+          'modeChanges': stats.governor.modeChanges,
+        },
+        'placement': <String, dynamic>{
+          'mode': stats.placement.mode,
+          'nice': stats.placement.nice,
+          'cpuMask': stats.placement.cpuMask,
+          'coreClasses': stats.placement.coreClasses,
+          'workersPinned': stats.placement.workersPinned,
+          'frameThreadPinned': stats.placement.frameThreadPinned != 0,
+          'priorityApplied': stats.placement.priorityApplied != 0,
+        },
+      };
+    } finally {
+      calloc.free(statsPtr);
+    }
+  }
+
+  static Map<String, dynamic> _stageToMap(_YoloStageStats stage) {
+    return <String, dynamic>{
+      'count': stage.count,
+      'meanUs': stage.meanUs,
+      'p50Us': stage.p50Us,
+      'p90Us': stage.p90Us,
+      'p99Us': stage.p99Us,
+      'maxUs': stage.maxUs,
+    };
   }
 
   Future<void> dispose() async {
@@ -413,6 +2061,7 @@ class _NativeYoloWorker {
 
 class _NativeFrame {
   _NativeFrame({
+    required this.format,
     required this.width,
     required this.height,
     required this.rotation,
@@ -422,8 +2071,13 @@ class _NativeFrame {
     required this.yBytes,
     required this.uBytes,
     required this.vBytes,
+    required this.captureTimeNs,
+    required this.deadlineNs,
+    required this.pixelsAddress,
+    this.roi,
   });
 
+  final int format;
   final int width;
   final int height;
   final int rotation;
@@ -433,12 +2087,18 @@ class _NativeFrame {
   final Uint8List yBytes;
   final Uint8List uBytes;
   final Uint8List vBytes;
+  final int captureTimeNs;
+  final int deadlineNs;
+  // Address of a packed frame already in native memory; 0 for YUV.
+  final int pixelsAddress;
+  final List<double>? roi;
 
   factory _NativeFrame.fromMessage(Map<String, dynamic> map) {
     final TransferableTypedData yData = map['yData'] as TransferableTypedData;
     final TransferableTypedData uData = map['uData'] as TransferableTypedData;
     final TransferableTypedData vData = map['vData'] as TransferableTypedData;
     return _NativeFrame(
+      format: map['format'] as int,
       width: map['width'] as int,
       height: map['height'] as int,
       rotation: map['rotation'] as int,
@@ -448,11 +2108,116 @@ class _NativeFrame {
       yBytes: yData.materialize().asUint8List(),
       uBytes: uData.materialize().asUint8List(),
       vBytes: vData.materialize().asUint8List(),
+      captureTimeNs: map['captureTimeNs'] as int,
+      deadlineNs: map['deadlineNs'] as int,
+      pixelsAddress: map['pixels'] as int? ?? 0,
+      roi: (map['roi'] as List<dynamic>?)?.cast<double>(),
     );
   }
 }
 
-DynamicLibrary _openLibrary() {
+/// Native copies of a frame's chroma planes.
+///
+/// Android hands out semi-planar frames as two overlapping views of one
+/// buffer (the V plane reads VUVU..., the U plane is the same bytes shifted
+/// by one). When that is verified the engine gets a single interleaved copy
+/// with `u == v + 1`, which it recognises as NV21 (or NV12 for the mirrored
+/// case) and converts with adjacent loads. Anything else is copied plane by
+/// plane and takes the generic path.
+class _ChromaBuffers {
+  _ChromaBuffers._(this.u, this.v, this._owned);
+
+  final Pointer<Uint8> u;
+  final Pointer<Uint8> v;
+  final List<Pointer<Uint8>> _owned;
+
+  static const int _samples = 16;
+
+  factory _ChromaBuffers.copy(_NativeFrame frame) {
+    if (frame.uvPixelStride == 2) {
+      if (_isShiftedView(frame.vBytes, frame.uBytes)) {
+        final Pointer<Uint8> vu = _interleaved(frame.vBytes, frame.uBytes);
+        return _ChromaBuffers._(vu + 1, vu, [vu]);
+      }
+      if (_isShiftedView(frame.uBytes, frame.vBytes)) {
+        final Pointer<Uint8> uv = _interleaved(frame.uBytes, frame.vBytes);
+        return _ChromaBuffers._(uv, uv + 1, [uv]);
+      }
+    }
+    final Pointer<Uint8> u = calloc<Uint8>(frame.uBytes.length);
+    final Pointer<Uint8> v = calloc<Uint8>(frame.vBytes.length);
+    u.asTypedList(frame.uBytes.length).setAll(0, frame.uBytes);
+    v.asTypedList(frame.vBytes.length).setAll(0, frame.vBytes);
+    return _ChromaBuffers._(u, v, [u, v]);
+  }
+
+  /// Whether [second] holds the bytes of [first] shifted by one, sampled at
+  /// evenly spaced positions across the plane.
+  static bool _isShiftedView(Uint8List first, Uint8List second) {
+    if (first.length < 2 || first.length != second.length) {
+      return false;
+    }
+    final int last = first.length - 2;
+    for (int i = 0; i <= _samples; i++) {
+      final int index = (last * i) ~/ _samples;
+      if (first[index + 1] != second[index]) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  /// [first] followed by the one trailing byte only [second] covers.
+  static Pointer<Uint8> _interleaved(Uint8List first, Uint8List second) {
+    final Pointer<Uint8> buffer = calloc<Uint8>(first.length + 1);
+    final Uint8List view = buffer.asTypedList(first.length + 1);
+    view.setAll(0, first);
+    view[first.length] = second[second.length - 1];
+    return buffer;
+  }
+
+  void free() {
+    for (final Pointer<Uint8> pointer in _owned) {
+      calloc.free(pointer);
+    }
+  }
+}
+
+/// `YOLO_ENGINE_FRAME_EXPIRED`: the frame missed its deadline and was skipped.
+const int _frameExpiredStatus = -3;
+
+/// `YOLO_ENGINE_FRAME_LOW_QUALITY`: the quality gate skipped the frame.
+const int _frameLowQualityStatus = -4;
+
+/// `YOLO_ENGINE_FRAME_SUSPENDED`: the frame arrived while suspended.
+const int _frameSuspendedStatus = -5;
+
+/// `YOLO_ENGINE_FRAME_GOVERNED`: the cadence governor held the frame back.
+const int _frameGovernedStatus = -6;
+
+/// `YOLO_CAPTURE_PENDING` / `YOLO_CAPTURE_DONE`.
+const int _capturePending = 0;
+const int _captureDone = 1;
+
+/// `YOLO_CLASSIFIER_MAX_TOP_K`.
+const int _classifierMaxTopK = 5;
+
+/// `YOLO_RESULT_MAX_DETECTIONS`.
+const int _resultMaxDetections = 256;
+
+/// Engine clock for capture timestamps; resolved on first use in whichever
+/// isolate calls it.
+final int Function() _engineNowNs =
+    openYoloEngineLibrary().lookupFunction<Int64 Function(), int Function()>('YoloEngineNowNs', isLeaf: true);
+
+/// Result channel reader for the UI isolate; a leaf call, as it only swaps
+/// an index.
+final _AcquireResultsDart _acquireResults = openYoloEngineLibrary()
+    .lookupFunction<_AcquireResultsNative, _AcquireResultsDart>('YoloEngineAcquireResults', isLeaf: true);
+
+/// The native library holding the engine and the observation store
+/// (`native_observation_store.dart`).
+DynamicLibrary openYoloEngineLibrary() {
   if (Platform.isAndroid || Platform.isLinux) {
     return DynamicLibrary.open('libyolo_engine.so');
   }
@@ -468,14 +2233,66 @@ DynamicLibrary _openLibrary() {
 class _NativeBindings {
   _NativeBindings(DynamicLibrary library)
       : create = library.lookupFunction<_CreateEngineNative, _CreateEngineDart>('YoloEngineCreate'),
+        configInitDefault =
+            library.lookupFunction<_ConfigInitDefaultNative, _ConfigInitDefaultDart>('YoloEngineConfigInitDefault'),
+        createWithConfig =
+            library.lookupFunction<_CreateWithConfigNative, _CreateWithConfigDart>('YoloEngineCreateWithConfig'),
+        getMemoryStats =
+            library.lookupFunction<_GetMemoryStatsNative, _GetMemoryStatsDart>('YoloEngineGetMemoryStats'),
+        getTuningInfo = library.lookupFunction<_GetTuningInfoNative, _GetTuningInfoDart>('YoloEngineGetTuningInfo'),
+        swapModel = library.lookupFunction<_SwapModelNative, _SwapModelDart>('YoloEngineSwapModel'),
+        updateDecodeConfig = library.lookupFunction<_UpdateDecodeConfigNative, _UpdateDecodeConfigDart>(
+            'YoloEngineUpdateDecodeConfig'),
+        suspend = library.lookupFunction<_SuspendNative, _SuspendDart>('YoloEngineSuspend'),
+        resume = library.lookupFunction<_SuspendNative, _SuspendDart>('YoloEngineResume'),
+        requestCapture =
+            library.lookupFunction<_RequestCaptureNative, _RequestCaptureDart>('YoloEngineRequestCapture'),
+        captureBest = library.lookupFunction<_CaptureBestNative, _CaptureBestDart>('YoloEngineCaptureBest'),
+        getCaptureStatus =
+            library.lookupFunction<_GetCaptureStatusNative, _GetCaptureStatusDart>('YoloEngineGetCaptureStatus'),
+        cancelCapture =
+            library.lookupFunction<_GetCaptureStatusNative, _GetCaptureStatusDart>('YoloEngineCancelCapture'),
+        getModelSwapInfo =
+            library.lookupFunction<_GetModelSwapInfoNative, _GetModelSwapInfoDart>('YoloEngineGetModelSwapInfo'),
         destroy = library.lookupFunction<_DestroyEngineNative, _DestroyEngineDart>('YoloEngineDestroy'),
-        process = library.lookupFunction<_ProcessFrameNative, _ProcessFrameDart>('YoloEngineProcessYuvFrame'),
-        releaseDetections = library.lookupFunction<_ReleaseDetectionsNative, _ReleaseDetectionsDart>('YoloEngineReleaseDetections');
+        process = library.lookupFunction<_ProcessFrameNative, _ProcessFrameDart>('YoloEngineProcessFrame'),
+        releaseDetections = library.lookupFunction<_ReleaseDetectionsNative, _ReleaseDetectionsDart>('YoloEngineReleaseDetections'),
+        getStats = library.lookupFunction<_GetStatsNative, _GetStatsDart>('YoloEngineGetStats'),
+        resetStats = library.lookupFunction<_ResetStatsNative, _ResetStatsDart>('YoloEngineResetStats'),
+        startTrace = library.lookupFunction<_StartTraceNative, _StartTraceDart>('YoloEngineStartTrace'),
+        stopTrace = library.lookupFunction<_StopTraceNative, _StopTraceDart>('YoloEngineStopTrace'),
+        dumpTrace = library.lookupFunction<_DumpTraceNative, _DumpTraceDart>('YoloEngineDumpTrace'),
+        startRecording =
+            library.lookupFunction<_StartRecordingNative, _StartRecordingDart>('YoloEngineStartRecording'),
+        stopRecording = library.lookupFunction<_StopRecordingNative, _StopRecordingDart>('YoloEngineStopRecording'),
+        getRecordingInfo =
+            library.lookupFunction<_GetRecordingInfoNative, _GetRecordingInfoDart>('YoloEngineGetRecordingInfo');
 
   final _CreateEngineDart create;
+  final _ConfigInitDefaultDart configInitDefault;
+  final _CreateWithConfigDart createWithConfig;
+  final _GetMemoryStatsDart getMemoryStats;
+  final _GetTuningInfoDart getTuningInfo;
+  final _SwapModelDart swapModel;
+  final _UpdateDecodeConfigDart updateDecodeConfig;
+  final _SuspendDart suspend;
+  final _SuspendDart resume;
+  final _RequestCaptureDart requestCapture;
+  final _CaptureBestDart captureBest;
+  final _GetCaptureStatusDart getCaptureStatus;
+  final _GetCaptureStatusDart cancelCapture;
+  final _GetModelSwapInfoDart getModelSwapInfo;
   final _DestroyEngineDart destroy;
   final _ProcessFrameDart process;
   final _ReleaseDetectionsDart releaseDetections;
+  final _GetStatsDart getStats;
+  final _ResetStatsDart resetStats;
+  final _StartTraceDart startTrace;
+  final _StopTraceDart stopTrace;
+  final _DumpTraceDart dumpTrace;
+  final _StartRecordingDart startRecording;
+  final _StopRecordingDart stopRecording;
+  final _GetRecordingInfoDart getRecordingInfo;
 }
 
 base class _YoloDetection extends Struct {
@@ -498,11 +2315,506 @@ base class _YoloDetection extends Struct {
   external int classIndex;
 }
 
+base class _YoloClassification extends Struct {
+  @Int32()
+  external int count;
+
+  @Array(_classifierMaxTopK)
+  external Array<Int32> classIndex;
+
+  @Array(_classifierMaxTopK)
+  external Array<Float> score;
+}
+
+base class _YoloResultFrame extends Struct {
+  @Uint64()
+  external int sequence;
+
+  @Int32()
+  external int count;
+
+  @Int32()
+  external int predicted;
+
+  @Float()
+  external double trackConfidence;
+
+  @Int32()
+  external int lowQuality;
+
+  @Int64()
+  external int captureTimeNs;
+
+  @Int64()
+  external int receiveTimeNs;
+
+  @Int64()
+  external int inferenceStartNs;
+
+  @Int64()
+  external int decodeEndNs;
+
+  @Float()
+  external double roiLeft;
+
+  @Float()
+  external double roiTop;
+
+  @Float()
+  external double roiRight;
+
+  @Float()
+  external double roiBottom;
+
+  @Int32()
+  external int hasClassifications;
+
+  @Array(_resultMaxDetections)
+  external Array<_YoloDetection> detections;
+
+  @Array(_resultMaxDetections)
+  external Array<_YoloClassification> classifications;
+}
+
 base class _YoloDetections extends Struct {
   external Pointer<_YoloDetection> detections;
 
   @Int32()
   external int count;
+
+  @Int64()
+  external int captureTimeNs;
+
+  @Int64()
+  external int receiveTimeNs;
+
+  @Int64()
+  external int inferenceStartNs;
+
+  @Int64()
+  external int decodeEndNs;
+
+  @Int32()
+  external int predicted;
+
+  @Float()
+  external double trackConfidence;
+
+  external Pointer<_YoloClassification> classifications;
+
+  @Float()
+  external double sharpness;
+
+  @Float()
+  external double meanLuma;
+
+  @Float()
+  external double darkFraction;
+
+  @Float()
+  external double brightFraction;
+
+  @Int32()
+  external int lowQuality;
+
+  @Float()
+  external double roiLeft;
+
+  @Float()
+  external double roiTop;
+
+  @Float()
+  external double roiRight;
+
+  @Float()
+  external double roiBottom;
+}
+
+base class _YoloEngineConfig extends Struct {
+  external Pointer<Utf8> modelPath;
+
+  @Int32()
+  external int inputWidth;
+
+  @Int32()
+  external int inputHeight;
+
+  @Int32()
+  external int numThreads;
+
+  @Int32()
+  external int maxDetections;
+
+  @Float()
+  external double confidenceThreshold;
+
+  @Float()
+  external double iouThreshold;
+
+  @Int32()
+  external int useGpu;
+
+  @Int32()
+  external int allowFp16;
+
+  @Int32()
+  external int autoTune;
+
+  external Pointer<Utf8> tuningCachePath;
+
+  @Int32()
+  external int inferenceInterval;
+
+  @Float()
+  external double minTrackConfidence;
+
+  external Pointer<Utf8> classifierModelPath;
+
+  @Int32()
+  external int classifierTopK;
+
+  @Float()
+  external double classifierMinScore;
+
+  @Int32()
+  external int frameRingSize;
+
+  @Int32()
+  external int qualityGate;
+
+  @Float()
+  external double minSharpness;
+
+  @Float()
+  external double maxClippedFraction;
+
+  @Int32()
+  external int autoZoom;
+
+  @Int32()
+  external int resultChannel;
+
+  @Int32()
+  external int governor;
+
+  @Float()
+  external double governorMaxFps;
+
+  @Float()
+  external double governorMaxDutyCycle;
+
+  @Float()
+  external double governorMaxCpuMsPerS;
+
+  @Int32()
+  external int governorIdleAfterMs;
+
+  @Float()
+  external double governorIdleFps;
+
+  @Int32()
+  external int corePlacement;
+
+  @Uint64()
+  external int coreMask;
+
+  @Int32()
+  external int threadNice;
+}
+
+base class _YoloFrameDescriptor extends Struct {
+  @Int32()
+  external int format;
+
+  @Int32()
+  external int width;
+
+  @Int32()
+  external int height;
+
+  @Int32()
+  external int rotationDegrees;
+
+  @Array(3)
+  external Array<Pointer<Uint8>> planes;
+
+  @Array(3)
+  external Array<Int32> rowStrides;
+
+  @Array(3)
+  external Array<Int32> pixelStrides;
+
+  @Int64()
+  external int captureTimeNs;
+
+  @Int64()
+  external int deadlineNs;
+
+  @Float()
+  external double roiLeft;
+
+  @Float()
+  external double roiTop;
+
+  @Float()
+  external double roiRight;
+
+  @Float()
+  external double roiBottom;
+}
+
+base class _YoloMemoryStats extends Struct {
+  @Uint64()
+  external int scratchBytes;
+
+  @Uint64()
+  external int scratchPeakBytes;
+
+  @Uint64()
+  external int tensorArenaBytes;
+
+  @Uint64()
+  external int modelBytes;
+
+  @Uint64()
+  external int steadyStateBytes;
+
+  @Uint64()
+  external int peakBytes;
+
+  @Uint64()
+  external int processResidentBytes;
+
+  @Int32()
+  external int suspended;
+
+  @Float()
+  external double suspendMs;
+
+  @Float()
+  external double resumeMs;
+
+  @Uint64()
+  external int suspendReleasedBytes;
+}
+
+base class _YoloTuningInfo extends Struct {
+  @Int32()
+  external int delegate;
+
+  @Int32()
+  external int numThreads;
+
+  @Float()
+  external double invokeUs;
+
+  @Int32()
+  external int fromCache;
+
+  @Int32()
+  external int candidatesTested;
+}
+
+base class _YoloDecodeConfig extends Struct {
+  @Float()
+  external double confidenceThreshold;
+
+  @Float()
+  external double iouThreshold;
+
+  @Int32()
+  external int maxDetections;
+
+  @Int32()
+  external int classCount;
+
+  external Pointer<Float> classThresholds;
+
+  external Pointer<Uint8> classEnabled;
+}
+
+base class _YoloCaptureRequest extends Struct {
+  external _YoloDetection box;
+
+  @Float()
+  external double margin;
+
+  @Int32()
+  external int cropMaxSide;
+
+  @Int32()
+  external int thumbnailMaxSide;
+
+  external Pointer<Utf8> cropPath;
+
+  external Pointer<Utf8> thumbnailPath;
+}
+
+base class _YoloModelSwapInfo extends Struct {
+  @Int32()
+  external int state;
+
+  @Int32()
+  external int swapsCompleted;
+
+  @Float()
+  external double loadMs;
+
+  @Float()
+  external double warmupMs;
+
+  @Float()
+  external double switchUs;
+
+  @Float()
+  external double requestToSwitchMs;
+
+  @Float()
+  external double releaseMs;
+}
+
+base class _YoloRecordingInfo extends Struct {
+  @Int32()
+  external int state;
+
+  @Int64()
+  external int framesRecorded;
+
+  @Int64()
+  external int framesDropped;
+
+  @Int64()
+  external int bytesWritten;
+
+  @Int64()
+  external int bufferBytes;
+}
+
+base class _YoloStageStats extends Struct {
+  @Uint64()
+  external int count;
+
+  @Float()
+  external double meanUs;
+
+  @Float()
+  external double p50Us;
+
+  @Float()
+  external double p90Us;
+
+  @Float()
+  external double p99Us;
+
+  @Float()
+  external double maxUs;
+}
+
+base class _YoloEngineStats extends Struct {
+  external _YoloStageStats yuvToRgb;
+  external _YoloStageStats rotate;
+  external _YoloStageStats resize;
+  external _YoloStageStats invoke;
+  external _YoloStageStats decode;
+  external _YoloStageStats total;
+
+  @Uint64()
+  external int framesProcessed;
+
+  @Uint64()
+  external int framesDropped;
+
+  @Uint64()
+  external int candidatesPreNms;
+
+  @Uint64()
+  external int candidatesPostNms;
+
+  @Uint64()
+  external int allocations;
+
+  @Uint64()
+  external int framesExpired;
+
+  external _YoloStageStats queueWait;
+  external _YoloStageStats captureToResult;
+
+  @Uint64()
+  external int framesTracked;
+
+  external _YoloStageStats track;
+
+  @Uint64()
+  external int cropsClassified;
+
+  @Uint64()
+  external int classificationCacheHits;
+
+  external _YoloStageStats classify;
+
+  @Uint64()
+  external int framesLowQuality;
+
+  external _YoloStageStats quality;
+
+  @Uint64()
+  external int framesZoomed;
+
+  @Uint64()
+  external int framesGoverned;
+
+  external _YoloGovernorState governor;
+
+  external _YoloThreadPlacement placement;
+}
+
+base class _YoloThreadPlacement extends Struct {
+  @Int32()
+  external int mode;
+
+  @Int32()
+  external int nice;
+
+  @Uint64()
+  external int cpuMask;
+
+  @Int32()
+  external int coreClasses;
+
+  @Int32()
+  external int workersPinned;
+
+  @Int32()
+  external int frameThreadPinned;
+
+  @Int32()
+  external int priorityApplied;
+}
+
+base class _YoloGovernorState extends Struct {
+  @Int32()
+  external int mode;
+
+  @Int32()
+  external int limit;
+
+  @Float()
+  external double intervalMs;
+
+  @Float()
+  external double inferenceMs;
+
+  @Float()
+  external double dutyCycle;
+
+  @Float()
+  external double cpuMsPerS;
+
+  @Float()
+  external double invokeDrift;
+
+  @Uint64()
+  external int modeChanges;
 }
 
 typedef _CreateEngineNative = Pointer<Void> Function(
@@ -528,35 +2840,80 @@ typedef _CreateEngineDart = Pointer<Void> Function(
   int allowFp16,
 );
 
+typedef _ConfigInitDefaultNative = Void Function(Pointer<_YoloEngineConfig> config);
+typedef _ConfigInitDefaultDart = void Function(Pointer<_YoloEngineConfig> config);
+
+typedef _CreateWithConfigNative = Pointer<Void> Function(Pointer<_YoloEngineConfig> config);
+typedef _CreateWithConfigDart = Pointer<Void> Function(Pointer<_YoloEngineConfig> config);
+
+typedef _GetMemoryStatsNative = Int32 Function(Pointer<Void> handle, Pointer<_YoloMemoryStats> out);
+typedef _GetMemoryStatsDart = int Function(Pointer<Void> handle, Pointer<_YoloMemoryStats> out);
+
+typedef _GetTuningInfoNative = Int32 Function(Pointer<Void> handle, Pointer<_YoloTuningInfo> out);
+typedef _GetTuningInfoDart = int Function(Pointer<Void> handle, Pointer<_YoloTuningInfo> out);
+
+typedef _SwapModelNative = Int32 Function(Pointer<Void> handle, Pointer<Utf8> modelPath);
+typedef _SwapModelDart = int Function(Pointer<Void> handle, Pointer<Utf8> modelPath);
+
+typedef _AcquireResultsNative = Pointer<_YoloResultFrame> Function(Pointer<Void> handle);
+typedef _AcquireResultsDart = Pointer<_YoloResultFrame> Function(Pointer<Void> handle);
+
+typedef _UpdateDecodeConfigNative = Int32 Function(Pointer<Void> handle, Pointer<_YoloDecodeConfig> config);
+typedef _UpdateDecodeConfigDart = int Function(Pointer<Void> handle, Pointer<_YoloDecodeConfig> config);
+
+typedef _SuspendNative = Int32 Function(Pointer<Void> handle);
+typedef _SuspendDart = int Function(Pointer<Void> handle);
+
+typedef _RequestCaptureNative = Int32 Function(Pointer<Void> handle, Pointer<_YoloCaptureRequest> request);
+typedef _RequestCaptureDart = int Function(Pointer<Void> handle, Pointer<_YoloCaptureRequest> request);
+
+typedef _CaptureBestNative = Int32 Function(
+    Pointer<Void> handle, Pointer<_YoloCaptureRequest> request, Int32 windowMs);
+typedef _CaptureBestDart = int Function(Pointer<Void> handle, Pointer<_YoloCaptureRequest> request, int windowMs);
+
+typedef _GetCaptureStatusNative = Int32 Function(Pointer<Void> handle, Int32 captureId);
+typedef _GetCaptureStatusDart = int Function(Pointer<Void> handle, int captureId);
+
+typedef _GetModelSwapInfoNative = Int32 Function(Pointer<Void> handle, Pointer<_YoloModelSwapInfo> out);
+typedef _GetModelSwapInfoDart = int Function(Pointer<Void> handle, Pointer<_YoloModelSwapInfo> out);
+
 typedef _DestroyEngineNative = Void Function(Pointer<Void> handle);
 typedef _DestroyEngineDart = void Function(Pointer<Void> handle);
 
 typedef _ProcessFrameNative = Int32 Function(
   Pointer<Void> handle,
-  Pointer<Uint8> yPlane,
-  Pointer<Uint8> uPlane,
-  Pointer<Uint8> vPlane,
-  Int32 yRowStride,
-  Int32 uvRowStride,
-  Int32 uvPixelStride,
-  Int32 width,
-  Int32 height,
-  Int32 rotation,
+  Pointer<_YoloFrameDescriptor> frame,
   Pointer<_YoloDetections> result,
 );
 typedef _ProcessFrameDart = int Function(
   Pointer<Void> handle,
-  Pointer<Uint8> yPlane,
-  Pointer<Uint8> uPlane,
-  Pointer<Uint8> vPlane,
-  int yRowStride,
-  int uvRowStride,
-  int uvPixelStride,
-  int width,
-  int height,
-  int rotation,
+  Pointer<_YoloFrameDescriptor> frame,
   Pointer<_YoloDetections> result,
 );
 
 typedef _ReleaseDetectionsNative = Void Function(Pointer<_YoloDetections> detections);
 typedef _ReleaseDetectionsDart = void Function(Pointer<_YoloDetections> detections);
+
+typedef _GetStatsNative = Int32 Function(Pointer<Void> handle, Pointer<_YoloEngineStats> out);
+typedef _GetStatsDart = int Function(Pointer<Void> handle, Pointer<_YoloEngineStats> out);
+
+typedef _ResetStatsNative = Void Function(Pointer<Void> handle);
+typedef _ResetStatsDart = void Function(Pointer<Void> handle);
+
+typedef _StartTraceNative = Int32 Function(Pointer<Void> handle, Int32 maxEvents);
+typedef _StartTraceDart = int Function(Pointer<Void> handle, int maxEvents);
+
+typedef _StopTraceNative = Void Function(Pointer<Void> handle);
+typedef _StopTraceDart = void Function(Pointer<Void> handle);
+
+typedef _DumpTraceNative = Int32 Function(Pointer<Void> handle, Pointer<Utf8> path);
+typedef _DumpTraceDart = int Function(Pointer<Void> handle, Pointer<Utf8> path);
+
+typedef _StartRecordingNative = Int32 Function(Pointer<Void> handle, Pointer<Utf8> path, Int64 maxBytes);
+typedef _StartRecordingDart = int Function(Pointer<Void> handle, Pointer<Utf8> path, int maxBytes);
+
+typedef _StopRecordingNative = Void Function(Pointer<Void> handle);
+typedef _StopRecordingDart = void Function(Pointer<Void> handle);
+
+typedef _GetRecordingInfoNative = Int32 Function(Pointer<Void> handle, Pointer<_YoloRecordingInfo> out);
+typedef _GetRecordingInfoDart = int Function(Pointer<Void> handle, Pointer<_YoloRecordingInfo> out);
@@ -0,0 +1,218 @@
+import 'dart:convert';
+import 'dart:typed_data';
+
+import '../models/observation.dart';
+import '../native/native_observation_store.dart';
+
+/// Binary payload of a stored observation: a version byte, a bit per
+/// optional field that is present and per time that is UTC, then the fields
+/// in declaration order. Creation time, class index and location travel in
+/// the native record.
+class ObservationCodec {
+  static const int _version = 1;
+
+  static const int _hasConfidence = 1 << 0;
+  static const int _hasTop2Label = 1 << 1;
+  static const int _hasTop2Confidence = 1 << 2;
+  static const int _hasTop1VoteRatio = 1 << 3;
+  static const int _hasWindowFrameCount = 1 << 4;
+  static const int _hasWindowDurationMs = 1 << 5;
+  static const int _hasStabilityWinCount = 1 << 6;
+  static const int _hasStabilityWindowSize = 1 << 7;
+  static const int _hasIsLichen = 1 << 8;
+  static const int _hasPhotoPath = 1 << 9;
+  static const int _hasCapturedAt = 1 << 10;
+  static const int _hasLocationLabel = 1 << 11;
+  static const int _hasNotes = 1 << 12;
+  // Payloads written before these bits decode as local time, as they did.
+  static const int _createdAtUtc = 1 << 13;
+  static const int _capturedAtUtc = 1 << 14;
+
+  /// Store key of [observation]. Records without an id (only possible in
+  /// old JSON files) are keyed by their creation time so they are not
+  /// collapsed into one.
+  static String keyOf(Observation observation) {
+    return observation.id.isNotEmpty
+        ? observation.id
+        : 'created-${observation.createdAt.microsecondsSinceEpoch}';
+  }
+
+  /// The fields stored beside the payload.
+  static NativeStoreRecord recordOf(Observation observation) {
+    return NativeStoreRecord(
+      createdAtUs: observation.createdAt.microsecondsSinceEpoch,
+      latitude: observation.latitude,
+      longitude: observation.longitude,
+      accuracyMeters: observation.accuracyMeters,
+      classIndex: observation.classIndex,
+    );
+  }
+
+  static Uint8List encode(Observation o) {
+    final writer = _PayloadWriter();
+    var present = 0;
+    void flag(Object? value, int bit) {
+      if (value != null) present |= bit;
+    }
+
+    flag(o.confidence, _hasConfidence);
+    flag(o.top2Label, _hasTop2Label);
+    flag(o.top2Confidence, _hasTop2Confidence);
+    flag(o.top1VoteRatio, _hasTop1VoteRatio);
+    flag(o.windowFrameCount, _hasWindowFrameCount);
+    flag(o.windowDurationMs, _hasWindowDurationMs);
+    flag(o.stabilityWinCount, _hasStabilityWinCount);
+    flag(o.stabilityWindowSize, _hasStabilityWindowSize);
+    flag(o.isLichen, _hasIsLichen);
+    flag(o.photoPath, _hasPhotoPath);
+    flag(o.capturedAt, _hasCapturedAt);
+    flag(o.locationLabel, _hasLocationLabel);
+    flag(o.notes, _hasNotes);
+    if (o.createdAt.isUtc) present |= _createdAtUtc;
+    if (o.capturedAt?.isUtc ?? false) present |= _capturedAtUtc;
+
+    writer
+      ..uint8(_version)
+      ..uint32(present)
+      ..string(o.id)
+      ..string(o.speciesId)
+      ..string(o.label)
+      ..uint8(o.locationSource.index);
+    if (o.confidence != null) writer.float64(o.confidence!);
+    if (o.top2Label != null) writer.string(o.top2Label!);
+    if (o.top2Confidence != null) writer.float64(o.top2Confidence!);
+    if (o.top1VoteRatio != null) writer.float64(o.top1VoteRatio!);
+    if (o.windowFrameCount != null) writer.int64(o.windowFrameCount!);
+    if (o.windowDurationMs != null) writer.int64(o.windowDurationMs!);
+    if (o.stabilityWinCount != null) writer.int64(o.stabilityWinCount!);
+    if (o.stabilityWindowSize != null) writer.int64(o.stabilityWindowSize!);
+    if (o.isLichen != null) writer.uint8(o.isLichen! ? 1 : 0);
+    if (o.photoPath != null) writer.string(o.photoPath!);
+    if (o.capturedAt != null) {
+      writer.int64(o.capturedAt!.microsecondsSinceEpoch);
+    }
+    if (o.locationLabel != null) writer.string(o.locationLabel!);
+    if (o.notes != null) writer.string(o.notes!);
+    return writer.takeBytes();
+  }
+
+  static Observation decode(NativeStoreRecord record, Uint8List payload) {
+    final reader = _PayloadReader(payload);
+    final version = reader.uint8();
+    if (version != _version) {
+      throw FormatException('Unknown observation payload version $version');
+    }
+    final present = reader.uint32();
+    bool has(int bit) => present & bit != 0;
+
+    final id = reader.string();
+    final speciesId = reader.string();
+    final label = reader.string();
+    final sourceIndex = reader.uint8();
+    return Observation(
+      id: id,
+      speciesId: speciesId,
+      classIndex: record.classIndex,
+      label: label,
+      locationSource: sourceIndex < ObservationLocationSource.values.length
+          ? ObservationLocationSource.values[sourceIndex]
+          : ObservationLocationSource.none,
+      createdAt: DateTime.fromMicrosecondsSinceEpoch(
+        record.createdAtUs,
+        isUtc: has(_createdAtUtc),
+      ),
+      latitude: record.latitude,
+      longitude: record.longitude,
+      accuracyMeters: record.accuracyMeters,
+      confidence: has(_hasConfidence) ? reader.float64() : null,
+      top2Label: has(_hasTop2Label) ? reader.string() : null,
+      top2Confidence: has(_hasTop2Confidence) ? reader.float64() : null,
+      top1VoteRatio: has(_hasTop1VoteRatio) ? reader.float64() : null,
+      windowFrameCount: has(_hasWindowFrameCount) ? reader.int64() : null,
+      windowDurationMs: has(_hasWindowDurationMs) ? reader.int64() : null,
+      stabilityWinCount: has(_hasStabilityWinCount) ? reader.int64() : null,
+      stabilityWindowSize: has(_hasStabilityWindowSize) ? reader.int64() : null,
+      isLichen: has(_hasIsLichen) ? reader.uint8() != 0 : null,
+      photoPath: has(_hasPhotoPath) ? reader.string() : null,
+      capturedAt: has(_hasCapturedAt)
+          ? DateTime.fromMicrosecondsSinceEpoch(
+              reader.int64(),
+              isUtc: has(_capturedAtUtc),
+            )
+          : null,
+      locationLabel: has(_hasLocationLabel) ? reader.string() : null,
+      notes: has(_hasNotes) ? reader.string() : null,
+    );
+  }
+}
+
+class _PayloadWriter {
+  final BytesBuilder _bytes = BytesBuilder(copy: false);
+  final ByteData _scratch = ByteData(8);
+
+  void uint8(int value) => _bytes.addByte(value);
+
+  void uint32(int value) {
+    _scratch.setUint32(0, value, Endian.little);
+    _bytes.add(Uint8List.fromList(_scratch.buffer.asUint8List(0, 4)));
+  }
+
+  void int64(int value) {
+    _scratch.setInt64(0, value, Endian.little);
+    _bytes.add(Uint8List.fromList(_scratch.buffer.asUint8List(0, 8)));
+  }
+
+  void float64(double value) {
+    _scratch.setFloat64(0, value, Endian.little);
+    _bytes.add(Uint8List.fromList(_scratch.buffer.asUint8List(0, 8)));
+  }
+
+  void string(String value) {
+    final encoded = utf8.encode(value);
+    uint32(encoded.length);
+    _bytes.add(encoded);
+  }
+
+  Uint8List takeBytes() => _bytes.takeBytes();
+}
+
+/// Reads the fields [_PayloadWriter] wrote. Strings are decoded straight
+/// from [bytes], which may be a view of native memory.
+class _PayloadReader {
+  _PayloadReader(Uint8List bytes)
+      : _bytes = bytes,
+        _data = ByteData.sublistView(bytes);
+
+  final Uint8List _bytes;
+  final ByteData _data;
+  int _offset = 0;
+
+  int uint8() => _data.getUint8(_offset++);
+
+  int uint32() {
+    final value = _data.getUint32(_offset, Endian.little);
+    _offset += 4;
+    return value;
+  }
+
+  int int64() {
+    final value = _data.getInt64(_offset, Endian.little);
+    _offset += 8;
+    return value;
+  }
+
+  double float64() {
+    final value = _data.getFloat64(_offset, Endian.little);
+    _offset += 8;
+    return value;
+  }
+
+  String string() {
+    final length = uint32();
+    final value = utf8.decode(
+      Uint8List.sublistView(_bytes, _offset, _offset + length),
+    );
+    _offset += length;
+    return value;
+  }
+}
@@ -5,6 +5,8 @@ import 'dart:io';
 import 'package:path_provider/path_provider.dart';
 
 import '../models/observation.dart';
+import '../native/native_observation_store.dart';
+import 'observation_codec.dart';
 
 abstract class ObservationsRepository {
   Future<void> saveObservation(Observation observation);
@@ -12,20 +14,67 @@ abstract class ObservationsRepository {
   Future<List<Observation>> getObservationsWithLocation();
 }
 
+/// Observations live in the native append-only store (`observations.log`),
+/// so saving one appends a record instead of rewriting everything saved so
+/// far. A JSON file from earlier versions is imported on first use. Where
+/// the native library is unavailable the repository keeps using the JSON
+/// file.
 class ObservationRepository implements ObservationsRepository {
   ObservationRepository._();
 
   static final ObservationRepository instance = ObservationRepository._();
   final StreamController<List<Observation>> _locationStreamController =
       StreamController<List<Observation>>.broadcast();
+  Future<NativeObservationStore?>? _store;
 
   Future<File> _getFile() async {
     final directory = await getApplicationSupportDirectory();
     return File('${directory.path}/observations.json');
   }
 
+  /// A failed open or import is not cached: the JSON file stays in place
+  /// and serves this call, and the next call tries the store again.
+  Future<NativeObservationStore?> _openStore() {
+    return _store ??= _openAndImport().catchError((Object _) {
+      _store = null;
+      return null;
+    });
+  }
+
+  Future<NativeObservationStore?> _openAndImport() async {
+    final directory = await getApplicationSupportDirectory();
+    final path = '${directory.path}/observations.log';
+    var store = NativeObservationStore.open(path);
+    if (store == null) {
+      return null;
+    }
+    final legacy = await _getFile();
+    if (await legacy.exists()) {
+      try {
+        for (final observation in await _loadJson(legacy)) {
+          _put(store, observation);
+        }
+      } finally {
+        // Closing flushes the imported records before the file they came
+        // from goes away. An import that fails is repeated by the next open;
+        // records are keyed, so nothing is duplicated.
+        store.close();
+      }
+      await legacy.delete();
+      store = NativeObservationStore.open(path);
+    }
+    return store;
+  }
+
   Future<List<Observation>> loadObservations() async {
-    final file = await _getFile();
+    final store = await _openStore();
+    if (store == null) {
+      return _loadJson(await _getFile());
+    }
+    return store.read(ObservationCodec.decode);
+  }
+
+  Future<List<Observation>> _loadJson(File file) async {
     if (!await file.exists()) {
       return [];
     }
@@ -42,17 +91,33 @@ class ObservationRepository implements ObservationsRepository {
   }
 
   Future<void> saveObservations(List<Observation> observations) async {
-    final file = await _getFile();
-    final data = observations.map((item) => item.toJson()).toList();
-    await file.writeAsString(jsonEncode(data));
+    final store = await _openStore();
+    if (store == null) {
+      final file = await _getFile();
+      final data = observations.map((item) => item.toJson()).toList();
+      await file.writeAsString(jsonEncode(data));
+    } else {
+      store.clear();
+      for (final observation in observations) {
+        _put(store, observation);
+      }
+    }
     await _emitLocationUpdate(observations);
   }
 
   @override
   Future<void> saveObservation(Observation observation) async {
-    final observations = await loadObservations();
-    observations.add(observation);
-    await saveObservations(observations);
+    final store = await _openStore();
+    if (store == null) {
+      final observations = await loadObservations();
+      observations.add(observation);
+      await saveObservations(observations);
+      return;
+    }
+    _put(store, observation);
+    if (observation.location != null) {
+      await _emitLocationUpdate();
+    }
   }
 
   Future<void> addObservation(Observation observation) async {
@@ -60,15 +125,24 @@ class ObservationRepository implements ObservationsRepository {
   }
 
   Future<void> clearObservations() async {
-    final file = await _getFile();
-    if (await file.exists()) {
-      await file.writeAsString('[]');
+    final store = await _openStore();
+    if (store != null) {
+      store.clear();
+    } else {
+      final file = await _getFile();
+      if (await file.exists()) {
+        await file.writeAsString('[]');
+      }
     }
     await _emitLocationUpdate(const []);
   }
 
   @override
   Future<List<Observation>> getObservationsWithLocation() async {
+    final store = await _openStore();
+    if (store != null) {
+      return store.read(ObservationCodec.decode, locatedOnly: true);
+    }
     final observations = await loadObservations();
     return observations.where((item) => item.location != null).toList();
   }
@@ -83,11 +157,23 @@ class ObservationRepository implements ObservationsRepository {
     yield* _locationStreamController.stream;
   }
 
+  void _put(NativeObservationStore store, Observation observation) {
+    store.put(
+      ObservationCodec.keyOf(observation),
+      ObservationCodec.recordOf(observation),
+      ObservationCodec.encode(observation),
+    );
+  }
+
   Future<void> _emitLocationUpdate([
     List<Observation>? observations,
   ]) async {
-    final list = observations ?? await loadObservations();
-    final withLocation = list.where((item) => item.location != null).toList();
+    if (!_locationStreamController.hasListener) {
+      return;
+    }
+    final withLocation = observations == null
+        ? await getObservationsWithLocation()
+        : observations.where((item) => item.location != null).toList();
     if (!_locationStreamController.isClosed) {
       _locationStreamController.add(withLocation);
     }
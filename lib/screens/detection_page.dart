@@ -4,6 +4,7 @@ import 'dart:ui' as ui;
 
 import 'package:camera/camera.dart';
 import 'package:flutter/material.dart';
+import 'package:flutter/scheduler.dart';
 import 'package:flutter/services.dart';
 import 'package:path_provider/path_provider.dart';
 import 'package:permission_handler/permission_handler.dart';
@@ -15,6 +16,7 @@ import '../models/species.dart';
 import '../models/navigation_args.dart';
 import '../native/native_yolo_engine.dart';
 import '../repositories/species_repository.dart';
+import '../services/attachment_storage_service.dart';
 
 const Color _deepGreen = Color(0xFF1F4E3D);
 const Color _accentGreen = Color(0xFF8FBFA1);
@@ -29,11 +31,16 @@ class DetectionPage extends StatefulWidget {
 }
 
 class _DetectionPageState extends State<DetectionPage>
-    with WidgetsBindingObserver {
+    with WidgetsBindingObserver, SingleTickerProviderStateMixin {
   CameraController? _camera;
   NativeYoloEngine? _nativeEngine;
-  StreamSubscription<List<NativeDetection>>? _nativeDetectionsSub;
+  // Polls the engine's shared result channel once per vsync, so boxes are
+  // painted at display rate whatever the inference rate, with no isolate
+  // message per frame.
+  late final Ticker _resultsTicker = createTicker(_onResultsTick);
+  int _lastResultSequence = 0;
   StreamSubscription<String>? _nativeErrorSub;
+  StreamSubscription<NativeFrameQuality>? _nativeQualitySub;
   late DetectionStabilityEngine _stabilityEngine;
   List<String> _labels = [];
   final SpeciesRepository _speciesRepository = SpeciesRepository.instance;
@@ -54,7 +61,15 @@ class _DetectionPageState extends State<DetectionPage>
   StableTrack? _primaryTrack;
   String? _errorMessage;
 
-  static const double _confThreshold = 0.30;
+  /// Consecutive frames the quality gate rejected, and the reason shown to
+  /// the user once the run is long enough to not be a single shaky frame.
+  int _lowQualityStreak = 0;
+  NativeQualityIssue? _qualityIssue;
+  static const int _qualityPromptFrames = 5;
+
+  // Native decode drops everything below this, so nothing under it is ever
+  // sent across the isolate boundary only to be filtered out here.
+  static const double _confThreshold = 0.45;
   static const double _nmsIoUThreshold = 0.45;
 
   @override
@@ -188,6 +203,7 @@ class _DetectionPageState extends State<DetectionPage>
       'assets/models/yolo11n_float32.tflite',
       'yolo11n_float32.tflite',
     );
+    final supportDir = await getApplicationSupportDirectory();
     final config = NativeYoloConfig(
       modelPath: modelPath,
       inputWidth: _inputWidth,
@@ -198,19 +214,48 @@ class _DetectionPageState extends State<DetectionPage>
       iouThreshold: _nmsIoUThreshold,
       useGpu: true,
       allowFp16: true,
+      autoTune: true,
+      tuningCachePath: '${supportDir.path}/yolo_tuning_cache.txt',
+      // Boxes for a frame older than this would be drawn visibly behind the
+      // preview; skip it and let the next frame through instead.
+      maxFrameAge: const Duration(milliseconds: 250),
+      // Surveys run for hours: cap inference at half the camera rate and
+      // let optical flow carry the boxes in between. With nothing in view the
+      // engine idles at 2 fps, and it backs off further if the phone heats up.
+      cadence: const NativeCadenceBudget(maxFps: 15, maxDutyCycle: 0.5),
+      // Keep inference off the little cores, where a band of preprocessing
+      // or an interpreter thread landing there stretches the whole frame, and
+      // run it just below the display threads.
+      corePlacement: NativeCorePlacement.auto,
+      threadNice: -4,
+      // Keep the last few inferred frames so a capture can use the sharpest
+      // one from just before the tap instead of whatever frame follows it.
+      frameRingSize: 4,
+      // Blurred or badly exposed frames would only add noisy votes to the
+      // stability window; skip them and tell the user instead.
+      qualityGate: NativeQualityGate.skip,
+      // Specimens usually fill a small part of the frame; once one holds
+      // still, every other inference looks at it up close.
+      autoZoom: true,
+      resultChannel: true,
     );
 
-    await _nativeDetectionsSub?.cancel();
+    _resultsTicker.stop();
     await _nativeErrorSub?.cancel();
+    await _nativeQualitySub?.cancel();
     await _nativeEngine?.dispose();
 
     _nativeEngine = await NativeYoloEngine.create(config);
-    _nativeDetectionsSub = _nativeEngine!.detections.listen(
-      _onNativeDetections,
-    );
+    _lastResultSequence = 0;
+    if (mounted) {
+      _resultsTicker.start();
+    }
     _nativeErrorSub = _nativeEngine!.errors.listen((msg) {
       debugPrint('Native engine warning: $msg');
     });
+    _nativeQualitySub = _nativeEngine!.frameQuality.listen(
+      _onFrameQuality,
+    );
   }
 
   Future<String> _materializeAsset(String assetPath, String fileName) async {
@@ -226,6 +271,27 @@ class _DetectionPageState extends State<DetectionPage>
     return file.path;
   }
 
+  void _onFrameQuality(NativeFrameQuality quality) {
+    if (!mounted) return;
+    _lowQualityStreak = quality.lowQuality ? _lowQualityStreak + 1 : 0;
+    final NativeQualityIssue? issue =
+        _lowQualityStreak >= _qualityPromptFrames ? quality.issue : null;
+    if (issue != _qualityIssue) {
+      setState(() {
+        _qualityIssue = issue;
+      });
+    }
+  }
+
+  void _onResultsTick(Duration _) {
+    final NativeResultFrame? frame = _nativeEngine?.acquireResults();
+    if (frame == null || frame.sequence == _lastResultSequence) {
+      return;
+    }
+    _lastResultSequence = frame.sequence;
+    _onNativeDetections(frame.toDetections());
+  }
+
   void _onNativeDetections(List<NativeDetection> detections) {
     if (!mounted) return;
     if (!_engineReady) return;
@@ -369,7 +435,7 @@ class _DetectionPageState extends State<DetectionPage>
 
     String? photoPath;
     try {
-      photoPath = await _capturePhoto();
+      photoPath = await _capturePhoto(track);
       if (!mounted) return;
 
       final int? classIndex = track.lockedClassId ?? track.top1ClassId;
@@ -425,7 +491,15 @@ class _DetectionPageState extends State<DetectionPage>
     }
   }
 
-  Future<String?> _capturePhoto() async {
+  Future<String?> _capturePhoto(StableTrack track) async {
+    final engine = _nativeEngine;
+    if (engine != null) {
+      final String? path = await _captureNativeStill(engine, track);
+      if (path != null) {
+        return path;
+      }
+    }
+
     final controller = _camera;
     if (controller == null || !controller.value.isInitialized) {
       _showMessage('Camera not ready. Unable to capture photo.');
@@ -451,6 +525,30 @@ class _DetectionPageState extends State<DetectionPage>
     }
   }
 
+  /// Saves the tracked specimen straight from the live stream at sensor
+  /// resolution, with its thumbnail, so the preview never stalls and nothing
+  /// is decoded again in Dart. The sharpest buffered frame of the last
+  /// second is used, since the frames right after a tap are often shaken.
+  Future<String?> _captureNativeStill(NativeYoloEngine engine, StableTrack track) async {
+    try {
+      final Directory dir = await getTemporaryDirectory();
+      final int stamp = DateTime.now().millisecondsSinceEpoch;
+      final String cropPath = '${dir.path}${Platform.pathSeparator}capture_$stamp.png';
+      final bool ok = await engine.captureStill(
+        box: track.bbox,
+        classIndex: track.lockedClassId ?? -1,
+        bestWithin: const Duration(seconds: 1),
+        cropPath: cropPath,
+        thumbnailPath: AttachmentStorageService.thumbnailPathFor(cropPath),
+      );
+      return ok ? cropPath : null;
+    } catch (e, stack) {
+      debugPrint('Native capture error: $e');
+      debugPrintStack(stackTrace: stack);
+      return null;
+    }
+  }
+
   void _showMessage(String message) {
     if (!mounted) return;
     ScaffoldMessenger.of(
@@ -482,7 +580,9 @@ class _DetectionPageState extends State<DetectionPage>
       selected,
       ResolutionPreset.medium,
       enableAudio: false,
-      imageFormatGroup: ImageFormatGroup.yuv420,
+      // iOS delivers BGRA8888 natively; the engine reads it in place.
+      imageFormatGroup:
+          Platform.isIOS ? ImageFormatGroup.bgra8888 : ImageFormatGroup.yuv420,
     );
 
     await controller.initialize();
@@ -555,14 +655,15 @@ class _DetectionPageState extends State<DetectionPage>
   @override
   void dispose() {
     WidgetsBinding.instance.removeObserver(this);
+    _resultsTicker.dispose();
     _stopStreamAndDispose();
     super.dispose();
   }
 
   Future<void> _stopStreamAndDispose() async {
     await _disposeCameraController(silently: true);
-    await _nativeDetectionsSub?.cancel();
     await _nativeErrorSub?.cancel();
+    await _nativeQualitySub?.cancel();
     try {
       await _nativeEngine?.dispose();
     } catch (_) {}
@@ -572,10 +673,35 @@ class _DetectionPageState extends State<DetectionPage>
   @override
   void didChangeAppLifecycleState(AppLifecycleState state) {
     if (state == AppLifecycleState.inactive) {
-      unawaited(_disposeCameraController());
+      unawaited(_disposeCameraController().then((_) => _suspendNativeEngine()));
     } else if (state == AppLifecycleState.resumed && _hasPermission) {
-      _initCamera().then((_) => _startImageStream());
+      _resumeNativeEngine().then((_) => _initCamera()).then((_) => _startImageStream());
+    }
+  }
+
+  // Backgrounded, the engine gives its arenas and frame buffers back but
+  // keeps the model and delegate, so coming back is not a cold start.
+  Future<void> _suspendNativeEngine() async {
+    if (mounted) {
+      _resultsTicker.stop();
+    }
+    try {
+      await _nativeEngine?.suspend();
+    } catch (_) {}
+  }
+
+  Future<void> _resumeNativeEngine() async {
+    final engine = _nativeEngine;
+    if (engine == null) {
+      return;
     }
+    try {
+      if (!await engine.resume()) {
+        await _initializeNativeEngine();
+      } else if (mounted && !_resultsTicker.isActive) {
+        _resultsTicker.start();
+      }
+    } catch (_) {}
   }
 
   @override
@@ -636,7 +762,19 @@ class _DetectionPageState extends State<DetectionPage>
                     : '${(primaryTrack.top1AvgConf * 100).toStringAsFixed(1)}%';
                 final String statusText;
                 final IconData statusIcon;
-                if (primaryTrack == null) {
+                if (_qualityIssue != null) {
+                  switch (_qualityIssue!) {
+                    case NativeQualityIssue.blurred:
+                      statusText = 'Image blurred - hold the phone steady';
+                      statusIcon = Icons.blur_on;
+                    case NativeQualityIssue.tooDark:
+                      statusText = 'Too dark - find more light';
+                      statusIcon = Icons.brightness_low;
+                    case NativeQualityIssue.tooBright:
+                      statusText = 'Overexposed - avoid direct sunlight';
+                      statusIcon = Icons.brightness_high;
+                  }
+                } else if (primaryTrack == null) {
                   statusText = 'Scanning for species...';
                   statusIcon = Icons.center_focus_strong;
                 } else if (isReady) {
@@ -2,6 +2,7 @@ import 'dart:io';
 import 'dart:ui';
 
 import 'package:flutter/material.dart';
+import 'package:flutter/scheduler.dart';
 import 'package:flutter_map/flutter_map.dart';
 import 'package:latlong2/latlong.dart';
 import 'package:url_launcher/url_launcher.dart';
@@ -10,11 +11,13 @@ import 'package:uuid/uuid.dart';
 import '../models/field_note.dart';
 import '../models/navigation_args.dart';
 import '../models/observation.dart';
+import '../native/native_cluster_index.dart';
 import '../repositories/field_notes_repository.dart';
 import '../repositories/observation_repository.dart';
 import '../repositories/species_repository.dart';
 import '../services/map_tile_cache_service.dart';
 import '../services/settings_service.dart';
+import '../utils/cluster_window.dart';
 import '../utils/formatting.dart';
 import '../widgets/forest_background.dart';
 
@@ -42,6 +45,17 @@ class MapScreenState extends State<MapScreen> with TickerProviderStateMixin {
   Map<String, String> _speciesNames = {};
   TileProvider? _tileProvider;
   List<Observation> _observationsCache = const [];
+  // Observations are clustered natively per zoom level and only the markers
+  // inside the viewport are built. Without the native library every
+  // observation gets a marker.
+  final NativeClusterIndex? _clusterIndex = NativeClusterIndex.create();
+  final ValueNotifier<List<Marker>> _observationMarkers =
+      ValueNotifier<List<Marker>>(const []);
+  Stream<List<Observation>>? _observationStream;
+  List<Observation>? _indexedObservations;
+  ClusterWindow? _clusterWindow;
+  bool _cameraReady = false;
+  bool _clusterRefreshScheduled = false;
   MapFocusRequest? _pendingFocus;
   MapPickLocationArgs? _pickArgs;
   LatLng? _pickedLocation;
@@ -86,6 +100,8 @@ class MapScreenState extends State<MapScreen> with TickerProviderStateMixin {
   void dispose() {
     _settingsService.settingsNotifier.removeListener(_settingsListener);
     _mapAnimationController?.dispose();
+    _clusterIndex?.dispose();
+    _observationMarkers.dispose();
     super.dispose();
   }
 
@@ -249,22 +265,150 @@ class MapScreenState extends State<MapScreen> with TickerProviderStateMixin {
     List<Observation> observations, {
     bool interactive = true,
   }) {
-    return observations.map((observation) {
-      final location = observation.location!;
-      return Marker(
-        width: 44,
-        height: 44,
-        point: LatLng(location.latitude, location.longitude),
-        child: GestureDetector(
-          onTap: interactive ? () => _showObservationSheet(observation) : null,
-          child: const Icon(
-            Icons.location_on,
-            color: Color(0xFF8FBFA1),
-            size: 38,
-          ),
+    return observations
+        .map(
+          (observation) =>
+              _observationMarker(observation, interactive: interactive),
+        )
+        .toList();
+  }
+
+  Marker _observationMarker(
+    Observation observation, {
+    required bool interactive,
+  }) {
+    final location = observation.location!;
+    return Marker(
+      width: 44,
+      height: 44,
+      point: LatLng(location.latitude, location.longitude),
+      child: GestureDetector(
+        onTap: interactive ? () => _showObservationSheet(observation) : null,
+        child: const Icon(
+          Icons.location_on,
+          color: Color(0xFF8FBFA1),
+          size: 38,
         ),
+      ),
+    );
+  }
+
+  Marker _clusterMarker(NativeCluster cluster, {required bool interactive}) {
+    if (!cluster.isCluster) {
+      return _observationMarker(
+        _observationsCache[cluster.point],
+        interactive: interactive,
       );
-    }).toList();
+    }
+    final point = LatLng(cluster.latitude, cluster.longitude);
+    return Marker(
+      width: 48,
+      height: 48,
+      point: point,
+      child: GestureDetector(
+        onTap: interactive
+            ? () => _animateTo(point, cluster.expansionZoom.toDouble())
+            : null,
+        child: Container(
+          alignment: Alignment.center,
+          decoration: BoxDecoration(
+            shape: BoxShape.circle,
+            color: const Color(0xFF1F4E3D).withValues(alpha: 0.92),
+            border: Border.all(color: const Color(0xFF8FBFA1), width: 2),
+          ),
+          child: Text(
+            '${cluster.count}',
+            style: const TextStyle(
+              color: Colors.white,
+              fontWeight: FontWeight.w600,
+              fontSize: 13,
+            ),
+          ),
+        ),
+      ),
+    );
+  }
+
+  /// Loads a new observation list into the cluster index, or builds a
+  /// marker per observation when there is no index.
+  void _indexObservations(List<Observation> ordered) {
+    _observationsCache = ordered;
+    final index = _clusterIndex;
+    if (index == null) {
+      _observationMarkers.value =
+          _buildMarkers(ordered, interactive: _pickArgs == null);
+      return;
+    }
+    index.load([
+      for (final observation in ordered)
+        (observation.latitude!, observation.longitude!),
+    ]);
+    _clusterWindow = null;
+    _scheduleClusterRefresh();
+  }
+
+  /// Camera callbacks can arrive while the map lays itself out, when the
+  /// marker layer must not be marked dirty; those refreshes wait a frame.
+  void _scheduleClusterRefresh() {
+    if (SchedulerBinding.instance.schedulerPhase !=
+        SchedulerPhase.persistentCallbacks) {
+      _refreshClusters();
+      return;
+    }
+    if (_clusterRefreshScheduled) {
+      return;
+    }
+    _clusterRefreshScheduled = true;
+    WidgetsBinding.instance.addPostFrameCallback((_) {
+      _clusterRefreshScheduled = false;
+      if (mounted) {
+        _refreshClusters();
+      }
+    });
+  }
+
+  /// Queries the clusters for the viewport padded by half its size on each
+  /// side, so panning only queries again once the view leaves that window
+  /// or the whole zoom level changes.
+  void _refreshClusters() {
+    final index = _clusterIndex;
+    if (index == null || !_cameraReady) {
+      return;
+    }
+    final camera = _mapController.camera;
+    final bounds = camera.visibleBounds;
+    final int zoom = camera.zoom.floor();
+    final window = _clusterWindow;
+    if (window != null &&
+        window.covers(
+          west: bounds.west,
+          south: bounds.south,
+          east: bounds.east,
+          north: bounds.north,
+          zoom: zoom,
+        )) {
+      return;
+    }
+    final ClusterWindow next = ClusterWindow.around(
+      west: bounds.west,
+      south: bounds.south,
+      east: bounds.east,
+      north: bounds.north,
+      zoom: zoom,
+    );
+    _clusterWindow = next;
+    final clusters = index.query(
+      west: next.west,
+      south: next.south,
+      east: next.east,
+      north: next.north,
+      zoom: zoom,
+    );
+    final bool interactive = _pickArgs == null;
+    _observationMarkers.value = [
+      for (final cluster in clusters)
+        _clusterMarker(cluster, interactive: interactive),
+    ];
   }
 
   String _displayNameFor(Observation observation) {
@@ -777,6 +921,7 @@ class MapScreenState extends State<MapScreen> with TickerProviderStateMixin {
 
     if (_loading) {
       _mapReady = false;
+      _cameraReady = false;
       return const Scaffold(
         body: Center(child: CircularProgressIndicator()),
       );
@@ -787,6 +932,9 @@ class MapScreenState extends State<MapScreen> with TickerProviderStateMixin {
 
     if (showLocationDisabled) {
       _mapReady = false;
+      _cameraReady = false;
+      // The stream is listened to once; the next map gets a fresh one.
+      _observationStream = null;
     }
 
     return Scaffold(
@@ -847,17 +995,20 @@ class MapScreenState extends State<MapScreen> with TickerProviderStateMixin {
               ),
             )
           : StreamBuilder<List<Observation>>(
-              stream: _observationRepository.watchObservationsWithLocation(),
+              stream: _observationStream ??=
+                  _observationRepository.watchObservationsWithLocation(),
               builder: (context, snapshot) {
                 final observations = snapshot.data ?? const <Observation>[];
                 if (snapshot.connectionState == ConnectionState.waiting &&
                     observations.isEmpty &&
                     !pickMode) {
                   _mapReady = false;
+                  _cameraReady = false;
                   return const Center(child: CircularProgressIndicator());
                 }
                 if (observations.isEmpty && !pickMode) {
                   _mapReady = false;
+                  _cameraReady = false;
                   return ForestBackground(
                     padding: const EdgeInsets.symmetric(
                       horizontal: 20,
@@ -885,13 +1036,13 @@ class MapScreenState extends State<MapScreen> with TickerProviderStateMixin {
                   );
                 }
 
-                final ordered = [...observations];
-                ordered.sort((a, b) => b.createdAt.compareTo(a.createdAt));
-                _observationsCache = ordered;
-                final markers = _buildMarkers(
-                  ordered,
-                  interactive: !pickMode,
-                );
+                if (!identical(observations, _indexedObservations)) {
+                  _indexedObservations = observations;
+                  final sorted = [...observations];
+                  sorted.sort((a, b) => b.createdAt.compareTo(a.createdAt));
+                  _indexObservations(sorted);
+                }
+                final ordered = _observationsCache;
                 final Observation? first =
                     ordered.isEmpty ? null : ordered.first;
                 final ObservationLocation? firstLocation = first?.location;
@@ -906,7 +1057,7 @@ class MapScreenState extends State<MapScreen> with TickerProviderStateMixin {
                 _mapReady = true;
                 _maybeHandlePendingFocus();
 
-                final List<Marker> overlayMarkers = [...markers];
+                final List<Marker> overlayMarkers = [];
                 final LatLng? picked = _pickedLocation;
                 if (picked != null) {
                   overlayMarkers.add(
@@ -952,6 +1103,14 @@ class MapScreenState extends State<MapScreen> with TickerProviderStateMixin {
                                 });
                               }
                             : null,
+                        onMapReady: () {
+                          _cameraReady = true;
+                          _clusterWindow = null;
+                          _scheduleClusterRefresh();
+                        },
+                        onPositionChanged: (position, hasGesture) {
+                          _scheduleClusterRefresh();
+                        },
                       ),
                       mapController: _mapController,
                       children: [
@@ -963,7 +1122,12 @@ class MapScreenState extends State<MapScreen> with TickerProviderStateMixin {
                           userAgentPackageName: 'realtime_detection_app',
                           tileProvider: _tileProvider ?? NetworkTileProvider(),
                         ),
-                        MarkerLayer(markers: overlayMarkers),
+                        ValueListenableBuilder<List<Marker>>(
+                          valueListenable: _observationMarkers,
+                          builder: (context, markers, _) => MarkerLayer(
+                            markers: [...markers, ...overlayMarkers],
+                          ),
+                        ),
                       ],
                     ),
                     if (pickMode)
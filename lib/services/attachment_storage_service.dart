@@ -15,6 +15,17 @@ class AttachmentStorageService {
   static const String _thumbnailPrefix = 'thumb_';
   final Uuid _uuid = const Uuid();
 
+  /// Where a native capture writes the thumbnail for [imagePath]; picked up
+  /// by [saveImageToNoteFolder] instead of decoding the photo again.
+  static String thumbnailPathFor(String imagePath) {
+    final int slash = imagePath.lastIndexOf(Platform.pathSeparator);
+    final String dir = slash == -1 ? '' : imagePath.substring(0, slash + 1);
+    final String name = imagePath.substring(slash + 1);
+    final int dot = name.lastIndexOf('.');
+    final String stem = dot == -1 ? name : name.substring(0, dot);
+    return '$dir$_thumbnailPrefix$stem.png';
+  }
+
   Future<Directory> _getBaseDir() async {
     final directory = await getApplicationSupportDirectory();
     final baseDir = Directory('${directory.path}/$_baseFolderName');
@@ -48,7 +59,15 @@ class AttachmentStorageService {
     final savedFile = await imageFile.copy(filePath);
     String? thumbnailPath;
     try {
-      thumbnailPath = await _generateThumbnail(savedFile, noteDir, attachmentId);
+      final File nativeThumbnail = File(thumbnailPathFor(imageFile.path));
+      if (await nativeThumbnail.exists()) {
+        final copied = await nativeThumbnail.copy(
+          '${noteDir.path}${Platform.pathSeparator}$_thumbnailPrefix$attachmentId.png',
+        );
+        thumbnailPath = copied.path;
+      } else {
+        thumbnailPath = await _generateThumbnail(savedFile, noteDir, attachmentId);
+      }
     } catch (_) {
       thumbnailPath = null;
     }
@@ -0,0 +1,66 @@
+/// The padded viewport and whole zoom level the map's cluster markers were
+/// queried for. While the view stays inside it at the same level, the
+/// markers already cover it and the index is not queried again.
+///
+/// Longitudes are unwrapped: a view across the antimeridian has its [east]
+/// moved past 180 instead of below [west], so the window is never inverted.
+/// The native index wraps them back.
+class ClusterWindow {
+  final double west;
+  final double south;
+  final double east;
+  final double north;
+  final int zoom;
+
+  const ClusterWindow({
+    required this.west,
+    required this.south,
+    required this.east,
+    required this.north,
+    required this.zoom,
+  });
+
+  /// The view padded by half its size on each side.
+  factory ClusterWindow.around({
+    required double west,
+    required double south,
+    required double east,
+    required double north,
+    required int zoom,
+  }) {
+    final double unwrappedEast = _unwrapEast(west, east);
+    final double padLon = (unwrappedEast - west) / 2;
+    final double padLat = (north - south) / 2;
+    return ClusterWindow(
+      west: west - padLon,
+      south: south - padLat,
+      east: unwrappedEast + padLon,
+      north: north + padLat,
+      zoom: zoom,
+    );
+  }
+
+  /// Whether the view lies inside the window at the same zoom level. The
+  /// view may be on either side of the antimeridian from the window.
+  bool covers({
+    required double west,
+    required double south,
+    required double east,
+    required double north,
+    required int zoom,
+  }) {
+    if (zoom != this.zoom || south < this.south || north > this.north) {
+      return false;
+    }
+    final double unwrappedEast = _unwrapEast(west, east);
+    for (final double shift in const [-360.0, 0.0, 360.0]) {
+      if (west + shift >= this.west && unwrappedEast + shift <= this.east) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  static double _unwrapEast(double west, double east) =>
+      east < west ? east + 360 : east;
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstdint>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Spatial index and zoom-level clustering for the observations map. Points
+// are loaded once; for every zoom from 0 to max_zoom the index merges points
+// closer than radius_px screen pixels into weighted clusters, and above
+// max_zoom it returns the points themselves. A query returns only what falls
+// inside a viewport at one zoom, so the map builds one marker per visible
+// cluster instead of one per observation.
+//
+// An index is not thread-safe: use each handle from one thread at a time.
+
+// A marker at the queried zoom. For a lone point count is 1 and point is its
+// position in the loaded array; for a cluster point is one of its members.
+// expansion_zoom is the lowest zoom at which the cluster splits.
+struct YoloCluster {
+  double latitude;
+  double longitude;
+  int32_t count;
+  int32_t point;
+  int32_t expansion_zoom;
+};
+
+// |tile_px| is the map's tile size in pixels; max_zoom is clamped to 0..24.
+// Null on failure.
+void* YoloClusterIndexCreate(float radius_px, int32_t tile_px, int32_t max_zoom);
+
+void YoloClusterIndexDestroy(void* index);
+
+// Replaces the indexed points with |count| latitude/longitude pairs from
+// |coordinates|. Pairs that are not finite are left out. Returns 0, or -1 for
+// invalid arguments.
+int32_t YoloClusterIndexLoad(void* index, const double* coordinates, int32_t count);
+
+// Points |*out| at the clusters and points inside the box at |zoom| and
+// returns how many there are (negative on failure). west may exceed east for
+// a box across the antimeridian. The entries stay valid until the next call
+// on the index.
+int32_t YoloClusterIndexQuery(void* index, double west, double south, double east,
+                              double north, int32_t zoom, const YoloCluster** out);
+
+#ifdef __cplusplus
+}
+#endif
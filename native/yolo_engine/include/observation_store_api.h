@@ -0,0 +1,91 @@
+#pragma once
+
+#include <cstdint>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Append-only record log behind the app's saved observations. Each record is
+// a key, a few fixed fields the list and map queries filter on, and an opaque
+// payload the app encodes. Saving appends one record, so it costs the same
+// however many are stored; a later record with the same key replaces the
+// earlier one. Reads go through a memory mapping of the file and touch only
+// the records they return.
+//
+// Every record carries a checksum, so a save cut short by a crash or power
+// loss is dropped on the next open along with anything after it. A clean
+// close appends an index of the live records, which lets the next open skip
+// the scan. Once replaced and erased records outweigh live ones, a background
+// thread rewrites the live ones into a fresh file and swaps it in. That same
+// thread flushes appends to storage, so saving never waits on the disk.
+//
+// A store is not thread-safe: use each handle from one thread at a time.
+
+// Set in YoloStoreRecord.flags.
+#define YOLO_STORE_HAS_LOCATION 1u
+#define YOLO_STORE_HAS_CLASS_INDEX 2u
+
+struct YoloStoreRecord {
+  int64_t created_at_us;
+  double latitude;
+  double longitude;
+  // NaN when unknown.
+  double accuracy_meters;
+  int32_t class_index;
+  uint32_t flags;
+};
+
+// A live record. key and payload point into the store's mapping.
+struct YoloStoreEntry {
+  YoloStoreRecord record;
+  const uint8_t* key;
+  const uint8_t* payload;
+  int32_t key_bytes;
+  int32_t payload_bytes;
+};
+
+// opened_from_index is 1 when the last open read a clean-close index and 0
+// when it scanned the records. recovered_bytes is what that scan cut off a
+// damaged tail.
+struct YoloStoreStats {
+  int64_t live_records;
+  int64_t file_bytes;
+  int64_t dead_bytes;
+  int64_t recovered_bytes;
+  int32_t compactions;
+  int32_t opened_from_index;
+};
+
+// Opens or creates the store at |path|; null on failure. A file left by an
+// interrupted compaction next to it (|path| + ".compact") is removed.
+void* YoloStoreOpen(const char* path);
+
+// Waits for a running compaction, writes the index and closes the file.
+void YoloStoreClose(void* store);
+
+// Appends |record| and |payload| under |key| (1 to 65535 bytes). Returns 0,
+// -1 for invalid arguments or -2 when the write failed, in which case the
+// store is unchanged.
+int32_t YoloStorePut(void* store, const uint8_t* key, int32_t key_bytes,
+                     const YoloStoreRecord* record, const uint8_t* payload,
+                     int32_t payload_bytes);
+
+// Appends a deletion for |key|. Returns 0 (also when the key is not stored),
+// -1 for invalid arguments or -2 when the write failed.
+int32_t YoloStoreErase(void* store, const uint8_t* key, int32_t key_bytes);
+
+// Drops every record. Returns 0, or -2 when the file could not be truncated.
+int32_t YoloStoreClear(void* store);
+
+// Points |*out| at the live records whose flags include all of
+// |required_flags|, oldest first, and returns how many there are (negative
+// on failure). The entries and the bytes they point to stay valid until the
+// next call on the store.
+int32_t YoloStoreAcquire(void* store, uint32_t required_flags, const YoloStoreEntry** out);
+
+int32_t YoloStoreGetStats(void* store, YoloStoreStats* out);
+
+#ifdef __cplusplus
+}
+#endif
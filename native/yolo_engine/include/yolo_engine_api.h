@@ -15,11 +15,454 @@ struct YoloDetection {
   int32_t class_index;
 };
 
+#define YOLO_CLASSIFIER_MAX_TOP_K 5
+
+// Second-stage classifier result for one detection, best first. count is 0
+// for detections the classifier did not see (below classifier_min_score, or
+// a tracked frame with no remembered result for that box).
+struct YoloClassification {
+  int32_t count;
+  int32_t class_index[YOLO_CLASSIFIER_MAX_TOP_K];
+  float score[YOLO_CLASSIFIER_MAX_TOP_K];
+};
+
+// Timestamps are YoloEngineNowNs() nanoseconds. capture_time_ns echoes the
+// frame descriptor (0 when the caller did not stamp it); the rest are taken
+// by the engine when it picked the frame up, started inference and finished
+// decoding.
+//
+// predicted is 1 when the boxes were propagated from the last inferred frame
+// by the tracker instead of running the model; track_confidence is the
+// tracker's confidence for that frame (0 when it did not run).
+//
+// classifications runs parallel to detections when a classifier model is
+// configured, and is null otherwise.
+//
+// The quality fields are filled when the quality gate is on (see
+// YoloEngineConfig.quality_gate): sharpness is a Laplacian variance in
+// squared luma units, mean_luma is 0-255, and the fractions are the share of
+// samples crushed to black (<= 16) or blown to white (>= 240). low_quality is
+// 1 when the frame failed the gate.
+//
+// roi_* is the region the model ran on, normalized to the upright frame:
+// 0, 0, 1, 1 for whole-frame and tracked frames. Boxes are always in
+// whole-frame detector input coordinates, whatever the region.
 struct YoloDetections {
   YoloDetection* detections;
   int32_t count;
+  int64_t capture_time_ns;
+  int64_t receive_time_ns;
+  int64_t inference_start_ns;
+  int64_t decode_end_ns;
+  int32_t predicted;
+  float track_confidence;
+  YoloClassification* classifications;
+  float sharpness;
+  float mean_luma;
+  float dark_fraction;
+  float bright_fraction;
+  int32_t low_quality;
+  float roi_left;
+  float roi_top;
+  float roi_right;
+  float roi_bottom;
+};
+
+#define YOLO_RESULT_MAX_DETECTIONS 256
+
+// One processed frame as published to the result channel. sequence counts
+// published frames from 1; 0 means nothing has been published yet. Fields
+// mirror YoloDetections, with the arrays held inline so the whole frame is
+// one fixed-size block; frames with more than YOLO_RESULT_MAX_DETECTIONS
+// boxes keep the highest-scoring ones. classifications is meaningful only
+// when has_classifications is 1.
+struct YoloResultFrame {
+  uint64_t sequence;
+  int32_t count;
+  int32_t predicted;
+  float track_confidence;
+  int32_t low_quality;
+  int64_t capture_time_ns;
+  int64_t receive_time_ns;
+  int64_t inference_start_ns;
+  int64_t decode_end_ns;
+  float roi_left;
+  float roi_top;
+  float roi_right;
+  float roi_bottom;
+  int32_t has_classifications;
+  YoloDetection detections[YOLO_RESULT_MAX_DETECTIONS];
+  YoloClassification classifications[YOLO_RESULT_MAX_DETECTIONS];
+};
+
+// Extensible creation parameters. Always initialize with
+// YoloEngineConfigInitDefault() before overriding fields.
+struct YoloEngineConfig {
+  const char* model_path;
+  int32_t input_width;
+  int32_t input_height;
+  int32_t num_threads;
+  int32_t max_detections;
+  float confidence_threshold;
+  float iou_threshold;
+  int32_t use_gpu;
+  int32_t allow_fp16;
+  // Benchmark CPU/XNNPACK/GPU (GPU only when use_gpu is set) and thread
+  // counts up to num_threads on first run and reuse the decision cached at
+  // |tuning_cache_path| on later launches with the same settings.
+  int32_t auto_tune;
+  const char* tuning_cache_path;
+  // Run the model on every Nth frame and move the last detections with
+  // optical flow in between. 1 disables tracking. A frame whose tracking
+  // confidence falls below |min_track_confidence| is inferred instead.
+  int32_t inference_interval;
+  float min_track_confidence;
+  // Optional crop classifier (input [batch, h, w, 3], output [batch,
+  // classes]) run on detections scoring at least |classifier_min_score|.
+  // Results are remembered per box, so it only runs for new or changed ones.
+  const char* classifier_model_path;
+  int32_t classifier_top_k;
+  float classifier_min_score;
+  // Number of recent inferred frames with detections kept at full resolution
+  // for YoloEngineCaptureBest(). Each costs one upright RGB frame of memory;
+  // 0 disables the ring.
+  int32_t frame_ring_size;
+  // Cheap blur/exposure check on a decimated luma grid before any
+  // preprocessing (YoloQualityGate). A frame fails when its sharpness is
+  // below |min_sharpness| or more than |max_clipped_fraction| of its samples
+  // are crushed to black or blown to white.
+  int32_t quality_gate;
+  float min_sharpness;
+  float max_clipped_fraction;
+  // Once the best detection has held still for a few inferred frames,
+  // alternate whole-frame passes with passes on a crop centred on it, so the
+  // subject reaches the model at a multiple of its whole-frame resolution.
+  // Ignored for frames that carry their own region of interest.
+  int32_t auto_zoom;
+  // Also publish every processed frame's results into a shared triple
+  // buffer the UI thread reads with YoloEngineAcquireResults().
+  int32_t result_channel;
+  // Cadence governor: instead of inferring every frame it can, the engine
+  // spaces inferences to fit the tightest of |governor_max_fps|, a duty
+  // cycle (share of wall time spent inferring) and a process CPU time per
+  // second; 0 disables a cap. With nothing detected for
+  // |governor_idle_after_ms| it drops to |governor_idle_fps| until something
+  // appears, and it stretches the spacing when invoke latency drifts above
+  // its warm baseline (thermal throttling). Frames in between are tracked
+  // when there are boxes to move and skipped with
+  // YOLO_ENGINE_FRAME_GOVERNED otherwise. Overrides inference_interval.
+  int32_t governor;
+  float governor_max_fps;
+  float governor_max_duty_cycle;
+  float governor_max_cpu_ms_per_s;
+  int32_t governor_idle_after_ms;
+  float governor_idle_fps;
+  // Where the engine's threads run (YoloCorePlacement): the frame thread
+  // while it is inside the engine, the preprocessing workers, the model
+  // loader, and the interpreter threads, which inherit the mask from the
+  // thread that builds the interpreter. |core_mask| is the CPU bit mask for
+  // kYoloCorePlacementMask. A non-zero |thread_nice| (-20 to 19, lower is
+  // more urgent) is applied to the same threads; raising priority may need
+  // permissions the app lacks, in which case it is left alone.
+  int32_t core_placement;
+  uint64_t core_mask;
+  int32_t thread_nice;
+};
+
+// Decode settings that can change while frames are flowing; see
+// YoloEngineUpdateDecodeConfig. confidence_threshold, iou_threshold and
+// max_detections replace the values given at creation.
+//
+// class_thresholds and class_enabled are optional arrays of class_count
+// entries indexed by detector class. A threshold of 0 or less keeps
+// confidence_threshold for that class. A class with class_enabled 0 is left
+// out of the per-prediction class-score reduction, so it neither appears in
+// results nor hides a lower-scoring enabled class on the same prediction.
+// Classes past class_count use confidence_threshold, and are disabled when
+// class_enabled is given.
+struct YoloDecodeConfig {
+  float confidence_threshold;
+  float iou_threshold;
+  int32_t max_detections;
+  int32_t class_count;
+  const float* class_thresholds;
+  const uint8_t* class_enabled;
+};
+
+enum YoloQualityGate {
+  kYoloQualityGateOff = 0,
+  // Report quality and flag failing frames, but run them anyway.
+  kYoloQualityGateFlag = 1,
+  // Skip failing frames with YOLO_ENGINE_FRAME_LOW_QUALITY.
+  kYoloQualityGateSkip = 2,
+};
+
+enum YoloDelegate {
+  kYoloDelegateCpu = 0,
+  kYoloDelegateXnnpack = 1,
+  kYoloDelegateGpu = 2,
+};
+
+enum YoloPixelFormat {
+  kYoloPixelFormatYuv420 = 0,
+  kYoloPixelFormatRgb = 1,
+  kYoloPixelFormatRgba = 2,
+  kYoloPixelFormatBgra = 3,
+  kYoloPixelFormatBgr = 4,
+};
+
+// One input frame in any supported pixel format. YUV420 uses planes 0-2
+// (Y, U, V) with row_strides[0] for luma, row_strides[1] and
+// pixel_strides[1] for both chroma planes. Packed formats use plane 0 only:
+// interleaved pixels with row_strides[0] bytes per row (at least
+// width * channels); the pixel stride follows from the format.
+//
+// capture_time_ns and deadline_ns use the YoloEngineNowNs() clock; 0 means
+// unset. A frame whose deadline has passed is dropped before preprocessing,
+// or before inference if it expires while being preprocessed.
+//
+// roi_* optionally restricts inference to a region, normalized to the
+// upright (rotated) frame; the region is cropped before the resize, so it
+// gets the model's full input resolution, and boxes come back in whole-frame
+// coordinates. An empty region (all zero) runs on the whole frame.
+struct YoloFrameDescriptor {
+  int32_t format;
+  int32_t width;
+  int32_t height;
+  int32_t rotation_degrees;
+  const uint8_t* planes[3];
+  int32_t row_strides[3];
+  int32_t pixel_strides[3];
+  int64_t capture_time_ns;
+  int64_t deadline_ns;
+  float roi_left;
+  float roi_top;
+  float roi_right;
+  float roi_bottom;
+};
+
+struct YoloTuningInfo {
+  int32_t delegate;
+  int32_t num_threads;
+  float invoke_us;
+  int32_t from_cache;
+  int32_t candidates_tested;
+};
+
+enum YoloCorePlacement {
+  kYoloCorePlacementOff = 0,
+  // The fastest cores by cpu_capacity (or maximum frequency), enough for
+  // num_threads where the device has them and never its slowest cluster.
+  // Leaves affinity alone on symmetric CPUs.
+  kYoloCorePlacementAuto = 1,
+  kYoloCorePlacementMask = 2,
+};
+
+// Placement in effect: cpu_mask is the CPUs the engine's threads are held to
+// (0: not pinned), core_classes the distinct core capacities found.
+// workers_pinned counts preprocessing workers placed as asked;
+// frame_thread_pinned and priority_applied say whether the frame thread's
+// last entry into the engine got cpu_mask and nice.
+struct YoloThreadPlacement {
+  int32_t mode;
+  int32_t nice;
+  uint64_t cpu_mask;
+  int32_t core_classes;
+  int32_t workers_pinned;
+  int32_t frame_thread_pinned;
+  int32_t priority_applied;
+};
+
+// Latency summary for one pipeline stage, in microseconds.
+struct YoloStageStats {
+  uint64_t count;
+  float mean_us;
+  float p50_us;
+  float p90_us;
+  float p99_us;
+  float max_us;
+};
+
+enum YoloGovernorMode {
+  kYoloGovernorOff = 0,
+  kYoloGovernorActive = 1,
+  // Nothing detected recently; running at the idle rate.
+  kYoloGovernorIdle = 2,
+  // Invoke latency drifted above its baseline; spacing stretched to match.
+  kYoloGovernorThrottled = 3,
+};
+
+// Which budget set the current spacing.
+enum YoloGovernorLimit {
+  kYoloGovernorLimitNone = 0,
+  kYoloGovernorLimitMaxFps = 1,
+  kYoloGovernorLimitDutyCycle = 2,
+  kYoloGovernorLimitCpuTime = 3,
+  kYoloGovernorLimitIdle = 4,
+  kYoloGovernorLimitThermal = 5,
+};
+
+// Cadence governor state as of its last decision. interval_ms is the
+// spacing it enforces between inferences (0: every frame). inference_ms is
+// the smoothed wall-clock cost of an inferred frame, and duty_cycle and
+// cpu_ms_per_s what inference actually consumed at the recent cadence.
+// invoke_drift is recent invoke latency over the best seen since the model
+// was loaded or resumed.
+struct YoloGovernorState {
+  int32_t mode;
+  int32_t limit;
+  float interval_ms;
+  float inference_ms;
+  float duty_cycle;
+  float cpu_ms_per_s;
+  float invoke_drift;
+  uint64_t mode_changes;
+};
+
+struct YoloEngineStats {
+  YoloStageStats yuv_to_rgb;
+  YoloStageStats rotate;
+  YoloStageStats resize;
+  YoloStageStats invoke;
+  YoloStageStats decode;
+  YoloStageStats total;
+  uint64_t frames_processed;
+  uint64_t frames_dropped;
+  uint64_t candidates_pre_nms;
+  uint64_t candidates_post_nms;
+  uint64_t allocations;
+  // Frames dropped because their deadline passed (also in frames_dropped).
+  uint64_t frames_expired;
+  // Capture to engine pickup, and capture to end of decode, for frames that
+  // carry a capture timestamp.
+  YoloStageStats queue_wait;
+  YoloStageStats capture_to_result;
+  // Frames answered by the tracker instead of inference (also in
+  // frames_processed), and the time spent tracking them.
+  uint64_t frames_tracked;
+  YoloStageStats track;
+  // Crops run through the classifier, and detections that reused a
+  // remembered result instead.
+  uint64_t crops_classified;
+  uint64_t classification_cache_hits;
+  YoloStageStats classify;
+  // Frames failing the quality gate (skipped ones are also in
+  // frames_dropped), and the time spent checking.
+  uint64_t frames_low_quality;
+  YoloStageStats quality;
+  // Inferred frames that ran on a region rather than the whole frame.
+  uint64_t frames_zoomed;
+  // Frames the cadence governor held back from inference, tracked or
+  // skipped (the tracked ones are also in frames_tracked), and its state.
+  uint64_t frames_governed;
+  YoloGovernorState governor;
+  YoloThreadPlacement placement;
+};
+
+// Native memory attributable to the engine, in bytes. Steady state is what a
+// running stream holds; peak adds the scratch high-water mark.
+//
+// suspended is 1 between YoloEngineSuspend and YoloEngineResume. The last
+// suspend's duration and the drop in process resident memory it caused, and
+// the last resume's duration (warm-up invoke included), are kept after.
+struct YoloMemoryStats {
+  uint64_t scratch_bytes;
+  uint64_t scratch_peak_bytes;
+  uint64_t tensor_arena_bytes;
+  uint64_t model_bytes;
+  uint64_t steady_state_bytes;
+  uint64_t peak_bytes;
+  uint64_t process_resident_bytes;
+  int32_t suspended;
+  float suspend_ms;
+  float resume_ms;
+  uint64_t suspend_released_bytes;
 };
 
+enum YoloModelSwapState {
+  kYoloModelSwapIdle = 0,
+  kYoloModelSwapLoading = 1,
+  // Loaded and warmed up; adopted at the start of the next frame.
+  kYoloModelSwapReady = 2,
+  kYoloModelSwapDone = 3,
+  kYoloModelSwapFailed = 4,
+};
+
+// Progress and timing of the latest YoloEngineSwapModel() call. load_ms
+// covers reading the model and building the interpreter, warmup_ms the first
+// invoke (both on the loader thread). switch_us is what the frame thread
+// spent switching over, request_to_switch_ms the whole wait from the call to
+// the first frame on the new model, and release_ms freeing the old
+// interpreter (loader thread again).
+struct YoloModelSwapInfo {
+  int32_t state;
+  int32_t swaps_completed;
+  float load_ms;
+  float warmup_ms;
+  float switch_us;
+  float request_to_switch_ms;
+  float release_ms;
+};
+
+// Still capture from the live stream. The box is in detector input
+// coordinates (as returned in YoloDetection); an empty box captures the whole
+// frame. |margin| widens the box by that fraction of its size on each side.
+// The crop is written as PNG to |crop_path|, downsampled to fit
+// |crop_max_side| (0 keeps full resolution), and, when |thumbnail_path| is
+// set, a thumbnail fitting |thumbnail_max_side| next to it.
+struct YoloCaptureRequest {
+  YoloDetection box;
+  float margin;
+  int32_t crop_max_side;
+  int32_t thumbnail_max_side;
+  const char* crop_path;
+  const char* thumbnail_path;
+};
+
+#define YOLO_CAPTURE_PENDING 0
+#define YOLO_CAPTURE_DONE 1
+#define YOLO_CAPTURE_FAILED (-1)
+
+// Status returned by the frame entry points for a frame dropped because its
+// deadline had passed. Not an error; |out| is left empty.
+#define YOLO_ENGINE_FRAME_EXPIRED (-3)
+
+// Status for a frame skipped by kYoloQualityGateSkip. Not an error; |out|
+// carries the frame's quality but no detections.
+#define YOLO_ENGINE_FRAME_LOW_QUALITY (-4)
+
+// Status for a frame submitted while the engine is suspended; |out| is left
+// empty.
+#define YOLO_ENGINE_FRAME_SUSPENDED (-5)
+
+// Status for a frame the cadence governor skipped: no inference was due and
+// there were no boxes to track. Not an error; |out| is left empty and the
+// previous results stand.
+#define YOLO_ENGINE_FRAME_GOVERNED (-6)
+
+enum YoloRecordingState {
+  kYoloRecordingIdle = 0,
+  kYoloRecordingActive = 1,
+  // Reached its max_bytes; later frames were left out.
+  kYoloRecordingFull = 2,
+  // A write failed; the file ends at the last complete frame.
+  kYoloRecordingFailed = 3,
+};
+
+// Progress of the current or last recording. frames_dropped counts frames
+// left out because the writer fell behind, the size limit was reached or a
+// write failed; buffer_bytes is the memory held for frames in flight.
+struct YoloRecordingInfo {
+  int32_t state;
+  int64_t frames_recorded;
+  int64_t frames_dropped;
+  int64_t bytes_written;
+  int64_t buffer_bytes;
+};
+
+// Monotonic clock used for frame timestamps and deadlines.
+int64_t YoloEngineNowNs(void);
+
 void* YoloEngineCreate(const char* model_path,
                        int32_t input_width,
                        int32_t input_height,
@@ -30,8 +473,72 @@ void* YoloEngineCreate(const char* model_path,
                        int32_t use_gpu,
                        int32_t allow_fp16);
 
+void YoloEngineConfigInitDefault(YoloEngineConfig* config);
+
+void* YoloEngineCreateWithConfig(const YoloEngineConfig* config);
+
 void YoloEngineDestroy(void* handle);
 
+// Loads |model_path| on a background thread with the running delegate and
+// thread settings while the current model keeps serving frames, then switches
+// over between two frames. The new model must take the same input shape.
+// Returns 0 when loading started and -2 while a previous swap is pending or
+// the engine is suspended.
+int32_t YoloEngineSwapModel(void* handle, const char* model_path);
+
+int32_t YoloEngineGetModelSwapInfo(void* handle, YoloModelSwapInfo* out);
+
+// Copies |config| on the calling thread and hands it to the frame thread
+// without locking; it applies from the start of the next frame. Safe to call
+// from any thread, including while a frame is being processed. A later call
+// before that frame replaces an earlier one. Returns 0, or -1 for invalid
+// arguments.
+int32_t YoloEngineUpdateDecodeConfig(void* handle, const YoloDecodeConfig* config);
+
+// Releases memory while the app is backgrounded without a cold start on
+// return. Suspend deletes the interpreters (freeing their tensor arenas) and
+// frees the scratch arena, tracker pyramids and frame ring, but keeps the
+// memory-mapped model, the delegate objects and the tuning decision. Frames
+// are refused with YOLO_ENGINE_FRAME_SUSPENDED until Resume rebuilds the
+// interpreters and runs one warm-up invoke; per-stream buffers are
+// re-reserved by the first frame after. Both return 0 on success (or when
+// already in that state); Suspend returns -2 while a model swap is loading
+// and Resume -2 when the interpreter cannot be rebuilt, leaving the engine
+// suspended. Call between frames. YoloMemoryStats reports the timings.
+int32_t YoloEngineSuspend(void* handle);
+int32_t YoloEngineResume(void* handle);
+
+// Queues a still from the next processed frame at full sensor resolution,
+// without interrupting the stream. Only the crop's pixels are copied on the
+// frame thread; resampling and PNG encoding run on a writer thread. Returns a
+// capture id (> 0) for YoloEngineGetCaptureStatus, or -2 while a previous
+// request is still waiting for a frame. Call between frames.
+int32_t YoloEngineRequestCapture(void* handle, const YoloCaptureRequest* request);
+
+// Like YoloEngineRequestCapture, but takes the still from the frame ring:
+// among frames from the last |window_ms| whose detections overlap
+// request->box (same class_index unless it is negative), the one scoring
+// highest on sharpness (Laplacian variance of the box's luma) times detector
+// score is cropped at that frame's box. Falls back to the next frame when the
+// ring is disabled or holds no match. Call between frames.
+int32_t YoloEngineCaptureBest(void* handle, const YoloCaptureRequest* request, int32_t window_ms);
+
+// YOLO_CAPTURE_PENDING until the files are written, then YOLO_CAPTURE_DONE or
+// YOLO_CAPTURE_FAILED; a finished status is reported once. Unread statuses
+// are kept for the 32 most recently finished captures; older and unknown ids
+// read as YOLO_CAPTURE_FAILED.
+int32_t YoloEngineGetCaptureStatus(void* handle, int32_t capture_id);
+
+// Gives up on a capture, e.g. after the caller's timeout, and forgets its
+// status. Returns the status it had: YOLO_CAPTURE_DONE means the files were
+// already written and are left to the caller; YOLO_CAPTURE_PENDING means the
+// capture was dropped and none of its files remain, even if the writer was
+// part way through them. Call between frames.
+int32_t YoloEngineCancelCapture(void* handle, int32_t capture_id);
+
+// Reports the delegate/thread configuration the engine is running with.
+int32_t YoloEngineGetTuningInfo(void* handle, YoloTuningInfo* out);
+
 int32_t YoloEngineProcessYuvFrame(void* handle,
                                   const uint8_t* y_plane,
                                   const uint8_t* u_plane,
@@ -44,8 +551,56 @@ int32_t YoloEngineProcessYuvFrame(void* handle,
                                   int32_t rotation_degrees,
                                   YoloDetections* out);
 
+// Format-generic entry point; YoloEngineProcessYuvFrame is equivalent to
+// calling this with a kYoloPixelFormatYuv420 descriptor.
+int32_t YoloEngineProcessFrame(void* handle, const YoloFrameDescriptor* frame,
+                               YoloDetections* out);
+
 void YoloEngineReleaseDetections(YoloDetections* detections);
 
+// Newest frame published to the result channel (see
+// YoloEngineConfig.result_channel), or null when the channel is off. Reads
+// never block the frame thread and never allocate: the engine writes into
+// one of three slots and swaps it in with a single atomic exchange, and this
+// call takes the freshest one with another. The returned frame stays intact
+// until the next call, which may return the same frame again (compare
+// sequence). Meant for one reader thread, typically polling on vsync.
+const YoloResultFrame* YoloEngineAcquireResults(void* handle);
+
+int32_t YoloEngineGetStats(void* handle, YoloEngineStats* out);
+
+void YoloEngineResetStats(void* handle);
+
+int32_t YoloEngineGetMemoryStats(void* handle, YoloMemoryStats* out);
+
+// Starts recording per-stage spans, discarding any previous trace. The first
+// |max_events| spans are kept in a preallocated buffer; later ones are
+// counted as dropped. Call between frames.
+int32_t YoloEngineStartTrace(void* handle, int32_t max_events);
+
+void YoloEngineStopTrace(void* handle);
+
+// Writes the recorded spans as Chrome/Perfetto trace-event JSON. Returns the
+// number of spans written or a negative value on failure.
+int32_t YoloEngineDumpTrace(void* handle, const char* path);
+
+// Records every submitted frame (planes without row padding, strides,
+// rotation, region, timestamps) with the status and detections it was
+// answered with into |path|, for replaying field sessions off the device
+// (tools/replay.cc). Frames are copied on the frame thread and written by a
+// background thread into a chunked file laid out so a reader can map it and
+// pass the planes back to the engine in place; see frame_recorder.h. Frames
+// are left out rather than stalling the stream when the writer falls behind,
+// and recording ends once the file would pass |max_bytes| (0 for no limit).
+// Starting again ends the previous recording. Returns 0, -1 for invalid
+// arguments or -2 when the file cannot be created. Call between frames.
+int32_t YoloEngineStartRecording(void* handle, const char* path, int64_t max_bytes);
+
+// Writes out frames still queued and closes the file.
+void YoloEngineStopRecording(void* handle);
+
+int32_t YoloEngineGetRecordingInfo(void* handle, YoloRecordingInfo* out);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,335 @@
+#include "auto_tuner.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <set>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "engine_stats.h"
+#include "log.h"
+#include "yolo_engine.h"
+
+#if defined(__ANDROID__)
+#include <sys/system_properties.h>
+#elif defined(__APPLE__)
+#include <sys/sysctl.h>
+#endif
+
+namespace yolo {
+
+namespace {
+
+constexpr int kWarmupRuns = 2;
+constexpr int kTimedRuns = 5;
+// An output element matches the reference when |a - b| <= kAbsTolerance +
+// kRelTolerance * |b|; a candidate may miss on at most kMaxMismatchFraction of
+// elements (fp16 GPU kernels drift on a handful of near-tie logits).
+constexpr float kAbsTolerance = 0.01f;
+constexpr float kRelTolerance = 0.02f;
+constexpr double kMaxMismatchFraction = 0.001;
+
+constexpr uint64_t kFnvOffset = 1469598103934665603ull;
+constexpr uint64_t kFnvPrime = 1099511628211ull;
+
+uint64_t Fnv1a(uint64_t hash, const char* data, size_t size) {
+  for (size_t i = 0; i < size; ++i) {
+    hash ^= static_cast<uint8_t>(data[i]);
+    hash *= kFnvPrime;
+  }
+  return hash;
+}
+
+std::string ToHex(uint64_t value) {
+  char buffer[17];
+  std::snprintf(buffer, sizeof(buffer), "%016llx", static_cast<unsigned long long>(value));
+  return buffer;
+}
+
+std::string ReadFirstLine(const std::string& path) {
+  std::ifstream in(path);
+  std::string line;
+  std::getline(in, line);
+  return line;
+}
+
+#if defined(__ANDROID__)
+std::string SystemProperty(const char* name) {
+  char value[PROP_VALUE_MAX] = {0};
+  __system_property_get(name, value);
+  return value;
+}
+#endif
+
+std::string RawDeviceDescription() {
+  std::ostringstream out;
+  out << "cores=" << std::thread::hardware_concurrency();
+#if defined(__ANDROID__)
+  out << ";model=" << SystemProperty("ro.product.model")
+      << ";board=" << SystemProperty("ro.board.platform")
+      << ";build=" << SystemProperty("ro.build.fingerprint");
+#elif defined(__APPLE__)
+  char machine[64] = {0};
+  size_t size = sizeof(machine);
+  if (sysctlbyname("hw.machine", machine, &size, nullptr, 0) == 0) {
+    out << ";machine=" << machine;
+  }
+#endif
+#if defined(__linux__)
+  std::ifstream cpuinfo("/proc/cpuinfo");
+  std::string line;
+  while (std::getline(cpuinfo, line)) {
+    if (line.rfind("model name", 0) == 0 || line.rfind("Hardware", 0) == 0) {
+      out << ';' << line;
+      break;
+    }
+  }
+  for (unsigned cpu = 0; cpu < std::thread::hardware_concurrency(); ++cpu) {
+    const std::string base = "/sys/devices/system/cpu/cpu" + std::to_string(cpu);
+    out << ";cpu" << cpu << '=' << ReadFirstLine(base + "/cpufreq/cpuinfo_max_freq");
+  }
+#endif
+  return out.str();
+}
+
+// Cached decisions are only used within what |options| allows; the key
+// already covers these limits, so this guards against hand-edited or stale
+// entries.
+bool LoadCachedDecision(const std::string& cache_path, const std::string& key,
+                        const EngineOptions& options, TuningResult* result) {
+  std::ifstream in(cache_path);
+  std::string line;
+  while (std::getline(in, line)) {
+    std::istringstream fields(line);
+    std::string entry_key;
+    int delegate = 0;
+    int threads = 0;
+    double invoke_us = 0.0;
+    if (!(fields >> entry_key >> delegate >> threads >> invoke_us) || entry_key != key) {
+      continue;
+    }
+    if (delegate < static_cast<int>(DelegateKind::kCpu) ||
+        delegate > static_cast<int>(DelegateKind::kGpu) || threads <= 0 ||
+        threads > options.num_threads ||
+        (delegate == static_cast<int>(DelegateKind::kGpu) && !options.use_gpu)) {
+      return false;
+    }
+    result->config.delegate = static_cast<DelegateKind>(delegate);
+    result->config.num_threads = threads;
+    result->invoke_us = invoke_us;
+    result->from_cache = true;
+    return true;
+  }
+  return false;
+}
+
+void StoreDecision(const std::string& cache_path, const std::string& key,
+                   const TuningResult& result) {
+  std::vector<std::string> kept;
+  {
+    std::ifstream in(cache_path);
+    std::string line;
+    while (std::getline(in, line)) {
+      if (!line.empty() && line.compare(0, key.size() + 1, key + ' ') != 0) {
+        kept.push_back(line);
+      }
+    }
+  }
+  const std::string temp_path = cache_path + ".tmp";
+  {
+    std::ofstream out(temp_path, std::ios::trunc);
+    if (!out) {
+      return;
+    }
+    for (const auto& line : kept) {
+      out << line << '\n';
+    }
+    out << key << ' ' << static_cast<int>(result.config.delegate) << ' '
+        << result.config.num_threads << ' ' << result.invoke_us << '\n';
+  }
+  std::rename(temp_path.c_str(), cache_path.c_str());
+}
+
+std::vector<float> CalibrationInput(TfLiteInterpreter* interpreter) {
+  const TfLiteTensor* input = TfLiteInterpreterGetInputTensor(interpreter, 0);
+  const size_t count = input == nullptr ? 0 : TfLiteTensorByteSize(input) / sizeof(float);
+  std::vector<float> data(count);
+  // Fixed-seed LCG so every candidate sees identical, non-degenerate input.
+  uint32_t state = 0x12345678u;
+  for (auto& value : data) {
+    state = state * 1664525u + 1013904223u;
+    value = static_cast<float>(state >> 8) / static_cast<float>(1u << 24);
+  }
+  return data;
+}
+
+bool MatchesReference(const std::vector<float>& candidate, const std::vector<float>& reference) {
+  if (candidate.size() != reference.size() || reference.empty()) {
+    return false;
+  }
+  size_t mismatches = 0;
+  for (size_t i = 0; i < reference.size(); ++i) {
+    const float expected = reference[i];
+    if (!(std::fabs(candidate[i] - expected) <= kAbsTolerance + kRelTolerance * std::fabs(expected))) {
+      ++mismatches;
+    }
+  }
+  return static_cast<double>(mismatches) <= kMaxMismatchFraction * reference.size();
+}
+
+// Median invoke latency in microseconds, or a negative value on failure.
+double BenchmarkRuntime(InferenceRuntime* runtime, const std::vector<float>& input,
+                        std::vector<float>* output) {
+  std::vector<int> shape;
+  for (int i = 0; i < kWarmupRuns; ++i) {
+    if (!runtime->Invoke(input, output, &shape)) {
+      return -1.0;
+    }
+  }
+  std::vector<double> samples;
+  samples.reserve(kTimedRuns);
+  for (int i = 0; i < kTimedRuns; ++i) {
+    const uint64_t start = MonotonicNanos();
+    if (!runtime->Invoke(input, output, &shape)) {
+      return -1.0;
+    }
+    samples.push_back(static_cast<double>(MonotonicNanos() - start) / 1000.0);
+  }
+  std::nth_element(samples.begin(), samples.begin() + samples.size() / 2, samples.end());
+  return samples[samples.size() / 2];
+}
+
+std::vector<RuntimeConfig> CandidateConfigs(const EngineOptions& options) {
+  const int cores = std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+  const int max_threads = std::max(1, std::min(options.num_threads, cores));
+  std::set<int> thread_counts = {1, 2, 4, max_threads};
+  std::vector<RuntimeConfig> candidates;
+  for (DelegateKind delegate : {DelegateKind::kCpu, DelegateKind::kXnnpack}) {
+    if (!IsDelegateAvailable(delegate)) {
+      continue;
+    }
+    for (int threads : thread_counts) {
+      if (threads > max_threads) {
+        continue;
+      }
+      RuntimeConfig config;
+      config.delegate = delegate;
+      config.num_threads = threads;
+      config.allow_fp16 = options.allow_fp16;
+      candidates.push_back(config);
+    }
+  }
+  if (options.use_gpu && IsDelegateAvailable(DelegateKind::kGpu)) {
+    RuntimeConfig config;
+    config.delegate = DelegateKind::kGpu;
+    config.num_threads = std::min(options.num_threads, max_threads);
+    config.allow_fp16 = options.allow_fp16;
+    candidates.push_back(config);
+  }
+  return candidates;
+}
+
+}  // namespace
+
+std::string ModelFingerprint(const std::string& model_path) {
+  std::ifstream in(model_path, std::ios::binary);
+  if (!in) {
+    return std::string();
+  }
+  uint64_t hash = kFnvOffset;
+  std::vector<char> chunk(1 << 16);
+  while (in) {
+    in.read(chunk.data(), static_cast<std::streamsize>(chunk.size()));
+    hash = Fnv1a(hash, chunk.data(), static_cast<size_t>(in.gcount()));
+  }
+  return ToHex(hash);
+}
+
+std::string DeviceFingerprint() {
+  const std::string description = RawDeviceDescription();
+  return ToHex(Fnv1a(kFnvOffset, description.data(), description.size()));
+}
+
+std::unique_ptr<InferenceRuntime> AutoTuneRuntime(const ModelHandle& model,
+                                                  const std::string& model_path,
+                                                  const EngineOptions& options,
+                                                  TuningResult* result) {
+  TuningResult local_result;
+  TuningResult* tuning = result != nullptr ? result : &local_result;
+  *tuning = TuningResult();
+
+  std::ostringstream key_stream;
+  key_stream << ModelFingerprint(model_path) << '-' << DeviceFingerprint() << '-'
+             << options.input_width << 'x' << options.input_height << "-t"
+             << options.num_threads << (options.use_gpu ? "-gpu" : "-cpu");
+  const std::string key = key_stream.str();
+
+  if (!options.tuning_cache_path.empty() &&
+      LoadCachedDecision(options.tuning_cache_path, key, options, tuning)) {
+    tuning->config.allow_fp16 = options.allow_fp16;
+    auto runtime = InferenceRuntime::Create(model, tuning->config);
+    if (runtime) {
+      return runtime;
+    }
+    LogMessage("autotune: cached decision no longer valid, recalibrating");
+    *tuning = TuningResult();
+  }
+
+  RuntimeConfig reference_config;
+  reference_config.num_threads = options.num_threads;
+  reference_config.allow_fp16 = options.allow_fp16;
+  auto reference = InferenceRuntime::Create(model, reference_config);
+  if (!reference) {
+    return nullptr;
+  }
+  const std::vector<float> input = CalibrationInput(reference->interpreter());
+  std::vector<float> reference_output;
+  std::vector<int> reference_shape;
+  if (input.empty() || !reference->Invoke(input, &reference_output, &reference_shape)) {
+    return nullptr;
+  }
+  reference.reset();
+
+  std::unique_ptr<InferenceRuntime> best;
+  double best_us = -1.0;
+  std::vector<float> output;
+  for (const RuntimeConfig& candidate_config : CandidateConfigs(options)) {
+    auto candidate = InferenceRuntime::Create(model, candidate_config);
+    if (!candidate) {
+      continue;
+    }
+    ++tuning->candidates_tested;
+    const double invoke_us = BenchmarkRuntime(candidate.get(), input, &output);
+    const bool accurate = invoke_us >= 0.0 && MatchesReference(output, reference_output);
+    {
+      std::ostringstream log;
+      log << "autotune: " << DelegateName(candidate_config.delegate)
+          << " threads=" << candidate_config.num_threads << " medianUs=" << invoke_us
+          << (accurate ? "" : " rejected(accuracy)");
+      LogMessage(log.str());
+    }
+    if (accurate && (best_us < 0.0 || invoke_us < best_us)) {
+      best = std::move(candidate);
+      best_us = invoke_us;
+    }
+  }
+
+  if (!best) {
+    tuning->config = reference_config;
+    return InferenceRuntime::Create(model, reference_config);
+  }
+  tuning->config = best->config();
+  tuning->invoke_us = best_us;
+  if (!options.tuning_cache_path.empty()) {
+    StoreDecision(options.tuning_cache_path, key, *tuning);
+  }
+  return best;
+}
+
+}  // namespace yolo
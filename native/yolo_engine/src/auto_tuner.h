@@ -0,0 +1,38 @@
+#pragma once
+
+#include <memory>
+#include <string>
+
+#include "inference_runtime.h"
+
+namespace yolo {
+
+struct EngineOptions;
+
+struct TuningResult {
+  RuntimeConfig config;
+  double invoke_us = 0.0;
+  bool from_cache = false;
+  int candidates_tested = 0;
+};
+
+// 64-bit FNV-1a over the model file contents, as hex.
+std::string ModelFingerprint(const std::string& model_path);
+
+// Stable identifier for the SoC/OS build this process runs on, as hex. Any
+// change (new device, OS or driver update) invalidates cached decisions.
+std::string DeviceFingerprint();
+
+// Picks the delegate and thread count for |model|. A decision cached under
+// the same model, device, input size, thread cap and GPU permission is
+// reused directly; otherwise CPU (1/2/4/N threads, N = options.num_threads
+// or the core count if lower), XNNPACK and, if options.use_gpu allows it,
+// GPU candidates are benchmarked with real invokes. The fastest one whose
+// output matches the reference CPU run is kept and persisted to
+// options.tuning_cache_path.
+std::unique_ptr<InferenceRuntime> AutoTuneRuntime(const ModelHandle& model,
+                                                  const std::string& model_path,
+                                                  const EngineOptions& options,
+                                                  TuningResult* result);
+
+}  // namespace yolo
@@ -0,0 +1,433 @@
+#include "box_tracker.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "image_utils.h"
+#include "yolo_engine.h"
+
+namespace yolo {
+
+namespace {
+
+// Tracking runs on a base image of at most this many pixels on the long
+// side; flow is smooth enough that more resolution only costs time.
+constexpr int kMaxBaseSize = 320;
+constexpr int kWindowRadius = 4;
+constexpr int kWindowArea = (2 * kWindowRadius + 1) * (2 * kWindowRadius + 1);
+constexpr int kMaxIterations = 10;
+constexpr float kConvergedStep = 0.01f;
+constexpr int kGridSize = 5;
+constexpr int kMaxFeatures = 12;
+// Minimum per-pixel structure-tensor eigenvalue for a usable corner.
+constexpr float kMinCornerStrength = 4.0f;
+// Forward-backward round-trip error, in base pixels, above which a point is
+// treated as lost.
+constexpr float kMaxRoundTripError = 1.0f;
+constexpr float kMinScaleStep = 0.8f;
+constexpr float kMaxScaleStep = 1.25f;
+
+float Median(std::vector<float>* values) {
+  if (values->empty()) {
+    return 0.0f;
+  }
+  auto middle = values->begin() + values->size() / 2;
+  std::nth_element(values->begin(), middle, values->end());
+  return *middle;
+}
+
+// Maps a pixel of the rotated frame back to the sensor frame.
+inline void UnrotatePoint(int rotation, int width, int height, int dx, int dy, int* x, int* y) {
+  switch (rotation) {
+    case 90:
+      *x = dy;
+      *y = height - 1 - dx;
+      break;
+    case 180:
+      *x = width - 1 - dx;
+      *y = height - 1 - dy;
+      break;
+    case 270:
+      *x = width - 1 - dy;
+      *y = dx;
+      break;
+    default:
+      *x = dx;
+      *y = dy;
+      break;
+  }
+}
+
+// Resamples the frame's luma into |base| in rotated, model-aligned space.
+// Each output pixel averages a 2x2 footprint to tame aliasing from the large
+// downscale.
+template <typename LumaFn>
+void SampleBase(const FrameMetadata& frame, const LumaFn& luma, LumaPlane* base) {
+  const int rotation = ((frame.rotation_degrees % 360) + 360) % 360;
+  const bool transposed = rotation == 90 || rotation == 270;
+  const int rotated_width = transposed ? frame.height : frame.width;
+  const int rotated_height = transposed ? frame.width : frame.height;
+  const float scale_x = static_cast<float>(rotated_width) / base->width;
+  const float scale_y = static_cast<float>(rotated_height) / base->height;
+  // The footprint's top-left corner; on a frame one pixel wide or high both
+  // of its samples fall on that pixel.
+  const int max_rx = std::max(0, rotated_width - 2);
+  const int max_ry = std::max(0, rotated_height - 2);
+  for (int v = 0; v < base->height; ++v) {
+    const int ry = std::clamp(static_cast<int>((v + 0.5f) * scale_y - 0.5f), 0, max_ry);
+    for (int u = 0; u < base->width; ++u) {
+      const int rx = std::clamp(static_cast<int>((u + 0.5f) * scale_x - 0.5f), 0, max_rx);
+      int sum = 0;
+      for (int oy = 0; oy < 2; ++oy) {
+        for (int ox = 0; ox < 2; ++ox) {
+          int x = 0;
+          int y = 0;
+          UnrotatePoint(rotation, frame.width, frame.height,
+                        std::min(rx + ox, rotated_width - 1),
+                        std::min(ry + oy, rotated_height - 1), &x, &y);
+          sum += luma(x, y);
+        }
+      }
+      base->pixels[static_cast<size_t>(v) * base->width + u] = static_cast<uint8_t>(sum >> 2);
+    }
+  }
+}
+
+void Downsample(const LumaPlane& src, LumaPlane* dst) {
+  dst->Resize(std::max(1, src.width / 2), std::max(1, src.height / 2));
+  for (int y = 0; y < dst->height; ++y) {
+    const int y0 = std::min(2 * y, src.height - 1);
+    const int y1 = std::min(2 * y + 1, src.height - 1);
+    for (int x = 0; x < dst->width; ++x) {
+      const int x0 = std::min(2 * x, src.width - 1);
+      const int x1 = std::min(2 * x + 1, src.width - 1);
+      const int sum = src.At(x0, y0) + src.At(x1, y0) + src.At(x0, y1) + src.At(x1, y1);
+      dst->pixels[static_cast<size_t>(y) * dst->width + x] = static_cast<uint8_t>((sum + 2) >> 2);
+    }
+  }
+}
+
+}  // namespace
+
+void LumaPlane::Resize(int new_width, int new_height) {
+  width = new_width;
+  height = new_height;
+  pixels.resize(static_cast<size_t>(new_width) * new_height);
+}
+
+float LumaPlane::Sample(float x, float y) const {
+  x = std::clamp(x, 0.0f, static_cast<float>(width - 1));
+  y = std::clamp(y, 0.0f, static_cast<float>(height - 1));
+  const int x0 = static_cast<int>(x);
+  const int y0 = static_cast<int>(y);
+  const int x1 = std::min(x0 + 1, width - 1);
+  const int y1 = std::min(y0 + 1, height - 1);
+  const float fx = x - x0;
+  const float fy = y - y0;
+  const float top = At(x0, y0) + (At(x1, y0) - At(x0, y0)) * fx;
+  const float bottom = At(x0, y1) + (At(x1, y1) - At(x0, y1)) * fx;
+  return top + (bottom - top) * fy;
+}
+
+void BoxTracker::Clear() {
+  anchored_ = false;
+  boxes_.clear();
+}
+
+void BoxTracker::Release() {
+  Clear();
+  previous_ = Pyramid();
+  current_ = Pyramid();
+  boxes_.shrink_to_fit();
+  features_ = std::vector<Point>();
+  moved_ = std::vector<Point>();
+  values_ = std::vector<float>();
+}
+
+size_t BoxTracker::memory_bytes() const {
+  size_t bytes = 0;
+  for (int level = 0; level < kLevels; ++level) {
+    bytes += previous_[level].pixels.capacity() + current_[level].pixels.capacity();
+  }
+  return bytes + boxes_.capacity() * sizeof(YoloDetection) +
+         (features_.capacity() + moved_.capacity()) * sizeof(Point) +
+         values_.capacity() * sizeof(float);
+}
+
+void BoxTracker::BuildPyramid(const FrameMetadata& frame, Pyramid* pyramid) const {
+  const float scale =
+      std::min(1.0f, static_cast<float>(kMaxBaseSize) / std::max(model_width_, model_height_));
+  LumaPlane& base = (*pyramid)[0];
+  base.Resize(std::max(1, static_cast<int>(model_width_ * scale)),
+              std::max(1, static_cast<int>(model_height_ * scale)));
+
+  if (frame.format == PixelFormat::kYuv420) {
+    SampleBase(frame,
+               [&frame](int x, int y) {
+                 return frame.y_plane[static_cast<size_t>(frame.y_row_stride) * y + x];
+               },
+               &base);
+  } else {
+    PixelView view;
+    if (!PackedFrameView(frame, &view)) {
+      std::fill(base.pixels.begin(), base.pixels.end(), 0);
+    } else {
+      // BT.601 luma in 8.8 fixed point.
+      SampleBase(frame,
+                 [&view](int x, int y) {
+                   const uint8_t* pixel = view.data + static_cast<size_t>(view.row_stride) * y +
+                                          static_cast<size_t>(x) * view.pixel_stride;
+                   return (77 * pixel[view.channel[0]] + 150 * pixel[view.channel[1]] +
+                           29 * pixel[view.channel[2]]) >>
+                          8;
+                 },
+                 &base);
+    }
+  }
+  for (int level = 1; level < kLevels; ++level) {
+    Downsample((*pyramid)[level - 1], &(*pyramid)[level]);
+  }
+}
+
+void BoxTracker::Reset(const FrameMetadata& frame, int model_width, int model_height,
+                       const std::vector<YoloDetection>& detections) {
+  model_width_ = model_width;
+  model_height_ = model_height;
+  boxes_.assign(detections.begin(), detections.end());
+  anchored_ = frame.width > 1 && frame.height > 1;
+  if (anchored_) {
+    BuildPyramid(frame, &previous_);
+  }
+}
+
+void BoxTracker::SelectFeatures(const LumaPlane& image, const YoloDetection& box,
+                                std::vector<Point>* points) const {
+  points->clear();
+  const float scale = static_cast<float>(image.width) / model_width_;
+  const float inset_x = 0.1f * (box.right - box.left);
+  const float inset_y = 0.1f * (box.bottom - box.top);
+  const float left = (box.left + inset_x) * scale;
+  const float top = (box.top + inset_y) * scale;
+  const float width = (box.right - box.left - 2 * inset_x) * scale;
+  const float height = (box.bottom - box.top - 2 * inset_y) * scale;
+  if (width < 2.0f || height < 2.0f) {
+    return;
+  }
+
+  // Score a regular grid by Shi-Tomasi corner strength and keep the best.
+  struct Candidate {
+    float strength;
+    Point point;
+  };
+  Candidate candidates[kGridSize * kGridSize];
+  int count = 0;
+  const int margin = kWindowRadius + 1;
+  for (int gy = 0; gy < kGridSize; ++gy) {
+    for (int gx = 0; gx < kGridSize; ++gx) {
+      const int cx = static_cast<int>(left + width * (gx + 0.5f) / kGridSize);
+      const int cy = static_cast<int>(top + height * (gy + 0.5f) / kGridSize);
+      if (cx < margin || cy < margin || cx >= image.width - margin ||
+          cy >= image.height - margin) {
+        continue;
+      }
+      float sxx = 0.0f;
+      float sxy = 0.0f;
+      float syy = 0.0f;
+      for (int dy = -kWindowRadius; dy <= kWindowRadius; ++dy) {
+        for (int dx = -kWindowRadius; dx <= kWindowRadius; ++dx) {
+          const float ix =
+              0.5f * (image.At(cx + dx + 1, cy + dy) - image.At(cx + dx - 1, cy + dy));
+          const float iy =
+              0.5f * (image.At(cx + dx, cy + dy + 1) - image.At(cx + dx, cy + dy - 1));
+          sxx += ix * ix;
+          sxy += ix * iy;
+          syy += iy * iy;
+        }
+      }
+      const float half_trace = 0.5f * (sxx + syy);
+      const float spread = std::sqrt(0.25f * (sxx - syy) * (sxx - syy) + sxy * sxy);
+      const float window = static_cast<float>(kWindowArea);
+      const float strength = (half_trace - spread) / window;
+      if (strength >= kMinCornerStrength) {
+        candidates[count++] = {strength, {static_cast<float>(cx), static_cast<float>(cy)}};
+      }
+    }
+  }
+  const int keep = std::min(count, kMaxFeatures);
+  std::partial_sort(candidates, candidates + keep, candidates + count,
+                    [](const Candidate& a, const Candidate& b) { return a.strength > b.strength; });
+  for (int i = 0; i < keep; ++i) {
+    points->push_back(candidates[i].point);
+  }
+}
+
+bool BoxTracker::TrackPoint(const Pyramid& from, const Pyramid& to, Point start,
+                            Point* end) const {
+  float guess_x = 0.0f;
+  float guess_y = 0.0f;
+  for (int level = kLevels - 1; level >= 0; --level) {
+    const LumaPlane& prev = from[level];
+    const LumaPlane& next = to[level];
+    const float level_scale = 1.0f / static_cast<float>(1 << level);
+    const float px = start.x * level_scale;
+    const float py = start.y * level_scale;
+
+    // The template window and its gradients stay put while the match moves,
+    // so they are sampled once per level rather than on every iteration.
+    float templ[kWindowArea];
+    float grad_x[kWindowArea];
+    float grad_y[kWindowArea];
+    float gxx = 0.0f;
+    float gxy = 0.0f;
+    float gyy = 0.0f;
+    int k = 0;
+    for (int dy = -kWindowRadius; dy <= kWindowRadius; ++dy) {
+      for (int dx = -kWindowRadius; dx <= kWindowRadius; ++dx, ++k) {
+        const float ix =
+            0.5f * (prev.Sample(px + dx + 1, py + dy) - prev.Sample(px + dx - 1, py + dy));
+        const float iy =
+            0.5f * (prev.Sample(px + dx, py + dy + 1) - prev.Sample(px + dx, py + dy - 1));
+        templ[k] = prev.Sample(px + dx, py + dy);
+        grad_x[k] = ix;
+        grad_y[k] = iy;
+        gxx += ix * ix;
+        gxy += ix * iy;
+        gyy += iy * iy;
+      }
+    }
+    const float det = gxx * gyy - gxy * gxy;
+    if (det < 1e-3f) {
+      return false;
+    }
+
+    float vx = 0.0f;
+    float vy = 0.0f;
+    for (int iteration = 0; iteration < kMaxIterations; ++iteration) {
+      float bx = 0.0f;
+      float by = 0.0f;
+      const float qx = px + guess_x + vx;
+      const float qy = py + guess_y + vy;
+      k = 0;
+      for (int dy = -kWindowRadius; dy <= kWindowRadius; ++dy) {
+        for (int dx = -kWindowRadius; dx <= kWindowRadius; ++dx, ++k) {
+          const float diff = templ[k] - next.Sample(qx + dx, qy + dy);
+          bx += diff * grad_x[k];
+          by += diff * grad_y[k];
+        }
+      }
+      const float step_x = (gyy * bx - gxy * by) / det;
+      const float step_y = (gxx * by - gxy * bx) / det;
+      vx += step_x;
+      vy += step_y;
+      if (step_x * step_x + step_y * step_y < kConvergedStep * kConvergedStep) {
+        break;
+      }
+    }
+    if (level > 0) {
+      guess_x = 2.0f * (guess_x + vx);
+      guess_y = 2.0f * (guess_y + vy);
+    } else {
+      guess_x += vx;
+      guess_y += vy;
+    }
+  }
+  end->x = start.x + guess_x;
+  end->y = start.y + guess_y;
+  const LumaPlane& base = to[0];
+  return end->x >= 0.0f && end->y >= 0.0f && end->x < base.width && end->y < base.height;
+}
+
+float BoxTracker::TrackBox(const YoloDetection& box, YoloDetection* moved) {
+  *moved = box;
+  SelectFeatures(previous_[0], box, &features_);
+  if (features_.empty()) {
+    return 0.0f;
+  }
+
+  moved_.clear();
+  std::vector<Point>& origins = features_;
+  size_t kept = 0;
+  float round_trip_total = 0.0f;
+  for (const Point& start : origins) {
+    Point end;
+    Point back;
+    if (!TrackPoint(previous_, current_, start, &end) ||
+        !TrackPoint(current_, previous_, end, &back)) {
+      continue;
+    }
+    const float error = std::hypot(back.x - start.x, back.y - start.y);
+    if (error > kMaxRoundTripError) {
+      continue;
+    }
+    origins[kept++] = start;
+    moved_.push_back(end);
+    round_trip_total += error;
+  }
+  if (kept == 0) {
+    return 0.0f;
+  }
+  const float inlier_ratio = static_cast<float>(kept) / static_cast<float>(features_.size());
+  origins.resize(kept);
+
+  values_.clear();
+  for (size_t i = 0; i < kept; ++i) {
+    values_.push_back(moved_[i].x - origins[i].x);
+  }
+  const float shift_x = Median(&values_);
+  values_.clear();
+  for (size_t i = 0; i < kept; ++i) {
+    values_.push_back(moved_[i].y - origins[i].y);
+  }
+  const float shift_y = Median(&values_);
+
+  values_.clear();
+  for (size_t i = 0; i < kept; ++i) {
+    for (size_t j = i + 1; j < kept; ++j) {
+      const float before = std::hypot(origins[i].x - origins[j].x, origins[i].y - origins[j].y);
+      if (before > 1.0f) {
+        const float after = std::hypot(moved_[i].x - moved_[j].x, moved_[i].y - moved_[j].y);
+        values_.push_back(after / before);
+      }
+    }
+  }
+  const float scale_step =
+      values_.empty() ? 1.0f : std::clamp(Median(&values_), kMinScaleStep, kMaxScaleStep);
+
+  const float to_model = static_cast<float>(model_width_) / previous_[0].width;
+  const float center_x = 0.5f * (box.left + box.right) + shift_x * to_model;
+  const float center_y = 0.5f * (box.top + box.bottom) + shift_y * to_model;
+  const float half_width = 0.5f * (box.right - box.left) * scale_step;
+  const float half_height = 0.5f * (box.bottom - box.top) * scale_step;
+  const float max_x = static_cast<float>(model_width_);
+  const float max_y = static_cast<float>(model_height_);
+  moved->left = std::clamp(center_x - half_width, 0.0f, max_x);
+  moved->right = std::clamp(center_x + half_width, 0.0f, max_x);
+  moved->top = std::clamp(center_y - half_height, 0.0f, max_y);
+  moved->bottom = std::clamp(center_y + half_height, 0.0f, max_y);
+
+  const float mean_error = round_trip_total / static_cast<float>(kept);
+  return inlier_ratio * std::exp(-mean_error);
+}
+
+bool BoxTracker::Track(const FrameMetadata& frame, std::vector<YoloDetection>* detections,
+                       float* confidence) {
+  detections->clear();
+  *confidence = 0.0f;
+  if (!anchored_) {
+    return false;
+  }
+  BuildPyramid(frame, &current_);
+  float lowest = 1.0f;
+  for (YoloDetection& box : boxes_) {
+    YoloDetection moved;
+    lowest = std::min(lowest, TrackBox(box, &moved));
+    box = moved;
+  }
+  detections->assign(boxes_.begin(), boxes_.end());
+  // The next frame is tracked from this one, keeping per-step motion small.
+  std::swap(previous_, current_);
+  *confidence = lowest;
+  return true;
+}
+
+}  // namespace yolo
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "yolo_engine_api.h"
+
+namespace yolo {
+
+struct FrameMetadata;
+
+// 8-bit single-channel image.
+struct LumaPlane {
+  int width = 0;
+  int height = 0;
+  std::vector<uint8_t> pixels;
+
+  void Resize(int new_width, int new_height);
+  uint8_t At(int x, int y) const { return pixels[static_cast<size_t>(y) * width + x]; }
+  // Bilinear sample with edge clamping.
+  float Sample(float x, float y) const;
+};
+
+// Propagates the last detections across frames that skip inference. Each
+// frame's luma is resampled into model-input space (rotation and resize
+// applied, so boxes need no coordinate mapping) and kept as a small image
+// pyramid. Boxes are moved with sparse pyramidal Lucas-Kanade on corner
+// features inside each box, filtered with a forward-backward check; the
+// median flow gives the translation and pairwise point distances the scale.
+//
+// Confidence per box is the fraction of features that survive the
+// forward-backward check, discounted by their residual error. The engine
+// falls back to inference when it drops below the configured threshold.
+class BoxTracker {
+ public:
+  static constexpr int kLevels = 3;
+
+  BoxTracker() = default;
+
+  BoxTracker(const BoxTracker&) = delete;
+  BoxTracker& operator=(const BoxTracker&) = delete;
+
+  // Anchors the tracker on an inferred frame and its detections.
+  void Reset(const FrameMetadata& frame, int model_width, int model_height,
+             const std::vector<YoloDetection>& detections);
+  // Moves the anchored boxes onto |frame|. Returns false when there is
+  // nothing to track from. |confidence| is the minimum over all boxes (1 when
+  // there are none).
+  bool Track(const FrameMetadata& frame, std::vector<YoloDetection>* detections,
+             float* confidence);
+  void Clear();
+  // Clear() and free the pyramids and per-box scratch.
+  void Release();
+
+  bool anchored() const { return anchored_; }
+  size_t memory_bytes() const;
+
+ private:
+  using Pyramid = std::array<LumaPlane, kLevels>;
+
+  struct Point {
+    float x;
+    float y;
+  };
+
+  void BuildPyramid(const FrameMetadata& frame, Pyramid* pyramid) const;
+  void SelectFeatures(const LumaPlane& image, const YoloDetection& box,
+                      std::vector<Point>* points) const;
+  bool TrackPoint(const Pyramid& from, const Pyramid& to, Point start, Point* end) const;
+  float TrackBox(const YoloDetection& box, YoloDetection* moved);
+
+  int model_width_ = 0;
+  int model_height_ = 0;
+  bool anchored_ = false;
+  Pyramid previous_;
+  Pyramid current_;
+  std::vector<YoloDetection> boxes_;
+  // Per-box scratch reused across frames.
+  std::vector<Point> features_;
+  std::vector<Point> moved_;
+  std::vector<float> values_;
+};
+
+}  // namespace yolo
@@ -0,0 +1,159 @@
+#include "cadence_governor.h"
+
+#include <algorithm>
+
+namespace yolo {
+
+namespace {
+
+constexpr double kSmoothing = 0.2;
+// Invokes to skip before trusting the latency baseline: the first few pay
+// for delegate warm-up and cold caches.
+constexpr int kWarmupInvokes = 5;
+// A gap this long is a paused stream, not a cadence to learn from.
+constexpr uint64_t kMaxSpacingNs = 5'000'000'000ull;
+
+double Smooth(double average, double sample) {
+  return average <= 0.0 ? sample : average + kSmoothing * (sample - average);
+}
+
+}  // namespace
+
+void CadenceGovernor::Configure(const CadenceBudget& budget) {
+  budget_ = budget;
+  enabled_ = true;
+  mode_ = kYoloGovernorActive;
+  interval_ns_ = 0;
+  UpdateInterval(0);
+  Publish();
+}
+
+bool CadenceGovernor::Due(uint64_t now_ns) const {
+  if (slot_ns_ == 0) {
+    return true;
+  }
+  // Frames arrive on the camera's grid, so an exact deadline would keep
+  // missing by a hair and halve the rate. The slack is paid back from the
+  // schedule, not from the caller's frame times, so the long-run rate still
+  // honours the budget.
+  return now_ns + interval_ns_ / 4 >= slot_ns_ + interval_ns_;
+}
+
+void CadenceGovernor::RecordInference(uint64_t start_ns, uint64_t end_ns, uint64_t cpu_ns,
+                                      uint64_t invoke_ns, size_t detections) {
+  if (last_start_ns_ != 0 && start_ns > last_start_ns_ &&
+      start_ns - last_start_ns_ < kMaxSpacingNs) {
+    spacing_ns_ = Smooth(spacing_ns_, static_cast<double>(start_ns - last_start_ns_));
+  }
+  last_start_ns_ = start_ns;
+  slot_ns_ = slot_ns_ == 0 ? start_ns : std::max(slot_ns_ + interval_ns_, start_ns);
+  if (first_start_ns_ == 0) {
+    first_start_ns_ = start_ns;
+  }
+  inference_ns_ = Smooth(inference_ns_, static_cast<double>(end_ns - start_ns));
+  cpu_ns_ = Smooth(cpu_ns_, static_cast<double>(cpu_ns));
+  if (invoke_ns > 0) {
+    invoke_ns_ = Smooth(invoke_ns_, static_cast<double>(invoke_ns));
+    if (++invoke_samples_ >= kWarmupInvokes &&
+        (baseline_invoke_ns_ <= 0.0 || invoke_ns_ < baseline_invoke_ns_)) {
+      baseline_invoke_ns_ = invoke_ns_;
+    }
+  }
+  if (detections > 0) {
+    last_detection_ns_ = end_ns;
+  }
+  UpdateInterval(end_ns);
+  Publish();
+}
+
+void CadenceGovernor::ResetBaseline() {
+  invoke_ns_ = 0.0;
+  baseline_invoke_ns_ = 0.0;
+  invoke_samples_ = 0;
+}
+
+void CadenceGovernor::ResetActivity() {
+  slot_ns_ = 0;
+  first_start_ns_ = 0;
+  last_start_ns_ = 0;
+  last_detection_ns_ = 0;
+  UpdateInterval(0);
+  Publish();
+}
+
+void CadenceGovernor::UpdateInterval(uint64_t now_ns) {
+  double interval = 0.0;
+  int32_t limit = kYoloGovernorLimitNone;
+  auto consider = [&](double candidate, int32_t candidate_limit) {
+    if (candidate > interval) {
+      interval = candidate;
+      limit = candidate_limit;
+    }
+  };
+  if (budget_.max_fps > 0.0f) {
+    consider(1e9 / budget_.max_fps, kYoloGovernorLimitMaxFps);
+  }
+  if (budget_.max_duty_cycle > 0.0f) {
+    consider(inference_ns_ / budget_.max_duty_cycle, kYoloGovernorLimitDutyCycle);
+  }
+  if (budget_.max_cpu_ms_per_s > 0.0f) {
+    consider(cpu_ns_ * 1000.0 / budget_.max_cpu_ms_per_s, kYoloGovernorLimitCpuTime);
+  }
+  int32_t mode = kYoloGovernorActive;
+  const uint64_t seen_ns = std::max(last_detection_ns_, first_start_ns_);
+  if (seen_ns != 0 && budget_.idle_fps > 0.0f &&
+      now_ns > seen_ns + static_cast<uint64_t>(budget_.idle_after_ms) * 1'000'000ull) {
+    consider(1e9 / budget_.idle_fps, kYoloGovernorLimitIdle);
+    mode = kYoloGovernorIdle;
+  }
+  const double drift = baseline_invoke_ns_ > 0.0 ? invoke_ns_ / baseline_invoke_ns_ : 1.0;
+  if (drift > budget_.throttle_drift) {
+    // Uncapped, stretch the cost of an inference itself. The measured
+    // spacing would feed back on its own stretching.
+    interval = std::max(interval, inference_ns_) * drift;
+    limit = kYoloGovernorLimitThermal;
+    mode = kYoloGovernorThrottled;
+  }
+  const uint64_t next_interval_ns = static_cast<uint64_t>(interval);
+  if (next_interval_ns < interval_ns_) {
+    // The slack an early inference borrowed was sized for the old interval;
+    // do not let it delay a faster cadence.
+    slot_ns_ = std::min(slot_ns_, last_start_ns_);
+  }
+  interval_ns_ = next_interval_ns;
+  limit_ = limit;
+  if (mode != mode_) {
+    mode_ = mode;
+    mode_changes_.fetch_add(1, std::memory_order_relaxed);
+  }
+}
+
+void CadenceGovernor::Publish() {
+  const double spacing = std::max(spacing_ns_, inference_ns_);
+  published_mode_.store(mode_, std::memory_order_relaxed);
+  published_limit_.store(limit_, std::memory_order_relaxed);
+  published_interval_ms_.store(static_cast<float>(interval_ns_ / 1e6), std::memory_order_relaxed);
+  published_inference_ms_.store(static_cast<float>(inference_ns_ / 1e6),
+                                std::memory_order_relaxed);
+  published_duty_cycle_.store(spacing > 0.0 ? static_cast<float>(inference_ns_ / spacing) : 0.0f,
+                              std::memory_order_relaxed);
+  published_cpu_ms_per_s_.store(
+      spacing > 0.0 ? static_cast<float>(cpu_ns_ / spacing * 1000.0) : 0.0f,
+      std::memory_order_relaxed);
+  published_invoke_drift_.store(
+      baseline_invoke_ns_ > 0.0 ? static_cast<float>(invoke_ns_ / baseline_invoke_ns_) : 1.0f,
+      std::memory_order_relaxed);
+}
+
+void CadenceGovernor::Snapshot(YoloGovernorState* out) const {
+  out->mode = published_mode_.load(std::memory_order_relaxed);
+  out->limit = published_limit_.load(std::memory_order_relaxed);
+  out->interval_ms = published_interval_ms_.load(std::memory_order_relaxed);
+  out->inference_ms = published_inference_ms_.load(std::memory_order_relaxed);
+  out->duty_cycle = published_duty_cycle_.load(std::memory_order_relaxed);
+  out->cpu_ms_per_s = published_cpu_ms_per_s_.load(std::memory_order_relaxed);
+  out->invoke_drift = published_invoke_drift_.load(std::memory_order_relaxed);
+  out->mode_changes = mode_changes_.load(std::memory_order_relaxed);
+}
+
+}  // namespace yolo
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#include "yolo_engine_api.h"
+
+namespace yolo {
+
+// Inference budget for the cadence governor. Each cap of 0 is off.
+struct CadenceBudget {
+  float max_fps = 0.0f;
+  // Share of wall time spent preprocessing, inferring and decoding.
+  float max_duty_cycle = 0.0f;
+  // Process CPU time per second of wall time, in milliseconds.
+  float max_cpu_ms_per_s = 0.0f;
+  // With no detections for this long, drop to |idle_fps|.
+  int idle_after_ms = 3000;
+  float idle_fps = 2.0f;
+  // Invoke latency this far above its best since the model was loaded is
+  // taken as thermal throttling.
+  float throttle_drift = 1.3f;
+};
+
+// Spaces inferences to fit a CadenceBudget instead of running the model on
+// every frame. The spacing is the widest of the configured caps, each turned
+// into a minimum interval from the measured cost of recent inferences:
+// 1 / max_fps, cost / max_duty_cycle, and CPU time / max_cpu_ms_per_s.
+//
+// With nothing detected for a while the interval widens to the idle rate,
+// and the first detection snaps it back. Invoke latency drifting above its
+// warm baseline stretches the interval by the same factor. A throttled
+// device runs the model less often until it cools and latency recovers.
+//
+// Frame thread only, apart from Snapshot(), which reads the last published
+// state from any thread.
+class CadenceGovernor {
+ public:
+  CadenceGovernor() = default;
+
+  CadenceGovernor(const CadenceGovernor&) = delete;
+  CadenceGovernor& operator=(const CadenceGovernor&) = delete;
+
+  void Configure(const CadenceBudget& budget);
+  bool enabled() const { return enabled_; }
+
+  // Whether a frame arriving at |now_ns| should be inferred.
+  bool Due(uint64_t now_ns) const;
+  // Feeds one inferred frame: its wall-clock span, the process CPU time it
+  // took, the interpreter invoke alone, and how many boxes it found.
+  void RecordInference(uint64_t start_ns, uint64_t end_ns, uint64_t cpu_ns, uint64_t invoke_ns,
+                       size_t detections);
+  // Forgets the latency baseline, e.g. for a new model or a rebuilt
+  // interpreter.
+  void ResetBaseline();
+  // Forgets the schedule and when anything was last inferred or detected,
+  // e.g. after the stream was suspended, so the pause itself does not count
+  // as an idle spell.
+  void ResetActivity();
+
+  void Snapshot(YoloGovernorState* out) const;
+
+ private:
+  void UpdateInterval(uint64_t now_ns);
+  void Publish();
+
+  CadenceBudget budget_;
+  bool enabled_ = false;
+  uint64_t interval_ns_ = 0;
+  // Scheduled time of the last inference; the next is due one interval on.
+  uint64_t slot_ns_ = 0;
+  uint64_t first_start_ns_ = 0;
+  uint64_t last_start_ns_ = 0;
+  uint64_t last_detection_ns_ = 0;
+  // Smoothed per-inference costs and spacing, in nanoseconds.
+  double inference_ns_ = 0.0;
+  double cpu_ns_ = 0.0;
+  double spacing_ns_ = 0.0;
+  double invoke_ns_ = 0.0;
+  double baseline_invoke_ns_ = 0.0;
+  int invoke_samples_ = 0;
+  int32_t mode_ = kYoloGovernorOff;
+  int32_t limit_ = kYoloGovernorLimitNone;
+
+  std::atomic<int32_t> published_mode_{kYoloGovernorOff};
+  std::atomic<int32_t> published_limit_{kYoloGovernorLimitNone};
+  std::atomic<float> published_interval_ms_{0.0f};
+  std::atomic<float> published_inference_ms_{0.0f};
+  std::atomic<float> published_duty_cycle_{0.0f};
+  std::atomic<float> published_cpu_ms_per_s_{0.0f};
+  std::atomic<float> published_invoke_drift_{1.0f};
+  std::atomic<uint64_t> mode_changes_{0};
+};
+
+}  // namespace yolo
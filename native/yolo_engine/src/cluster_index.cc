@@ -0,0 +1,211 @@
+#include "cluster_index.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace yolo {
+
+namespace {
+
+// Ranges this small are scanned instead of split further.
+constexpr size_t kLeafSize = 16;
+// Each split pops one span and pushes two, so a search never holds more than
+// one span per tree level plus one; 2^64 nodes would need 64 levels.
+constexpr size_t kMaxSpans = 66;
+constexpr double kPi = 3.14159265358979323846;
+
+double X(double longitude) { return longitude / 360.0 + 0.5; }
+
+double Y(double latitude) {
+  const double s = std::sin(latitude * kPi / 180.0);
+  if (s >= 1.0) return 0.0;
+  if (s <= -1.0) return 1.0;
+  const double y = 0.5 - 0.25 * std::log((1.0 + s) / (1.0 - s)) / kPi;
+  return std::min(1.0, std::max(0.0, y));
+}
+
+double Longitude(double x) { return (x - 0.5) * 360.0; }
+
+double Latitude(double y) {
+  return 360.0 * std::atan(std::exp((180.0 - y * 360.0) * kPi / 180.0)) / kPi - 90.0;
+}
+
+// Into [-180, 180).
+double WrapLongitude(double longitude) {
+  return std::fmod(std::fmod(longitude + 180.0, 360.0) + 360.0, 360.0) - 180.0;
+}
+
+// Inclusive range of |Level::nodes| and the axis its median splits on.
+struct Span {
+  size_t left;
+  size_t right;
+  int axis;
+};
+
+}  // namespace
+
+ClusterIndex::ClusterIndex(float radius_px, int tile_px, int max_zoom)
+    : radius_px_(radius_px), tile_px_(tile_px), max_zoom_(max_zoom) {}
+
+void ClusterIndex::Load(const double* coordinates, size_t count) {
+  levels_.assign(static_cast<size_t>(max_zoom_) + 2, Level());
+  Level& points = levels_.back();
+  points.nodes.reserve(count);
+  for (size_t i = 0; i < count; ++i) {
+    const double latitude = coordinates[2 * i];
+    const double longitude = coordinates[2 * i + 1];
+    if (!std::isfinite(latitude) || !std::isfinite(longitude)) {
+      continue;
+    }
+    Node node;
+    node.x = X(WrapLongitude(longitude));
+    node.y = Y(latitude);
+    node.point = static_cast<int32_t>(i);
+    node.expansion_zoom = max_zoom_ + 1;
+    points.nodes.push_back(node);
+  }
+  BuildTree(&points);
+  for (int zoom = max_zoom_; zoom >= 0; --zoom) {
+    Cluster(levels_[zoom + 1], zoom, &levels_[zoom]);
+    BuildTree(&levels_[zoom]);
+  }
+}
+
+int32_t ClusterIndex::Query(double west, double south, double east, double north, int zoom,
+                            const YoloCluster** out) {
+  view_.clear();
+  hits_.clear();
+  if (!levels_.empty()) {
+    const Level& level = levels_[std::min(std::max(zoom, 0), max_zoom_ + 1)];
+    const double min_y = Y(std::min(90.0, std::max(-90.0, north)));
+    const double max_y = Y(std::min(90.0, std::max(-90.0, south)));
+    if (east - west >= 360.0) {
+      Range(level, 0.0, min_y, 1.0, max_y, &hits_);
+    } else {
+      const double min_x = X(WrapLongitude(west));
+      const double max_x = east == 180.0 ? 1.0 : X(WrapLongitude(east));
+      if (min_x > max_x) {
+        Range(level, min_x, min_y, 1.0, max_y, &hits_);
+        Range(level, 0.0, min_y, max_x, max_y, &hits_);
+      } else {
+        Range(level, min_x, min_y, max_x, max_y, &hits_);
+      }
+    }
+    view_.reserve(hits_.size());
+    for (uint32_t index : hits_) {
+      const Node& node = level.nodes[index];
+      view_.push_back(YoloCluster{Latitude(node.y), Longitude(node.x), node.count, node.point,
+                                  node.expansion_zoom});
+    }
+  }
+  *out = view_.data();
+  return static_cast<int32_t>(view_.size());
+}
+
+void ClusterIndex::BuildTree(Level* level) {
+  if (level->nodes.empty()) {
+    return;
+  }
+  std::vector<Span> stack{{0, level->nodes.size() - 1, 0}};
+  while (!stack.empty()) {
+    const Span span = stack.back();
+    stack.pop_back();
+    if (span.right - span.left <= kLeafSize) {
+      continue;
+    }
+    const size_t middle = (span.left + span.right) / 2;
+    auto begin = level->nodes.begin();
+    std::nth_element(begin + span.left, begin + middle, begin + span.right + 1,
+                     [&](const Node& a, const Node& b) {
+                       return span.axis == 0 ? a.x < b.x : a.y < b.y;
+                     });
+    stack.push_back({span.left, middle - 1, 1 - span.axis});
+    stack.push_back({middle + 1, span.right, 1 - span.axis});
+  }
+}
+
+void ClusterIndex::Cluster(const Level& above, int zoom, Level* out) {
+  const double radius = radius_px_ / (tile_px_ * std::ldexp(1.0, zoom));
+  std::vector<bool> taken(above.nodes.size(), false);
+  out->nodes.reserve(above.nodes.size());
+  for (size_t i = 0; i < above.nodes.size(); ++i) {
+    if (taken[i]) {
+      continue;
+    }
+    taken[i] = true;
+    const Node& node = above.nodes[i];
+    hits_.clear();
+    Within(above, node.x, node.y, radius, &hits_);
+    double weighted_x = node.x * node.count;
+    double weighted_y = node.y * node.count;
+    int32_t count = node.count;
+    for (uint32_t index : hits_) {
+      if (taken[index]) {
+        continue;
+      }
+      taken[index] = true;
+      const Node& neighbour = above.nodes[index];
+      weighted_x += neighbour.x * neighbour.count;
+      weighted_y += neighbour.y * neighbour.count;
+      count += neighbour.count;
+    }
+    if (count == node.count) {
+      out->nodes.push_back(node);
+      continue;
+    }
+    Node cluster;
+    cluster.x = weighted_x / count;
+    cluster.y = weighted_y / count;
+    cluster.count = count;
+    cluster.point = node.point;
+    cluster.expansion_zoom = zoom + 1;
+    out->nodes.push_back(cluster);
+  }
+}
+
+void ClusterIndex::Range(const Level& level, double min_x, double min_y, double max_x,
+                         double max_y, std::vector<uint32_t>* out) const {
+  if (level.nodes.empty()) {
+    return;
+  }
+  auto inside = [&](const Node& node) {
+    return node.x >= min_x && node.x <= max_x && node.y >= min_y && node.y <= max_y;
+  };
+  Span stack[kMaxSpans];
+  size_t depth = 0;
+  stack[depth++] = {0, level.nodes.size() - 1, 0};
+  while (depth > 0) {
+    const Span span = stack[--depth];
+    if (span.right - span.left <= kLeafSize) {
+      for (size_t i = span.left; i <= span.right; ++i) {
+        if (inside(level.nodes[i])) out->push_back(static_cast<uint32_t>(i));
+      }
+      continue;
+    }
+    const size_t middle = (span.left + span.right) / 2;
+    const Node& node = level.nodes[middle];
+    if (inside(node)) out->push_back(static_cast<uint32_t>(middle));
+    const double split = span.axis == 0 ? node.x : node.y;
+    if ((span.axis == 0 ? min_x : min_y) <= split) {
+      stack[depth++] = {span.left, middle - 1, 1 - span.axis};
+    }
+    if ((span.axis == 0 ? max_x : max_y) >= split) {
+      stack[depth++] = {middle + 1, span.right, 1 - span.axis};
+    }
+  }
+}
+
+void ClusterIndex::Within(const Level& level, double x, double y, double radius,
+                          std::vector<uint32_t>* out) const {
+  const size_t first = out->size();
+  Range(level, x - radius, y - radius, x + radius, y + radius, out);
+  const double radius_squared = radius * radius;
+  auto outside = [&](uint32_t index) {
+    const double dx = level.nodes[index].x - x;
+    const double dy = level.nodes[index].y - y;
+    return dx * dx + dy * dy > radius_squared;
+  };
+  out->erase(std::remove_if(out->begin() + first, out->end(), outside), out->end());
+}
+
+}  // namespace yolo
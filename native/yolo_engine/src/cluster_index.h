@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "cluster_index_api.h"
+
+namespace yolo {
+
+// The index behind YoloClusterIndex*(); see cluster_index_api.h. Works in
+// Web Mercator coordinates scaled to [0, 1]. Level z holds the clusters shown
+// at zoom z and level max_zoom + 1 the points. Each level is built from the
+// one above it: nodes are visited in order, and every node not yet taken
+// absorbs the untaken nodes within the zoom's radius into one cluster at
+// their weighted centre. Each level's nodes are stored as a static k-d tree,
+// each range split at its median on alternating axes, which serves the
+// neighbour searches while building and the viewport queries; nearby nodes
+// sit next to each other in memory, and the next level is built in that
+// order.
+class ClusterIndex {
+ public:
+  ClusterIndex(float radius_px, int tile_px, int max_zoom);
+
+  void Load(const double* coordinates, size_t count);
+  int32_t Query(double west, double south, double east, double north, int zoom,
+                const YoloCluster** out);
+
+ private:
+  struct Node {
+    double x = 0.0;
+    double y = 0.0;
+    int32_t count = 1;
+    int32_t point = 0;
+    int32_t expansion_zoom = 0;
+  };
+
+  struct Level {
+    std::vector<Node> nodes;
+  };
+
+  void BuildTree(Level* level);
+  void Cluster(const Level& above, int zoom, Level* out);
+  // Appends to |out| the indices of |level|'s nodes inside the box.
+  void Range(const Level& level, double min_x, double min_y, double max_x, double max_y,
+             std::vector<uint32_t>* out) const;
+  void Within(const Level& level, double x, double y, double radius,
+              std::vector<uint32_t>* out) const;
+
+  const double radius_px_;
+  const double tile_px_;
+  const int max_zoom_;
+  std::vector<Level> levels_;
+  std::vector<uint32_t> hits_;
+  std::vector<YoloCluster> view_;
+};
+
+}  // namespace yolo
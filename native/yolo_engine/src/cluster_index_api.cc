@@ -0,0 +1,50 @@
+#include "cluster_index_api.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+
+#include "cluster_index.h"
+
+namespace {
+
+constexpr int32_t kMaxZoom = 24;
+
+yolo::ClusterIndex* AsIndex(void* handle) { return static_cast<yolo::ClusterIndex*>(handle); }
+
+}  // namespace
+
+extern "C" {
+
+void* YoloClusterIndexCreate(float radius_px, int32_t tile_px, int32_t max_zoom) {
+  if (!std::isfinite(radius_px) || radius_px <= 0.0f || tile_px <= 0) {
+    return nullptr;
+  }
+  return new (std::nothrow)
+      yolo::ClusterIndex(radius_px, tile_px, std::min(std::max(max_zoom, 0), kMaxZoom));
+}
+
+void YoloClusterIndexDestroy(void* index) {
+  delete AsIndex(index);
+}
+
+int32_t YoloClusterIndexLoad(void* index, const double* coordinates, int32_t count) {
+  if (index == nullptr || count < 0 || (coordinates == nullptr && count > 0)) {
+    return -1;
+  }
+  AsIndex(index)->Load(coordinates, static_cast<size_t>(count));
+  return 0;
+}
+
+int32_t YoloClusterIndexQuery(void* index, double west, double south, double east,
+                              double north, int32_t zoom, const YoloCluster** out) {
+  if (index == nullptr || out == nullptr || !std::isfinite(west) || !std::isfinite(south) ||
+      !std::isfinite(east) || !std::isfinite(north)) {
+    return -1;
+  }
+  return AsIndex(index)->Query(west, south, east, north, zoom, out);
+}
+
+}  // extern "C"
@@ -0,0 +1,210 @@
+#include "crop_classifier.h"
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+#include "postprocess.h"
+#include "scratch_arena.h"
+
+namespace yolo {
+
+namespace {
+
+// Context kept around each box, as a fraction of its size.
+constexpr float kCropMargin = 0.1f;
+constexpr float kMatchIoU = 0.5f;
+// Frames an unmatched cache entry survives before it is dropped.
+constexpr uint64_t kCacheMaxAge = 15;
+constexpr size_t kCacheCapacity = 64;
+
+}  // namespace
+
+CropClassifier::CropClassifier(std::unique_ptr<InferenceRuntime> runtime, int top_k)
+    : runtime_(std::move(runtime)), top_k_(top_k) {
+  const std::vector<int>& shape = runtime_->input_shape();
+  batch_ = std::max(1, shape[0]);
+  input_height_ = shape[1];
+  input_width_ = shape[2];
+}
+
+std::unique_ptr<CropClassifier> CropClassifier::Create(ModelHandle model,
+                                                       const RuntimeConfig& config, int top_k) {
+  auto runtime = InferenceRuntime::Create(std::move(model), config);
+  if (runtime == nullptr) {
+    return nullptr;
+  }
+  const std::vector<int>& input = runtime->input_shape();
+  const std::vector<int>& output = runtime->output_shape();
+  if (input.size() != 4 || input[3] != 3 || input[1] <= 0 || input[2] <= 0 || output.size() != 2) {
+    return nullptr;
+  }
+  top_k = std::clamp(top_k, 1, YOLO_CLASSIFIER_MAX_TOP_K);
+  return std::unique_ptr<CropClassifier>(new CropClassifier(std::move(runtime), top_k));
+}
+
+size_t CropClassifier::ScratchBytes() const {
+  return ScratchArena::AlignUp(static_cast<size_t>(kMaxBatch) * input_width_ * input_height_ * 3 *
+                               sizeof(float));
+}
+
+int CropClassifier::EnsureBatch(int count) {
+  int wanted = 1;
+  while (wanted < count && wanted < kMaxBatch) {
+    wanted *= 2;
+  }
+  if (wanted == batch_) {
+    return batch_;
+  }
+  if (runtime_->ResizeInput({wanted, input_height_, input_width_, 3})) {
+    batch_ = wanted;
+  }
+  return batch_;
+}
+
+void CropClassifier::TopK(const float* scores, YoloClassification* out) const {
+  const int num_classes = static_cast<int>(runtime_->output_shape()[1]);
+  // Probabilities pass through; logits are softmaxed so scores stay
+  // comparable with the detector's.
+  bool probabilities = true;
+  float max_score = scores[0];
+  for (int c = 0; c < num_classes; ++c) {
+    probabilities = probabilities && scores[c] >= 0.0f && scores[c] <= 1.0f;
+    max_score = std::max(max_score, scores[c]);
+  }
+  float denominator = 1.0f;
+  if (!probabilities) {
+    denominator = 0.0f;
+    for (int c = 0; c < num_classes; ++c) {
+      denominator += std::exp(scores[c] - max_score);
+    }
+  }
+
+  out->count = 0;
+  const int k = std::min(top_k_, num_classes);
+  for (int c = 0; c < num_classes; ++c) {
+    const float score = probabilities ? scores[c] : std::exp(scores[c] - max_score) / denominator;
+    int slot = out->count;
+    if (slot == k && score <= out->score[k - 1]) {
+      continue;
+    }
+    if (slot == k) {
+      --slot;
+    } else {
+      ++out->count;
+    }
+    while (slot > 0 && out->score[slot - 1] < score) {
+      out->score[slot] = out->score[slot - 1];
+      out->class_index[slot] = out->class_index[slot - 1];
+      --slot;
+    }
+    out->score[slot] = score;
+    out->class_index[slot] = c;
+  }
+}
+
+bool CropClassifier::Classify(const PixelView& source, int model_width, int model_height,
+                              const YoloDetection* boxes, size_t count, ScratchArena* arena,
+                              ThreadPool* pool, YoloClassification* out) {
+  const float to_source_x = static_cast<float>(source.width) / model_width;
+  const float to_source_y = static_cast<float>(source.height) / model_height;
+  const size_t crop_floats = static_cast<size_t>(input_width_) * input_height_ * 3;
+
+  size_t done = 0;
+  while (done < count) {
+    const int batch = EnsureBatch(static_cast<int>(count - done));
+    const size_t chunk = std::min(count - done, static_cast<size_t>(batch));
+    const size_t batch_floats = crop_floats * batch;
+    float* input = runtime_->MutableInput();
+    const bool staged = input == nullptr || runtime_->input_count() != batch_floats;
+    if (staged) {
+      input = arena->Allocate<float>(batch_floats);
+      if (input == nullptr) {
+        return false;
+      }
+    }
+
+    for (size_t i = 0; i < chunk; ++i) {
+      const YoloDetection& box = boxes[done + i];
+      const float margin_x = kCropMargin * (box.right - box.left);
+      const float margin_y = kCropMargin * (box.bottom - box.top);
+      const int left = std::clamp(static_cast<int>((box.left - margin_x) * to_source_x), 0,
+                                  source.width - 1);
+      const int top = std::clamp(static_cast<int>((box.top - margin_y) * to_source_y), 0,
+                                 source.height - 1);
+      const int right =
+          std::clamp(static_cast<int>(std::ceil((box.right + margin_x) * to_source_x)), left + 1,
+                     source.width);
+      const int bottom =
+          std::clamp(static_cast<int>(std::ceil((box.bottom + margin_y) * to_source_y)), top + 1,
+                     source.height);
+      PixelView crop = source;
+      crop.data = source.data + static_cast<size_t>(source.row_stride) * top +
+                  static_cast<size_t>(source.pixel_stride) * left;
+      crop.width = right - left;
+      crop.height = bottom - top;
+      ResizeAndNormalize(crop, input_width_, input_height_, input + crop_floats * i, pool);
+    }
+    // Unused batch slots keep whatever the last invoke left; their outputs
+    // are ignored.
+    if ((staged && !runtime_->CopyInput(input, batch_floats)) || !runtime_->Run()) {
+      return false;
+    }
+    const float* output = runtime_->Output();
+    if (output == nullptr) {
+      return false;
+    }
+    const size_t num_classes = static_cast<size_t>(runtime_->output_shape()[1]);
+    for (size_t i = 0; i < chunk; ++i) {
+      TopK(output + num_classes * i, &out[done + i]);
+    }
+    done += chunk;
+  }
+  return true;
+}
+
+const YoloClassification* ClassificationCache::Find(const YoloDetection& box,
+                                                    uint64_t frame_seq) {
+  Entry* best = nullptr;
+  float best_iou = kMatchIoU;
+  for (Entry& entry : entries_) {
+    if (entry.box.class_index != box.class_index) {
+      continue;
+    }
+    const float iou = ComputeIoU(entry.box, box);
+    if (iou >= best_iou) {
+      best_iou = iou;
+      best = &entry;
+    }
+  }
+  if (best == nullptr) {
+    return nullptr;
+  }
+  // Following the box keeps slow drift from eventually breaking the match.
+  best->box = box;
+  best->last_seen = frame_seq;
+  return &best->result;
+}
+
+void ClassificationCache::Insert(const YoloDetection& box, const YoloClassification& result,
+                                 uint64_t frame_seq) {
+  if (entries_.size() >= kCacheCapacity) {
+    auto oldest = std::min_element(entries_.begin(), entries_.end(),
+                                   [](const Entry& a, const Entry& b) {
+                                     return a.last_seen < b.last_seen;
+                                   });
+    *oldest = Entry{box, result, frame_seq};
+    return;
+  }
+  entries_.push_back(Entry{box, result, frame_seq});
+}
+
+void ClassificationCache::Expire(uint64_t frame_seq) {
+  entries_.erase(std::remove_if(entries_.begin(), entries_.end(),
+                                [frame_seq](const Entry& entry) {
+                                  return frame_seq - entry.last_seen > kCacheMaxAge;
+                                }),
+                 entries_.end());
+}
+
+}  // namespace yolo
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "image_utils.h"
+#include "inference_runtime.h"
+#include "yolo_engine_api.h"
+
+namespace yolo {
+
+class ScratchArena;
+class ThreadPool;
+
+// Second-stage species classifier. Each detection is cropped from the
+// full-resolution frame (the view preprocessing resized from, not the model
+// input), resized to the classifier input and written into one batched
+// input tensor, so a frame with several new boxes costs a single invoke.
+class CropClassifier {
+ public:
+  // Largest batch the input tensor is resized to; more crops are split into
+  // several invokes.
+  static constexpr int kMaxBatch = 8;
+
+  static std::unique_ptr<CropClassifier> Create(ModelHandle model, const RuntimeConfig& config,
+                                                int top_k);
+
+  CropClassifier(const CropClassifier&) = delete;
+  CropClassifier& operator=(const CropClassifier&) = delete;
+
+  // Classifies |boxes|, given in |model_width| x |model_height| detector
+  // input coordinates over |source|, writing one entry per box to |out|.
+  bool Classify(const PixelView& source, int model_width, int model_height,
+                const YoloDetection* boxes, size_t count, ScratchArena* arena, ThreadPool* pool,
+                YoloClassification* out);
+
+  int input_width() const { return input_width_; }
+  int input_height() const { return input_height_; }
+  // Arena bytes Classify() may need to stage a full batch.
+  size_t ScratchBytes() const;
+  size_t arena_bytes() const { return runtime_->arena_bytes(); }
+  // See InferenceRuntime::Release(); the current batch size survives.
+  void Release() { runtime_->Release(); }
+  bool Restore() { return runtime_->Restore(); }
+
+ private:
+  CropClassifier(std::unique_ptr<InferenceRuntime> runtime, int top_k);
+
+  // Resizes the input batch to the next power of two holding |count| crops.
+  // Returns the batch actually available, which stays at the current size if
+  // the delegate cannot resize.
+  int EnsureBatch(int count);
+  void TopK(const float* scores, YoloClassification* out) const;
+
+  std::unique_ptr<InferenceRuntime> runtime_;
+  int top_k_;
+  int batch_ = 1;
+  int input_width_ = 0;
+  int input_height_ = 0;
+};
+
+// Classifier results remembered per track. A detection that overlaps a
+// remembered box of the same detector class reuses its result, so the
+// classifier only runs for new boxes or boxes that moved or changed shape
+// enough to drop below the IoU threshold.
+class ClassificationCache {
+ public:
+  // Returns the cached result for |box|, refreshing the entry, or nullptr.
+  const YoloClassification* Find(const YoloDetection& box, uint64_t frame_seq);
+  void Insert(const YoloDetection& box, const YoloClassification& result, uint64_t frame_seq);
+  // Drops entries not matched for a while; call once per frame.
+  void Expire(uint64_t frame_seq);
+  void Clear() { entries_.clear(); }
+
+ private:
+  struct Entry {
+    YoloDetection box;
+    YoloClassification result;
+    uint64_t last_seen;
+  };
+
+  std::vector<Entry> entries_;
+};
+
+}  // namespace yolo
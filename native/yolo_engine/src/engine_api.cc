@@ -1,8 +1,10 @@
 #include "yolo_engine_api.h"
 
 #include <algorithm>
+#include <cstdint>
 #include <memory>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "yolo_engine.h"
@@ -13,73 +15,441 @@ inline yolo::YoloEngine* AsEngine(void* handle) {
   return reinterpret_cast<yolo::YoloEngine*>(handle);
 }
 
+int PackedChannels(int32_t format) {
+  switch (format) {
+    case kYoloPixelFormatRgb:
+    case kYoloPixelFormatBgr:
+      return 3;
+    case kYoloPixelFormatRgba:
+    case kYoloPixelFormatBgra:
+      return 4;
+    default:
+      return 0;
+  }
+}
+
+bool ToFrameMetadata(const YoloFrameDescriptor* descriptor, yolo::FrameMetadata* frame) {
+  if (descriptor == nullptr || descriptor->width <= 0 || descriptor->height <= 0 ||
+      descriptor->planes[0] == nullptr) {
+    return false;
+  }
+  frame->y_plane = descriptor->planes[0];
+  frame->width = descriptor->width;
+  frame->height = descriptor->height;
+  frame->y_row_stride = descriptor->row_strides[0];
+  frame->rotation_degrees = descriptor->rotation_degrees;
+  frame->capture_time_ns = descriptor->capture_time_ns;
+  frame->deadline_ns = descriptor->deadline_ns;
+  if (descriptor->roi_right > descriptor->roi_left && descriptor->roi_bottom > descriptor->roi_top) {
+    frame->roi.left = std::clamp(descriptor->roi_left, 0.0f, 1.0f);
+    frame->roi.top = std::clamp(descriptor->roi_top, 0.0f, 1.0f);
+    frame->roi.right = std::clamp(descriptor->roi_right, 0.0f, 1.0f);
+    frame->roi.bottom = std::clamp(descriptor->roi_bottom, 0.0f, 1.0f);
+  }
+  if (descriptor->format == kYoloPixelFormatYuv420) {
+    if (descriptor->planes[1] == nullptr || descriptor->planes[2] == nullptr) {
+      return false;
+    }
+    frame->u_plane = descriptor->planes[1];
+    frame->v_plane = descriptor->planes[2];
+    frame->uv_row_stride = descriptor->row_strides[1];
+    frame->uv_pixel_stride = descriptor->pixel_strides[1];
+    frame->format = yolo::PixelFormat::kYuv420;
+    return true;
+  }
+  const int channels = PackedChannels(descriptor->format);
+  if (channels == 0 || descriptor->row_strides[0] < descriptor->width * channels) {
+    return false;
+  }
+  frame->format = static_cast<yolo::PixelFormat>(descriptor->format);
+  return true;
+}
+
+bool ToCaptureRequest(const YoloCaptureRequest* request, yolo::CaptureRequest* capture) {
+  if (request == nullptr || request->crop_path == nullptr) {
+    return false;
+  }
+  capture->box = request->box;
+  capture->margin = std::max(0.0f, request->margin);
+  capture->crop_max_side = std::max(0, request->crop_max_side);
+  capture->thumbnail_max_side = std::max(0, request->thumbnail_max_side);
+  capture->crop_path = request->crop_path;
+  if (request->thumbnail_path != nullptr) {
+    capture->thumbnail_path = request->thumbnail_path;
+  }
+  return true;
+}
+
 }  // namespace
 
 extern "C" {
 
-void* YoloEngineCreate(const char* model_path, int32_t input_width, int32_t input_height,
-                       int32_t num_threads, int32_t max_detections, float confidence_threshold,
-                       float iou_threshold, int32_t use_gpu, int32_t allow_fp16) {
-  if (model_path == nullptr) {
+int64_t YoloEngineNowNs(void) {
+  return static_cast<int64_t>(yolo::MonotonicNanos());
+}
+
+void YoloEngineConfigInitDefault(YoloEngineConfig* config) {
+  if (config == nullptr) {
+    return;
+  }
+  const yolo::EngineOptions defaults;
+  config->model_path = nullptr;
+  config->input_width = defaults.input_width;
+  config->input_height = defaults.input_height;
+  config->num_threads = defaults.num_threads;
+  config->max_detections = defaults.max_detections;
+  config->confidence_threshold = defaults.confidence_threshold;
+  config->iou_threshold = defaults.iou_threshold;
+  config->use_gpu = defaults.use_gpu ? 1 : 0;
+  config->allow_fp16 = defaults.allow_fp16 ? 1 : 0;
+  config->auto_tune = defaults.auto_tune ? 1 : 0;
+  config->tuning_cache_path = nullptr;
+  config->inference_interval = defaults.inference_interval;
+  config->min_track_confidence = defaults.min_track_confidence;
+  config->classifier_model_path = nullptr;
+  config->classifier_top_k = defaults.classifier_top_k;
+  config->classifier_min_score = defaults.classifier_min_score;
+  config->frame_ring_size = defaults.frame_ring_size;
+  config->quality_gate = static_cast<int32_t>(defaults.quality_gate);
+  config->min_sharpness = defaults.min_sharpness;
+  config->max_clipped_fraction = defaults.max_clipped_fraction;
+  config->auto_zoom = defaults.auto_zoom ? 1 : 0;
+  config->result_channel = defaults.result_channel ? 1 : 0;
+  config->governor = defaults.governor ? 1 : 0;
+  config->governor_max_fps = defaults.cadence.max_fps;
+  config->governor_max_duty_cycle = defaults.cadence.max_duty_cycle;
+  config->governor_max_cpu_ms_per_s = defaults.cadence.max_cpu_ms_per_s;
+  config->governor_idle_after_ms = defaults.cadence.idle_after_ms;
+  config->governor_idle_fps = defaults.cadence.idle_fps;
+  config->core_placement = static_cast<int32_t>(defaults.core_placement);
+  config->core_mask = defaults.core_mask;
+  config->thread_nice = defaults.thread_nice;
+}
+
+void* YoloEngineCreateWithConfig(const YoloEngineConfig* config) {
+  if (config == nullptr || config->model_path == nullptr) {
     return nullptr;
   }
   yolo::EngineOptions options;
-  options.input_width = input_width;
-  options.input_height = input_height;
-  options.num_threads = std::max(1, num_threads);
-  options.max_detections = std::max(1, max_detections);
-  options.confidence_threshold = confidence_threshold;
-  options.iou_threshold = iou_threshold;
-  options.use_gpu = use_gpu != 0;
-  options.allow_fp16 = allow_fp16 != 0;
-
-  auto engine = yolo::YoloEngine::Create(model_path, options);
+  options.input_width = config->input_width;
+  options.input_height = config->input_height;
+  options.num_threads = std::max(1, config->num_threads);
+  options.max_detections = std::max(1, config->max_detections);
+  options.confidence_threshold = config->confidence_threshold;
+  options.iou_threshold = config->iou_threshold;
+  options.use_gpu = config->use_gpu != 0;
+  options.allow_fp16 = config->allow_fp16 != 0;
+  options.auto_tune = config->auto_tune != 0;
+  if (config->tuning_cache_path != nullptr) {
+    options.tuning_cache_path = config->tuning_cache_path;
+  }
+  options.inference_interval = std::max(1, config->inference_interval);
+  options.min_track_confidence = config->min_track_confidence;
+  if (config->classifier_model_path != nullptr) {
+    options.classifier_model_path = config->classifier_model_path;
+  }
+  options.classifier_top_k = config->classifier_top_k;
+  options.classifier_min_score = config->classifier_min_score;
+  options.frame_ring_size = std::max(0, config->frame_ring_size);
+  options.quality_gate = static_cast<yolo::QualityGate>(
+      std::clamp<int32_t>(config->quality_gate, kYoloQualityGateOff, kYoloQualityGateSkip));
+  options.min_sharpness = config->min_sharpness;
+  options.max_clipped_fraction = config->max_clipped_fraction;
+  options.auto_zoom = config->auto_zoom != 0;
+  options.result_channel = config->result_channel != 0;
+  options.governor = config->governor != 0;
+  options.cadence.max_fps = std::max(0.0f, config->governor_max_fps);
+  options.cadence.max_duty_cycle = std::clamp(config->governor_max_duty_cycle, 0.0f, 1.0f);
+  options.cadence.max_cpu_ms_per_s = std::max(0.0f, config->governor_max_cpu_ms_per_s);
+  options.cadence.idle_after_ms = std::max(0, config->governor_idle_after_ms);
+  options.cadence.idle_fps = std::max(0.0f, config->governor_idle_fps);
+  options.core_placement = static_cast<yolo::CorePlacement>(
+      std::clamp<int32_t>(config->core_placement, kYoloCorePlacementOff, kYoloCorePlacementMask));
+  options.core_mask = config->core_mask;
+  options.thread_nice = std::clamp<int32_t>(config->thread_nice, -20, 19);
+
+  auto engine = yolo::YoloEngine::Create(config->model_path, options);
   return engine ? engine.release() : nullptr;
 }
 
+void* YoloEngineCreate(const char* model_path, int32_t input_width, int32_t input_height,
+                       int32_t num_threads, int32_t max_detections, float confidence_threshold,
+                       float iou_threshold, int32_t use_gpu, int32_t allow_fp16) {
+  YoloEngineConfig config;
+  YoloEngineConfigInitDefault(&config);
+  config.model_path = model_path;
+  config.input_width = input_width;
+  config.input_height = input_height;
+  config.num_threads = num_threads;
+  config.max_detections = max_detections;
+  config.confidence_threshold = confidence_threshold;
+  config.iou_threshold = iou_threshold;
+  config.use_gpu = use_gpu;
+  config.allow_fp16 = allow_fp16;
+  return YoloEngineCreateWithConfig(&config);
+}
+
 void YoloEngineDestroy(void* handle) {
   delete AsEngine(handle);
 }
 
+int32_t YoloEngineSwapModel(void* handle, const char* model_path) {
+  if (handle == nullptr || model_path == nullptr) {
+    return -1;
+  }
+  return AsEngine(handle)->SwapModel(model_path) ? 0 : -2;
+}
+
+int32_t YoloEngineGetModelSwapInfo(void* handle, YoloModelSwapInfo* out) {
+  if (handle == nullptr || out == nullptr) {
+    return -1;
+  }
+  AsEngine(handle)->GetModelSwapInfo(out);
+  return 0;
+}
+
+int32_t YoloEngineUpdateDecodeConfig(void* handle, const YoloDecodeConfig* config) {
+  if (handle == nullptr || config == nullptr || config->class_count < 0 ||
+      config->max_detections <= 0) {
+    return -1;
+  }
+  auto settings = std::make_unique<yolo::DecodeSettings>();
+  settings->confidence_threshold = config->confidence_threshold;
+  settings->iou_threshold = config->iou_threshold;
+  settings->max_detections = config->max_detections;
+  const size_t count = static_cast<size_t>(config->class_count);
+  if (config->class_thresholds != nullptr) {
+    settings->class_thresholds.assign(config->class_thresholds, config->class_thresholds + count);
+  }
+  if (config->class_enabled != nullptr) {
+    settings->class_enabled.assign(config->class_enabled, config->class_enabled + count);
+  }
+  AsEngine(handle)->UpdateDecodeSettings(std::move(settings));
+  return 0;
+}
+
+int32_t YoloEngineSuspend(void* handle) {
+  if (handle == nullptr) {
+    return -1;
+  }
+  return AsEngine(handle)->Suspend() ? 0 : -2;
+}
+
+int32_t YoloEngineResume(void* handle) {
+  if (handle == nullptr) {
+    return -1;
+  }
+  return AsEngine(handle)->Resume() ? 0 : -2;
+}
+
+int32_t YoloEngineRequestCapture(void* handle, const YoloCaptureRequest* request) {
+  yolo::CaptureRequest capture;
+  if (handle == nullptr || !ToCaptureRequest(request, &capture)) {
+    return -1;
+  }
+  const int32_t id = AsEngine(handle)->RequestCapture(std::move(capture));
+  return id > 0 ? id : -2;
+}
+
+int32_t YoloEngineCaptureBest(void* handle, const YoloCaptureRequest* request, int32_t window_ms) {
+  yolo::CaptureRequest capture;
+  if (handle == nullptr || window_ms < 0 || !ToCaptureRequest(request, &capture)) {
+    return -1;
+  }
+  const int32_t id =
+      AsEngine(handle)->CaptureBest(std::move(capture), static_cast<int64_t>(window_ms) * 1000000);
+  return id > 0 ? id : -2;
+}
+
+int32_t YoloEngineGetCaptureStatus(void* handle, int32_t capture_id) {
+  if (handle == nullptr || capture_id <= 0) {
+    return YOLO_CAPTURE_FAILED;
+  }
+  return AsEngine(handle)->TakeCaptureStatus(capture_id);
+}
+
+int32_t YoloEngineCancelCapture(void* handle, int32_t capture_id) {
+  if (handle == nullptr || capture_id <= 0) {
+    return YOLO_CAPTURE_FAILED;
+  }
+  return AsEngine(handle)->CancelCapture(capture_id);
+}
+
+int32_t YoloEngineGetTuningInfo(void* handle, YoloTuningInfo* out) {
+  if (handle == nullptr || out == nullptr) {
+    return -1;
+  }
+  const yolo::TuningResult& tuning = AsEngine(handle)->tuning();
+  out->delegate = static_cast<int32_t>(tuning.config.delegate);
+  out->num_threads = tuning.config.num_threads;
+  out->invoke_us = static_cast<float>(tuning.invoke_us);
+  out->from_cache = tuning.from_cache ? 1 : 0;
+  out->candidates_tested = tuning.candidates_tested;
+  return 0;
+}
+
 int32_t YoloEngineProcessYuvFrame(void* handle, const uint8_t* y_plane, const uint8_t* u_plane,
                                   const uint8_t* v_plane, int32_t y_row_stride, int32_t uv_row_stride,
                                   int32_t uv_pixel_stride, int32_t width, int32_t height,
                                   int32_t rotation_degrees, YoloDetections* out) {
-  if (handle == nullptr || y_plane == nullptr || u_plane == nullptr || v_plane == nullptr ||
-      out == nullptr) {
+  YoloFrameDescriptor frame{};
+  frame.format = kYoloPixelFormatYuv420;
+  frame.width = width;
+  frame.height = height;
+  frame.rotation_degrees = rotation_degrees;
+  frame.planes[0] = y_plane;
+  frame.planes[1] = u_plane;
+  frame.planes[2] = v_plane;
+  frame.row_strides[0] = y_row_stride;
+  frame.row_strides[1] = uv_row_stride;
+  frame.row_strides[2] = uv_row_stride;
+  frame.pixel_strides[0] = 1;
+  frame.pixel_strides[1] = uv_pixel_stride;
+  frame.pixel_strides[2] = uv_pixel_stride;
+  return YoloEngineProcessFrame(handle, &frame, out);
+}
+
+int32_t YoloEngineProcessFrame(void* handle, const YoloFrameDescriptor* descriptor,
+                               YoloDetections* out) {
+  yolo::FrameMetadata frame{};
+  if (handle == nullptr || out == nullptr || !ToFrameMetadata(descriptor, &frame)) {
     return -1;
   }
-  yolo::FrameMetadata frame{y_plane,      u_plane,        v_plane,       width,
-                            height,       y_row_stride,   uv_row_stride, uv_pixel_stride,
-                            rotation_degrees};
   auto* engine = AsEngine(handle);
   std::vector<YoloDetection> detections;
-  if (!engine->ProcessFrame(frame, &detections)) {
-    return -2;
+  yolo::FrameReport report;
+  const yolo::FrameResult result = engine->ProcessFrame(frame, &detections, &report);
+  out->detections = nullptr;
+  out->classifications = nullptr;
+  out->count = 0;
+  out->capture_time_ns = frame.capture_time_ns;
+  out->receive_time_ns = static_cast<int64_t>(report.receive_ns);
+  out->inference_start_ns = static_cast<int64_t>(report.inference_start_ns);
+  out->decode_end_ns = static_cast<int64_t>(report.decode_end_ns);
+  out->predicted = report.predicted ? 1 : 0;
+  out->track_confidence = report.track_confidence;
+  out->sharpness = report.quality.sharpness;
+  out->mean_luma = report.quality.mean_luma;
+  out->dark_fraction = report.quality.dark_fraction;
+  out->bright_fraction = report.quality.bright_fraction;
+  out->low_quality = report.low_quality ? 1 : 0;
+  out->roi_left = report.roi.left;
+  out->roi_top = report.roi.top;
+  out->roi_right = report.roi.right;
+  out->roi_bottom = report.roi.bottom;
+  if (result != yolo::FrameResult::kProcessed) {
+    return yolo::FrameStatus(result);
   }
 
   if (detections.empty()) {
-    out->detections = nullptr;
-    out->count = 0;
     return 0;
   }
 
+  engine->stats().AddAllocations(1);
   auto* buffer = new YoloDetection[detections.size()];
   for (size_t i = 0; i < detections.size(); ++i) {
     buffer[i] = detections[i];
   }
   out->detections = buffer;
   out->count = static_cast<int32_t>(detections.size());
+  const std::vector<YoloClassification>& classifications = engine->classifications();
+  if (classifications.size() == detections.size()) {
+    engine->stats().AddAllocations(1);
+    out->classifications = new YoloClassification[classifications.size()];
+    std::copy(classifications.begin(), classifications.end(), out->classifications);
+  }
   return 0;
 }
 
+const YoloResultFrame* YoloEngineAcquireResults(void* handle) {
+  if (handle == nullptr) {
+    return nullptr;
+  }
+  return AsEngine(handle)->AcquireResults();
+}
+
 void YoloEngineReleaseDetections(YoloDetections* detections) {
   if (detections == nullptr || detections->detections == nullptr) {
     return;
   }
   delete[] detections->detections;
+  delete[] detections->classifications;
   detections->detections = nullptr;
+  detections->classifications = nullptr;
   detections->count = 0;
 }
 
+int32_t YoloEngineGetStats(void* handle, YoloEngineStats* out) {
+  if (handle == nullptr || out == nullptr) {
+    return -1;
+  }
+  AsEngine(handle)->stats().Snapshot(out);
+  AsEngine(handle)->governor().Snapshot(&out->governor);
+  AsEngine(handle)->placement().Snapshot(&out->placement);
+  return 0;
+}
+
+void YoloEngineResetStats(void* handle) {
+  if (handle == nullptr) {
+    return;
+  }
+  AsEngine(handle)->stats().Reset();
+}
+
+int32_t YoloEngineGetMemoryStats(void* handle, YoloMemoryStats* out) {
+  if (handle == nullptr || out == nullptr) {
+    return -1;
+  }
+  AsEngine(handle)->GetMemoryStats(out);
+  return 0;
+}
+
+int32_t YoloEngineStartTrace(void* handle, int32_t max_events) {
+  if (handle == nullptr || max_events <= 0) {
+    return -1;
+  }
+  AsEngine(handle)->trace().Start(static_cast<size_t>(max_events));
+  return 0;
+}
+
+void YoloEngineStopTrace(void* handle) {
+  if (handle == nullptr) {
+    return;
+  }
+  AsEngine(handle)->trace().Stop();
+}
+
+int32_t YoloEngineDumpTrace(void* handle, const char* path) {
+  if (handle == nullptr || path == nullptr) {
+    return -1;
+  }
+  const int64_t written = AsEngine(handle)->trace().DumpJson(path);
+  if (written < 0) {
+    return -2;
+  }
+  return static_cast<int32_t>(std::min<int64_t>(written, INT32_MAX));
+}
+
+int32_t YoloEngineStartRecording(void* handle, const char* path, int64_t max_bytes) {
+  if (handle == nullptr || path == nullptr || max_bytes < 0) {
+    return -1;
+  }
+  return AsEngine(handle)->StartRecording(path, static_cast<uint64_t>(max_bytes)) ? 0 : -2;
+}
+
+void YoloEngineStopRecording(void* handle) {
+  if (handle == nullptr) {
+    return;
+  }
+  AsEngine(handle)->StopRecording();
+}
+
+int32_t YoloEngineGetRecordingInfo(void* handle, YoloRecordingInfo* out) {
+  if (handle == nullptr || out == nullptr) {
+    return -1;
+  }
+  AsEngine(handle)->GetRecordingInfo(out);
+  return 0;
+}
+
 }  // extern "C"
@@ -0,0 +1,148 @@
+#include "engine_stats.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <ctime>
+
+namespace yolo {
+
+namespace {
+
+constexpr double kNanosPerMicro = 1000.0;
+
+void ResetCounter(std::atomic<uint64_t>* counter) {
+  counter->store(0, std::memory_order_relaxed);
+}
+
+uint64_t Load(const std::atomic<uint64_t>& counter) {
+  return counter.load(std::memory_order_relaxed);
+}
+
+}  // namespace
+
+uint64_t MonotonicNanos() {
+  return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                   std::chrono::steady_clock::now().time_since_epoch())
+                                   .count());
+}
+
+uint64_t ProcessCpuNanos() {
+  timespec now{};
+  if (clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &now) != 0) {
+    return 0;
+  }
+  return static_cast<uint64_t>(now.tv_sec) * 1'000'000'000ull + static_cast<uint64_t>(now.tv_nsec);
+}
+
+LatencyHistogram::LatencyHistogram() {
+  Reset();
+}
+
+int LatencyHistogram::BucketFor(uint64_t micros) {
+  const int bucket =
+      static_cast<int>(kSubBuckets * std::log2(1.0 + static_cast<double>(micros)));
+  return std::min(bucket, kBucketCount - 1);
+}
+
+double LatencyHistogram::BucketUpperMicros(int bucket) {
+  return std::exp2(static_cast<double>(bucket + 1) / kSubBuckets) - 1.0;
+}
+
+void LatencyHistogram::Record(uint64_t nanos) {
+  buckets_[BucketFor(nanos / 1000)].fetch_add(1, std::memory_order_relaxed);
+  count_.fetch_add(1, std::memory_order_relaxed);
+  sum_ns_.fetch_add(nanos, std::memory_order_relaxed);
+  uint64_t current_max = max_ns_.load(std::memory_order_relaxed);
+  while (nanos > current_max &&
+         !max_ns_.compare_exchange_weak(current_max, nanos, std::memory_order_relaxed)) {
+  }
+}
+
+void LatencyHistogram::Reset() {
+  for (auto& bucket : buckets_) {
+    ResetCounter(&bucket);
+  }
+  ResetCounter(&count_);
+  ResetCounter(&sum_ns_);
+  ResetCounter(&max_ns_);
+}
+
+void LatencyHistogram::Snapshot(YoloStageStats* out) const {
+  std::array<uint64_t, kBucketCount> counts;
+  uint64_t total = 0;
+  for (int i = 0; i < kBucketCount; ++i) {
+    counts[i] = Load(buckets_[i]);
+    total += counts[i];
+  }
+  const double max_us = static_cast<double>(Load(max_ns_)) / kNanosPerMicro;
+  out->count = total;
+  out->mean_us =
+      total == 0 ? 0.0f
+                 : static_cast<float>(static_cast<double>(Load(sum_ns_)) / kNanosPerMicro / total);
+  out->max_us = static_cast<float>(max_us);
+
+  auto percentile = [&](double fraction) -> float {
+    if (total == 0) {
+      return 0.0f;
+    }
+    const uint64_t rank = static_cast<uint64_t>(std::ceil(fraction * static_cast<double>(total)));
+    uint64_t seen = 0;
+    for (int i = 0; i < kBucketCount; ++i) {
+      seen += counts[i];
+      if (seen >= rank) {
+        return static_cast<float>(std::min(BucketUpperMicros(i), max_us));
+      }
+    }
+    return static_cast<float>(max_us);
+  };
+  out->p50_us = percentile(0.50);
+  out->p90_us = percentile(0.90);
+  out->p99_us = percentile(0.99);
+}
+
+void EngineStats::Reset() {
+  for (auto& histogram : histograms_) {
+    histogram.Reset();
+  }
+  ResetCounter(&frames_processed_);
+  ResetCounter(&frames_dropped_);
+  ResetCounter(&frames_expired_);
+  ResetCounter(&frames_tracked_);
+  ResetCounter(&crops_classified_);
+  ResetCounter(&classification_cache_hits_);
+  ResetCounter(&frames_low_quality_);
+  ResetCounter(&frames_zoomed_);
+  ResetCounter(&frames_governed_);
+  ResetCounter(&candidates_pre_nms_);
+  ResetCounter(&candidates_post_nms_);
+  ResetCounter(&allocations_);
+}
+
+void EngineStats::Snapshot(YoloEngineStats* out) const {
+  histograms_[static_cast<int>(Stage::kYuvToRgb)].Snapshot(&out->yuv_to_rgb);
+  histograms_[static_cast<int>(Stage::kRotate)].Snapshot(&out->rotate);
+  histograms_[static_cast<int>(Stage::kResize)].Snapshot(&out->resize);
+  histograms_[static_cast<int>(Stage::kInvoke)].Snapshot(&out->invoke);
+  histograms_[static_cast<int>(Stage::kDecode)].Snapshot(&out->decode);
+  histograms_[static_cast<int>(Stage::kTotal)].Snapshot(&out->total);
+  out->frames_processed = Load(frames_processed_);
+  out->frames_dropped = Load(frames_dropped_);
+  out->candidates_pre_nms = Load(candidates_pre_nms_);
+  out->candidates_post_nms = Load(candidates_post_nms_);
+  out->allocations = Load(allocations_);
+  out->frames_expired = Load(frames_expired_);
+  histograms_[static_cast<int>(Stage::kQueueWait)].Snapshot(&out->queue_wait);
+  histograms_[static_cast<int>(Stage::kCaptureToResult)].Snapshot(&out->capture_to_result);
+  out->frames_tracked = Load(frames_tracked_);
+  histograms_[static_cast<int>(Stage::kTrack)].Snapshot(&out->track);
+  out->crops_classified = Load(crops_classified_);
+  out->classification_cache_hits = Load(classification_cache_hits_);
+  histograms_[static_cast<int>(Stage::kClassify)].Snapshot(&out->classify);
+  out->frames_low_quality = Load(frames_low_quality_);
+  histograms_[static_cast<int>(Stage::kQuality)].Snapshot(&out->quality);
+  out->frames_zoomed = Load(frames_zoomed_);
+  out->frames_governed = Load(frames_governed_);
+}
+
+}  // namespace yolo
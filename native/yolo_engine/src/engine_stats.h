@@ -0,0 +1,103 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+#include "yolo_engine_api.h"
+
+namespace yolo {
+
+enum class Stage : int {
+  kYuvToRgb = 0,
+  kRotate,
+  kResize,
+  kInvoke,
+  kDecode,
+  kTotal,
+  // Capture timestamp to engine pickup / to end of decode.
+  kQueueWait,
+  kCaptureToResult,
+  // Optical-flow box propagation on frames that skip inference.
+  kTrack,
+  // Second-stage crop classifier.
+  kClassify,
+  // Blur/exposure pre-check.
+  kQuality,
+  kCount,
+};
+
+uint64_t MonotonicNanos();
+// CPU time consumed by all threads of the process so far.
+uint64_t ProcessCpuNanos();
+
+// Fixed-bucket latency histogram. Buckets are log-linear (four sub-buckets per
+// power of two of microseconds) so recording is a single relaxed increment and
+// percentiles stay within ~20% of the true value from 1us up to ~60s.
+class LatencyHistogram {
+ public:
+  static constexpr int kSubBuckets = 4;
+  static constexpr int kBucketCount = 26 * kSubBuckets;
+
+  LatencyHistogram();
+
+  void Record(uint64_t nanos);
+  void Reset();
+  void Snapshot(YoloStageStats* out) const;
+
+ private:
+  static int BucketFor(uint64_t micros);
+  static double BucketUpperMicros(int bucket);
+
+  std::array<std::atomic<uint64_t>, kBucketCount> buckets_;
+  std::atomic<uint64_t> count_{0};
+  std::atomic<uint64_t> sum_ns_{0};
+  std::atomic<uint64_t> max_ns_{0};
+};
+
+// Always-on engine counters. Writers are the frame thread; readers may be any
+// thread, so every field is a relaxed atomic and snapshots are best-effort.
+class EngineStats {
+ public:
+  void RecordStage(Stage stage, uint64_t nanos) {
+    histograms_[static_cast<int>(stage)].Record(nanos);
+  }
+  void AddFramesProcessed(uint64_t count) { Add(&frames_processed_, count); }
+  void AddFramesDropped(uint64_t count) { Add(&frames_dropped_, count); }
+  void AddFramesExpired(uint64_t count) { Add(&frames_expired_, count); }
+  void AddFramesTracked(uint64_t count) { Add(&frames_tracked_, count); }
+  void AddFramesLowQuality(uint64_t count) { Add(&frames_low_quality_, count); }
+  void AddFramesZoomed(uint64_t count) { Add(&frames_zoomed_, count); }
+  void AddFramesGoverned(uint64_t count) { Add(&frames_governed_, count); }
+  void AddCropsClassified(uint64_t count) { Add(&crops_classified_, count); }
+  void AddClassificationCacheHits(uint64_t count) { Add(&classification_cache_hits_, count); }
+  void AddCandidatesPreNms(uint64_t count) { Add(&candidates_pre_nms_, count); }
+  void AddCandidatesPostNms(uint64_t count) { Add(&candidates_post_nms_, count); }
+  void AddAllocations(uint64_t count) { Add(&allocations_, count); }
+
+  void Reset();
+  void Snapshot(YoloEngineStats* out) const;
+
+ private:
+  static void Add(std::atomic<uint64_t>* counter, uint64_t count) {
+    if (count != 0) {
+      counter->fetch_add(count, std::memory_order_relaxed);
+    }
+  }
+
+  std::array<LatencyHistogram, static_cast<int>(Stage::kCount)> histograms_;
+  std::atomic<uint64_t> frames_processed_{0};
+  std::atomic<uint64_t> frames_dropped_{0};
+  std::atomic<uint64_t> frames_expired_{0};
+  std::atomic<uint64_t> frames_tracked_{0};
+  std::atomic<uint64_t> crops_classified_{0};
+  std::atomic<uint64_t> classification_cache_hits_{0};
+  std::atomic<uint64_t> frames_low_quality_{0};
+  std::atomic<uint64_t> frames_zoomed_{0};
+  std::atomic<uint64_t> frames_governed_{0};
+  std::atomic<uint64_t> candidates_pre_nms_{0};
+  std::atomic<uint64_t> candidates_post_nms_{0};
+  std::atomic<uint64_t> allocations_{0};
+};
+
+}  // namespace yolo
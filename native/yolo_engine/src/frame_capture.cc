@@ -0,0 +1,287 @@
+#include "frame_capture.h"
+
+#include <zlib.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <utility>
+
+#include "log.h"
+
+namespace yolo {
+
+namespace {
+
+void PutBigEndian(uint32_t value, uint8_t* out) {
+  out[0] = static_cast<uint8_t>(value >> 24);
+  out[1] = static_cast<uint8_t>(value >> 16);
+  out[2] = static_cast<uint8_t>(value >> 8);
+  out[3] = static_cast<uint8_t>(value);
+}
+
+bool WriteChunk(std::FILE* file, const char type[4], const uint8_t* data, size_t size) {
+  uint8_t header[8];
+  PutBigEndian(static_cast<uint32_t>(size), header);
+  std::memcpy(header + 4, type, 4);
+  uLong crc = crc32(0L, header + 4, 4);
+  if (size > 0) {
+    crc = crc32(crc, data, static_cast<uInt>(size));
+  }
+  uint8_t trailer[4];
+  PutBigEndian(static_cast<uint32_t>(crc), trailer);
+  return std::fwrite(header, 1, 8, file) == 8 &&
+         (size == 0 || std::fwrite(data, 1, size, file) == size) &&
+         std::fwrite(trailer, 1, 4, file) == 4;
+}
+
+// Largest size that fits |max_side| with the aspect ratio kept; never
+// upscales. A |max_side| of 0 keeps the source size.
+void FitWithin(int width, int height, int max_side, int* out_width, int* out_height) {
+  const int longest = std::max(width, height);
+  if (max_side <= 0 || longest <= max_side) {
+    *out_width = width;
+    *out_height = height;
+    return;
+  }
+  const double scale = static_cast<double>(max_side) / longest;
+  *out_width = std::max(1, static_cast<int>(std::lround(width * scale)));
+  *out_height = std::max(1, static_cast<int>(std::lround(height * scale)));
+}
+
+}  // namespace
+
+bool WritePng(const std::string& path, const uint8_t* rgb, int width, int height) {
+  if (rgb == nullptr || width <= 0 || height <= 0) {
+    return false;
+  }
+  // Every row gets the Sub filter, which suits camera images well and costs
+  // one subtraction per byte.
+  const size_t row_bytes = static_cast<size_t>(width) * 3;
+  std::vector<uint8_t> filtered((row_bytes + 1) * height);
+  for (int y = 0; y < height; ++y) {
+    const uint8_t* src = rgb + row_bytes * y;
+    uint8_t* dst = filtered.data() + (row_bytes + 1) * y;
+    dst[0] = 1;
+    std::memcpy(dst + 1, src, 3);
+    for (size_t i = 3; i < row_bytes; ++i) {
+      dst[1 + i] = static_cast<uint8_t>(src[i] - src[i - 3]);
+    }
+  }
+  uLongf compressed_size = compressBound(static_cast<uLong>(filtered.size()));
+  std::vector<uint8_t> compressed(compressed_size);
+  if (compress2(compressed.data(), &compressed_size, filtered.data(),
+                static_cast<uLong>(filtered.size()), Z_DEFAULT_COMPRESSION) != Z_OK) {
+    return false;
+  }
+
+  std::FILE* file = std::fopen(path.c_str(), "wb");
+  if (file == nullptr) {
+    return false;
+  }
+  static const uint8_t kSignature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n'};
+  uint8_t header[13];
+  PutBigEndian(static_cast<uint32_t>(width), header);
+  PutBigEndian(static_cast<uint32_t>(height), header + 4);
+  header[8] = 8;   // bit depth
+  header[9] = 2;   // truecolour RGB
+  header[10] = 0;  // deflate
+  header[11] = 0;  // adaptive filtering
+  header[12] = 0;  // no interlace
+  const bool ok = std::fwrite(kSignature, 1, 8, file) == 8 &&
+                  WriteChunk(file, "IHDR", header, sizeof(header)) &&
+                  WriteChunk(file, "IDAT", compressed.data(), compressed_size) &&
+                  WriteChunk(file, "IEND", nullptr, 0);
+  return std::fclose(file) == 0 && ok;
+}
+
+CaptureWriter::~CaptureWriter() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopping_ = true;
+  }
+  jobs_cv_.notify_all();
+  if (thread_.joinable()) {
+    thread_.join();
+  }
+}
+
+void CaptureWriter::Submit(int32_t id, const CaptureRequest& request, const PixelView& frame,
+                           int model_width, int model_height) {
+  const YoloDetection& box = request.box;
+  int left = 0;
+  int top = 0;
+  int right = frame.width;
+  int bottom = frame.height;
+  if (box.right > box.left && box.bottom > box.top) {
+    const float to_frame_x = static_cast<float>(frame.width) / model_width;
+    const float to_frame_y = static_cast<float>(frame.height) / model_height;
+    const float margin_x = request.margin * (box.right - box.left);
+    const float margin_y = request.margin * (box.bottom - box.top);
+    left = std::clamp(static_cast<int>((box.left - margin_x) * to_frame_x), 0, frame.width - 1);
+    top = std::clamp(static_cast<int>((box.top - margin_y) * to_frame_y), 0, frame.height - 1);
+    right = std::clamp(static_cast<int>(std::ceil((box.right + margin_x) * to_frame_x)), left + 1,
+                       frame.width);
+    bottom = std::clamp(static_cast<int>(std::ceil((box.bottom + margin_y) * to_frame_y)),
+                        top + 1, frame.height);
+  }
+
+  // Raw rows only: the channel order and pixel stride travel with the view
+  // and are resolved by the resampler on the writer thread.
+  Job job;
+  job.id = id;
+  job.request = request;
+  const size_t row_bytes = static_cast<size_t>(right - left) * frame.pixel_stride;
+  job.pixels.resize(row_bytes * (bottom - top));
+  for (int y = top; y < bottom; ++y) {
+    std::memcpy(job.pixels.data() + row_bytes * (y - top),
+                frame.data + static_cast<size_t>(frame.row_stride) * y +
+                    static_cast<size_t>(left) * frame.pixel_stride,
+                row_bytes);
+  }
+  job.view = frame;
+  job.view.data = job.pixels.data();
+  job.view.width = right - left;
+  job.view.height = bottom - top;
+  job.view.row_stride = static_cast<int>(row_bytes);
+
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    status_.emplace(id, YOLO_CAPTURE_PENDING);
+    jobs_.push_back(std::move(job));
+    if (!thread_.joinable()) {
+      thread_ = std::thread(&CaptureWriter::Run, this);
+    }
+  }
+  jobs_cv_.notify_one();
+}
+
+void CaptureWriter::Reserve(int32_t id) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  status_.emplace(id, YOLO_CAPTURE_PENDING);
+}
+
+void CaptureWriter::MarkFailed(int32_t id) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  FinishLocked(id, YOLO_CAPTURE_FAILED);
+}
+
+int32_t CaptureWriter::TakeStatus(int32_t id) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = status_.find(id);
+  if (it == status_.end()) {
+    return YOLO_CAPTURE_FAILED;
+  }
+  const int32_t status = it->second;
+  if (status != YOLO_CAPTURE_PENDING) {
+    status_.erase(it);
+    --finished_;
+  }
+  return status;
+}
+
+int32_t CaptureWriter::Cancel(int32_t id) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = status_.find(id);
+  if (it == status_.end()) {
+    return YOLO_CAPTURE_FAILED;
+  }
+  const int32_t status = it->second;
+  status_.erase(it);
+  if (status != YOLO_CAPTURE_PENDING) {
+    --finished_;
+    return status;
+  }
+  if (id == writing_) {
+    writing_cancelled_ = true;
+  }
+  jobs_.erase(std::remove_if(jobs_.begin(), jobs_.end(),
+                             [id](const Job& job) { return job.id == id; }),
+              jobs_.end());
+  return status;
+}
+
+void CaptureWriter::FinishLocked(int32_t id, int32_t status) {
+  auto it = status_.find(id);
+  if (it != status_.end() && it->second != YOLO_CAPTURE_PENDING) {
+    it->second = status;
+    return;
+  }
+  status_[id] = status;
+  ++finished_;
+  for (auto oldest = status_.begin(); finished_ > kMaxFinished && oldest != status_.end();) {
+    if (oldest->second == YOLO_CAPTURE_PENDING) {
+      ++oldest;
+      continue;
+    }
+    oldest = status_.erase(oldest);
+    --finished_;
+  }
+}
+
+void CaptureWriter::Run() {
+  for (;;) {
+    Job job;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      jobs_cv_.wait(lock, [this] { return stopping_ || !jobs_.empty(); });
+      if (jobs_.empty()) {
+        return;
+      }
+      job = std::move(jobs_.front());
+      jobs_.pop_front();
+      writing_ = job.id;
+      writing_cancelled_ = false;
+    }
+    job.view.data = job.pixels.data();
+    const bool ok = Write(job);
+    bool cancelled = false;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      writing_ = 0;
+      cancelled = writing_cancelled_;
+      if (!cancelled) {
+        FinishLocked(job.id, ok ? YOLO_CAPTURE_DONE : YOLO_CAPTURE_FAILED);
+      }
+    }
+    // Nobody collects a cancelled capture's files, and half-written ones are
+    // no use either.
+    if (!ok || cancelled) {
+      std::remove(job.request.crop_path.c_str());
+      if (!job.request.thumbnail_path.empty()) {
+        std::remove(job.request.thumbnail_path.c_str());
+      }
+    }
+    if (!ok && !cancelled) {
+      LogMessage("capture: failed to write " + job.request.crop_path);
+    }
+  }
+}
+
+bool CaptureWriter::Write(const Job& job) const {
+  int crop_width = 0;
+  int crop_height = 0;
+  FitWithin(job.view.width, job.view.height, job.request.crop_max_side, &crop_width,
+            &crop_height);
+  std::vector<uint8_t> crop(static_cast<size_t>(crop_width) * crop_height * 3);
+  ResampleArea(job.view, crop_width, crop_height, crop.data());
+  if (!job.request.crop_path.empty() &&
+      !WritePng(job.request.crop_path, crop.data(), crop_width, crop_height)) {
+    return false;
+  }
+  if (job.request.thumbnail_path.empty() || job.request.thumbnail_max_side <= 0) {
+    return true;
+  }
+  // The thumbnail is reduced from the original pixels, not the already
+  // downsampled crop, so it is filtered only once.
+  int thumb_width = 0;
+  int thumb_height = 0;
+  FitWithin(job.view.width, job.view.height, job.request.thumbnail_max_side, &thumb_width,
+            &thumb_height);
+  std::vector<uint8_t> thumbnail(static_cast<size_t>(thumb_width) * thumb_height * 3);
+  ResampleArea(job.view, thumb_width, thumb_height, thumbnail.data());
+  return WritePng(job.request.thumbnail_path, thumbnail.data(), thumb_width, thumb_height);
+}
+
+}  // namespace yolo
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "image_utils.h"
+#include "yolo_engine_api.h"
+
+namespace yolo {
+
+// A still requested from the live stream. The box is in detector input
+// coordinates; an empty box means the whole frame.
+struct CaptureRequest {
+  YoloDetection box{};
+  float margin = 0.0f;
+  int crop_max_side = 0;
+  int thumbnail_max_side = 0;
+  std::string crop_path;
+  std::string thumbnail_path;
+};
+
+// Writes requested stills off the frame thread. The frame thread only copies
+// the crop's source rows out of the frame (Submit); downsampling and PNG
+// encoding happen on a writer thread started on first use.
+class CaptureWriter {
+ public:
+  CaptureWriter() = default;
+  // Finishes queued captures before returning; they are user photos.
+  ~CaptureWriter();
+
+  CaptureWriter(const CaptureWriter&) = delete;
+  CaptureWriter& operator=(const CaptureWriter&) = delete;
+
+  // Registers |id| as pending before its frame has arrived.
+  void Reserve(int32_t id);
+  // Copies the part of |frame| covered by |request| (|model_width| x
+  // |model_height| coordinates) and queues it under |id|.
+  void Submit(int32_t id, const CaptureRequest& request, const PixelView& frame, int model_width,
+              int model_height);
+  void MarkFailed(int32_t id);
+  // YOLO_CAPTURE_* status of |id|. Finished ids are forgotten once read, or
+  // once kMaxFinished newer captures have finished unread; forgotten and
+  // unknown ids read as failed.
+  int32_t TakeStatus(int32_t id);
+  // Forgets |id| and returns its status at the time of the call. A pending
+  // capture is dropped from the queue or, if it is being written, has its
+  // files removed once the write ends, so nothing of it is left on disk. A
+  // finished one keeps its files.
+  int32_t Cancel(int32_t id);
+
+ private:
+  struct Job {
+    int32_t id = 0;
+    CaptureRequest request;
+    std::vector<uint8_t> pixels;
+    PixelView view;
+  };
+
+  // Finished statuses kept for callers that never read them.
+  static constexpr size_t kMaxFinished = 32;
+
+  void Run();
+  bool Write(const Job& job) const;
+  // Records a finished status, evicting the oldest unread ones past
+  // kMaxFinished. Requires |mutex_|.
+  void FinishLocked(int32_t id, int32_t status);
+
+  std::mutex mutex_;
+  std::condition_variable jobs_cv_;
+  std::thread thread_;
+  std::deque<Job> jobs_;
+  // Every id from Reserve()/Submit() until it is read or cancelled; ids
+  // increase, so the first finished entry is the oldest.
+  std::map<int32_t, int32_t> status_;
+  size_t finished_ = 0;
+  // Id of the job on the writer thread, and whether it was cancelled.
+  int32_t writing_ = 0;
+  bool writing_cancelled_ = false;
+  bool stopping_ = false;
+};
+
+// Encodes tightly packed RGB8 as a PNG file.
+bool WritePng(const std::string& path, const uint8_t* rgb, int width, int height);
+
+}  // namespace yolo
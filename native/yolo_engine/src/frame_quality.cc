@@ -0,0 +1,77 @@
+#include "frame_quality.h"
+
+#include <algorithm>
+#include <cstdint>
+
+#include "image_utils.h"
+#include "yolo_engine.h"
+
+namespace yolo {
+
+namespace {
+
+constexpr int kQualityGrid = 160;
+constexpr int kDarkLuma = 16;
+constexpr int kBrightLuma = 240;
+
+}  // namespace
+
+bool MeasureFrameQuality(const FrameMetadata& frame, int model_long_side, FrameQuality* out) {
+  PixelView view;
+  if (frame.format == PixelFormat::kYuv420) {
+    if (frame.y_plane == nullptr || frame.width <= 0 || frame.height <= 0) {
+      return false;
+    }
+    view.data = frame.y_plane;
+    view.width = frame.width;
+    view.height = frame.height;
+    view.row_stride = frame.y_row_stride;
+    view.pixel_stride = 1;
+    view.channel = {0, 0, 0};
+  } else if (!PackedFrameView(frame, &view)) {
+    return false;
+  }
+
+  // Laplacian taps one model pixel apart; samples on a coarser grid.
+  const int long_side = std::max(view.width, view.height);
+  const int tap = std::max(1, long_side / std::max(1, model_long_side));
+  const int step = std::max(tap, (long_side + kQualityGrid - 1) / kQualityGrid);
+  uint32_t histogram[256] = {};
+  double sum = 0.0;
+  double sum_squares = 0.0;
+  uint32_t count = 0;
+  for (int y = tap; y + tap < view.height; y += step) {
+    for (int x = tap; x + tap < view.width; x += step) {
+      const int center = LumaAt(view, x, y);
+      const int laplacian = LumaAt(view, x - tap, y) + LumaAt(view, x + tap, y) +
+                            LumaAt(view, x, y - tap) + LumaAt(view, x, y + tap) - 4 * center;
+      ++histogram[center];
+      sum += laplacian;
+      sum_squares += static_cast<double>(laplacian) * laplacian;
+      ++count;
+    }
+  }
+  if (count == 0) {
+    return false;
+  }
+
+  uint64_t luma_total = 0;
+  uint32_t dark = 0;
+  uint32_t bright = 0;
+  for (int value = 0; value < 256; ++value) {
+    luma_total += static_cast<uint64_t>(value) * histogram[value];
+    if (value <= kDarkLuma) {
+      dark += histogram[value];
+    } else if (value >= kBrightLuma) {
+      bright += histogram[value];
+    }
+  }
+  const double mean = sum / count;
+  out->sharpness = static_cast<float>(sum_squares / count - mean * mean);
+  out->mean_luma = static_cast<float>(luma_total) / count;
+  out->dark_fraction = static_cast<float>(dark) / count;
+  out->bright_fraction = static_cast<float>(bright) / count;
+  return true;
+}
+
+}  // namespace yolo
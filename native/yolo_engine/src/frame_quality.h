@@ -0,0 +1,32 @@
+#pragma once
+
+namespace yolo {
+
+struct FrameMetadata;
+
+enum class QualityGate : int {
+  kOff = 0,
+  // Measure and report, but infer every frame.
+  kFlag = 1,
+  // Skip inference on frames that fail the check.
+  kSkip = 2,
+};
+
+// Cheap image statistics over a decimated luma grid (at most 160 samples
+// across). |sharpness| is the variance of a 4-neighbour Laplacian whose taps
+// are spaced at the detector's input scale, so blur that would survive the
+// resize to the model lowers it and finer sensor noise does not raise it.
+// The luma fractions come from a histogram of the same samples.
+struct FrameQuality {
+  float sharpness = 0.0f;
+  float mean_luma = 0.0f;
+  // Samples at or below 16, and at or above 240.
+  float dark_fraction = 0.0f;
+  float bright_fraction = 0.0f;
+};
+
+// |model_long_side| is the longer side of the detector input. Returns false
+// for frames it cannot read.
+bool MeasureFrameQuality(const FrameMetadata& frame, int model_long_side, FrameQuality* out);
+
+}  // namespace yolo
@@ -0,0 +1,405 @@
+#include "frame_recorder.h"
+
+#include <algorithm>
+#include <cstring>
+#include <utility>
+
+#include "engine_stats.h"
+#include "image_utils.h"
+#include "log.h"
+#include "yolo_engine.h"
+
+#if defined(__linux__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace yolo {
+
+namespace {
+
+// Frames waiting for the writer before new ones are left out. A few frames
+// ride out a slow flash write without letting memory grow with the backlog.
+constexpr size_t kMaxQueuedChunks = 4;
+
+size_t AlignUp(size_t bytes) {
+  return (bytes + kRecordingAlignment - 1) / kRecordingAlignment * kRecordingAlignment;
+}
+
+int PackedBytesPerPixel(PixelFormat format) {
+  return format == PixelFormat::kRgb || format == PixelFormat::kBgr ? 3 : 4;
+}
+
+// One plane as it is copied into the chunk: |samples| bytes per row, read
+// |source_pixel_stride| apart, stored packed.
+struct PlaneCopy {
+  const uint8_t* source = nullptr;
+  int source_row_stride = 0;
+  int source_pixel_stride = 1;
+  int samples = 0;
+  int rows = 0;
+  size_t offset = 0;
+
+  size_t bytes() const { return static_cast<size_t>(samples) * rows; }
+};
+
+void CopyPlane(const PlaneCopy& plane, uint8_t* chunk) {
+  uint8_t* out = chunk + plane.offset;
+  for (int y = 0; y < plane.rows; ++y) {
+    const uint8_t* row = plane.source + static_cast<size_t>(plane.source_row_stride) * y;
+    if (plane.source_pixel_stride == 1) {
+      std::memcpy(out, row, static_cast<size_t>(plane.samples));
+    } else {
+      for (int x = 0; x < plane.samples; ++x) {
+        out[x] = row[static_cast<size_t>(x) * plane.source_pixel_stride];
+      }
+    }
+    out += plane.samples;
+  }
+}
+
+}  // namespace
+
+FrameRecorder::~FrameRecorder() { Stop(); }
+
+bool FrameRecorder::Start(const std::string& path, uint64_t max_bytes,
+                          const RecordingFileHeader& header) {
+  std::lock_guard<std::mutex> control(control_mutex_);
+  StopLocked();
+  std::FILE* file = std::fopen(path.c_str(), "wb");
+  if (file == nullptr) {
+    LogMessage("recorder: failed to create " + path);
+    return false;
+  }
+  RecordingFileHeader file_header = header;
+  std::memcpy(file_header.magic, kRecordingMagic, sizeof(kRecordingMagic));
+  file_header.version = kRecordingVersion;
+  file_header.header_bytes = sizeof(RecordingFileHeader);
+  file_header.start_time_ns = static_cast<int64_t>(MonotonicNanos());
+  if (std::fwrite(&file_header, sizeof(file_header), 1, file) != 1) {
+    std::fclose(file);
+    LogMessage("recorder: failed to write " + path);
+    return false;
+  }
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  file_ = file;
+  max_bytes_ = max_bytes;
+  accepted_bytes_ = sizeof(RecordingFileHeader);
+  frames_recorded_.store(0, std::memory_order_relaxed);
+  frames_dropped_.store(0, std::memory_order_relaxed);
+  bytes_written_.store(sizeof(RecordingFileHeader), std::memory_order_relaxed);
+  state_.store(kYoloRecordingActive, std::memory_order_relaxed);
+  recording_.store(true, std::memory_order_relaxed);
+  thread_ = std::thread(&FrameRecorder::Run, this);
+  return true;
+}
+
+void FrameRecorder::Stop() {
+  std::lock_guard<std::mutex> control(control_mutex_);
+  StopLocked();
+}
+
+void FrameRecorder::StopLocked() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (file_ == nullptr) {
+      return;
+    }
+    recording_.store(false, std::memory_order_relaxed);
+    stopping_ = true;
+  }
+  chunks_cv_.notify_all();
+  if (thread_.joinable()) {
+    thread_.join();
+  }
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (std::fclose(file_) != 0) {
+    state_.store(kYoloRecordingFailed, std::memory_order_relaxed);
+  }
+  file_ = nullptr;
+  stopping_ = false;
+  free_.clear();
+  free_.shrink_to_fit();
+  buffer_bytes_.store(0, std::memory_order_relaxed);
+  // A recording that filled up or failed keeps saying so until the next one.
+  int32_t active = kYoloRecordingActive;
+  state_.compare_exchange_strong(active, kYoloRecordingIdle, std::memory_order_relaxed);
+}
+
+void FrameRecorder::Record(const FrameMetadata& frame, uint64_t sequence, int32_t status,
+                           const std::vector<YoloDetection>& detections,
+                           const DecodeSettings& decode, int64_t receive_time_ns,
+                           int64_t decode_end_ns, bool predicted) {
+  if (!recording() || frame.y_plane == nullptr || frame.width <= 0 || frame.height <= 0) {
+    return;
+  }
+  RecordedFrameHeader header{};
+  header.magic = kRecordedFrameMagic;
+  header.header_bytes = sizeof(RecordedFrameHeader);
+  header.sequence = sequence;
+  header.capture_time_ns = frame.capture_time_ns;
+  header.deadline_ns = frame.deadline_ns;
+  header.receive_time_ns = receive_time_ns;
+  header.decode_end_ns = decode_end_ns;
+  header.format = static_cast<int32_t>(frame.format);
+  header.width = frame.width;
+  header.height = frame.height;
+  header.rotation_degrees = frame.rotation_degrees;
+  header.status = status;
+  header.predicted = predicted ? 1 : 0;
+  header.roi_left = frame.roi.left;
+  header.roi_top = frame.roi.top;
+  header.roi_right = frame.roi.right;
+  header.roi_bottom = frame.roi.bottom;
+  header.confidence_threshold = decode.confidence_threshold;
+  header.iou_threshold = decode.iou_threshold;
+  header.max_detections = decode.max_detections;
+  header.decode_flags =
+      decode.class_thresholds.empty() && decode.class_enabled.empty() ? 0 : kRecordedClassFilters;
+
+  PlaneCopy planes[3];
+  int plane_count = 1;
+  planes[0].source = frame.y_plane;
+  planes[0].source_row_stride = frame.y_row_stride;
+  planes[0].rows = frame.height;
+  if (frame.format != PixelFormat::kYuv420) {
+    const int pixel_bytes = PackedBytesPerPixel(frame.format);
+    planes[0].samples = frame.width * pixel_bytes;
+    header.row_strides[0] = planes[0].samples;
+    header.pixel_strides[0] = pixel_bytes;
+  } else {
+    if (frame.u_plane == nullptr || frame.v_plane == nullptr) {
+      return;
+    }
+    planes[0].samples = frame.width;
+    header.row_strides[0] = frame.width;
+    header.pixel_strides[0] = 1;
+    const int chroma_width = (frame.width + 1) / 2;
+    const int chroma_height = (frame.height + 1) / 2;
+    const ChromaLayout layout = DetectChromaLayout(frame);
+    if (layout == ChromaLayout::kNv12 || layout == ChromaLayout::kNv21) {
+      // One block from whichever plane comes first in memory; the other is
+      // the next byte.
+      plane_count = 2;
+      planes[1].source = layout == ChromaLayout::kNv12 ? frame.u_plane : frame.v_plane;
+      planes[1].source_row_stride = frame.uv_row_stride;
+      planes[1].samples = chroma_width * 2;
+      planes[1].rows = chroma_height;
+      header.row_strides[1] = header.row_strides[2] = chroma_width * 2;
+      header.pixel_strides[1] = header.pixel_strides[2] = 2;
+    } else {
+      plane_count = 3;
+      for (int i = 1; i < 3; ++i) {
+        planes[i].source = i == 1 ? frame.u_plane : frame.v_plane;
+        planes[i].source_row_stride = frame.uv_row_stride;
+        planes[i].source_pixel_stride = std::max(1, frame.uv_pixel_stride);
+        planes[i].samples = chroma_width;
+        planes[i].rows = chroma_height;
+        header.row_strides[i] = chroma_width;
+        header.pixel_strides[i] = 1;
+      }
+    }
+  }
+
+  size_t offset = AlignUp(sizeof(RecordedFrameHeader));
+  for (int i = 0; i < plane_count; ++i) {
+    planes[i].offset = offset;
+    offset += AlignUp(planes[i].bytes());
+  }
+  header.plane_offsets[0] = static_cast<uint32_t>(planes[0].offset);
+  if (frame.format == PixelFormat::kYuv420) {
+    if (plane_count == 2) {
+      const bool nv12 = planes[1].source == frame.u_plane;
+      header.plane_offsets[1] = static_cast<uint32_t>(planes[1].offset + (nv12 ? 0 : 1));
+      header.plane_offsets[2] = static_cast<uint32_t>(planes[1].offset + (nv12 ? 1 : 0));
+    } else {
+      header.plane_offsets[1] = static_cast<uint32_t>(planes[1].offset);
+      header.plane_offsets[2] = static_cast<uint32_t>(planes[2].offset);
+    }
+  }
+  const size_t detection_count = status == 0 ? detections.size() : 0;
+  header.detections_offset = static_cast<uint32_t>(offset);
+  header.detection_count = static_cast<int32_t>(detection_count);
+  offset += AlignUp(detection_count * sizeof(YoloDetection));
+  header.chunk_bytes = offset;
+
+  std::vector<uint8_t> chunk;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (file_ == nullptr || stopping_ || !recording()) {
+      return;
+    }
+    if (queue_.size() >= kMaxQueuedChunks) {
+      frames_dropped_.fetch_add(1, std::memory_order_relaxed);
+      return;
+    }
+    if (max_bytes_ > 0 && accepted_bytes_ + offset > max_bytes_) {
+      recording_.store(false, std::memory_order_relaxed);
+      state_.store(kYoloRecordingFull, std::memory_order_relaxed);
+      frames_dropped_.fetch_add(1, std::memory_order_relaxed);
+      return;
+    }
+    accepted_bytes_ += offset;
+    if (!free_.empty()) {
+      chunk = std::move(free_.back());
+      free_.pop_back();
+    }
+  }
+  // Buffers only grow, so after the first few frames of a stream this is a
+  // plain copy.
+  const size_t capacity = chunk.capacity();
+  chunk.resize(offset);
+  if (chunk.capacity() != capacity) {
+    buffer_bytes_.fetch_add(static_cast<int64_t>(chunk.capacity() - capacity),
+                            std::memory_order_relaxed);
+  }
+  std::memcpy(chunk.data(), &header, sizeof(header));
+  for (int i = 0; i < plane_count; ++i) {
+    CopyPlane(planes[i], chunk.data());
+  }
+  if (detection_count > 0) {
+    std::memcpy(chunk.data() + header.detections_offset, detections.data(),
+                detection_count * sizeof(YoloDetection));
+  }
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    queue_.push_back(std::move(chunk));
+  }
+  chunks_cv_.notify_one();
+}
+
+void FrameRecorder::GetInfo(YoloRecordingInfo* out) const {
+  out->state = state_.load(std::memory_order_relaxed);
+  out->frames_recorded = frames_recorded_.load(std::memory_order_relaxed);
+  out->frames_dropped = frames_dropped_.load(std::memory_order_relaxed);
+  out->bytes_written = bytes_written_.load(std::memory_order_relaxed);
+  out->buffer_bytes = buffer_bytes_.load(std::memory_order_relaxed);
+}
+
+void FrameRecorder::Run() {
+  for (;;) {
+    std::vector<uint8_t> chunk;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      chunks_cv_.wait(lock, [this] { return stopping_ || !queue_.empty(); });
+      if (queue_.empty()) {
+        return;
+      }
+      chunk = std::move(queue_.front());
+      queue_.pop_front();
+    }
+    const bool ok = state_.load(std::memory_order_relaxed) != kYoloRecordingFailed &&
+                    std::fwrite(chunk.data(), 1, chunk.size(), file_) == chunk.size();
+    if (ok) {
+      frames_recorded_.fetch_add(1, std::memory_order_relaxed);
+      bytes_written_.fetch_add(static_cast<int64_t>(chunk.size()), std::memory_order_relaxed);
+    } else {
+      frames_dropped_.fetch_add(1, std::memory_order_relaxed);
+      if (state_.exchange(kYoloRecordingFailed, std::memory_order_relaxed) !=
+          kYoloRecordingFailed) {
+        recording_.store(false, std::memory_order_relaxed);
+        LogMessage("recorder: write failed, recording stopped");
+      }
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    free_.push_back(std::move(chunk));
+  }
+}
+
+RecordingReader::~RecordingReader() {
+#if defined(__linux__)
+  if (data_ != nullptr) {
+    munmap(const_cast<uint8_t*>(data_), size_);
+  }
+#endif
+}
+
+bool RecordingReader::Open(const std::string& path) {
+#if defined(__linux__)
+  if (data_ != nullptr) {
+    munmap(const_cast<uint8_t*>(data_), size_);
+    data_ = nullptr;
+    size_ = 0;
+  }
+  frames_.clear();
+  const int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    return false;
+  }
+  struct stat info {};
+  if (fstat(fd, &info) != 0 || info.st_size < static_cast<off_t>(sizeof(RecordingFileHeader))) {
+    close(fd);
+    return false;
+  }
+  void* mapped = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (mapped == MAP_FAILED) {
+    return false;
+  }
+  data_ = static_cast<const uint8_t*>(mapped);
+  size_ = static_cast<size_t>(info.st_size);
+  madvise(mapped, size_, MADV_SEQUENTIAL);
+  std::memcpy(&header_, data_, sizeof(header_));
+  if (std::memcmp(header_.magic, kRecordingMagic, sizeof(kRecordingMagic)) != 0 ||
+      header_.version != kRecordingVersion || header_.header_bytes < sizeof(RecordingFileHeader)) {
+    return false;
+  }
+
+  size_t offset = AlignUp(header_.header_bytes);
+  while (offset + sizeof(RecordedFrameHeader) <= size_) {
+    const auto* chunk = reinterpret_cast<const RecordedFrameHeader*>(data_ + offset);
+    if (chunk->magic != kRecordedFrameMagic || chunk->chunk_bytes < sizeof(RecordedFrameHeader) ||
+        chunk->chunk_bytes > size_ - offset) {
+      break;
+    }
+    const uint64_t detections_end =
+        chunk->detections_offset +
+        static_cast<uint64_t>(std::max(0, chunk->detection_count)) * sizeof(YoloDetection);
+    bool valid = detections_end <= chunk->chunk_bytes;
+    for (uint32_t plane_offset : chunk->plane_offsets) {
+      valid = valid && plane_offset < chunk->chunk_bytes;
+    }
+    if (!valid) {
+      break;
+    }
+    frames_.push_back(chunk);
+    offset += static_cast<size_t>(chunk->chunk_bytes);
+  }
+  return true;
+#else
+  (void)path;
+  return false;
+#endif
+}
+
+YoloFrameDescriptor RecordingReader::Descriptor(const RecordedFrameHeader& chunk) {
+  const auto* base = reinterpret_cast<const uint8_t*>(&chunk);
+  YoloFrameDescriptor descriptor{};
+  descriptor.format = chunk.format;
+  descriptor.width = chunk.width;
+  descriptor.height = chunk.height;
+  descriptor.rotation_degrees = chunk.rotation_degrees;
+  const int planes = chunk.format == kYoloPixelFormatYuv420 ? 3 : 1;
+  for (int i = 0; i < planes; ++i) {
+    descriptor.planes[i] = base + chunk.plane_offsets[i];
+    descriptor.row_strides[i] = chunk.row_strides[i];
+    descriptor.pixel_strides[i] = chunk.pixel_strides[i];
+  }
+  descriptor.capture_time_ns = chunk.capture_time_ns;
+  descriptor.deadline_ns = chunk.deadline_ns;
+  descriptor.roi_left = chunk.roi_left;
+  descriptor.roi_top = chunk.roi_top;
+  descriptor.roi_right = chunk.roi_right;
+  descriptor.roi_bottom = chunk.roi_bottom;
+  return descriptor;
+}
+
+const YoloDetection* RecordingReader::Detections(const RecordedFrameHeader& chunk) {
+  return reinterpret_cast<const YoloDetection*>(reinterpret_cast<const uint8_t*>(&chunk) +
+                                                chunk.detections_offset);
+}
+
+}  // namespace yolo
@@ -0,0 +1,194 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "yolo_engine_api.h"
+
+namespace yolo {
+
+struct DecodeSettings;
+struct FrameMetadata;
+
+// Recording container. A RecordingFileHeader is followed by one chunk per
+// submitted frame: a RecordedFrameHeader, then the frame's planes and the
+// detections the engine answered with, each at a 64-byte aligned offset from
+// the chunk start. Chunks are padded to 64 bytes too, so once the file is
+// mapped every plane can be handed back to the engine in place. Planes are
+// stored without row padding; NV12/NV21 chroma stays one interleaved block so
+// a replayed frame takes the same conversion path as the live one. Fields are
+// in the writer's byte order. A recording cut short by a crash ends at its
+// last complete chunk.
+inline constexpr char kRecordingMagic[8] = {'Y', 'O', 'L', 'O', 'R', 'E', 'C', '1'};
+// Version 2 added the options after inference_interval and the per-frame
+// decode settings; version 1 files are not read.
+inline constexpr uint32_t kRecordingVersion = 2;
+// "YRFR" read as little-endian bytes.
+inline constexpr uint32_t kRecordedFrameMagic = 0x52465259;
+inline constexpr size_t kRecordingAlignment = 64;
+
+// The options the recorded results depend on, so a replay can match them.
+// Booleans are 0 or 1; quality_gate is a YoloQualityGate. classifier is 1
+// when a crop classifier ran (its model is not part of the recording), and
+// use_gpu when the detector ran on the GPU delegate.
+struct RecordingFileHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t header_bytes;
+  int64_t start_time_ns;
+  int32_t input_width;
+  int32_t input_height;
+  int32_t num_threads;
+  int32_t max_detections;
+  float confidence_threshold;
+  float iou_threshold;
+  int32_t inference_interval;
+  float min_track_confidence;
+  int32_t quality_gate;
+  float min_sharpness;
+  float max_clipped_fraction;
+  int32_t auto_zoom;
+  int32_t governor;
+  float governor_max_fps;
+  float governor_max_duty_cycle;
+  float governor_max_cpu_ms_per_s;
+  int32_t governor_idle_after_ms;
+  float governor_idle_fps;
+  int32_t classifier;
+  int32_t classifier_top_k;
+  float classifier_min_score;
+  int32_t use_gpu;
+  int32_t reserved[3];
+};
+static_assert(sizeof(RecordingFileHeader) == 128, "RecordingFileHeader layout");
+
+// Set in RecordedFrameHeader.decode_flags when per-class thresholds or an
+// enabled-class list were in effect; the recording does not hold them.
+inline constexpr int32_t kRecordedClassFilters = 1;
+
+// Plane offsets are from the start of the chunk. |status| is what
+// YoloEngineProcessFrame returned for the frame; detections are only stored
+// for frames that returned 0. The decode settings are the ones the frame was
+// decoded with, which YoloEngineUpdateDecodeConfig() may have changed since
+// the recording started.
+struct RecordedFrameHeader {
+  uint32_t magic;
+  uint32_t header_bytes;
+  uint64_t chunk_bytes;
+  uint64_t sequence;
+  int64_t capture_time_ns;
+  int64_t deadline_ns;
+  int64_t receive_time_ns;
+  int64_t decode_end_ns;
+  int32_t format;
+  int32_t width;
+  int32_t height;
+  int32_t rotation_degrees;
+  int32_t row_strides[3];
+  int32_t pixel_strides[3];
+  uint32_t plane_offsets[3];
+  uint32_t detections_offset;
+  int32_t detection_count;
+  int32_t status;
+  int32_t predicted;
+  float roi_left;
+  float roi_top;
+  float roi_right;
+  float roi_bottom;
+  float confidence_threshold;
+  float iou_threshold;
+  int32_t max_detections;
+  int32_t decode_flags;
+  int32_t reserved;
+};
+static_assert(sizeof(RecordedFrameHeader) == 160, "RecordedFrameHeader layout");
+
+// Writes submitted frames and their results to a recording. The frame thread
+// copies each frame into a reusable buffer laid out exactly as its chunk
+// (Record); a writer thread appends the chunks to the file. When the writer
+// falls behind by more than a few frames, or the file would pass its size
+// limit, frames are left out of the recording rather than holding up the
+// stream; sequence numbers show the gaps.
+class FrameRecorder {
+ public:
+  FrameRecorder() = default;
+  // Writes out queued frames before returning.
+  ~FrameRecorder();
+
+  FrameRecorder(const FrameRecorder&) = delete;
+  FrameRecorder& operator=(const FrameRecorder&) = delete;
+
+  // Creates |path| and starts a recording, ending any previous one first.
+  // |header| supplies the recorded options; its magic, version and start
+  // time are filled in. |max_bytes| of 0 leaves the size unbounded.
+  bool Start(const std::string& path, uint64_t max_bytes, const RecordingFileHeader& header);
+  // Drains the queue and closes the file.
+  void Stop();
+  bool recording() const { return recording_.load(std::memory_order_relaxed); }
+
+  void Record(const FrameMetadata& frame, uint64_t sequence, int32_t status,
+              const std::vector<YoloDetection>& detections, const DecodeSettings& decode,
+              int64_t receive_time_ns, int64_t decode_end_ns, bool predicted);
+  void GetInfo(YoloRecordingInfo* out) const;
+
+ private:
+  void Run();
+  void Finish(int32_t state);
+  // Stop() with |control_mutex_| held.
+  void StopLocked();
+
+  // Serializes Start() and Stop(); the frame thread never waits on it.
+  std::mutex control_mutex_;
+  mutable std::mutex mutex_;
+  std::condition_variable chunks_cv_;
+  std::thread thread_;
+  std::FILE* file_ = nullptr;
+  std::deque<std::vector<uint8_t>> queue_;
+  std::vector<std::vector<uint8_t>> free_;
+  bool stopping_ = false;
+  uint64_t max_bytes_ = 0;
+  // Bytes of the header and every chunk accepted so far, written or queued.
+  uint64_t accepted_bytes_ = 0;
+  std::atomic<bool> recording_{false};
+  std::atomic<int32_t> state_{kYoloRecordingIdle};
+  std::atomic<int64_t> frames_recorded_{0};
+  std::atomic<int64_t> frames_dropped_{0};
+  std::atomic<int64_t> bytes_written_{0};
+  std::atomic<int64_t> buffer_bytes_{0};
+};
+
+// Read side of a recording, for tools: maps the file and walks its chunks.
+// Linux only; Open() fails elsewhere.
+class RecordingReader {
+ public:
+  RecordingReader() = default;
+  ~RecordingReader();
+
+  RecordingReader(const RecordingReader&) = delete;
+  RecordingReader& operator=(const RecordingReader&) = delete;
+
+  bool Open(const std::string& path);
+  const RecordingFileHeader& header() const { return header_; }
+  // Every complete chunk, in file order.
+  const std::vector<const RecordedFrameHeader*>& frames() const { return frames_; }
+
+  // A descriptor pointing into the mapping, ready for YoloEngineProcessFrame.
+  static YoloFrameDescriptor Descriptor(const RecordedFrameHeader& chunk);
+  static const YoloDetection* Detections(const RecordedFrameHeader& chunk);
+
+ private:
+  const uint8_t* data_ = nullptr;
+  size_t size_ = 0;
+  RecordingFileHeader header_{};
+  std::vector<const RecordedFrameHeader*> frames_;
+};
+
+}  // namespace yolo
@@ -0,0 +1,161 @@
+#include "frame_ring.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "postprocess.h"
+
+namespace yolo {
+
+namespace {
+
+constexpr int kSharpnessGrid = 64;
+// A track drifts between the stored frame and the request, so the overlap
+// needed to call it the same object is looser than NMS.
+constexpr float kMinMatchIoU = 0.3f;
+
+}  // namespace
+
+float BoxSharpness(const PixelView& frame, const YoloDetection& box, int model_width,
+                   int model_height) {
+  if (frame.data == nullptr || model_width <= 0 || model_height <= 0) {
+    return 0.0f;
+  }
+  const float to_frame_x = static_cast<float>(frame.width) / model_width;
+  const float to_frame_y = static_cast<float>(frame.height) / model_height;
+  const int left = std::clamp(static_cast<int>(box.left * to_frame_x), 0, frame.width - 1);
+  const int top = std::clamp(static_cast<int>(box.top * to_frame_y), 0, frame.height - 1);
+  const int right = std::clamp(static_cast<int>(box.right * to_frame_x), left + 1, frame.width);
+  const int bottom = std::clamp(static_cast<int>(box.bottom * to_frame_y), top + 1, frame.height);
+
+  // Downsample by point sampling on a regular grid: the Laplacian then sees
+  // detail at the grid's scale, which is what survives in a saved crop.
+  const int longest = std::max(right - left, bottom - top);
+  const int step = std::max(1, (longest + kSharpnessGrid - 1) / kSharpnessGrid);
+  const int grid_columns = std::min((right - left) / step, kSharpnessGrid);
+  const int grid_rows = std::min((bottom - top) / step, kSharpnessGrid);
+  if (grid_columns < 3 || grid_rows < 3) {
+    return 0.0f;
+  }
+  int luma[kSharpnessGrid][kSharpnessGrid];
+  for (int gy = 0; gy < grid_rows; ++gy) {
+    for (int gx = 0; gx < grid_columns; ++gx) {
+      luma[gy][gx] = LumaAt(frame, left + gx * step, top + gy * step);
+    }
+  }
+  double sum = 0.0;
+  double sum_squares = 0.0;
+  for (int gy = 1; gy + 1 < grid_rows; ++gy) {
+    for (int gx = 1; gx + 1 < grid_columns; ++gx) {
+      const int laplacian = luma[gy - 1][gx] + luma[gy + 1][gx] + luma[gy][gx - 1] +
+                            luma[gy][gx + 1] - 4 * luma[gy][gx];
+      sum += laplacian;
+      sum_squares += static_cast<double>(laplacian) * laplacian;
+    }
+  }
+  const double count = static_cast<double>(grid_rows - 2) * (grid_columns - 2);
+  const double mean = sum / count;
+  return static_cast<float>(sum_squares / count - mean * mean);
+}
+
+void FrameRing::Configure(size_t slots) {
+  slots_.clear();
+  slots_.shrink_to_fit();
+  slots_.resize(slots);
+  next_ = 0;
+}
+
+void FrameRing::Push(const PixelView& frame, int64_t time_ns,
+                     const std::vector<YoloDetection>& detections, int model_width,
+                     int model_height) {
+  if (slots_.empty() || frame.data == nullptr || detections.empty()) {
+    return;
+  }
+  Slot& slot = slots_[next_];
+  next_ = (next_ + 1) % slots_.size();
+
+  const size_t row_bytes = static_cast<size_t>(frame.width) * frame.pixel_stride;
+  slot.pixels.resize(row_bytes * frame.height);
+  if (frame.row_stride == static_cast<int>(row_bytes)) {
+    std::memcpy(slot.pixels.data(), frame.data, slot.pixels.size());
+  } else {
+    for (int y = 0; y < frame.height; ++y) {
+      std::memcpy(slot.pixels.data() + row_bytes * y,
+                  frame.data + static_cast<size_t>(frame.row_stride) * y, row_bytes);
+    }
+  }
+  slot.view = frame;
+  slot.view.data = slot.pixels.data();
+  slot.view.row_stride = static_cast<int>(row_bytes);
+  slot.time_ns = time_ns;
+  slot.detections.assign(detections.begin(), detections.end());
+  slot.scores.resize(detections.size());
+  for (size_t i = 0; i < detections.size(); ++i) {
+    slot.scores[i] =
+        BoxSharpness(slot.view, detections[i], model_width, model_height) * detections[i].score;
+  }
+  slot.valid = true;
+}
+
+bool FrameRing::FindBest(const YoloDetection& box, int64_t since_ns, PixelView* frame,
+                         YoloDetection* match) const {
+  const Slot* best_slot = nullptr;
+  size_t best_index = 0;
+  for (const Slot& slot : slots_) {
+    if (!slot.valid || slot.time_ns < since_ns) {
+      continue;
+    }
+    // The stored detection that overlaps the request most stands for the
+    // track in that frame.
+    float best_iou = kMinMatchIoU;
+    size_t index = slot.detections.size();
+    for (size_t i = 0; i < slot.detections.size(); ++i) {
+      const YoloDetection& candidate = slot.detections[i];
+      if (box.class_index >= 0 && candidate.class_index != box.class_index) {
+        continue;
+      }
+      const float iou = ComputeIoU(candidate, box);
+      if (iou >= best_iou) {
+        best_iou = iou;
+        index = i;
+      }
+    }
+    if (index == slot.detections.size()) {
+      continue;
+    }
+    if (best_slot == nullptr || slot.scores[index] > best_slot->scores[best_index]) {
+      best_slot = &slot;
+      best_index = index;
+    }
+  }
+  if (best_slot == nullptr) {
+    return false;
+  }
+  *frame = best_slot->view;
+  *match = best_slot->detections[best_index];
+  return true;
+}
+
+void FrameRing::Clear() {
+  for (Slot& slot : slots_) {
+    slot.valid = false;
+  }
+}
+
+void FrameRing::Release() {
+  for (Slot& slot : slots_) {
+    slot = Slot();
+  }
+}
+
+size_t FrameRing::memory_bytes() const {
+  size_t bytes = 0;
+  for (const Slot& slot : slots_) {
+    bytes += slot.pixels.capacity() +
+             slot.detections.capacity() * sizeof(YoloDetection) +
+             slot.scores.capacity() * sizeof(float);
+  }
+  return bytes;
+}
+
+}  // namespace yolo
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "image_utils.h"
+#include "yolo_engine_api.h"
+
+namespace yolo {
+
+// Laplacian variance of the luma inside |box| (|model_width| x
+// |model_height| coordinates), sampled on a grid of at most 64 x 64 points
+// so the cost does not depend on the box size. Higher is sharper.
+float BoxSharpness(const PixelView& frame, const YoloDetection& box, int model_width,
+                   int model_height);
+
+// The last few inferred frames that had detections, kept at full upright
+// resolution so a capture can pick the best of them after the fact instead of
+// whatever frame follows the user's tap. Each slot's buffer is reused once it
+// has grown to the stream's frame size, so steady state allocates nothing.
+//
+// Detections are scored on insertion by sharpness times detector score; a
+// lookup only compares stored scores.
+class FrameRing {
+ public:
+  FrameRing() = default;
+
+  FrameRing(const FrameRing&) = delete;
+  FrameRing& operator=(const FrameRing&) = delete;
+
+  // Sets the number of slots; 0 disables the ring and frees its memory.
+  void Configure(size_t slots);
+  bool enabled() const { return !slots_.empty(); }
+
+  // Copies |frame| into the oldest slot along with its detections.
+  void Push(const PixelView& frame, int64_t time_ns, const std::vector<YoloDetection>& detections,
+            int model_width, int model_height);
+  // Finds the best-scoring detection overlapping |box| (same class unless
+  // |box| has none) among frames stamped at or after |since_ns|. On success
+  // |frame| views the slot's pixels, valid until the next Push().
+  bool FindBest(const YoloDetection& box, int64_t since_ns, PixelView* frame,
+                YoloDetection* match) const;
+  // Forgets stored frames, keeping the slot buffers.
+  void Clear();
+  // Forgets stored frames and frees their buffers, keeping the slot count.
+  void Release();
+
+  size_t memory_bytes() const;
+
+ private:
+  struct Slot {
+    bool valid = false;
+    int64_t time_ns = 0;
+    std::vector<uint8_t> pixels;
+    PixelView view;
+    std::vector<YoloDetection> detections;
+    std::vector<float> scores;
+  };
+
+  std::vector<Slot> slots_;
+  size_t next_ = 0;
+};
+
+}  // namespace yolo
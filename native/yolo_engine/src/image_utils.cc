@@ -2,7 +2,10 @@
 
 #include <algorithm>
 #include <cmath>
+#include <cstring>
+#include <vector>
 
+#include "thread_pool.h"
 #include "yolo_engine.h"
 
 namespace yolo {
@@ -13,65 +16,248 @@ inline uint8_t ClampToByte(int value) {
   if (value > 255) return 255;
   return static_cast<uint8_t>(value);
 }
-}  // namespace
 
-void Yuv420ToRgb(const FrameMetadata& frame, std::vector<uint8_t>* rgb_target) {
-  if (rgb_target == nullptr) {
+// Runs fn(begin, end) over |rows| either inline or in bands on |pool|.
+template <typename Fn>
+void ForEachRowBand(ThreadPool* pool, int rows, int row_bytes, int row_multiple, const Fn& fn) {
+  if (pool == nullptr || pool->num_threads() <= 1) {
+    fn(0, rows);
     return;
   }
-  const int width = frame.width;
-  const int height = frame.height;
-  const size_t required = static_cast<size_t>(width) * static_cast<size_t>(height) * 3;
-  rgb_target->assign(required, 0);
+  int band = RowsPerBand(row_bytes, rows, pool->num_threads());
+  band = std::max(row_multiple, band - band % row_multiple);
+  pool->ParallelFor(rows, band, fn);
+}
 
-  for (int y = 0; y < height; ++y) {
-    const int y_row_index = frame.y_row_stride * y;
-    const int uv_row_index = frame.uv_row_stride * (y >> 1);
-    for (int x = 0; x < width; ++x) {
-      const int y_index = y_row_index + x;
-      const int uv_index = uv_row_index + (x >> 1) * frame.uv_pixel_stride;
+// BT.601 full-range YUV to RGB in 2.14 fixed point: each coefficient times
+// 2^14, rounded. 8-bit inputs keep every intermediate well inside 32 bits.
+constexpr int kYuvShift = 14;
+constexpr int kYuvHalf = 1 << (kYuvShift - 1);
+constexpr int kRedFromV = 22970;     // 1.402
+constexpr int kGreenFromU = 5638;    // 0.344136
+constexpr int kGreenFromV = 11700;   // 0.714136
+constexpr int kBlueFromU = 29032;    // 1.772
+
+// What one chroma sample adds to each channel, rounding included. A sample
+// covers a 2x2 block of pixels, so this is computed once per block.
+struct ChromaTerms {
+  int red;
+  int green;
+  int blue;
+};
 
-      const double yf = static_cast<double>(frame.y_plane[y_index]);
-      const double uf = static_cast<double>(frame.u_plane[uv_index]) - 128.0;
-      const double vf = static_cast<double>(frame.v_plane[uv_index]) - 128.0;
+inline ChromaTerms MakeChromaTerms(uint8_t u, uint8_t v) {
+  const int uc = static_cast<int>(u) - 128;
+  const int vc = static_cast<int>(v) - 128;
+  return {kRedFromV * vc + kYuvHalf, kYuvHalf - kGreenFromU * uc - kGreenFromV * vc,
+          kBlueFromU * uc + kYuvHalf};
+}
+
+inline uint8_t FixedToByte(int value) {
+  return static_cast<uint8_t>(std::min(std::max(value >> kYuvShift, 0), 255));
+}
+
+// Writes one RGB pixel. The arithmetic is shared by every layout so all
+// conversion paths produce bit-identical output.
+inline void StorePixel(uint8_t luma, const ChromaTerms& chroma, uint8_t* out) {
+  const int y = static_cast<int>(luma) << kYuvShift;
+  out[0] = FixedToByte(y + chroma.red);
+  out[1] = FixedToByte(y + chroma.green);
+  out[2] = FixedToByte(y + chroma.blue);
+}
 
-      int r = static_cast<int>(std::round(yf + 1.402 * vf));
-      int g = static_cast<int>(std::round(yf - 0.344136 * uf - 0.714136 * vf));
-      int b = static_cast<int>(std::round(yf + 1.772 * uf));
+// Chroma sample |index| (one per two luma columns) of the current chroma
+// row. The specializations turn the per-pixel stride multiply and separate
+// U/V gathers of the generic path into adjacent loads from one stream.
+template <ChromaLayout kLayout>
+inline void LoadChroma(const uint8_t* u_row, const uint8_t* v_row, int index, int pixel_stride,
+                       uint8_t* u, uint8_t* v) {
+  if constexpr (kLayout == ChromaLayout::kI420) {
+    *u = u_row[index];
+    *v = v_row[index];
+  } else if constexpr (kLayout == ChromaLayout::kNv12) {
+    const uint8_t* uv = u_row + 2 * index;
+    *u = uv[0];
+    *v = uv[1];
+  } else if constexpr (kLayout == ChromaLayout::kNv21) {
+    const uint8_t* vu = v_row + 2 * index;
+    *v = vu[0];
+    *u = vu[1];
+  } else {
+    *u = u_row[static_cast<size_t>(index) * pixel_stride];
+    *v = v_row[static_cast<size_t>(index) * pixel_stride];
+  }
+}
 
-      const size_t rgb_index = (static_cast<size_t>(y) * width + x) * 3;
-      (*rgb_target)[rgb_index] = ClampToByte(r);
-      (*rgb_target)[rgb_index + 1] = ClampToByte(g);
-      (*rgb_target)[rgb_index + 2] = ClampToByte(b);
+template <ChromaLayout kLayout>
+void Yuv420RowsToRgb(const FrameMetadata& frame, int row_begin, int row_end,
+                     uint8_t* rgb_target) {
+  const int width = frame.width;
+  const size_t out_stride = static_cast<size_t>(width) * 3;
+  int y = row_begin;
+  while (y < row_end) {
+    // Rows 2k and 2k + 1 share chroma row k; both are written in one pass so
+    // each chroma sample is loaded and expanded once for its 2x2 block.
+    const bool pair = (y & 1) == 0 && y + 1 < row_end;
+    const uint8_t* luma = frame.y_plane + static_cast<size_t>(frame.y_row_stride) * y;
+    const uint8_t* luma_below = luma + frame.y_row_stride;
+    const size_t uv_offset = static_cast<size_t>(frame.uv_row_stride) * (y >> 1);
+    const uint8_t* u_row = frame.u_plane + uv_offset;
+    const uint8_t* v_row = frame.v_plane + uv_offset;
+    uint8_t* out = rgb_target + static_cast<size_t>(y) * out_stride;
+    uint8_t* out_below = out + out_stride;
+    const int even_width = width & ~1;
+    for (int x = 0; x < even_width; x += 2) {
+      uint8_t u = 0;
+      uint8_t v = 0;
+      LoadChroma<kLayout>(u_row, v_row, x >> 1, frame.uv_pixel_stride, &u, &v);
+      const ChromaTerms chroma = MakeChromaTerms(u, v);
+      StorePixel(luma[x], chroma, out + x * 3);
+      StorePixel(luma[x + 1], chroma, out + (x + 1) * 3);
+      if (pair) {
+        StorePixel(luma_below[x], chroma, out_below + x * 3);
+        StorePixel(luma_below[x + 1], chroma, out_below + (x + 1) * 3);
+      }
+    }
+    if (even_width < width) {
+      uint8_t u = 0;
+      uint8_t v = 0;
+      LoadChroma<kLayout>(u_row, v_row, even_width >> 1, frame.uv_pixel_stride, &u, &v);
+      const ChromaTerms chroma = MakeChromaTerms(u, v);
+      StorePixel(luma[even_width], chroma, out + even_width * 3);
+      if (pair) {
+        StorePixel(luma_below[even_width], chroma, out_below + even_width * 3);
+      }
     }
+    y += pair ? 2 : 1;
   }
 }
 
-void RotateRgb(const std::vector<uint8_t>& src, int width, int height, int rotation_degrees,
-               std::vector<uint8_t>* dst) {
-  if (dst == nullptr) {
-    return;
+template <ChromaLayout kLayout>
+void Yuv420ToRgbWithLayout(const FrameMetadata& frame, uint8_t* rgb_target, ThreadPool* pool) {
+  // Bands start on even rows so each chroma row is read by a single band.
+  ForEachRowBand(pool, frame.height, frame.width * 3, 2, [&](int begin, int end) {
+    Yuv420RowsToRgb<kLayout>(frame, begin, end, rgb_target);
+  });
+}
+
+}  // namespace
+
+ChromaLayout DetectChromaLayout(const FrameMetadata& frame) {
+  if (frame.uv_pixel_stride == 1) {
+    return ChromaLayout::kI420;
   }
-  const int normalized_rotation = ((rotation_degrees % 360) + 360) % 360;
-  if (normalized_rotation == 0) {
-    *dst = src;
+  if (frame.uv_pixel_stride == 2 && frame.u_plane != nullptr && frame.v_plane != nullptr) {
+    if (frame.u_plane == frame.v_plane + 1) {
+      return ChromaLayout::kNv21;
+    }
+    if (frame.v_plane == frame.u_plane + 1) {
+      return ChromaLayout::kNv12;
+    }
+  }
+  return ChromaLayout::kGeneric;
+}
+
+bool ChromaLayoutMatches(const FrameMetadata& frame, ChromaLayout layout) {
+  return layout == ChromaLayout::kGeneric || DetectChromaLayout(frame) == layout;
+}
+
+const char* ChromaLayoutName(ChromaLayout layout) {
+  switch (layout) {
+    case ChromaLayout::kGeneric:
+      return "generic";
+    case ChromaLayout::kI420:
+      return "i420";
+    case ChromaLayout::kNv12:
+      return "nv12";
+    case ChromaLayout::kNv21:
+      return "nv21";
+  }
+  return "unknown";
+}
+
+void Yuv420ToRgb(const FrameMetadata& frame, ChromaLayout layout, uint8_t* rgb_target,
+                 ThreadPool* pool) {
+  if (rgb_target == nullptr) {
     return;
   }
+  switch (layout) {
+    case ChromaLayout::kI420:
+      Yuv420ToRgbWithLayout<ChromaLayout::kI420>(frame, rgb_target, pool);
+      break;
+    case ChromaLayout::kNv12:
+      Yuv420ToRgbWithLayout<ChromaLayout::kNv12>(frame, rgb_target, pool);
+      break;
+    case ChromaLayout::kNv21:
+      Yuv420ToRgbWithLayout<ChromaLayout::kNv21>(frame, rgb_target, pool);
+      break;
+    case ChromaLayout::kGeneric:
+      Yuv420ToRgbWithLayout<ChromaLayout::kGeneric>(frame, rgb_target, pool);
+      break;
+  }
+}
 
-  const int channels = 3;
-  int dst_width = width;
-  int dst_height = height;
-  if (normalized_rotation == 90 || normalized_rotation == 270) {
-    dst_width = height;
-    dst_height = width;
+PixelView RgbView(const uint8_t* rgb, int width, int height) {
+  PixelView view;
+  view.data = rgb;
+  view.width = width;
+  view.height = height;
+  view.row_stride = width * 3;
+  view.pixel_stride = 3;
+  return view;
+}
+
+bool PackedFrameView(const FrameMetadata& frame, PixelView* view) {
+  PixelView result;
+  switch (frame.format) {
+    case PixelFormat::kRgb:
+      result.pixel_stride = 3;
+      break;
+    case PixelFormat::kBgr:
+      result.pixel_stride = 3;
+      result.channel = {2, 1, 0};
+      break;
+    case PixelFormat::kRgba:
+      result.pixel_stride = 4;
+      break;
+    case PixelFormat::kBgra:
+      result.pixel_stride = 4;
+      result.channel = {2, 1, 0};
+      break;
+    case PixelFormat::kYuv420:
+      return false;
   }
-  dst->assign(static_cast<size_t>(dst_width) * dst_height * channels, 0);
+  if (frame.y_plane == nullptr || frame.width <= 0 || frame.height <= 0 ||
+      frame.y_row_stride < frame.width * result.pixel_stride) {
+    return false;
+  }
+  result.data = frame.y_plane;
+  result.width = frame.width;
+  result.height = frame.height;
+  result.row_stride = frame.y_row_stride;
+  *view = result;
+  return true;
+}
 
-  for (int y = 0; y < height; ++y) {
+namespace {
+
+// kPixelStride is 3 or 4 for the common packed formats so the compiler can
+// fold the per-pixel offsets; 0 reads it from the view.
+template <int kPixelStride>
+void RotateRows(const PixelView& src, int rotation, int row_begin, int row_end, uint8_t* dst) {
+  const int pixel_stride = kPixelStride > 0 ? kPixelStride : src.pixel_stride;
+  const int width = src.width;
+  const int height = src.height;
+  const int dst_width = (rotation == 90 || rotation == 270) ? height : width;
+  const int r = src.channel[0];
+  const int g = src.channel[1];
+  const int b = src.channel[2];
+  for (int y = row_begin; y < row_end; ++y) {
+    const uint8_t* row = src.data + static_cast<size_t>(src.row_stride) * y;
     for (int x = 0; x < width; ++x) {
       int dst_x = x;
       int dst_y = y;
-      switch (normalized_rotation) {
+      switch (rotation) {
         case 90:
           dst_x = height - 1 - y;
           dst_y = x;
@@ -90,32 +276,32 @@ void RotateRgb(const std::vector<uint8_t>& src, int width, int height, int rotat
           break;
       }
 
-      const size_t src_index = (static_cast<size_t>(y) * width + x) * channels;
-      const size_t dst_index = (static_cast<size_t>(dst_y) * dst_width + dst_x) * channels;
-      (*dst)[dst_index] = src[src_index];
-      (*dst)[dst_index + 1] = src[src_index + 1];
-      (*dst)[dst_index + 2] = src[src_index + 2];
+      const uint8_t* pixel = row + static_cast<size_t>(x) * pixel_stride;
+      const size_t dst_index = (static_cast<size_t>(dst_y) * dst_width + dst_x) * 3;
+      dst[dst_index] = pixel[r];
+      dst[dst_index + 1] = pixel[g];
+      dst[dst_index + 2] = pixel[b];
     }
   }
 }
 
-void ResizeAndNormalize(const std::vector<uint8_t>& src, int src_width, int src_height,
-                        int dst_width, int dst_height, std::vector<float>* dst) {
-  if (dst == nullptr || src.empty() || src_width <= 0 || src_height <= 0 || dst_width <= 0 ||
-      dst_height <= 0) {
-    return;
-  }
+template <int kPixelStride>
+void ResizeRows(const PixelView& src, int dst_width, int dst_height, int row_begin, int row_end,
+                float* dst) {
+  const int pixel_stride = kPixelStride > 0 ? kPixelStride : src.pixel_stride;
   const int channels = 3;
-  dst->assign(static_cast<size_t>(dst_width) * dst_height * channels, 0.0f);
-
+  const int src_width = src.width;
+  const int src_height = src.height;
   const float scale_x = static_cast<float>(src_width) / static_cast<float>(dst_width);
   const float scale_y = static_cast<float>(src_height) / static_cast<float>(dst_height);
 
-  for (int y = 0; y < dst_height; ++y) {
+  for (int y = row_begin; y < row_end; ++y) {
     const float src_y = (y + 0.5f) * scale_y - 0.5f;
     const int y0 = std::clamp(static_cast<int>(std::floor(src_y)), 0, src_height - 1);
     const int y1 = std::clamp(y0 + 1, 0, src_height - 1);
     const float y_lerp = src_y - static_cast<float>(y0);
+    const uint8_t* top_row = src.data + static_cast<size_t>(src.row_stride) * y0;
+    const uint8_t* bottom_row = src.data + static_cast<size_t>(src.row_stride) * y1;
 
     for (int x = 0; x < dst_width; ++x) {
       const float src_x = (x + 0.5f) * scale_x - 0.5f;
@@ -123,23 +309,159 @@ void ResizeAndNormalize(const std::vector<uint8_t>& src, int src_width, int src_
       const int x1 = std::clamp(x0 + 1, 0, src_width - 1);
       const float x_lerp = src_x - static_cast<float>(x0);
 
-      const size_t top_left = (static_cast<size_t>(y0) * src_width + x0) * channels;
-      const size_t top_right = (static_cast<size_t>(y0) * src_width + x1) * channels;
-      const size_t bottom_left = (static_cast<size_t>(y1) * src_width + x0) * channels;
-      const size_t bottom_right = (static_cast<size_t>(y1) * src_width + x1) * channels;
+      const uint8_t* top_left = top_row + static_cast<size_t>(x0) * pixel_stride;
+      const uint8_t* top_right = top_row + static_cast<size_t>(x1) * pixel_stride;
+      const uint8_t* bottom_left = bottom_row + static_cast<size_t>(x0) * pixel_stride;
+      const uint8_t* bottom_right = bottom_row + static_cast<size_t>(x1) * pixel_stride;
 
       const size_t dst_index = (static_cast<size_t>(y) * dst_width + x) * channels;
       for (int c = 0; c < channels; ++c) {
-        const float top = static_cast<float>(src[top_left + c]) +
-                          (static_cast<float>(src[top_right + c]) -
-                           static_cast<float>(src[top_left + c])) *
+        const int offset = src.channel[c];
+        const float top = static_cast<float>(top_left[offset]) +
+                          (static_cast<float>(top_right[offset]) -
+                           static_cast<float>(top_left[offset])) *
                               x_lerp;
-        const float bottom = static_cast<float>(src[bottom_left + c]) +
-                             (static_cast<float>(src[bottom_right + c]) -
-                              static_cast<float>(src[bottom_left + c])) *
+        const float bottom = static_cast<float>(bottom_left[offset]) +
+                             (static_cast<float>(bottom_right[offset]) -
+                              static_cast<float>(bottom_left[offset])) *
                                  x_lerp;
         const float value = top + (bottom - top) * y_lerp;
-        (*dst)[dst_index + c] = value / 255.0f;
+        dst[dst_index + c] = value / 255.0f;
+      }
+    }
+  }
+}
+
+bool IsPackedRgb(const PixelView& view) {
+  return view.pixel_stride == 3 && view.row_stride == view.width * 3 && view.channel[0] == 0 &&
+         view.channel[1] == 1 && view.channel[2] == 2;
+}
+
+}  // namespace
+
+void RotateRgb(const PixelView& src, int rotation_degrees, uint8_t* dst, ThreadPool* pool) {
+  if (src.data == nullptr || dst == nullptr) {
+    return;
+  }
+  const int normalized_rotation = ((rotation_degrees % 360) + 360) % 360;
+  if (normalized_rotation == 0 && IsPackedRgb(src)) {
+    std::memcpy(dst, src.data, static_cast<size_t>(src.width) * src.height * 3);
+    return;
+  }
+
+  ForEachRowBand(pool, src.height, src.width * 3, 1, [&](int row_begin, int row_end) {
+    switch (src.pixel_stride) {
+      case 3:
+        RotateRows<3>(src, normalized_rotation, row_begin, row_end, dst);
+        break;
+      case 4:
+        RotateRows<4>(src, normalized_rotation, row_begin, row_end, dst);
+        break;
+      default:
+        RotateRows<0>(src, normalized_rotation, row_begin, row_end, dst);
+        break;
+    }
+  });
+}
+
+void ResizeAndNormalize(const PixelView& src, int dst_width, int dst_height, float* dst,
+                        ThreadPool* pool) {
+  if (dst == nullptr || src.data == nullptr || src.width <= 0 || src.height <= 0 ||
+      dst_width <= 0 || dst_height <= 0) {
+    return;
+  }
+  const int row_bytes = dst_width * 3 * static_cast<int>(sizeof(float));
+  ForEachRowBand(pool, dst_height, row_bytes, 1, [&](int row_begin, int row_end) {
+    switch (src.pixel_stride) {
+      case 3:
+        ResizeRows<3>(src, dst_width, dst_height, row_begin, row_end, dst);
+        break;
+      case 4:
+        ResizeRows<4>(src, dst_width, dst_height, row_begin, row_end, dst);
+        break;
+      default:
+        ResizeRows<0>(src, dst_width, dst_height, row_begin, row_end, dst);
+        break;
+    }
+  });
+}
+
+namespace {
+
+// Source taps for one output sample along an axis.
+struct ResampleTaps {
+  int first = 0;
+  std::vector<float> weights;
+};
+
+std::vector<ResampleTaps> AxisTaps(int src_size, int dst_size) {
+  std::vector<ResampleTaps> taps(static_cast<size_t>(dst_size));
+  const double scale = static_cast<double>(src_size) / dst_size;
+  for (int i = 0; i < dst_size; ++i) {
+    ResampleTaps& tap = taps[static_cast<size_t>(i)];
+    if (scale <= 1.0) {
+      const double center = (i + 0.5) * scale - 0.5;
+      const int lower = std::clamp(static_cast<int>(std::floor(center)), 0, src_size - 1);
+      const float fraction = static_cast<float>(std::clamp(center - lower, 0.0, 1.0));
+      tap.first = lower;
+      tap.weights = {1.0f - fraction};
+      if (lower + 1 < src_size) {
+        tap.weights.push_back(fraction);
+      } else {
+        tap.weights[0] = 1.0f;
+      }
+      continue;
+    }
+    const double begin = i * scale;
+    const double end = std::min<double>(src_size, (i + 1) * scale);
+    tap.first = static_cast<int>(begin);
+    for (int s = tap.first; s < end; ++s) {
+      const double overlap = std::min<double>(s + 1, end) - std::max<double>(s, begin);
+      tap.weights.push_back(static_cast<float>(overlap / scale));
+    }
+  }
+  return taps;
+}
+
+}  // namespace
+
+void ResampleArea(const PixelView& src, int dst_width, int dst_height, uint8_t* dst) {
+  if (dst == nullptr || src.data == nullptr || src.width <= 0 || src.height <= 0 ||
+      dst_width <= 0 || dst_height <= 0) {
+    return;
+  }
+  const std::vector<ResampleTaps> column_taps = AxisTaps(src.width, dst_width);
+  const std::vector<ResampleTaps> row_taps = AxisTaps(src.height, dst_height);
+  // Vertical pass into one float row, then horizontal taps out of it, so
+  // working memory is a single source row.
+  std::vector<float> row(static_cast<size_t>(src.width) * 3);
+  for (int y = 0; y < dst_height; ++y) {
+    const ResampleTaps& vertical = row_taps[static_cast<size_t>(y)];
+    std::fill(row.begin(), row.end(), 0.0f);
+    for (size_t t = 0; t < vertical.weights.size(); ++t) {
+      const float weight = vertical.weights[t];
+      const uint8_t* source_row =
+          src.data + static_cast<size_t>(src.row_stride) * (vertical.first + static_cast<int>(t));
+      for (int x = 0; x < src.width; ++x) {
+        const uint8_t* pixel = source_row + static_cast<size_t>(x) * src.pixel_stride;
+        float* out = &row[static_cast<size_t>(x) * 3];
+        out[0] += weight * pixel[src.channel[0]];
+        out[1] += weight * pixel[src.channel[1]];
+        out[2] += weight * pixel[src.channel[2]];
+      }
+    }
+    uint8_t* out = dst + static_cast<size_t>(y) * dst_width * 3;
+    for (int x = 0; x < dst_width; ++x) {
+      const ResampleTaps& horizontal = column_taps[static_cast<size_t>(x)];
+      float sum[3] = {0.0f, 0.0f, 0.0f};
+      for (size_t t = 0; t < horizontal.weights.size(); ++t) {
+        const float* pixel = &row[static_cast<size_t>(horizontal.first + static_cast<int>(t)) * 3];
+        sum[0] += horizontal.weights[t] * pixel[0];
+        sum[1] += horizontal.weights[t] * pixel[1];
+        sum[2] += horizontal.weights[t] * pixel[2];
+      }
+      for (int c = 0; c < 3; ++c) {
+        out[x * 3 + c] = ClampToByte(static_cast<int>(sum[c] + 0.5f));
       }
     }
   }
@@ -1,16 +1,74 @@
 #pragma once
 
+#include <array>
+#include <cstddef>
 #include <cstdint>
-#include <vector>
 
 namespace yolo {
 
 struct FrameMetadata;
+class ThreadPool;
 
-void Yuv420ToRgb(const FrameMetadata& frame, std::vector<uint8_t>* rgb_target);
-void RotateRgb(const std::vector<uint8_t>& src, int width, int height, int rotation_degrees,
-               std::vector<uint8_t>* dst);
-void ResizeAndNormalize(const std::vector<uint8_t>& src, int src_width, int src_height,
-                        int dst_width, int dst_height, std::vector<float>* dst);
+// How the two chroma planes of a YUV420 frame are laid out in memory.
+enum class ChromaLayout : int {
+  kGeneric = 0,  // arbitrary pixel stride, U and V addressed separately
+  kI420,         // planar: U and V each packed one byte per sample
+  kNv12,         // semi-planar UVUV..., v_plane == u_plane + 1
+  kNv21,         // semi-planar VUVU..., u_plane == v_plane + 1 (Android default)
+};
+
+// Classifies |frame| from its plane pointers and strides. Constant for a
+// given camera stream, so the engine detects it once and revalidates cheaply
+// with ChromaLayoutMatches().
+ChromaLayout DetectChromaLayout(const FrameMetadata& frame);
+bool ChromaLayoutMatches(const FrameMetadata& frame, ChromaLayout layout);
+const char* ChromaLayoutName(ChromaLayout layout);
+
+// Read-only view of interleaved 8-bit pixels with arbitrary row stride.
+// |channel| gives the byte offsets of R, G and B inside a pixel, so BGR(A)
+// and RGB(A) sources are read in place without a conversion pass.
+struct PixelView {
+  const uint8_t* data = nullptr;
+  int width = 0;
+  int height = 0;
+  int row_stride = 0;
+  int pixel_stride = 3;
+  std::array<int, 3> channel = {0, 1, 2};
+};
+
+// BT.601 luma of the pixel at (x, y) in 8.8 fixed point. A view with
+// |pixel_stride| 1 and all channels at offset 0 reads a Y plane unchanged.
+inline int LumaAt(const PixelView& view, int x, int y) {
+  const uint8_t* pixel = view.data + static_cast<size_t>(view.row_stride) * y +
+                         static_cast<size_t>(x) * view.pixel_stride;
+  return (77 * pixel[view.channel[0]] + 150 * pixel[view.channel[1]] +
+          29 * pixel[view.channel[2]]) >>
+         8;
+}
+
+// Tightly packed RGB, as produced by Yuv420ToRgb and RotateRgb.
+PixelView RgbView(const uint8_t* rgb, int width, int height);
+// View over a packed-format frame; false for YUV or an inconsistent stride.
+bool PackedFrameView(const FrameMetadata& frame, PixelView* view);
+
+// Destination buffers are caller-owned (normally engine scratch arena memory)
+// and must hold the full output; every element is overwritten. With a |pool|
+// the work is split into row bands across its threads; without one it runs
+// on the calling thread.
+void Yuv420ToRgb(const FrameMetadata& frame, ChromaLayout layout, uint8_t* rgb_target,
+                 ThreadPool* pool = nullptr);
+
+// Writes tightly packed RGB (any source channel order) rotated clockwise.
+void RotateRgb(const PixelView& src, int rotation_degrees, uint8_t* dst,
+               ThreadPool* pool = nullptr);
+// Bilinear, for one-off geometries such as classifier crops; the per-frame
+// model input goes through a cached ResamplePlan instead.
+void ResizeAndNormalize(const PixelView& src, int dst_width, int dst_height, float* dst,
+                        ThreadPool* pool = nullptr);
+// Writes tightly packed RGB8. Each output pixel averages its whole source
+// footprint with fractional edge weights (a box filter), so large downscales
+// do not alias the way bilinear sampling does; upscaling falls back to
+// bilinear. Meant for stills, not the per-frame path.
+void ResampleArea(const PixelView& src, int dst_width, int dst_height, uint8_t* dst);
 
 }  // namespace yolo
@@ -0,0 +1,312 @@
+#include "inference_runtime.h"
+
+#include <dlfcn.h>
+
+#include <algorithm>
+#include <utility>
+
+#include "memory_usage.h"
+#include "tensorflow_lite/xnnpack_delegate.h"
+
+#if defined(__ANDROID__)
+#include "tensorflow_lite/delegate.h"
+#include "tensorflow_lite/delegate_options.h"
+#elif defined(__APPLE__)
+#include <TargetConditionals.h>
+#if TARGET_OS_IOS
+#include "tensorflow_lite/metal_delegate.h"
+#endif
+#endif
+
+namespace yolo {
+
+namespace {
+
+// XNNPACK entry points are resolved at runtime: not every TensorFlow Lite
+// build we link against exports them, and a hard reference would stop the
+// whole engine from loading on those builds.
+struct XnnpackApi {
+  decltype(&TfLiteXNNPackDelegateOptionsDefault) options_default = nullptr;
+  decltype(&TfLiteXNNPackDelegateCreate) create = nullptr;
+  decltype(&TfLiteXNNPackDelegateDelete) destroy = nullptr;
+
+  bool available() const {
+    return options_default != nullptr && create != nullptr && destroy != nullptr;
+  }
+};
+
+const XnnpackApi& Xnnpack() {
+  static const XnnpackApi api = [] {
+    XnnpackApi resolved;
+    resolved.options_default = reinterpret_cast<decltype(&TfLiteXNNPackDelegateOptionsDefault)>(
+        dlsym(RTLD_DEFAULT, "TfLiteXNNPackDelegateOptionsDefault"));
+    resolved.create = reinterpret_cast<decltype(&TfLiteXNNPackDelegateCreate)>(
+        dlsym(RTLD_DEFAULT, "TfLiteXNNPackDelegateCreate"));
+    resolved.destroy = reinterpret_cast<decltype(&TfLiteXNNPackDelegateDelete)>(
+        dlsym(RTLD_DEFAULT, "TfLiteXNNPackDelegateDelete"));
+    return resolved;
+  }();
+  return api;
+}
+
+}  // namespace
+
+const char* DelegateName(DelegateKind delegate) {
+  switch (delegate) {
+    case DelegateKind::kCpu:
+      return "cpu";
+    case DelegateKind::kXnnpack:
+      return "xnnpack";
+    case DelegateKind::kGpu:
+      return "gpu";
+  }
+  return "unknown";
+}
+
+ModelHandle LoadModel(const std::string& model_path) {
+  TfLiteModel* model = TfLiteModelCreateFromFile(model_path.c_str());
+  if (model == nullptr) {
+    return nullptr;
+  }
+  return ModelHandle(model, TfLiteModelDelete);
+}
+
+bool IsDelegateAvailable(DelegateKind delegate) {
+  switch (delegate) {
+    case DelegateKind::kCpu:
+      return true;
+    case DelegateKind::kXnnpack:
+      return Xnnpack().available();
+    case DelegateKind::kGpu:
+#if defined(__ANDROID__) || (defined(__APPLE__) && TARGET_OS_IOS)
+      return true;
+#else
+      return false;
+#endif
+  }
+  return false;
+}
+
+InferenceRuntime::InferenceRuntime(ModelHandle model, const RuntimeConfig& config)
+    : model_(std::move(model)), config_(config) {}
+
+InferenceRuntime::~InferenceRuntime() {
+  // The interpreter references the delegate, so it has to go first.
+  if (interpreter_ != nullptr) {
+    TfLiteInterpreterDelete(interpreter_);
+    interpreter_ = nullptr;
+  }
+  DeleteDelegate();
+  if (interpreter_options_ != nullptr) {
+    TfLiteInterpreterOptionsDelete(interpreter_options_);
+    interpreter_options_ = nullptr;
+  }
+}
+
+std::unique_ptr<InferenceRuntime> InferenceRuntime::Create(ModelHandle model,
+                                                           const RuntimeConfig& config) {
+  if (model == nullptr || !IsDelegateAvailable(config.delegate)) {
+    return nullptr;
+  }
+  const size_t resident_before = ResidentMemoryBytes();
+  auto runtime = std::unique_ptr<InferenceRuntime>(new InferenceRuntime(std::move(model), config));
+  runtime->interpreter_options_ = TfLiteInterpreterOptionsCreate();
+  if (runtime->interpreter_options_ == nullptr) {
+    return nullptr;
+  }
+  TfLiteInterpreterOptionsSetNumThreads(runtime->interpreter_options_, config.num_threads);
+
+  // Delegates must be registered on the options before the interpreter is
+  // built, otherwise they are silently ignored.
+  if (!runtime->CreateDelegate()) {
+    return nullptr;
+  }
+  if (!runtime->BuildInterpreter()) {
+    return nullptr;
+  }
+  const size_t resident_after = ResidentMemoryBytes();
+  const size_t io_bytes = (runtime->input_count_ + runtime->output_count_) * sizeof(float);
+  runtime->arena_bytes_ =
+      std::max(io_bytes, resident_after > resident_before ? resident_after - resident_before : 0);
+  return runtime;
+}
+
+bool InferenceRuntime::BuildInterpreter() {
+  interpreter_ = TfLiteInterpreterCreate(model_.get(), interpreter_options_);
+  if (interpreter_ == nullptr) {
+    return false;
+  }
+  // A restored interpreter starts at the model's shape; put back any batch
+  // size chosen since.
+  if (!input_shape_.empty() &&
+      TfLiteInterpreterResizeInputTensor(interpreter_, 0, input_shape_.data(),
+                                         static_cast<int32_t>(input_shape_.size())) != kTfLiteOk) {
+    return false;
+  }
+  if (TfLiteInterpreterAllocateTensors(interpreter_) != kTfLiteOk) {
+    return false;
+  }
+  CacheTensorInfo();
+  return true;
+}
+
+void InferenceRuntime::Release() {
+  if (interpreter_ == nullptr) {
+    return;
+  }
+  TfLiteInterpreterDelete(interpreter_);
+  interpreter_ = nullptr;
+}
+
+bool InferenceRuntime::Restore() {
+  if (interpreter_ != nullptr) {
+    return true;
+  }
+  if (!BuildInterpreter()) {
+    if (interpreter_ != nullptr) {
+      TfLiteInterpreterDelete(interpreter_);
+      interpreter_ = nullptr;
+    }
+    return false;
+  }
+  return true;
+}
+
+void InferenceRuntime::CacheTensorInfo() {
+  auto read_shape = [](const TfLiteTensor* tensor, std::vector<int>* shape) -> size_t {
+    shape->clear();
+    if (tensor == nullptr) {
+      return 0;
+    }
+    size_t count = 1;
+    const int dims = TfLiteTensorNumDims(tensor);
+    for (int i = 0; i < dims; ++i) {
+      shape->push_back(TfLiteTensorDim(tensor, i));
+      count *= static_cast<size_t>(std::max(0, shape->back()));
+    }
+    return count;
+  };
+  input_count_ = read_shape(TfLiteInterpreterGetInputTensor(interpreter_, 0), &input_shape_);
+  output_count_ = read_shape(TfLiteInterpreterGetOutputTensor(interpreter_, 0), &output_shape_);
+}
+
+bool InferenceRuntime::CreateDelegate() {
+  switch (config_.delegate) {
+    case DelegateKind::kCpu:
+      return true;
+    case DelegateKind::kXnnpack: {
+      const XnnpackApi& api = Xnnpack();
+      TfLiteXNNPackDelegateOptions xnnpack_options = api.options_default();
+      xnnpack_options.num_threads = config_.num_threads;
+      delegate_ = api.create(&xnnpack_options);
+      break;
+    }
+    case DelegateKind::kGpu: {
+#if defined(__ANDROID__)
+      TfLiteGpuDelegateOptionsV2 gpu_options = TfLiteGpuDelegateOptionsV2Default();
+      gpu_options.inference_preference = TFLITE_GPU_INFERENCE_PREFERENCE_FAST_SINGLE_ANSWER;
+      gpu_options.is_precision_loss_allowed = config_.allow_fp16 ? 1 : 0;
+      delegate_ = reinterpret_cast<TfLiteDelegate*>(TfLiteGpuDelegateV2Create(&gpu_options));
+#elif defined(__APPLE__) && TARGET_OS_IOS
+      TfLiteGpuDelegateOptions gpu_options = TfLiteGpuDelegateOptionsDefault();
+      gpu_options.allow_precision_loss = config_.allow_fp16 ? 1 : 0;
+      gpu_options.wait_type = TFLGpuDelegateWaitType::TFLGpuDelegateWaitTypePassive;
+      gpu_options.max_delegated_partitions = 1;
+      delegate_ = reinterpret_cast<TfLiteDelegate*>(TfLiteGpuDelegateCreate(&gpu_options));
+#endif
+      break;
+    }
+  }
+  if (delegate_ == nullptr) {
+    return false;
+  }
+  TfLiteInterpreterOptionsAddDelegate(interpreter_options_, delegate_);
+  return true;
+}
+
+void InferenceRuntime::DeleteDelegate() {
+  if (delegate_ == nullptr) {
+    return;
+  }
+  switch (config_.delegate) {
+    case DelegateKind::kCpu:
+      break;
+    case DelegateKind::kXnnpack:
+      Xnnpack().destroy(delegate_);
+      break;
+    case DelegateKind::kGpu:
+#if defined(__ANDROID__)
+      TfLiteGpuDelegateV2Delete(delegate_);
+#elif defined(__APPLE__) && TARGET_OS_IOS
+      TFLGpuDelegateDelete(delegate_);
+#endif
+      break;
+  }
+  delegate_ = nullptr;
+}
+
+float* InferenceRuntime::MutableInput() {
+  TfLiteTensor* input_tensor = TfLiteInterpreterGetInputTensor(interpreter_, 0);
+  if (input_tensor == nullptr || TfLiteTensorType(input_tensor) != kTfLiteFloat32 ||
+      TfLiteTensorByteSize(input_tensor) != input_count_ * sizeof(float)) {
+    return nullptr;
+  }
+  return static_cast<float*>(TfLiteTensorData(input_tensor));
+}
+
+bool InferenceRuntime::CopyInput(const float* data, size_t count) {
+  TfLiteTensor* input_tensor = TfLiteInterpreterGetInputTensor(interpreter_, 0);
+  if (input_tensor == nullptr || data == nullptr) {
+    return false;
+  }
+  return TfLiteTensorCopyFromBuffer(input_tensor, data, count * sizeof(float)) == kTfLiteOk;
+}
+
+bool InferenceRuntime::ResizeInput(const std::vector<int>& shape) {
+  if (shape == input_shape_) {
+    return true;
+  }
+  if (TfLiteInterpreterResizeInputTensor(interpreter_, 0, shape.data(),
+                                         static_cast<int32_t>(shape.size())) != kTfLiteOk ||
+      TfLiteInterpreterAllocateTensors(interpreter_) != kTfLiteOk) {
+    // Put the previous shape back so the interpreter stays usable.
+    TfLiteInterpreterResizeInputTensor(interpreter_, 0, input_shape_.data(),
+                                       static_cast<int32_t>(input_shape_.size()));
+    TfLiteInterpreterAllocateTensors(interpreter_);
+    return false;
+  }
+  CacheTensorInfo();
+  return true;
+}
+
+bool InferenceRuntime::Run() {
+  return TfLiteInterpreterInvoke(interpreter_) == kTfLiteOk;
+}
+
+const float* InferenceRuntime::Output() const {
+  const TfLiteTensor* output_tensor = TfLiteInterpreterGetOutputTensor(interpreter_, 0);
+  if (output_tensor == nullptr || TfLiteTensorType(output_tensor) != kTfLiteFloat32) {
+    return nullptr;
+  }
+  return static_cast<const float*>(TfLiteTensorData(output_tensor));
+}
+
+bool InferenceRuntime::Invoke(const std::vector<float>& input_buffer,
+                              std::vector<float>* output_buffer,
+                              std::vector<int>* output_shape) {
+  if (output_buffer == nullptr || output_shape == nullptr) {
+    return false;
+  }
+  if (!CopyInput(input_buffer.data(), input_buffer.size()) || !Run()) {
+    return false;
+  }
+  const float* output = Output();
+  if (output == nullptr) {
+    return false;
+  }
+  *output_shape = output_shape_;
+  output_buffer->assign(output, output + output_count_);
+  return true;
+}
+
+}  // namespace yolo
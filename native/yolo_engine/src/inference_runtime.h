@@ -0,0 +1,95 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "tensorflow_lite/c_api.h"
+
+namespace yolo {
+
+enum class DelegateKind : int {
+  kCpu = 0,
+  kXnnpack = 1,
+  kGpu = 2,
+};
+
+struct RuntimeConfig {
+  DelegateKind delegate = DelegateKind::kCpu;
+  int num_threads = 2;
+  bool allow_fp16 = true;
+};
+
+const char* DelegateName(DelegateKind delegate);
+
+using ModelHandle = std::shared_ptr<TfLiteModel>;
+
+ModelHandle LoadModel(const std::string& model_path);
+
+// One interpreter bound to a (shared) model with a particular delegate and
+// thread configuration. The engine owns one for serving frames; the auto-tuner
+// builds short-lived ones to benchmark alternatives against the same model.
+class InferenceRuntime {
+ public:
+  static std::unique_ptr<InferenceRuntime> Create(ModelHandle model, const RuntimeConfig& config);
+  ~InferenceRuntime();
+
+  InferenceRuntime(const InferenceRuntime&) = delete;
+  InferenceRuntime& operator=(const InferenceRuntime&) = delete;
+
+  const RuntimeConfig& config() const { return config_; }
+  TfLiteInterpreter* interpreter() const { return interpreter_; }
+  const std::vector<int>& input_shape() const { return input_shape_; }
+  const std::vector<int>& output_shape() const { return output_shape_; }
+  size_t input_count() const { return input_count_; }
+  size_t output_count() const { return output_count_; }
+  // Resident memory attributed to interpreter creation and tensor allocation,
+  // never less than the input and output tensor sizes; 0 while released.
+  size_t arena_bytes() const { return interpreter_ != nullptr ? arena_bytes_ : 0; }
+
+  // Input tensor storage when it is float32, so preprocessing can write into
+  // it directly; nullptr otherwise (use CopyInput).
+  float* MutableInput();
+  bool CopyInput(const float* data, size_t count);
+  // Resizes input 0 and reallocates tensors; a no-op for the current shape.
+  // Some delegates reject resizing, in which case the old shape stays.
+  bool ResizeInput(const std::vector<int>& shape);
+  bool Run();
+  // Output tensor storage after Run(); valid until the next Run().
+  const float* Output() const;
+
+  // Deletes the interpreter, and with it the tensor arena, keeping the model,
+  // the options and the delegate. Nothing but Restore() and the accessors may
+  // be called until Restore() rebuilds the interpreter at the current input
+  // shape.
+  void Release();
+  bool Restore();
+  bool released() const { return interpreter_ == nullptr; }
+
+  // Convenience wrapper copying input and output through vectors.
+  bool Invoke(const std::vector<float>& input_buffer, std::vector<float>* output_buffer,
+              std::vector<int>* output_shape);
+
+ private:
+  InferenceRuntime(ModelHandle model, const RuntimeConfig& config);
+
+  bool BuildInterpreter();
+  bool CreateDelegate();
+  void DeleteDelegate();
+  void CacheTensorInfo();
+
+  ModelHandle model_;
+  RuntimeConfig config_;
+  TfLiteInterpreterOptions* interpreter_options_ = nullptr;
+  TfLiteInterpreter* interpreter_ = nullptr;
+  TfLiteDelegate* delegate_ = nullptr;
+  std::vector<int> input_shape_;
+  std::vector<int> output_shape_;
+  size_t input_count_ = 0;
+  size_t output_count_ = 0;
+  size_t arena_bytes_ = 0;
+};
+
+bool IsDelegateAvailable(DelegateKind delegate);
+
+}  // namespace yolo
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+
+namespace yolo {
+
+// Hands the most recent value from any thread to the frame thread without a
+// lock. Publish() swaps a heap copy in with one atomic exchange and frees a
+// predecessor the frame thread never took; Take() is a single load when
+// nothing is pending, so polling it every frame is free.
+template <typename T>
+class LatestValue {
+ public:
+  LatestValue() = default;
+  ~LatestValue() { delete pending_.exchange(nullptr, std::memory_order_acquire); }
+
+  LatestValue(const LatestValue&) = delete;
+  LatestValue& operator=(const LatestValue&) = delete;
+
+  void Publish(std::unique_ptr<T> value) {
+    delete pending_.exchange(value.release(), std::memory_order_acq_rel);
+  }
+
+  // The value published last, or null when nothing is new since the last
+  // call.
+  std::unique_ptr<T> Take() {
+    if (pending_.load(std::memory_order_relaxed) == nullptr) {
+      return nullptr;
+    }
+    return std::unique_ptr<T>(pending_.exchange(nullptr, std::memory_order_acq_rel));
+  }
+
+ private:
+  std::atomic<T*> pending_{nullptr};
+};
+
+}  // namespace yolo
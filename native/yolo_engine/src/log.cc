@@ -0,0 +1,25 @@
+#include "log.h"
+
+#include <cstdio>
+
+#if defined(__ANDROID__)
+#include <android/log.h>
+#endif
+
+namespace yolo {
+
+namespace {
+
+constexpr char kLogTag[] = "YoloEngine";
+
+}  // namespace
+
+void LogMessage(const std::string& message) {
+#if defined(__ANDROID__)
+  __android_log_print(ANDROID_LOG_INFO, kLogTag, "%s", message.c_str());
+#else
+  std::fprintf(stderr, "%s\n", message.c_str());
+#endif
+}
+
+}  // namespace yolo
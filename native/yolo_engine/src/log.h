@@ -0,0 +1,11 @@
+#pragma once
+
+#include <string>
+
+namespace yolo {
+
+// Writes |message| to logcat under the "YoloEngine" tag on Android and to
+// stderr elsewhere.
+void LogMessage(const std::string& message);
+
+}  // namespace yolo
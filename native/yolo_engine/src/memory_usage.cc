@@ -0,0 +1,47 @@
+#include "memory_usage.h"
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstdio>
+
+#if defined(__APPLE__)
+#include <mach/mach.h>
+#endif
+
+namespace yolo {
+
+size_t ResidentMemoryBytes() {
+#if defined(__APPLE__)
+  mach_task_basic_info_data_t info;
+  mach_msg_type_number_t count = MACH_TASK_BASIC_INFO_COUNT;
+  if (task_info(mach_task_self(), MACH_TASK_BASIC_INFO, reinterpret_cast<task_info_t>(&info),
+                &count) != KERN_SUCCESS) {
+    return 0;
+  }
+  return static_cast<size_t>(info.resident_size);
+#else
+  FILE* statm = std::fopen("/proc/self/statm", "r");
+  if (statm == nullptr) {
+    return 0;
+  }
+  unsigned long total_pages = 0;
+  unsigned long resident_pages = 0;
+  const int fields = std::fscanf(statm, "%lu %lu", &total_pages, &resident_pages);
+  std::fclose(statm);
+  if (fields != 2) {
+    return 0;
+  }
+  return static_cast<size_t>(resident_pages) * static_cast<size_t>(sysconf(_SC_PAGESIZE));
+#endif
+}
+
+size_t FileSizeBytes(const std::string& path) {
+  struct stat info;
+  if (stat(path.c_str(), &info) != 0) {
+    return 0;
+  }
+  return static_cast<size_t>(info.st_size);
+}
+
+}  // namespace yolo
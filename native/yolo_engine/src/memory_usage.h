@@ -0,0 +1,14 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+namespace yolo {
+
+// Current resident set size of the process in bytes, or 0 if unavailable.
+size_t ResidentMemoryBytes();
+
+// Size of the file at |path| in bytes, or 0 if it cannot be stat'ed.
+size_t FileSizeBytes(const std::string& path);
+
+}  // namespace yolo
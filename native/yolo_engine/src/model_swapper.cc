@@ -0,0 +1,169 @@
+#include "model_swapper.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <utility>
+
+#include "engine_stats.h"
+#include "log.h"
+#include "memory_usage.h"
+
+namespace yolo {
+
+namespace {
+
+float ToMillis(uint64_t nanos) {
+  return static_cast<float>(static_cast<double>(nanos) / 1e6);
+}
+
+}  // namespace
+
+ModelSwapper::~ModelSwapper() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    cancelled_ = true;
+  }
+  retired_cv_.notify_all();
+  // A load that is still building its interpreter finishes first; there is
+  // no way to interrupt TfLiteInterpreterCreate.
+  if (thread_.joinable()) {
+    thread_.join();
+  }
+}
+
+bool ModelSwapper::Start(const std::string& model_path, const RuntimeConfig& config,
+                         const std::vector<int>& input_shape) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (in_flight_) {
+      return false;
+    }
+    in_flight_ = true;
+    request_ns_ = MonotonicNanos();
+    const int32_t swaps_completed = info_.swaps_completed;
+    info_ = YoloModelSwapInfo{};
+    info_.state = kYoloModelSwapLoading;
+    info_.swaps_completed = swaps_completed;
+  }
+  // The previous loader cleared |in_flight_| as its last step, so this join
+  // does not wait on real work.
+  if (thread_.joinable()) {
+    thread_.join();
+  }
+  thread_ = std::thread(&ModelSwapper::Load, this, model_path, config, input_shape, request_ns_);
+  return true;
+}
+
+void ModelSwapper::Load(std::string model_path, RuntimeConfig config,
+                        std::vector<int> input_shape, uint64_t request_ns) {
+  const uint64_t load_start = MonotonicNanos();
+  Prepared prepared;
+  prepared.model = LoadModel(model_path);
+  if (prepared.model == nullptr) {
+    Fail("model swap: cannot load " + model_path);
+    return;
+  }
+  prepared.runtime = InferenceRuntime::Create(prepared.model, config);
+  if (prepared.runtime == nullptr) {
+    Fail(std::string("model swap: cannot build interpreter with ") + DelegateName(config.delegate));
+    return;
+  }
+  // Preprocessing and box coordinates are sized for the current input; a
+  // model with a different input needs a new engine.
+  if (prepared.runtime->input_shape() != input_shape) {
+    Fail("model swap: input shape of " + model_path + " differs from the running model");
+    return;
+  }
+  prepared.model_bytes = FileSizeBytes(model_path);
+
+  // The first invoke pays for delegate kernel compilation and first-touch of
+  // the tensor arena; keep that off the frame thread too.
+  const uint64_t warmup_start = MonotonicNanos();
+  float* input = prepared.runtime->MutableInput();
+  bool warmed = false;
+  if (input != nullptr) {
+    std::fill(input, input + prepared.runtime->input_count(), 0.0f);
+    warmed = prepared.runtime->Run();
+  } else {
+    const std::vector<float> zeros(prepared.runtime->input_count(), 0.0f);
+    warmed = prepared.runtime->CopyInput(zeros.data(), zeros.size()) && prepared.runtime->Run();
+  }
+  if (!warmed) {
+    Fail("model swap: warm-up invoke failed for " + model_path);
+    return;
+  }
+  const uint64_t warmup_end = MonotonicNanos();
+
+  Prepared retired;
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    info_.load_ms = ToMillis(warmup_start - load_start);
+    info_.warmup_ms = ToMillis(warmup_end - warmup_start);
+    if (cancelled_) {
+      return;
+    }
+    prepared_ = std::move(prepared);
+    info_.state = kYoloModelSwapReady;
+    ready_.store(true, std::memory_order_release);
+    retired_cv_.wait(lock, [this] { return has_retired_ || cancelled_; });
+    if (!has_retired_) {
+      return;
+    }
+    retired = std::move(retired_);
+    has_retired_ = false;
+  }
+
+  const uint64_t release_start = MonotonicNanos();
+  // Interpreter before model, as in InferenceRuntime's own teardown.
+  retired.runtime.reset();
+  retired.model.reset();
+  const uint64_t release_end = MonotonicNanos();
+
+  char log[160];
+  std::snprintf(log, sizeof(log),
+                "model swap: loadMs=%.1f warmupMs=%.1f requestToSwitchMs=%.1f releaseMs=%.1f",
+                info_.load_ms, info_.warmup_ms, ToMillis(release_start - request_ns),
+                ToMillis(release_end - release_start));
+  LogMessage(log);
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  info_.release_ms = ToMillis(release_end - release_start);
+  info_.state = kYoloModelSwapDone;
+  in_flight_ = false;
+}
+
+void ModelSwapper::Fail(const std::string& reason) {
+  LogMessage(reason);
+  std::lock_guard<std::mutex> lock(mutex_);
+  info_.state = kYoloModelSwapFailed;
+  in_flight_ = false;
+}
+
+bool ModelSwapper::TakeReady(Prepared* out) {
+  if (!ready_.load(std::memory_order_acquire)) {
+    return false;
+  }
+  std::lock_guard<std::mutex> lock(mutex_);
+  *out = std::move(prepared_);
+  ready_.store(false, std::memory_order_relaxed);
+  return true;
+}
+
+void ModelSwapper::Retire(Prepared retired, uint64_t switch_ns) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    retired_ = std::move(retired);
+    has_retired_ = true;
+    info_.switch_us = static_cast<float>(static_cast<double>(switch_ns) / 1e3);
+    info_.request_to_switch_ms = ToMillis(MonotonicNanos() - request_ns_);
+    ++info_.swaps_completed;
+  }
+  retired_cv_.notify_all();
+}
+
+void ModelSwapper::GetInfo(YoloModelSwapInfo* out) const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  *out = info_;
+}
+
+}  // namespace yolo
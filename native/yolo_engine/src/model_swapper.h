@@ -0,0 +1,67 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "inference_runtime.h"
+#include "yolo_engine_api.h"
+
+namespace yolo {
+
+// Builds a replacement runtime off the frame thread so the current one keeps
+// serving frames while a new model loads. The loader thread loads the model,
+// creates the interpreter with the engine's delegate settings and runs one
+// warm-up invoke, then parks until the engine adopts the result between
+// frames. The engine hands the runtime it replaced back through Retire() so
+// the old interpreter is torn down on the loader thread, not the frame thread.
+class ModelSwapper {
+ public:
+  struct Prepared {
+    ModelHandle model;
+    std::unique_ptr<InferenceRuntime> runtime;
+    size_t model_bytes = 0;
+  };
+
+  ModelSwapper() = default;
+  // Abandons any swap in flight and joins the loader thread.
+  ~ModelSwapper();
+
+  ModelSwapper(const ModelSwapper&) = delete;
+  ModelSwapper& operator=(const ModelSwapper&) = delete;
+
+  // Starts loading |model_path|. The new model must take |input_shape|.
+  // Returns false while a previous swap has not been adopted yet.
+  bool Start(const std::string& model_path, const RuntimeConfig& config,
+             const std::vector<int>& input_shape);
+  // Frame-thread poll; a single acquire load unless a runtime is ready.
+  bool TakeReady(Prepared* out);
+  // Gives the replaced runtime to the loader thread to destroy and records
+  // how long the frame thread spent switching.
+  void Retire(Prepared retired, uint64_t switch_ns);
+  void GetInfo(YoloModelSwapInfo* out) const;
+
+ private:
+  void Load(std::string model_path, RuntimeConfig config, std::vector<int> input_shape,
+            uint64_t request_ns);
+  void Fail(const std::string& reason);
+
+  mutable std::mutex mutex_;
+  std::condition_variable retired_cv_;
+  std::thread thread_;
+  std::atomic<bool> ready_{false};
+  bool in_flight_ = false;
+  bool cancelled_ = false;
+  bool has_retired_ = false;
+  Prepared prepared_;
+  Prepared retired_;
+  uint64_t request_ns_ = 0;
+  YoloModelSwapInfo info_{};
+};
+
+}  // namespace yolo
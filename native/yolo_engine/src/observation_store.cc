@@ -0,0 +1,700 @@
+#include "observation_store.h"
+
+#include <zlib.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <utility>
+
+#include "log.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+#define YOLO_STORE_POSIX 1
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace yolo {
+
+namespace {
+
+constexpr char kFileMagic[8] = {'Y', 'O', 'B', 'S', 'L', 'O', 'G', '1'};
+constexpr char kFooterMagic[8] = {'Y', 'O', 'B', 'S', 'I', 'D', 'X', '1'};
+constexpr uint32_t kFileVersion = 1;
+// "YOBR" read as little-endian bytes.
+constexpr uint32_t kRecordMagic = 0x52424f59;
+constexpr uint16_t kKindPut = 1;
+constexpr uint16_t kKindErase = 2;
+// Dead records are only worth a rewrite once there are more of them than
+// live ones and they add up to something.
+constexpr uint64_t kMinCompactBytes = 64 * 1024;
+// Quiet time after the last write before the index is checkpointed.
+constexpr auto kCheckpointDelay = std::chrono::seconds(2);
+constexpr size_t kCopyChunkBytes = 64 * 1024;
+
+struct FileHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t header_bytes;
+  uint8_t reserved[16];
+};
+static_assert(sizeof(FileHeader) == 32, "FileHeader layout");
+
+static_assert(sizeof(YoloStoreRecord) == 40, "YoloStoreRecord layout");
+
+// |crc| covers everything after it up to the end of the payload.
+struct RecordHeader {
+  uint32_t magic;
+  uint32_t crc;
+  uint32_t record_bytes;
+  uint16_t kind;
+  uint16_t key_bytes;
+  uint32_t payload_bytes;
+  uint32_t reserved;
+  YoloStoreRecord fields;
+};
+static_assert(sizeof(RecordHeader) == 64, "RecordHeader layout");
+
+// Follows |entry_count| little-endian record offsets.
+struct Footer {
+  char magic[8];
+  uint64_t index_offset;
+  uint64_t entry_count;
+  uint32_t index_crc;
+  uint32_t footer_crc;
+};
+static_assert(sizeof(Footer) == 32, "Footer layout");
+
+uint32_t Checksum(const void* data, size_t size) {
+  return static_cast<uint32_t>(
+      crc32(0L, static_cast<const Bytef*>(data), static_cast<uInt>(size)));
+}
+
+uint32_t RecordBytes(size_t key_bytes, size_t payload_bytes) {
+  return static_cast<uint32_t>((sizeof(RecordHeader) + key_bytes + payload_bytes + 7) & ~size_t{7});
+}
+
+uint32_t RecordChecksum(const uint8_t* record) {
+  const auto* header = reinterpret_cast<const RecordHeader*>(record);
+  const size_t covered = sizeof(RecordHeader) + header->key_bytes + header->payload_bytes;
+  return Checksum(record + offsetof(RecordHeader, record_bytes),
+                  covered - offsetof(RecordHeader, record_bytes));
+}
+
+#if defined(YOLO_STORE_POSIX)
+bool WriteAll(int fd, const void* data, size_t size, uint64_t offset) {
+  const auto* bytes = static_cast<const uint8_t*>(data);
+  while (size > 0) {
+    const ssize_t written = pwrite(fd, bytes, size, static_cast<off_t>(offset));
+    if (written <= 0) {
+      return false;
+    }
+    bytes += written;
+    size -= static_cast<size_t>(written);
+    offset += static_cast<uint64_t>(written);
+  }
+  return true;
+}
+
+bool ReadAll(int fd, void* data, size_t size, uint64_t offset) {
+  auto* bytes = static_cast<uint8_t*>(data);
+  while (size > 0) {
+    const ssize_t read = pread(fd, bytes, size, static_cast<off_t>(offset));
+    if (read <= 0) {
+      return false;
+    }
+    bytes += read;
+    size -= static_cast<size_t>(read);
+    offset += static_cast<uint64_t>(read);
+  }
+  return true;
+}
+
+// Data only where the platform has it; the file size changes with appends
+// either way, which fdatasync() covers.
+void SyncFile(int fd) {
+#if defined(__APPLE__)
+  fsync(fd);
+#else
+  fdatasync(fd);
+#endif
+}
+
+// Makes a rename durable.
+void SyncDirectory(const std::string& path) {
+  const size_t slash = path.find_last_of('/');
+  const std::string directory = slash == std::string::npos ? "." : path.substr(0, slash);
+  const int fd = open(directory.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd >= 0) {
+    fsync(fd);
+    close(fd);
+  }
+}
+#endif
+
+}  // namespace
+
+std::unique_ptr<ObservationStore> ObservationStore::Open(const std::string& path) {
+#if defined(YOLO_STORE_POSIX)
+  std::unique_ptr<ObservationStore> store(new ObservationStore(path));
+  if (!store->Load()) {
+    return nullptr;
+  }
+  store->worker_ = std::thread(&ObservationStore::Run, store.get());
+  return store;
+#else
+  (void)path;
+  return nullptr;
+#endif
+}
+
+ObservationStore::ObservationStore(std::string path) : path_(std::move(path)) {}
+
+ObservationStore::~ObservationStore() {
+#if defined(YOLO_STORE_POSIX)
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopping_ = true;
+  }
+  work_cv_.notify_all();
+  if (worker_.joinable()) {
+    worker_.join();
+  }
+  Unmap();
+  if (fd_ >= 0) {
+    if (index_dirty_ && !footer_present_) {
+      WriteIndex();
+    }
+    SyncFile(fd_);
+    close(fd_);
+  }
+#endif
+}
+
+bool ObservationStore::Load() {
+#if defined(YOLO_STORE_POSIX)
+  // Whatever an interrupted compaction left is incomplete by definition.
+  unlink((path_ + ".compact").c_str());
+  fd_ = open(path_.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+  if (fd_ < 0) {
+    LogMessage("store: failed to open " + path_);
+    return false;
+  }
+  struct stat info {};
+  if (fstat(fd_, &info) != 0) {
+    return false;
+  }
+  const size_t file_bytes = static_cast<size_t>(info.st_size);
+  if (file_bytes == 0) {
+    FileHeader header{};
+    std::memcpy(header.magic, kFileMagic, sizeof(kFileMagic));
+    header.version = kFileVersion;
+    header.header_bytes = sizeof(FileHeader);
+    if (!WriteAll(fd_, &header, sizeof(header), 0)) {
+      return false;
+    }
+    end_ = sizeof(FileHeader);
+    return true;
+  }
+  FileHeader header{};
+  if (file_bytes < sizeof(FileHeader) || !ReadAll(fd_, &header, sizeof(header), 0) ||
+      std::memcmp(header.magic, kFileMagic, sizeof(kFileMagic)) != 0 ||
+      header.version != kFileVersion) {
+    // Never overwrite a file this code did not write.
+    LogMessage("store: " + path_ + " is not a record log");
+    return false;
+  }
+  mapped_bytes_ = file_bytes;
+  void* mapped = mmap(nullptr, mapped_bytes_, PROT_READ, MAP_SHARED, fd_, 0);
+  if (mapped == MAP_FAILED) {
+    mapped_bytes_ = 0;
+    return false;
+  }
+  mapping_ = static_cast<const uint8_t*>(mapped);
+  opened_from_index_ = LoadIndex(file_bytes);
+  if (!opened_from_index_) {
+    Scan(file_bytes);
+  }
+  dead_bytes_ = end_ - sizeof(FileHeader) - live_bytes_;
+  return true;
+#else
+  return false;
+#endif
+}
+
+bool ObservationStore::LoadIndex(size_t file_bytes) {
+  if (file_bytes < sizeof(FileHeader) + sizeof(Footer)) {
+    return false;
+  }
+  Footer footer{};
+  std::memcpy(&footer, mapping_ + file_bytes - sizeof(Footer), sizeof(Footer));
+  if (std::memcmp(footer.magic, kFooterMagic, sizeof(kFooterMagic)) != 0 ||
+      footer.footer_crc != Checksum(&footer, offsetof(Footer, footer_crc)) ||
+      footer.index_offset < sizeof(FileHeader) ||
+      footer.entry_count > (file_bytes - sizeof(Footer)) / sizeof(uint64_t) ||
+      footer.index_offset + footer.entry_count * sizeof(uint64_t) + sizeof(Footer) !=
+          file_bytes) {
+    return false;
+  }
+  const uint8_t* index = mapping_ + footer.index_offset;
+  if (Checksum(index, footer.entry_count * sizeof(uint64_t)) != footer.index_crc) {
+    return false;
+  }
+  // The checksums vouch for the index; each record is only checked for
+  // plausibility, which keeps opening proportional to the index.
+  std::vector<Slot> slots;
+  slots.reserve(footer.entry_count);
+  for (uint64_t i = 0; i < footer.entry_count; ++i) {
+    Slot slot;
+    std::memcpy(&slot.offset, index + i * sizeof(uint64_t), sizeof(uint64_t));
+    if (slot.offset < sizeof(FileHeader) ||
+        slot.offset + sizeof(RecordHeader) > footer.index_offset) {
+      return false;
+    }
+    const auto* record = reinterpret_cast<const RecordHeader*>(mapping_ + slot.offset);
+    if (record->magic != kRecordMagic || record->kind != kKindPut ||
+        record->record_bytes != RecordBytes(record->key_bytes, record->payload_bytes) ||
+        slot.offset + record->record_bytes > footer.index_offset) {
+      return false;
+    }
+    slot.bytes = record->record_bytes;
+    slots.push_back(slot);
+  }
+  for (const Slot& slot : slots) {
+    const auto* key = reinterpret_cast<const char*>(mapping_ + slot.offset + sizeof(RecordHeader));
+    const auto* record = reinterpret_cast<const RecordHeader*>(mapping_ + slot.offset);
+    PutSlot(std::string(key, record->key_bytes), slot);
+  }
+  end_ = footer.index_offset;
+  footer_present_ = true;
+  return true;
+}
+
+void ObservationStore::Scan(size_t file_bytes) {
+  uint64_t offset = sizeof(FileHeader);
+  while (offset + sizeof(RecordHeader) <= file_bytes) {
+    const uint8_t* bytes = mapping_ + offset;
+    const auto* record = reinterpret_cast<const RecordHeader*>(bytes);
+    if (record->magic != kRecordMagic ||
+        record->record_bytes != RecordBytes(record->key_bytes, record->payload_bytes) ||
+        offset + record->record_bytes > file_bytes || record->key_bytes == 0 ||
+        (record->kind != kKindPut && record->kind != kKindErase) ||
+        record->crc != RecordChecksum(bytes)) {
+      break;
+    }
+    std::string key(reinterpret_cast<const char*>(bytes + sizeof(RecordHeader)),
+                    record->key_bytes);
+    if (record->kind == kKindPut) {
+      PutSlot(std::move(key), Slot{offset, record->record_bytes});
+    } else {
+      auto it = keys_.find(key);
+      if (it != keys_.end()) {
+        EraseSlot(it);
+      }
+    }
+    offset += record->record_bytes;
+  }
+  end_ = offset;
+  index_dirty_ = true;
+  recovered_bytes_ = file_bytes - offset;
+#if defined(YOLO_STORE_POSIX)
+  if (recovered_bytes_ > 0) {
+    // A torn append, or an index whose checksum failed; either way the
+    // records before it stand.
+    LogMessage("store: dropped " + std::to_string(recovered_bytes_) + " bytes after the last " +
+               "intact record of " + path_);
+    if (ftruncate(fd_, static_cast<off_t>(end_)) != 0) {
+      LogMessage("store: failed to truncate " + path_);
+    }
+  }
+#endif
+}
+
+void ObservationStore::PutSlot(std::string key, Slot slot) {
+  auto it = keys_.find(key);
+  if (it == keys_.end()) {
+    keys_.emplace(std::move(key), slots_.size());
+    slots_.push_back(slot);
+  } else {
+    // A replacement keeps the original's place in the order.
+    Slot& previous = slots_[it->second];
+    live_bytes_ -= previous.bytes;
+    dead_bytes_ += previous.bytes;
+    previous = slot;
+  }
+  live_bytes_ += slot.bytes;
+}
+
+void ObservationStore::EraseSlot(std::unordered_map<std::string, size_t>::iterator it) {
+  Slot& slot = slots_[it->second];
+  live_bytes_ -= slot.bytes;
+  slot = Slot{};
+  keys_.erase(it);
+  ++erased_slots_;
+  // Dropping costs one pass over |slots_|, paid for by the erases since the
+  // last one, so each erase stays constant time on average.
+  if (erased_slots_ * 2 > slots_.size()) {
+    DropErased();
+  }
+}
+
+void ObservationStore::DropErased() {
+  std::vector<size_t> moved_to(slots_.size());
+  size_t kept = 0;
+  for (size_t i = 0; i < slots_.size(); ++i) {
+    moved_to[i] = kept;
+    if (!slots_[i].erased()) {
+      slots_[kept++] = slots_[i];
+    }
+  }
+  slots_.resize(kept);
+  for (auto& entry : keys_) {
+    entry.second = moved_to[entry.second];
+  }
+  erased_slots_ = 0;
+}
+
+bool ObservationStore::Append(uint16_t kind, const uint8_t* key, size_t key_bytes,
+                              const YoloStoreRecord& record, const uint8_t* payload,
+                              size_t payload_bytes, uint32_t* bytes) {
+#if defined(YOLO_STORE_POSIX)
+  if (footer_present_) {
+    if (ftruncate(fd_, static_cast<off_t>(end_)) != 0) {
+      return false;
+    }
+    footer_present_ = false;
+    remap_needed_ = true;
+  }
+  const uint32_t record_bytes = RecordBytes(key_bytes, payload_bytes);
+  record_buffer_.assign(record_bytes, 0);
+  RecordHeader header{};
+  header.magic = kRecordMagic;
+  header.record_bytes = record_bytes;
+  header.kind = kind;
+  header.key_bytes = static_cast<uint16_t>(key_bytes);
+  header.payload_bytes = static_cast<uint32_t>(payload_bytes);
+  header.fields = record;
+  std::memcpy(record_buffer_.data(), &header, sizeof(header));
+  std::memcpy(record_buffer_.data() + sizeof(header), key, key_bytes);
+  if (payload_bytes > 0) {
+    std::memcpy(record_buffer_.data() + sizeof(header) + key_bytes, payload, payload_bytes);
+  }
+  header.crc = RecordChecksum(record_buffer_.data());
+  std::memcpy(record_buffer_.data() + offsetof(RecordHeader, crc), &header.crc,
+              sizeof(header.crc));
+  if (!WriteAll(fd_, record_buffer_.data(), record_bytes, end_)) {
+    // A partial record would fail its checksum anyway; cutting it keeps the
+    // next append from landing after it.
+    if (ftruncate(fd_, static_cast<off_t>(end_)) != 0) {
+      LogMessage("store: failed to truncate " + path_);
+    }
+    return false;
+  }
+  end_ += record_bytes;
+  *bytes = record_bytes;
+  return true;
+#else
+  (void)kind;
+  (void)key;
+  (void)key_bytes;
+  (void)record;
+  (void)payload;
+  (void)payload_bytes;
+  (void)bytes;
+  return false;
+#endif
+}
+
+void ObservationStore::MarkWritten() {
+  index_dirty_ = true;
+  sync_pending_ = true;
+  if (dead_bytes_ >= kMinCompactBytes && dead_bytes_ > live_bytes_) {
+    compact_requested_ = true;
+  }
+  work_cv_.notify_one();
+}
+
+bool ObservationStore::Put(const uint8_t* key, size_t key_bytes, const YoloStoreRecord& record,
+                           const uint8_t* payload, size_t payload_bytes) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  const uint64_t offset = end_;
+  uint32_t bytes = 0;
+  if (!Append(kKindPut, key, key_bytes, record, payload, payload_bytes, &bytes)) {
+    return false;
+  }
+  PutSlot(std::string(reinterpret_cast<const char*>(key), key_bytes), Slot{offset, bytes});
+  MarkWritten();
+  return true;
+}
+
+bool ObservationStore::Erase(const uint8_t* key, size_t key_bytes) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = keys_.find(std::string(reinterpret_cast<const char*>(key), key_bytes));
+  if (it == keys_.end()) {
+    return true;
+  }
+  uint32_t bytes = 0;
+  if (!Append(kKindErase, key, key_bytes, YoloStoreRecord{}, nullptr, 0, &bytes)) {
+    return false;
+  }
+  dead_bytes_ += slots_[it->second].bytes + bytes;
+  EraseSlot(it);
+  MarkWritten();
+  return true;
+}
+
+bool ObservationStore::Clear() {
+#if defined(YOLO_STORE_POSIX)
+  std::lock_guard<std::mutex> lock(mutex_);
+  // The caller's views die with the records.
+  Unmap();
+  view_.clear();
+  if (ftruncate(fd_, sizeof(FileHeader)) != 0) {
+    return false;
+  }
+  slots_.clear();
+  keys_.clear();
+  erased_slots_ = 0;
+  end_ = sizeof(FileHeader);
+  live_bytes_ = 0;
+  dead_bytes_ = 0;
+  footer_present_ = false;
+  ++generation_;
+  MarkWritten();
+  return true;
+#else
+  return false;
+#endif
+}
+
+bool ObservationStore::Remap() {
+#if defined(YOLO_STORE_POSIX)
+  if (!remap_needed_ && mapping_ != nullptr && mapped_bytes_ >= end_) {
+    return true;
+  }
+  Unmap();
+  remap_needed_ = false;
+  if (end_ == 0) {
+    return true;
+  }
+  void* mapped = mmap(nullptr, end_, PROT_READ, MAP_SHARED, fd_, 0);
+  if (mapped == MAP_FAILED) {
+    return false;
+  }
+  mapping_ = static_cast<const uint8_t*>(mapped);
+  mapped_bytes_ = end_;
+  return true;
+#else
+  return false;
+#endif
+}
+
+void ObservationStore::Unmap() {
+#if defined(YOLO_STORE_POSIX)
+  if (mapping_ != nullptr) {
+    munmap(const_cast<uint8_t*>(mapping_), mapped_bytes_);
+  }
+#endif
+  mapping_ = nullptr;
+  mapped_bytes_ = 0;
+}
+
+int32_t ObservationStore::Acquire(uint32_t required_flags, const YoloStoreEntry** out) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  view_.clear();
+  if (!Remap()) {
+    return -2;
+  }
+  for (const Slot& slot : slots_) {
+    if (slot.erased()) {
+      continue;
+    }
+    const uint8_t* bytes = mapping_ + slot.offset;
+    const auto* record = reinterpret_cast<const RecordHeader*>(bytes);
+    if ((record->fields.flags & required_flags) != required_flags) {
+      continue;
+    }
+    YoloStoreEntry entry{};
+    entry.record = record->fields;
+    entry.key = bytes + sizeof(RecordHeader);
+    entry.key_bytes = record->key_bytes;
+    entry.payload = entry.key + record->key_bytes;
+    entry.payload_bytes = static_cast<int32_t>(record->payload_bytes);
+    view_.push_back(entry);
+  }
+  *out = view_.data();
+  return static_cast<int32_t>(view_.size());
+}
+
+void ObservationStore::GetStats(YoloStoreStats* out) const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  out->live_records = static_cast<int64_t>(keys_.size());
+  out->file_bytes = static_cast<int64_t>(
+      end_ + (footer_present_ ? keys_.size() * sizeof(uint64_t) + sizeof(Footer) : 0));
+  out->dead_bytes = static_cast<int64_t>(dead_bytes_);
+  out->recovered_bytes = static_cast<int64_t>(recovered_bytes_);
+  out->compactions = compactions_;
+  out->opened_from_index = opened_from_index_ ? 1 : 0;
+}
+
+bool ObservationStore::WriteIndex() {
+#if defined(YOLO_STORE_POSIX)
+  const size_t entries = keys_.size();
+  std::vector<uint8_t> buffer(entries * sizeof(uint64_t) + sizeof(Footer));
+  size_t written = 0;
+  for (const Slot& slot : slots_) {
+    if (!slot.erased()) {
+      std::memcpy(buffer.data() + written++ * sizeof(uint64_t), &slot.offset, sizeof(uint64_t));
+    }
+  }
+  Footer footer{};
+  std::memcpy(footer.magic, kFooterMagic, sizeof(kFooterMagic));
+  footer.index_offset = end_;
+  footer.entry_count = entries;
+  footer.index_crc = Checksum(buffer.data(), entries * sizeof(uint64_t));
+  footer.footer_crc = Checksum(&footer, offsetof(Footer, footer_crc));
+  std::memcpy(buffer.data() + entries * sizeof(uint64_t), &footer, sizeof(footer));
+  if (!WriteAll(fd_, buffer.data(), buffer.size(), end_)) {
+    // Leave no half-written index behind; the records are what count.
+    if (ftruncate(fd_, static_cast<off_t>(end_)) != 0) {
+      LogMessage("store: failed to truncate " + path_);
+    }
+    return false;
+  }
+  footer_present_ = true;
+  index_dirty_ = false;
+  return true;
+#else
+  return false;
+#endif
+}
+
+void ObservationStore::Run() {
+#if defined(YOLO_STORE_POSIX)
+  std::unique_lock<std::mutex> lock(mutex_);
+  auto has_work = [this] { return stopping_ || sync_pending_ || compact_requested_; };
+  for (;;) {
+    work_cv_.wait(lock, has_work);
+    if (stopping_) {
+      return;
+    }
+    if (compact_requested_) {
+      compact_requested_ = false;
+      Compact(&lock);
+      continue;
+    }
+    sync_pending_ = false;
+    const int fd = fd_;
+    lock.unlock();
+    SyncFile(fd);
+    lock.lock();
+    // Checkpoint the index once saves stop coming, so the next launch opens
+    // without a scan even if this process never closes the store.
+    if (work_cv_.wait_for(lock, kCheckpointDelay, has_work)) {
+      continue;
+    }
+    if (index_dirty_ && !footer_present_ && WriteIndex()) {
+      SyncFile(fd_);
+    }
+  }
+#endif
+}
+
+void ObservationStore::Compact(std::unique_lock<std::mutex>* lock) {
+#if defined(YOLO_STORE_POSIX)
+  const uint64_t generation = generation_;
+  const std::vector<Slot> snapshot = slots_;
+  const uint64_t snapshot_end = end_;
+  const int source = fd_;
+  const std::string temp_path = path_ + ".compact";
+  lock->unlock();
+
+  // Copy the live records with the caller free to keep appending.
+  std::unordered_map<uint64_t, uint64_t> moved;
+  moved.reserve(snapshot.size());
+  std::vector<uint8_t> buffer;
+  const int target = open(temp_path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+  bool ok = target >= 0;
+  uint64_t written = sizeof(FileHeader);
+  if (ok) {
+    buffer.resize(sizeof(FileHeader));
+    ok = ReadAll(source, buffer.data(), sizeof(FileHeader), 0) &&
+         WriteAll(target, buffer.data(), sizeof(FileHeader), 0);
+  }
+  for (size_t i = 0; ok && i < snapshot.size(); ++i) {
+    if (snapshot[i].erased()) {
+      continue;
+    }
+    buffer.resize(snapshot[i].bytes);
+    ok = ReadAll(source, buffer.data(), snapshot[i].bytes, snapshot[i].offset) &&
+         WriteAll(target, buffer.data(), snapshot[i].bytes, written);
+    moved.emplace(snapshot[i].offset, written);
+    written += snapshot[i].bytes;
+  }
+
+  lock->lock();
+  if (!ok || stopping_ || generation != generation_) {
+    if (target >= 0) {
+      close(target);
+    }
+    unlink(temp_path.c_str());
+    return;
+  }
+  // Appends made meanwhile go over as they are; their offsets shift by a
+  // constant.
+  const uint64_t tail_start = written;
+  buffer.resize(kCopyChunkBytes);
+  for (uint64_t offset = snapshot_end; ok && offset < end_; offset += kCopyChunkBytes) {
+    const size_t bytes = static_cast<size_t>(std::min<uint64_t>(kCopyChunkBytes, end_ - offset));
+    ok = ReadAll(fd_, buffer.data(), bytes, offset) &&
+         WriteAll(target, buffer.data(), bytes, tail_start + (offset - snapshot_end));
+  }
+  std::vector<Slot> slots = slots_;
+  for (Slot& slot : slots) {
+    if (slot.erased()) {
+      continue;
+    }
+    if (slot.offset >= snapshot_end) {
+      slot.offset = slot.offset - snapshot_end + tail_start;
+    } else {
+      auto it = moved.find(slot.offset);
+      ok = ok && it != moved.end();
+      if (it != moved.end()) slot.offset = it->second;
+    }
+  }
+  if (ok) {
+    SyncFile(target);
+    ok = rename(temp_path.c_str(), path_.c_str()) == 0;
+  }
+  if (!ok) {
+    close(target);
+    unlink(temp_path.c_str());
+    LogMessage("store: compaction of " + path_ + " failed");
+    return;
+  }
+  SyncDirectory(path_);
+  const uint64_t reclaimed = snapshot_end - tail_start;
+  close(fd_);
+  fd_ = target;
+  slots_ = std::move(slots);
+  end_ = tail_start + (end_ - snapshot_end);
+  dead_bytes_ = end_ - sizeof(FileHeader) - live_bytes_;
+  footer_present_ = false;
+  remap_needed_ = true;
+  ++compactions_;
+  if (WriteIndex()) {
+    SyncFile(fd_);
+  }
+  LogMessage("store: compacted " + path_ + ", reclaimed " + std::to_string(reclaimed) +
+             " bytes");
+#else
+  (void)lock;
+#endif
+}
+
+}  // namespace yolo
@@ -0,0 +1,112 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "observation_store_api.h"
+
+namespace yolo {
+
+// The record log behind YoloStore*(); see observation_store_api.h for the
+// contract. Layout: a 32-byte file header, then records, each a 64-byte
+// header (checksum, sizes, kind and the YoloStoreRecord fields) followed by
+// the key and payload and padded to 8 bytes. After a clean close or a
+// compaction the file ends with the offsets of the live records and a
+// checksummed footer; the first write after opening cuts them off again, and
+// the worker thread puts them back once writes settle.
+//
+// The calling thread appends with pwrite() and reads through a mapping it
+// alone owns. The worker thread flushes, checkpoints the index and compacts.
+// A compaction copies the live records to a new file with the lock released,
+// then takes it again to copy whatever was appended meanwhile before
+// renaming the new file over the old one. The caller's mapping of the old
+// file stays valid until its next call remaps.
+class ObservationStore {
+ public:
+  static std::unique_ptr<ObservationStore> Open(const std::string& path);
+  // Joins the worker and writes the index.
+  ~ObservationStore();
+
+  ObservationStore(const ObservationStore&) = delete;
+  ObservationStore& operator=(const ObservationStore&) = delete;
+
+  bool Put(const uint8_t* key, size_t key_bytes, const YoloStoreRecord& record,
+           const uint8_t* payload, size_t payload_bytes);
+  bool Erase(const uint8_t* key, size_t key_bytes);
+  bool Clear();
+  // Live entries whose flags include |required_flags|; see YoloStoreAcquire().
+  int32_t Acquire(uint32_t required_flags, const YoloStoreEntry** out);
+  void GetStats(YoloStoreStats* out) const;
+
+ private:
+  struct Slot {
+    // Offset 0 holds the file header, so it marks an erased slot.
+    uint64_t offset = 0;
+    uint32_t bytes = 0;
+
+    bool erased() const { return offset == 0; }
+  };
+
+  explicit ObservationStore(std::string path);
+
+  bool Load();
+  bool LoadIndex(size_t file_bytes);
+  void Scan(size_t file_bytes);
+  // Appends one record at |end_|; false leaves the file as it was.
+  bool Append(uint16_t kind, const uint8_t* key, size_t key_bytes,
+              const YoloStoreRecord& record, const uint8_t* payload, size_t payload_bytes,
+              uint32_t* bytes);
+  void PutSlot(std::string key, Slot slot);
+  void EraseSlot(std::unordered_map<std::string, size_t>::iterator it);
+  void DropErased();
+  void MarkWritten();
+  bool WriteIndex();
+  bool Remap();
+  void Unmap();
+  void Run();
+  void Compact(std::unique_lock<std::mutex>* lock);
+
+  const std::string path_;
+  int fd_ = -1;
+  mutable std::mutex mutex_;
+  std::condition_variable work_cv_;
+  std::thread worker_;
+
+  // Records, oldest first, and where each live key sits among them. An
+  // erase leaves its slot behind so no other key moves; the erased slots are
+  // dropped together once they make up half of |slots_|.
+  std::vector<Slot> slots_;
+  std::unordered_map<std::string, size_t> keys_;
+  size_t erased_slots_ = 0;
+  uint64_t end_ = 0;
+  uint64_t live_bytes_ = 0;
+  uint64_t dead_bytes_ = 0;
+  // The index and footer follow |end_| on disk.
+  bool footer_present_ = false;
+  bool index_dirty_ = false;
+  bool sync_pending_ = false;
+  bool compact_requested_ = false;
+  bool stopping_ = false;
+  // Bumped by Clear() so a compaction that started before it is dropped.
+  uint64_t generation_ = 0;
+
+  // Caller thread only.
+  const uint8_t* mapping_ = nullptr;
+  size_t mapped_bytes_ = 0;
+  bool remap_needed_ = false;
+  std::vector<uint8_t> record_buffer_;
+  std::vector<YoloStoreEntry> view_;
+
+  int32_t compactions_ = 0;
+  bool opened_from_index_ = false;
+  uint64_t recovered_bytes_ = 0;
+};
+
+}  // namespace yolo
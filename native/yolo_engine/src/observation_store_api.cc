@@ -0,0 +1,79 @@
+#include "observation_store_api.h"
+
+#include <cstddef>
+#include <cstdint>
+
+#include "observation_store.h"
+
+namespace {
+
+// Key lengths are stored in 16 bits.
+constexpr size_t kMaxKeyBytes = 0xffff;
+
+yolo::ObservationStore* AsStore(void* handle) {
+  return static_cast<yolo::ObservationStore*>(handle);
+}
+
+}  // namespace
+
+extern "C" {
+
+void* YoloStoreOpen(const char* path) {
+  if (path == nullptr) {
+    return nullptr;
+  }
+  return yolo::ObservationStore::Open(path).release();
+}
+
+void YoloStoreClose(void* store) {
+  delete AsStore(store);
+}
+
+int32_t YoloStorePut(void* store, const uint8_t* key, int32_t key_bytes,
+                     const YoloStoreRecord* record, const uint8_t* payload,
+                     int32_t payload_bytes) {
+  if (store == nullptr || key == nullptr || key_bytes <= 0 ||
+      static_cast<size_t>(key_bytes) > kMaxKeyBytes || record == nullptr ||
+      payload_bytes < 0 || (payload == nullptr && payload_bytes > 0)) {
+    return -1;
+  }
+  return AsStore(store)->Put(
+             key, static_cast<size_t>(key_bytes), *record, payload,
+             static_cast<size_t>(payload_bytes))
+             ? 0
+             : -2;
+}
+
+int32_t YoloStoreErase(void* store, const uint8_t* key, int32_t key_bytes) {
+  if (store == nullptr || key == nullptr || key_bytes <= 0 ||
+      static_cast<size_t>(key_bytes) > kMaxKeyBytes) {
+    return -1;
+  }
+  return AsStore(store)->Erase(key, static_cast<size_t>(key_bytes))
+             ? 0
+             : -2;
+}
+
+int32_t YoloStoreClear(void* store) {
+  if (store == nullptr) {
+    return -1;
+  }
+  return AsStore(store)->Clear() ? 0 : -2;
+}
+
+int32_t YoloStoreAcquire(void* store, uint32_t required_flags, const YoloStoreEntry** out) {
+  if (store == nullptr || out == nullptr) {
+    return -1;
+  }
+  return AsStore(store)->Acquire(required_flags, out);
+}
+
+int32_t YoloStoreGetStats(void* store, YoloStoreStats* out) {
+  if (store == nullptr || out == nullptr) {
+    return -1;
+  }
+  AsStore(store)->GetStats(out);
+  return 0;
+}
+
+}  // extern "C"
@@ -2,30 +2,19 @@
 
 #include <algorithm>
 #include <cmath>
-#include <cstdio>
 #include <limits>
 #include <sstream>
 #include <string>
 #include <utility>
 
-#if defined(__ANDROID__)
-#include <android/log.h>
-#endif
+#include "log.h"
+#include "thread_pool.h"
+#include "yolo_engine.h"
 
 namespace yolo {
 
 namespace {
 
-constexpr char kLogTag[] = "YoloEngine";
-
-void LogMessage(const std::string& message) {
-#if defined(__ANDROID__)
-  __android_log_print(ANDROID_LOG_INFO, kLogTag, "%s", message.c_str());
-#else
-  std::fprintf(stderr, "%s\n", message.c_str());
-#endif
-}
-
 std::string ShapeToString(const std::vector<int>& shape) {
   std::ostringstream out;
   out << '[';
@@ -45,6 +34,230 @@ float Clamp(float value, float minimum, float maximum) {
   return value;
 }
 
+// Predictions per decode band. Each prediction reads one float from every
+// channel, so bands are sized on that footprint.
+constexpr int kMinDecodeBand = 64;
+// Predictions whose class scores the channel-major kernel reduces together.
+constexpr int kScoreBlock = 64;
+
+int DecodeBandSize(int channels, int num_pred, ThreadPool* pool) {
+  if (pool == nullptr || pool->num_threads() <= 1) {
+    return std::max(1, num_pred);
+  }
+  const int prediction_bytes = channels * static_cast<int>(sizeof(float));
+  return std::max(kMinDecodeBand, RowsPerBand(prediction_bytes, num_pred, pool->num_threads()));
+}
+
+// Converts one prediction that passed the threshold to a clamped box in
+// input pixels. Box coordinates may be normalized or in pixels.
+inline YoloDetection MakeDetection(float cx, float cy, float w, float h, float score,
+                                   int class_index, const EngineOptions& options) {
+  const bool normalized =
+      std::fabs(cx) <= 1.5f && std::fabs(cy) <= 1.5f && w <= 1.5f && h <= 1.5f;
+  const float scale_x = normalized ? static_cast<float>(options.input_width) : 1.0f;
+  const float scale_y = normalized ? static_cast<float>(options.input_height) : 1.0f;
+
+  const float bx = cx * scale_x - 0.5f * w * scale_x;
+  const float by = cy * scale_y - 0.5f * h * scale_y;
+  const float bw = w * scale_x;
+  const float bh = h * scale_y;
+
+  YoloDetection det;
+  det.left = Clamp(bx, 0.0f, static_cast<float>(options.input_width));
+  det.top = Clamp(by, 0.0f, static_cast<float>(options.input_height));
+  det.right = Clamp(bx + bw, 0.0f, static_cast<float>(options.input_width));
+  det.bottom = Clamp(by + bh, 0.0f, static_cast<float>(options.input_height));
+  det.score = score;
+  det.class_index = class_index;
+  return det;
+}
+
+// [1, 4 + C, N]: a class's scores are contiguous across predictions, so a
+// block of predictions is max-reduced class by class, which the compiler
+// turns into vector max instructions. Most predictions fall below the
+// threshold; the winning class is only searched for the survivors, so ties
+// still go to the lowest class index. kClasses > 0 fixes the class count at
+// compile time; 0 reads it from the layout. A class mask swaps the class
+// range for the list of enabled classes, so masked rows are never read and
+// cannot outscore an enabled class.
+template <int kClasses>
+size_t DecodeChannelMajor(const float* tensor, const DecodeLayout& layout,
+                          const EngineOptions& options, const DecodeSettings& settings,
+                          int begin, int end, YoloDetection* out) {
+  const int classes = kClasses > 0 ? kClasses : layout.channels - 4;
+  const int* enabled = settings.masked ? settings.classes.data() : nullptr;
+  const int scored = settings.masked ? static_cast<int>(settings.classes.size()) : classes;
+  if (scored == 0) {
+    return 0;
+  }
+  const bool per_class = !settings.thresholds.empty();
+  const size_t stride = static_cast<size_t>(layout.num_pred);
+  const float* scores = tensor + 4 * stride;
+  float best[kScoreBlock];
+  size_t kept = 0;
+  for (int block = begin; block < end; block += kScoreBlock) {
+    const int count = std::min(kScoreBlock, end - block);
+    const float* first = scores + block;
+    if (enabled == nullptr) {
+      std::copy(first, first + count, best);
+      for (int c = 1; c < classes; ++c) {
+        const float* row = first + static_cast<size_t>(c) * stride;
+        for (int j = 0; j < count; ++j) {
+          best[j] = std::max(best[j], row[j]);
+        }
+      }
+    } else {
+      const float* row = first + static_cast<size_t>(enabled[0]) * stride;
+      std::copy(row, row + count, best);
+      for (int k = 1; k < scored; ++k) {
+        row = first + static_cast<size_t>(enabled[k]) * stride;
+        for (int j = 0; j < count; ++j) {
+          best[j] = std::max(best[j], row[j]);
+        }
+      }
+    }
+    for (int j = 0; j < count; ++j) {
+      if (!(best[j] >= settings.min_threshold)) {
+        continue;
+      }
+      int best_class = 0;
+      if (enabled == nullptr) {
+        while (first[static_cast<size_t>(best_class) * stride + j] != best[j]) {
+          ++best_class;
+        }
+      } else {
+        int k = 0;
+        while (first[static_cast<size_t>(enabled[k]) * stride + j] != best[j]) {
+          ++k;
+        }
+        best_class = enabled[k];
+      }
+      if (per_class && !(best[j] >= settings.thresholds[best_class])) {
+        continue;
+      }
+      const size_t i = static_cast<size_t>(block + j);
+      out[kept++] = MakeDetection(tensor[i], tensor[stride + i], tensor[2 * stride + i],
+                                  tensor[3 * stride + i], best[j], best_class, options);
+    }
+  }
+  return kept;
+}
+
+// [1, N, 4 + C]: each prediction is one contiguous row. Most rows fall below
+// the threshold, so the max is found first (a plain reduction) and the
+// winning index only searched for the survivors. A class mask gathers the
+// enabled scores instead of scanning the row.
+template <int kClasses>
+size_t DecodeAnchorMajor(const float* tensor, const DecodeLayout& layout,
+                         const EngineOptions& options, const DecodeSettings& settings,
+                         int begin, int end, YoloDetection* out) {
+  const int channels = kClasses > 0 ? kClasses + 4 : layout.channels;
+  const int classes = channels - 4;
+  const int* enabled = settings.masked ? settings.classes.data() : nullptr;
+  const int scored = settings.masked ? static_cast<int>(settings.classes.size()) : classes;
+  if (scored == 0) {
+    return 0;
+  }
+  const bool per_class = !settings.thresholds.empty();
+  size_t kept = 0;
+  for (int i = begin; i < end; ++i) {
+    const float* row = tensor + static_cast<size_t>(i) * channels;
+    const float* scores = row + 4;
+    float best;
+    int best_class = 0;
+    if (enabled == nullptr) {
+      best = scores[0];
+      for (int c = 1; c < classes; ++c) {
+        best = std::max(best, scores[c]);
+      }
+      if (!(best >= settings.min_threshold)) {
+        continue;
+      }
+      while (scores[best_class] != best) {
+        ++best_class;
+      }
+    } else {
+      best = scores[enabled[0]];
+      for (int k = 1; k < scored; ++k) {
+        best = std::max(best, scores[enabled[k]]);
+      }
+      if (!(best >= settings.min_threshold)) {
+        continue;
+      }
+      int k = 0;
+      while (scores[enabled[k]] != best) {
+        ++k;
+      }
+      best_class = enabled[k];
+    }
+    if (per_class && !(best >= settings.thresholds[best_class])) {
+      continue;
+    }
+    out[kept++] = MakeDetection(row[0], row[1], row[2], row[3], best, best_class, options);
+  }
+  return kept;
+}
+
+template <int kClasses>
+DecodeKernel KernelFor(OutputLayout layout) {
+  return layout == OutputLayout::kAnchorMajor ? &DecodeAnchorMajor<kClasses>
+                                              : &DecodeChannelMajor<kClasses>;
+}
+
+// Single-class detectors, the small class counts of field-specific models,
+// and COCO get unrolled kernels; anything else uses the generic one.
+DecodeKernel SelectKernel(OutputLayout layout, int num_classes) {
+  switch (num_classes) {
+    case 1:
+      return KernelFor<1>(layout);
+    case 2:
+      return KernelFor<2>(layout);
+    case 3:
+      return KernelFor<3>(layout);
+    case 4:
+      return KernelFor<4>(layout);
+    case 80:
+      return KernelFor<80>(layout);
+    default:
+      return KernelFor<0>(layout);
+  }
+}
+
+}  // namespace
+
+void DecodeSettings::Resolve(int num_classes) {
+  classes.clear();
+  thresholds.clear();
+  masked = false;
+  for (int c = 0; c < num_classes; ++c) {
+    if (!class_enabled.empty() &&
+        (static_cast<size_t>(c) >= class_enabled.size() || class_enabled[c] == 0)) {
+      masked = true;
+    } else {
+      classes.push_back(c);
+    }
+  }
+  bool per_class = false;
+  for (size_t c = 0; c < class_thresholds.size() && c < static_cast<size_t>(num_classes); ++c) {
+    per_class = per_class || class_thresholds[c] > 0.0f;
+  }
+  if (per_class) {
+    thresholds.assign(static_cast<size_t>(num_classes), confidence_threshold);
+    for (size_t c = 0; c < class_thresholds.size() && c < thresholds.size(); ++c) {
+      if (class_thresholds[c] > 0.0f) {
+        thresholds[c] = class_thresholds[c];
+      }
+    }
+  }
+  min_threshold = confidence_threshold;
+  if (per_class && !classes.empty()) {
+    min_threshold = thresholds[classes[0]];
+    for (int c : classes) {
+      min_threshold = std::min(min_threshold, thresholds[c]);
+    }
+  }
+}
+
 float ComputeIoU(const YoloDetection& a, const YoloDetection& b) {
   const float inter_left = std::max(a.left, b.left);
   const float inter_top = std::max(a.top, b.top);
@@ -59,141 +272,136 @@ float ComputeIoU(const YoloDetection& a, const YoloDetection& b) {
   return denom <= 0.0f ? 0.0f : inter_area / denom;
 }
 
-}  // namespace
-
-std::vector<YoloDetection> DecodeDetections(const std::vector<float>& tensor,
-                                            const std::vector<int>& shape,
-                                            const EngineOptions& options) {
-  std::vector<YoloDetection> empty;
-  if (tensor.empty()) {
-    return empty;
+const char* OutputLayoutName(OutputLayout layout) {
+  switch (layout) {
+    case OutputLayout::kChannelMajor:
+      return "channel-major";
+    case OutputLayout::kAnchorMajor:
+      return "anchor-major";
   }
+  return "unknown";
+}
+
+DecodeLayout ResolveDecodeLayout(const std::vector<int>& shape) {
+  DecodeLayout resolved;
   if (shape.size() != 3 && shape.size() != 4) {
     LogMessage("decode: unsupported outputTensorShape=" + ShapeToString(shape));
-    return empty;
+    return resolved;
   }
-
-  int channels = 0;
-  int num_pred = 0;
-
-  if (shape.size() == 3) {
-    channels = shape[1];
-    num_pred = shape[2];
-  } else if (shape.size() == 4 && shape[1] == 1) {
-    channels = shape[2];
-    num_pred = shape[3];
-  } else if (shape.size() == 4 && shape[3] == 1) {
-    channels = shape[1];
-    num_pred = shape[2];
+  // Batch first, then exactly two non-unit axes.
+  std::vector<int> axes;
+  for (size_t i = 1; i < shape.size(); ++i) {
+    if (shape[i] != 1) {
+      axes.push_back(shape[i]);
+    }
   }
-
-  if (channels < 5 || num_pred <= 0) {
-    std::ostringstream log;
-    log << "decode: invalid outputTensorShape=" << ShapeToString(shape)
-        << " channels=" << channels << " numPred=" << num_pred;
-    LogMessage(log.str());
-    return empty;
+  if (axes.size() != 2 || std::min(axes[0], axes[1]) < 5) {
+    LogMessage("decode: invalid outputTensorShape=" + ShapeToString(shape));
+    return resolved;
   }
+  // A detector has far more predictions than classes, so the shorter axis
+  // holds the box coordinates and class scores.
+  resolved.layout = axes[0] <= axes[1] ? OutputLayout::kChannelMajor : OutputLayout::kAnchorMajor;
+  resolved.channels = std::min(axes[0], axes[1]);
+  resolved.num_pred = std::max(axes[0], axes[1]);
+  resolved.kernel = SelectKernel(resolved.layout, resolved.channels - 4);
+  std::ostringstream log;
+  log << "decode: outputTensorShape=" << ShapeToString(shape) << ' '
+      << OutputLayoutName(resolved.layout) << " numPred=" << resolved.num_pred
+      << " numClasses=" << resolved.channels - 4;
+  LogMessage(log.str());
+  return resolved;
+}
 
-  const int num_classes = channels - 4;
-  if (num_classes <= 0) {
-    std::ostringstream log;
-    log << "decode: invalid numClasses=" << num_classes
-        << " from outputTensorShape=" << ShapeToString(shape);
-    LogMessage(log.str());
-    return empty;
+size_t DecodeScratchBytes(const DecodeLayout& layout) {
+  if (!layout.valid()) {
+    return 0;
   }
+  const size_t count = static_cast<size_t>(layout.num_pred);
+  const size_t bands = count / kMinDecodeBand + 1;
+  return ScratchArena::AlignUp(count * sizeof(YoloDetection)) + ScratchArena::AlignUp(count) +
+         ScratchArena::AlignUp(bands * sizeof(size_t));
+}
 
-  const size_t expected_size = static_cast<size_t>(channels) * static_cast<size_t>(num_pred);
-  if (tensor.size() < expected_size) {
-    std::ostringstream log;
-    log << "decode: outputTensor too small (size=" << tensor.size()
-        << " expected>=" << expected_size << ") for outputTensorShape="
-        << ShapeToString(shape);
-    LogMessage(log.str());
-    return empty;
+void DecodeDetections(const float* tensor, size_t tensor_size, const DecodeLayout& layout,
+                      const EngineOptions& options, const DecodeSettings& settings,
+                      ScratchArena* arena,
+                      std::vector<YoloDetection>* results, ThreadPool* pool,
+                      DecodeStats* stats) {
+  if (results == nullptr) {
+    return;
   }
-
-  const int loop_pred_count = num_pred;
-  {
+  results->clear();
+  if (tensor == nullptr || tensor_size == 0 || arena == nullptr || !layout.valid()) {
+    return;
+  }
+  const size_t expected_size =
+      static_cast<size_t>(layout.channels) * static_cast<size_t>(layout.num_pred);
+  if (tensor_size < expected_size) {
     std::ostringstream log;
-    log << "decode: outputTensorShape=" << ShapeToString(shape)
-        << " channels=" << channels
-        << " numPred=" << num_pred
-        << " numClasses=" << num_classes
-        << " loopBound=" << loop_pred_count;
+    log << "decode: outputTensor too small (size=" << tensor_size
+        << " expected>=" << expected_size << ')';
     LogMessage(log.str());
+    return;
   }
 
-  std::vector<YoloDetection> candidates;
-  candidates.reserve(std::min(loop_pred_count, options.max_detections * 2));
-
-  for (int i = 0; i < loop_pred_count; ++i) {
-    float cx = 0.0f;
-    float cy = 0.0f;
-    float w = 0.0f;
-    float h = 0.0f;
-    int best_class = -1;
-    float best_score = -std::numeric_limits<float>::infinity();
-
-    const int base = i;
-    cx = tensor[0 * loop_pred_count + base];
-    cy = tensor[1 * loop_pred_count + base];
-    w = tensor[2 * loop_pred_count + base];
-    h = tensor[3 * loop_pred_count + base];
-    const int class_start = 4;
-    for (int c = 0; c < num_classes; ++c) {
-      const float cls_score = tensor[(class_start + c) * loop_pred_count + base];
-      if (cls_score > best_score) {
-        best_score = cls_score;
-        best_class = c;
-      }
-    }
+  const int loop_pred_count = layout.num_pred;
+  auto* candidates = arena->Allocate<YoloDetection>(static_cast<size_t>(loop_pred_count));
+  const int band = DecodeBandSize(layout.channels, loop_pred_count, pool);
+  const int band_count = (loop_pred_count + band - 1) / band;
+  auto* band_kept = arena->Allocate<size_t>(static_cast<size_t>(band_count));
+  if (candidates == nullptr || band_kept == nullptr) {
+    return;
+  }
 
-    if (best_score < options.confidence_threshold) {
-      continue;
+  // Class reduction dominates decode, so bands of predictions are scored in
+  // parallel, each into its own slice of |candidates|, and then compacted in
+  // order so the result does not depend on the thread count.
+  auto score_band = [&](int begin, int end) {
+    band_kept[begin / band] =
+        layout.kernel(tensor, layout, options, settings, begin, end, candidates + begin);
+  };
+  if (band_count > 1) {
+    pool->ParallelFor(loop_pred_count, band, score_band);
+  } else {
+    score_band(0, loop_pred_count);
+  }
+  size_t candidate_count = 0;
+  for (int b = 0; b < band_count; ++b) {
+    const YoloDetection* slice = candidates + static_cast<size_t>(b) * band;
+    if (slice != candidates + candidate_count) {
+      std::copy(slice, slice + band_kept[b], candidates + candidate_count);
     }
-
-    const bool normalized =
-        std::fabs(cx) <= 1.5f && std::fabs(cy) <= 1.5f && w <= 1.5f && h <= 1.5f;
-    const float scale_x = normalized ? static_cast<float>(options.input_width) : 1.0f;
-    const float scale_y = normalized ? static_cast<float>(options.input_height) : 1.0f;
-
-    const float bx = cx * scale_x - 0.5f * w * scale_x;
-    const float by = cy * scale_y - 0.5f * h * scale_y;
-    const float bw = w * scale_x;
-    const float bh = h * scale_y;
-
-    YoloDetection det;
-    det.left = Clamp(bx, 0.0f, static_cast<float>(options.input_width));
-    det.top = Clamp(by, 0.0f, static_cast<float>(options.input_height));
-    det.right = Clamp(bx + bw, 0.0f, static_cast<float>(options.input_width));
-    det.bottom = Clamp(by + bh, 0.0f, static_cast<float>(options.input_height));
-    det.score = best_score;
-    det.class_index = best_class;
-    candidates.push_back(det);
+    candidate_count += band_kept[b];
   }
 
-  if (candidates.empty()) {
-    return candidates;
+  if (stats != nullptr) {
+    stats->candidates_pre_nms = static_cast<int>(candidate_count);
+  }
+  if (candidate_count == 0) {
+    return;
   }
 
-  std::sort(candidates.begin(), candidates.end(),
+  std::sort(candidates, candidates + candidate_count,
             [](const YoloDetection& a, const YoloDetection& b) { return a.score > b.score; });
 
-  std::vector<YoloDetection> results;
-  results.reserve(std::min(static_cast<int>(candidates.size()), options.max_detections));
-  std::vector<bool> suppressed(candidates.size(), false);
+  const size_t capacity_before = results->capacity();
+  results->reserve(std::min(candidate_count, static_cast<size_t>(settings.max_detections)));
+  auto* suppressed = arena->Allocate<uint8_t>(candidate_count);
+  if (suppressed == nullptr) {
+    return;
+  }
+  std::fill(suppressed, suppressed + candidate_count, 0);
 
-  for (size_t i = 0; i < candidates.size(); ++i) {
+  for (size_t i = 0; i < candidate_count; ++i) {
     if (suppressed[i]) {
       continue;
     }
-    results.push_back(candidates[i]);
-    if (static_cast<int>(results.size()) >= options.max_detections) {
+    results->push_back(candidates[i]);
+    if (static_cast<int>(results->size()) >= settings.max_detections) {
       break;
     }
-    for (size_t j = i + 1; j < candidates.size(); ++j) {
+    for (size_t j = i + 1; j < candidate_count; ++j) {
       if (suppressed[j]) {
         continue;
       }
@@ -201,13 +409,16 @@ std::vector<YoloDetection> DecodeDetections(const std::vector<float>& tensor,
         continue;
       }
       const float iou = ComputeIoU(candidates[i], candidates[j]);
-      if (iou > options.iou_threshold) {
-        suppressed[j] = true;
+      if (iou > settings.iou_threshold) {
+        suppressed[j] = 1;
       }
     }
   }
 
-  return results;
+  if (stats != nullptr) {
+    stats->candidates_post_nms = static_cast<int>(results->size());
+    stats->allocations = results->capacity() != capacity_before ? 1 : 0;
+  }
 }
 
 }  // namespace yolo
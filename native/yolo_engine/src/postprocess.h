@@ -1,13 +1,100 @@
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
 #include <vector>
 
-#include "yolo_engine.h"
+#include "scratch_arena.h"
+#include "yolo_engine_api.h"
 
 namespace yolo {
 
-std::vector<YoloDetection> DecodeDetections(const std::vector<float>& tensor,
-                                            const std::vector<int>& shape,
-                                            const EngineOptions& options);
+struct EngineOptions;
+
+struct DecodeStats {
+  int candidates_pre_nms = 0;
+  int candidates_post_nms = 0;
+  int allocations = 0;
+};
+
+// Intersection over union of two boxes in the same coordinate space.
+float ComputeIoU(const YoloDetection& a, const YoloDetection& b);
+
+enum class OutputLayout : int {
+  // [1, 4 + C, N]: one row per box coordinate and class (Ultralytics export).
+  kChannelMajor = 0,
+  // [1, N, 4 + C]: one row per prediction (transposed and many quantized
+  // exports).
+  kAnchorMajor = 1,
+};
+
+const char* OutputLayoutName(OutputLayout layout);
+
+// Thresholds and class filter applied by DecodeDetections. They can change
+// while frames flow (YoloEngineUpdateDecodeConfig), so they live apart from
+// EngineOptions.
+struct DecodeSettings {
+  float confidence_threshold = 0.3f;
+  float iou_threshold = 0.45f;
+  int max_detections = 100;
+  // Indexed by class. A threshold of 0 or less, or a class past the end,
+  // uses |confidence_threshold|. A non-empty |class_enabled| is an allow
+  // list: classes past its end are disabled.
+  std::vector<float> class_thresholds;
+  std::vector<uint8_t> class_enabled;
+
+  // Filled by Resolve() for one model's class count.
+  // Enabled classes in ascending order; only read when |masked|.
+  std::vector<int> classes;
+  bool masked = false;
+  // Per class, or empty when every class uses |confidence_threshold|.
+  std::vector<float> thresholds;
+  // Lowest threshold of any enabled class.
+  float min_threshold = 0.3f;
+
+  void Resolve(int num_classes);
+};
+
+struct DecodeLayout;
+
+// Scores predictions [begin, end) and writes those passing |settings| to
+// |out| in prediction order; returns how many were kept.
+using DecodeKernel = size_t (*)(const float* tensor, const DecodeLayout& layout,
+                                const EngineOptions& options, const DecodeSettings& settings,
+                                int begin, int end, YoloDetection* out);
+
+// How to read one model's output tensor. Resolved once per model, so frames
+// only index with it.
+struct DecodeLayout {
+  OutputLayout layout = OutputLayout::kChannelMajor;
+  // 4 box coordinates plus one score per class.
+  int channels = 0;
+  int num_pred = 0;
+  // Kernel specialised for the layout and, for common class counts, the
+  // number of classes.
+  DecodeKernel kernel = nullptr;
+
+  bool valid() const { return kernel != nullptr; }
+};
+
+// Squeezes unit dimensions out of a 3D or 4D output shape and picks the
+// layout: the box-and-class axis is the shorter of the two that remain.
+// Returns an invalid layout for shapes that cannot be YOLO output.
+DecodeLayout ResolveDecodeLayout(const std::vector<int>& shape);
+
+// Worst-case arena bytes DecodeDetections needs for |layout|.
+size_t DecodeScratchBytes(const DecodeLayout& layout);
+
+class ThreadPool;
+
+// Decodes |tensor| into |results| (cleared first). |settings| must be
+// resolved for |layout|'s class count. Candidate and NMS bookkeeping live in
+// |arena|; |results| only reallocates if it must grow. Per-prediction class
+// reduction is split into bands across |pool| when one is given.
+void DecodeDetections(const float* tensor, size_t tensor_size, const DecodeLayout& layout,
+                      const EngineOptions& options, const DecodeSettings& settings,
+                      ScratchArena* arena,
+                      std::vector<YoloDetection>* results, ThreadPool* pool = nullptr,
+                      DecodeStats* stats = nullptr);
 
 }  // namespace yolo
@@ -0,0 +1,261 @@
+#include "resampler.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "image_utils.h"
+#include "thread_pool.h"
+
+namespace yolo {
+
+namespace {
+
+constexpr int kWeightBits = 14;
+constexpr int kWeightOne = 1 << kWeightBits;
+// The vertical sums are brought down to 7 fractional bits before the
+// horizontal pass so the second sum of products stays inside 32 bits:
+// 255 << 7 times a unit weight of 1 << 14 is just under 2^29.
+constexpr int kRowShift = 7;
+constexpr float kOutputScale = 1.0f / (255.0f * (1 << (kWeightBits + kRowShift)));
+constexpr size_t kMaxCachedPlans = 3;
+
+int NormalizeRotation(int rotation_degrees) { return ((rotation_degrees % 360) + 360) % 360; }
+
+bool Transposed(int rotation) { return rotation == 90 || rotation == 270; }
+
+}  // namespace
+
+ResamplePlan::Axis ResamplePlan::BuildAxis(int src_size, int dst_size) {
+  const double scale = static_cast<double>(src_size) / dst_size;
+  // Exact source footprint of each output sample when shrinking; a tent of
+  // one input sample (bilinear) when growing.
+  auto footprint = [&](int i, int* lo, int* hi) {
+    if (scale > 1.0) {
+      *lo = static_cast<int>(i * scale);
+      *hi = std::min(src_size, static_cast<int>(std::ceil((i + 1) * scale)));
+    } else {
+      const double center = (i + 0.5) * scale - 0.5;
+      *lo = std::clamp(static_cast<int>(std::floor(center)), 0, src_size - 1);
+      *hi = std::min(src_size, *lo + 2);
+    }
+    *hi = std::max(*hi, *lo + 1);
+  };
+  Axis axis;
+  for (int i = 0; i < dst_size; ++i) {
+    int lo = 0;
+    int hi = 0;
+    footprint(i, &lo, &hi);
+    axis.taps = std::max(axis.taps, hi - lo);
+  }
+
+  axis.first.resize(static_cast<size_t>(dst_size));
+  axis.weights.assign(static_cast<size_t>(dst_size) * axis.taps, 0);
+  std::vector<double> exact(static_cast<size_t>(axis.taps));
+  for (int i = 0; i < dst_size; ++i) {
+    int lo = 0;
+    int hi = 0;
+    footprint(i, &lo, &hi);
+    const int count = hi - lo;
+    double sum = 0.0;
+    for (int k = 0; k < count; ++k) {
+      const int s = lo + k;
+      double weight = 0.0;
+      if (scale > 1.0) {
+        weight = std::min<double>(s + 1, (i + 1) * scale) - std::max<double>(s, i * scale);
+      } else {
+        weight = 1.0 - std::abs(std::clamp((i + 0.5) * scale - 0.5, 0.0, src_size - 1.0) - s);
+      }
+      exact[static_cast<size_t>(k)] = std::max(0.0, weight);
+      sum += exact[static_cast<size_t>(k)];
+    }
+    // Shifted left near the far edge so every sample reads |taps| in-range
+    // inputs; the extra ones get zero weight.
+    const int first = std::max(0, std::min(lo, src_size - axis.taps));
+    axis.first[static_cast<size_t>(i)] = first;
+    int16_t* weights = &axis.weights[static_cast<size_t>(i) * axis.taps + (lo - first)];
+    int total = 0;
+    int largest = 0;
+    for (int k = 0; k < count; ++k) {
+      const double share = sum > 0.0 ? exact[static_cast<size_t>(k)] / sum : (k == 0 ? 1.0 : 0.0);
+      weights[k] = static_cast<int16_t>(std::lround(share * kWeightOne));
+      total += weights[k];
+      if (weights[k] > weights[largest]) {
+        largest = k;
+      }
+    }
+    // Rounding leftovers go to the heaviest tap so flat areas come out exact.
+    weights[largest] = static_cast<int16_t>(weights[largest] + kWeightOne - total);
+  }
+  return axis;
+}
+
+ResamplePlan::ResamplePlan(int src_width, int src_height, int pixel_stride, int rotation_degrees,
+                           int dst_width, int dst_height, int threads)
+    : src_width_(src_width),
+      src_height_(src_height),
+      pixel_stride_(pixel_stride),
+      rotation_(NormalizeRotation(rotation_degrees)),
+      dst_width_(dst_width),
+      dst_height_(dst_height),
+      threads_(std::max(1, threads)) {
+  reduced_width_ = Transposed(rotation_) ? dst_height : dst_width;
+  reduced_height_ = Transposed(rotation_) ? dst_width : dst_height;
+  horizontal_ = BuildAxis(src_width, reduced_width_);
+  vertical_ = BuildAxis(src_height, reduced_height_);
+  // A couple of bands per thread, as RowsPerBand() does, each with its own
+  // row buffer; fixed here so the buffers are too.
+  bands_ = threads_ > 1 ? std::min(reduced_height_, threads_ * 2) : 1;
+  band_rows_ = (reduced_height_ + bands_ - 1) / bands_;
+  rows_.resize(static_cast<size_t>(bands_) * src_width * pixel_stride);
+}
+
+bool ResamplePlan::Matches(int src_width, int src_height, int pixel_stride, int rotation_degrees,
+                           int dst_width, int dst_height, int threads) const {
+  return src_width == src_width_ && src_height == src_height_ && pixel_stride == pixel_stride_ &&
+         NormalizeRotation(rotation_degrees) == rotation_ && dst_width == dst_width_ &&
+         dst_height == dst_height_ && std::max(1, threads) == threads_;
+}
+
+size_t ResamplePlan::memory_bytes() const {
+  return rows_.capacity() * sizeof(int32_t) +
+         (horizontal_.first.capacity() + vertical_.first.capacity()) * sizeof(int32_t) +
+         (horizontal_.weights.capacity() + vertical_.weights.capacity()) * sizeof(int16_t);
+}
+
+void ResamplePlan::Run(const PixelView& src, float* dst, ThreadPool* pool) {
+  if (src.data == nullptr || dst == nullptr || src.width != src_width_ ||
+      src.height != src_height_ || src.pixel_stride != pixel_stride_) {
+    return;
+  }
+  auto run_bands = [&](int begin, int end) {
+    for (int band = begin; band < end; ++band) {
+      switch (pixel_stride_) {
+        case 3:
+          RunBand<3>(src, band, dst);
+          break;
+        case 4:
+          RunBand<4>(src, band, dst);
+          break;
+        default:
+          RunBand<0>(src, band, dst);
+          break;
+      }
+    }
+  };
+  if (pool == nullptr || bands_ == 1) {
+    run_bands(0, bands_);
+  } else {
+    pool->ParallelFor(bands_, 1, run_bands);
+  }
+}
+
+// kPixelStride is 3 or 4 for the common packed formats so the compiler can
+// fold the per-pixel offsets; 0 reads it from the plan.
+template <int kPixelStride>
+void ResamplePlan::RunBand(const PixelView& src, int band, float* dst) {
+  const int pixel_stride = kPixelStride > 0 ? kPixelStride : pixel_stride_;
+  const int row_values = src_width_ * pixel_stride;
+  int32_t* row = &rows_[static_cast<size_t>(band) * row_values];
+  const int r = src.channel[0];
+  const int g = src.channel[1];
+  const int b = src.channel[2];
+
+  // Where reduced pixel (x, y) lands in the upright output: base(y) + x *
+  // step, in floats.
+  const int out_row = dst_width_ * 3;
+  const int row_begin = band * band_rows_;
+  const int row_end = std::min(reduced_height_, row_begin + band_rows_);
+  for (int y = row_begin; y < row_end; ++y) {
+    const int16_t* vertical = &vertical_.weights[static_cast<size_t>(y) * vertical_.taps];
+    const int first_row = vertical_.first[static_cast<size_t>(y)];
+    const uint8_t* source = src.data + static_cast<size_t>(src.row_stride) * first_row;
+    const int w0 = vertical[0];
+    for (int i = 0; i < row_values; ++i) {
+      row[i] = w0 * source[i];
+    }
+    for (int t = 1; t < vertical_.taps; ++t) {
+      const int weight = vertical[t];
+      if (weight == 0) {
+        continue;
+      }
+      source = src.data + static_cast<size_t>(src.row_stride) * (first_row + t);
+      for (int i = 0; i < row_values; ++i) {
+        row[i] += weight * source[i];
+      }
+    }
+    for (int i = 0; i < row_values; ++i) {
+      row[i] = (row[i] + (1 << (kRowShift - 1))) >> kRowShift;
+    }
+
+    ptrdiff_t base = 0;
+    ptrdiff_t step = 3;
+    switch (rotation_) {
+      case 90:
+        base = static_cast<ptrdiff_t>(reduced_height_ - 1 - y) * 3;
+        step = out_row;
+        break;
+      case 180:
+        base = static_cast<ptrdiff_t>(reduced_height_ - 1 - y) * out_row + out_row - 3;
+        step = -3;
+        break;
+      case 270:
+        base = static_cast<ptrdiff_t>(reduced_width_ - 1) * out_row + y * 3;
+        step = -out_row;
+        break;
+      default:
+        base = static_cast<ptrdiff_t>(y) * out_row;
+        break;
+    }
+    for (int x = 0; x < reduced_width_; ++x) {
+      const int16_t* horizontal = &horizontal_.weights[static_cast<size_t>(x) * horizontal_.taps];
+      const int32_t* pixel = row + horizontal_.first[static_cast<size_t>(x)] * pixel_stride;
+      int32_t sum_r = 0;
+      int32_t sum_g = 0;
+      int32_t sum_b = 0;
+      for (int t = 0; t < horizontal_.taps; ++t) {
+        const int weight = horizontal[t];
+        sum_r += weight * pixel[r];
+        sum_g += weight * pixel[g];
+        sum_b += weight * pixel[b];
+        pixel += pixel_stride;
+      }
+      float* out = dst + base + step * x;
+      out[0] = static_cast<float>(sum_r) * kOutputScale;
+      out[1] = static_cast<float>(sum_g) * kOutputScale;
+      out[2] = static_cast<float>(sum_b) * kOutputScale;
+    }
+  }
+}
+
+ResamplePlan* ResamplerCache::Get(int src_width, int src_height, int pixel_stride,
+                                  int rotation_degrees, int dst_width, int dst_height,
+                                  int threads) {
+  for (size_t i = 0; i < plans_.size(); ++i) {
+    if (plans_[i]->Matches(src_width, src_height, pixel_stride, rotation_degrees, dst_width,
+                           dst_height, threads)) {
+      std::rotate(plans_.begin(), plans_.begin() + i, plans_.begin() + i + 1);
+      return plans_.front().get();
+    }
+  }
+  if (src_width <= 0 || src_height <= 0 || pixel_stride < 3 || dst_width <= 0 ||
+      dst_height <= 0) {
+    return nullptr;
+  }
+  if (plans_.size() >= kMaxCachedPlans) {
+    plans_.pop_back();
+  }
+  plans_.insert(plans_.begin(),
+                std::make_unique<ResamplePlan>(src_width, src_height, pixel_stride,
+                                               rotation_degrees, dst_width, dst_height, threads));
+  return plans_.front().get();
+}
+
+size_t ResamplerCache::memory_bytes() const {
+  size_t bytes = 0;
+  for (const auto& plan : plans_) {
+    bytes += plan->memory_bytes();
+  }
+  return bytes;
+}
+
+}  // namespace yolo
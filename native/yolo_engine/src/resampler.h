@@ -0,0 +1,94 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace yolo {
+
+struct PixelView;
+class ThreadPool;
+
+// Separable resampling from an 8-bit view of one geometry to the model's
+// normalized float input, precomputed once per (source size, pixel stride,
+// rotation, target size, thread count). Shrinking averages each output
+// sample's exact source footprint, with fractional weights at its edges, so
+// every source pixel contributes and fine texture does not alias; growing
+// falls back to bilinear. Weights are 2.14 fixed point, padded to the same
+// tap count for every output sample so the inner loops have no
+// data-dependent bounds.
+//
+// The vertical pass runs first, straight over the raw source bytes (any
+// channel order, alpha included). It touches every source pixel and is the
+// loop the compiler vectorizes. The horizontal pass then works on one
+// reduced row at a time, picks out R, G and B, and writes each pixel to its
+// place in the output after a clockwise |rotation|. A rotated frame is
+// therefore shrunk before it is turned, never turned at full size.
+class ResamplePlan {
+ public:
+  ResamplePlan(int src_width, int src_height, int pixel_stride, int rotation_degrees,
+               int dst_width, int dst_height, int threads);
+
+  ResamplePlan(const ResamplePlan&) = delete;
+  ResamplePlan& operator=(const ResamplePlan&) = delete;
+
+  bool Matches(int src_width, int src_height, int pixel_stride, int rotation_degrees,
+               int dst_width, int dst_height, int threads) const;
+
+  // Writes dst_width x dst_height RGB floats in [0, 1] for |src|, which must
+  // have the plan's size and pixel stride (its row stride and channel order
+  // are free). With a |pool| the output rows are split across its threads;
+  // the result is identical for any pool size.
+  void Run(const PixelView& src, float* dst, ThreadPool* pool);
+
+  size_t memory_bytes() const;
+
+ private:
+  // Taps for every output sample along one axis: output i reads
+  // taps source samples from first[i] with weights[i * taps ...].
+  struct Axis {
+    int taps = 0;
+    std::vector<int32_t> first;
+    std::vector<int16_t> weights;
+  };
+
+  static Axis BuildAxis(int src_size, int dst_size);
+  template <int kPixelStride>
+  void RunBand(const PixelView& src, int band, float* dst);
+
+  int src_width_;
+  int src_height_;
+  int pixel_stride_;
+  int rotation_;
+  int dst_width_;
+  int dst_height_;
+  int threads_;
+  // Output size before rotation, in source orientation.
+  int reduced_width_;
+  int reduced_height_;
+  int bands_;
+  int band_rows_;
+  Axis horizontal_;
+  Axis vertical_;
+  // One vertically reduced source row per band.
+  std::vector<int32_t> rows_;
+};
+
+// Plans for the geometries a stream moves between. Auto zoom alternates the
+// whole frame with a crop every other pass, so a couple of entries turn
+// every frame into a lookup; the least recently used one is rebuilt on a
+// miss.
+class ResamplerCache {
+ public:
+  ResamplePlan* Get(int src_width, int src_height, int pixel_stride, int rotation_degrees,
+                    int dst_width, int dst_height, int threads);
+  void Clear() { plans_.clear(); }
+  size_t memory_bytes() const;
+
+ private:
+  // Most recently used first.
+  std::vector<std::unique_ptr<ResamplePlan>> plans_;
+};
+
+}  // namespace yolo
@@ -0,0 +1,22 @@
+#include "result_channel.h"
+
+namespace yolo {
+
+ResultChannel::ResultChannel() : slots_(new YoloResultFrame[kSlots]()) {}
+
+void ResultChannel::Publish() {
+  slots_[back_].sequence = ++sequence_;
+  // Release makes the slot's contents visible with the swap; acquire pairs
+  // with the reader's release of the slot it handed back.
+  back_ = middle_.exchange(back_ | kFresh, std::memory_order_acq_rel) & kIndexMask;
+}
+
+const YoloResultFrame* ResultChannel::Acquire() {
+  // Nothing new: keep the current slot, which the writer never touches.
+  if ((middle_.load(std::memory_order_relaxed) & kFresh) != 0) {
+    front_ = middle_.exchange(front_, std::memory_order_acq_rel) & kIndexMask;
+  }
+  return &slots_[front_];
+}
+
+}  // namespace yolo
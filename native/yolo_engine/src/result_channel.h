@@ -0,0 +1,48 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#include "yolo_engine_api.h"
+
+namespace yolo {
+
+// Triple buffer handing the newest YoloResultFrame from the frame thread to
+// one reader without locks or allocation. The writer owns one slot, the
+// reader another, and the third sits in the middle holding the latest
+// published frame. Publishing and acquiring each swap a slot with the middle
+// in a single atomic exchange, so neither side ever waits for the other and
+// the reader always sees a whole frame.
+class ResultChannel {
+ public:
+  ResultChannel();
+
+  ResultChannel(const ResultChannel&) = delete;
+  ResultChannel& operator=(const ResultChannel&) = delete;
+
+  // Slot for the writer to fill; not visible to the reader until Publish().
+  YoloResultFrame* back() { return &slots_[back_]; }
+  // Stamps the back slot with the next sequence number and swaps it in.
+  void Publish();
+
+  // Reader side: the newest published slot, stable until the next call.
+  const YoloResultFrame* Acquire();
+
+  size_t memory_bytes() const { return kSlots * sizeof(YoloResultFrame); }
+
+ private:
+  static constexpr size_t kSlots = 3;
+  // Set in |middle_| when it holds a frame the reader has not taken yet.
+  static constexpr uint32_t kFresh = 0x4;
+  static constexpr uint32_t kIndexMask = 0x3;
+
+  std::unique_ptr<YoloResultFrame[]> slots_;
+  uint32_t back_ = 0;
+  uint32_t front_ = 1;
+  std::atomic<uint32_t> middle_{2};
+  uint64_t sequence_ = 0;
+};
+
+}  // namespace yolo
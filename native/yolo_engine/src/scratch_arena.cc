@@ -0,0 +1,79 @@
+#include "scratch_arena.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+namespace yolo {
+
+void ScratchArena::AlignedDeleter::operator()(uint8_t* block) const {
+  std::free(block);
+}
+
+ScratchArena::Block ScratchArena::AllocateBlock(size_t bytes) {
+  void* memory = nullptr;
+  if (posix_memalign(&memory, kAlignment, std::max(AlignUp(bytes), kAlignment)) != 0) {
+    return Block();
+  }
+  return Block(static_cast<uint8_t*>(memory));
+}
+
+void ScratchArena::Reserve(size_t bytes) {
+  bytes = AlignUp(bytes);
+  if (bytes <= capacity_) {
+    return;
+  }
+  Block block = AllocateBlock(bytes);
+  if (!block) {
+    return;
+  }
+  block_ = std::move(block);
+  capacity_ = bytes;
+  used_ = 0;
+  ++allocations_;
+}
+
+void ScratchArena::Reset() {
+  if (!overflow_.empty()) {
+    const size_t wanted = used_ + overflow_bytes_;
+    overflow_.clear();
+    overflow_bytes_ = 0;
+    Reserve(wanted);
+  }
+  used_ = 0;
+}
+
+void ScratchArena::Release() {
+  overflow_.clear();
+  overflow_bytes_ = 0;
+  block_.reset();
+  capacity_ = 0;
+  used_ = 0;
+}
+
+void* ScratchArena::AllocateBytes(size_t bytes) {
+  bytes = AlignUp(bytes);
+  void* result = nullptr;
+  if (used_ + bytes <= capacity_) {
+    result = block_.get() + used_;
+    used_ += bytes;
+  } else {
+    Block block = AllocateBlock(bytes);
+    if (!block) {
+      return nullptr;
+    }
+    result = block.get();
+    overflow_.push_back(std::move(block));
+    overflow_bytes_ += bytes;
+    ++allocations_;
+  }
+  peak_ = std::max(peak_, used_ + overflow_bytes_);
+  return result;
+}
+
+int ScratchArena::TakeAllocationCount() {
+  const int count = allocations_;
+  allocations_ = 0;
+  return count;
+}
+
+}  // namespace yolo
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace yolo {
+
+// Engine-owned bump allocator for per-frame scratch (RGB planes, the input
+// tensor staging buffer, decode candidates). Every allocation is 64-byte
+// aligned and nothing is freed individually: Reset() at the start of each
+// frame rewinds the arena. The block is sized up front from the stream
+// geometry; if a frame still overflows it, the excess is served from
+// temporary blocks and the main block grows to the observed peak on the next
+// Reset(), so steady state performs no heap allocations at all.
+class ScratchArena {
+ public:
+  static constexpr size_t kAlignment = 64;
+
+  ScratchArena() = default;
+  ~ScratchArena() = default;
+
+  ScratchArena(const ScratchArena&) = delete;
+  ScratchArena& operator=(const ScratchArena&) = delete;
+
+  static size_t AlignUp(size_t bytes) { return (bytes + kAlignment - 1) & ~(kAlignment - 1); }
+
+  // Ensures the main block holds at least |bytes|. Only valid between frames.
+  void Reserve(size_t bytes);
+  void Reset();
+  // Drops every block. The next frame re-reserves from scratch.
+  void Release();
+
+  void* AllocateBytes(size_t bytes);
+
+  template <typename T>
+  T* Allocate(size_t count) {
+    return static_cast<T*>(AllocateBytes(count * sizeof(T)));
+  }
+
+  size_t capacity() const { return capacity_; }
+  size_t used() const { return used_ + overflow_bytes_; }
+  size_t peak() const { return peak_; }
+  // Heap allocations performed since the last call; feeds EngineStats.
+  int TakeAllocationCount();
+
+ private:
+  struct AlignedDeleter {
+    void operator()(uint8_t* block) const;
+  };
+  using Block = std::unique_ptr<uint8_t, AlignedDeleter>;
+
+  static Block AllocateBlock(size_t bytes);
+
+  Block block_;
+  size_t capacity_ = 0;
+  size_t used_ = 0;
+  size_t peak_ = 0;
+  std::vector<Block> overflow_;
+  size_t overflow_bytes_ = 0;
+  int allocations_ = 0;
+};
+
+}  // namespace yolo
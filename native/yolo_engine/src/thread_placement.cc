@@ -0,0 +1,225 @@
+#include "thread_placement.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <functional>
+
+#if defined(__linux__)
+#include <sched.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <cerrno>
+#endif
+
+namespace yolo {
+
+namespace {
+
+// Bits of a cpu_mask; CPUs past this are never pinned to.
+constexpr int kMaxMaskCpus = 64;
+
+#if defined(__linux__)
+static_assert(sizeof(cpu_set_t) <= 128, "ScopedPlacement::previous_mask_ is too small");
+
+bool ReadCpuValue(int cpu, const char* leaf, uint32_t* value) {
+  char path[96];
+  std::snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/%s", cpu, leaf);
+  FILE* file = std::fopen(path, "r");
+  if (file == nullptr) {
+    return false;
+  }
+  unsigned long parsed = 0;
+  const bool ok = std::fscanf(file, "%lu", &parsed) == 1 && parsed > 0;
+  std::fclose(file);
+  *value = static_cast<uint32_t>(parsed);
+  return ok;
+}
+
+// setpriority() with a zero id would renice the whole process; the thread id
+// limits it to the caller.
+pid_t CurrentThreadId() { return static_cast<pid_t>(syscall(SYS_gettid)); }
+
+void FillCpuSet(uint64_t mask, cpu_set_t* set) {
+  CPU_ZERO(set);
+  for (int cpu = 0; cpu < kMaxMaskCpus; ++cpu) {
+    if (mask & (uint64_t{1} << cpu)) {
+      CPU_SET(cpu, set);
+    }
+  }
+}
+
+uint64_t MaskFromCpuSet(const cpu_set_t& set) {
+  uint64_t mask = 0;
+  for (int cpu = 0; cpu < kMaxMaskCpus; ++cpu) {
+    if (CPU_ISSET(cpu, &set)) {
+      mask |= uint64_t{1} << cpu;
+    }
+  }
+  return mask;
+}
+
+bool SetThreadMask(uint64_t mask) {
+  cpu_set_t set;
+  FillCpuSet(mask, &set);
+  return sched_setaffinity(0, sizeof(set), &set) == 0;
+}
+
+bool ThreadNice(int* nice) {
+  errno = 0;
+  const int value = getpriority(PRIO_PROCESS, static_cast<id_t>(CurrentThreadId()));
+  if (value == -1 && errno != 0) {
+    return false;
+  }
+  *nice = value;
+  return true;
+}
+
+bool SetThreadNice(int nice) {
+  return setpriority(PRIO_PROCESS, static_cast<id_t>(CurrentThreadId()), nice) == 0;
+}
+#endif
+
+}  // namespace
+
+std::vector<uint32_t> ReadCoreCapacities() {
+  std::vector<uint32_t> capacities;
+#if defined(__linux__)
+  const long configured = sysconf(_SC_NPROCESSORS_CONF);
+  const int cpus = static_cast<int>(std::clamp<long>(configured, 0, kMaxMaskCpus));
+  // One source for every CPU; mixing capacities with frequencies would rank
+  // them against each other meaninglessly.
+  for (const char* leaf : {"cpu_capacity", "cpufreq/cpuinfo_max_freq"}) {
+    capacities.assign(static_cast<size_t>(cpus), 0);
+    bool complete = cpus > 0;
+    for (int cpu = 0; cpu < cpus && complete; ++cpu) {
+      complete = ReadCpuValue(cpu, leaf, &capacities[static_cast<size_t>(cpu)]);
+    }
+    if (complete) {
+      return capacities;
+    }
+  }
+  capacities.clear();
+#endif
+  return capacities;
+}
+
+uint64_t PerformanceCoreMask(const std::vector<uint32_t>& capacities, int threads,
+                             int* classes) {
+  std::vector<uint32_t> distinct(capacities);
+  std::sort(distinct.begin(), distinct.end(), std::greater<uint32_t>());
+  distinct.erase(std::unique(distinct.begin(), distinct.end()), distinct.end());
+  if (classes != nullptr) {
+    *classes = static_cast<int>(distinct.size());
+  }
+  if (distinct.size() < 2) {
+    return 0;
+  }
+  // Big cores first, then mid cores while there are too few for every
+  // thread; the little cluster would only drag the slowest band out.
+  uint64_t mask = 0;
+  int cores = 0;
+  for (size_t tier = 0; tier + 1 < distinct.size(); ++tier) {
+    if (tier > 0 && cores >= threads) {
+      break;
+    }
+    for (size_t cpu = 0; cpu < capacities.size() && cpu < kMaxMaskCpus; ++cpu) {
+      if (capacities[cpu] == distinct[tier]) {
+        mask |= uint64_t{1} << cpu;
+        ++cores;
+      }
+    }
+  }
+  return mask;
+}
+
+ThreadPlacement::ThreadPlacement(CorePlacement mode, uint64_t requested_mask, int nice,
+                                 int threads)
+    : mode_(mode), nice_(std::clamp(nice, -20, 19)) {
+#if defined(__linux__)
+  const uint64_t performance = PerformanceCoreMask(ReadCoreCapacities(), threads, &core_classes_);
+  if (mode == CorePlacement::kAuto) {
+    cpu_mask_ = performance;
+  } else if (mode == CorePlacement::kMask) {
+    cpu_mask_ = requested_mask;
+  }
+  // Stay inside what the process may use (cgroups, a caller's own pinning);
+  // a mask that leaves nothing is dropped rather than failing every thread.
+  cpu_set_t allowed;
+  if (cpu_mask_ != 0 && sched_getaffinity(0, sizeof(allowed), &allowed) == 0) {
+    cpu_mask_ &= MaskFromCpuSet(allowed);
+  }
+#else
+  (void)requested_mask;
+  (void)threads;
+  nice_ = 0;
+#endif
+}
+
+void ThreadPlacement::Apply() {
+#if defined(__linux__)
+  bool placed = true;
+  if (cpu_mask_ != 0) {
+    placed = SetThreadMask(cpu_mask_);
+  }
+  if (nice_ != 0) {
+    placed = SetThreadNice(nice_) && placed;
+  }
+  if (placed && active()) {
+    workers_pinned_.fetch_add(1, std::memory_order_relaxed);
+  }
+#endif
+}
+
+void ThreadPlacement::Snapshot(YoloThreadPlacement* out) const {
+  out->mode = static_cast<int32_t>(mode_);
+  out->nice = nice_;
+  out->cpu_mask = cpu_mask_;
+  out->core_classes = core_classes_;
+  out->workers_pinned = workers_pinned_.load(std::memory_order_relaxed);
+  out->frame_thread_pinned = frame_thread_pinned_.load(std::memory_order_relaxed);
+  out->priority_applied = priority_applied_.load(std::memory_order_relaxed);
+}
+
+ScopedPlacement::ScopedPlacement(ThreadPlacement* placement) {
+#if defined(__linux__)
+  if (placement == nullptr || !placement->active()) {
+    return;
+  }
+  if (placement->cpu_mask_ != 0) {
+    cpu_set_t* previous = reinterpret_cast<cpu_set_t*>(previous_mask_);
+    bool pinned = sched_getaffinity(0, sizeof(cpu_set_t), previous) == 0;
+    // Already there (the same thread on its last frame): nothing to change
+    // or put back.
+    if (pinned && MaskFromCpuSet(*previous) != placement->cpu_mask_) {
+      pinned = SetThreadMask(placement->cpu_mask_);
+      restore_affinity_ = pinned;
+    }
+    placement->frame_thread_pinned_.store(pinned ? 1 : 0, std::memory_order_relaxed);
+  }
+  if (placement->nice_ != 0) {
+    bool applied = ThreadNice(&previous_nice_);
+    if (applied && previous_nice_ != placement->nice_) {
+      applied = SetThreadNice(placement->nice_);
+      restore_nice_ = applied;
+    }
+    placement->priority_applied_.store(applied ? 1 : 0, std::memory_order_relaxed);
+  }
+#else
+  (void)placement;
+#endif
+}
+
+ScopedPlacement::~ScopedPlacement() {
+#if defined(__linux__)
+  if (restore_affinity_) {
+    sched_setaffinity(0, sizeof(cpu_set_t), reinterpret_cast<const cpu_set_t*>(previous_mask_));
+  }
+  if (restore_nice_) {
+    SetThreadNice(previous_nice_);
+  }
+#endif
+}
+
+}  // namespace yolo
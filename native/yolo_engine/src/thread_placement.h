@@ -0,0 +1,83 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+#include "yolo_engine_api.h"
+
+namespace yolo {
+
+enum class CorePlacement : int {
+  kOff = kYoloCorePlacementOff,
+  kAuto = kYoloCorePlacementAuto,
+  kMask = kYoloCorePlacementMask,
+};
+
+// Relative compute capacity of each CPU, indexed by CPU number. Read from
+// cpu_capacity where the kernel exports it (arm64 big.LITTLE), else from the
+// highest cpufreq frequency; empty when neither is readable for every CPU.
+std::vector<uint32_t> ReadCoreCapacities();
+
+// Cores from the fastest capacity classes, enough for |threads| where the
+// device has them but never its slowest class. Returns 0 on symmetric or
+// unreadable topologies, where pinning would buy nothing. |classes| receives
+// the number of distinct capacities.
+uint64_t PerformanceCoreMask(const std::vector<uint32_t>& capacities, int threads,
+                             int* classes);
+
+// Where the engine's threads run: the CPUs they may use (0 leaves affinity
+// alone) and their nice value (0 leaves priority alone). Threads the
+// interpreter spawns inherit both from whichever engine thread creates them,
+// so placing the creating thread is enough. Linux and Android only; a no-op
+// elsewhere.
+class ThreadPlacement {
+ public:
+  ThreadPlacement() = default;
+  ThreadPlacement(CorePlacement mode, uint64_t requested_mask, int nice, int threads);
+
+  ThreadPlacement(const ThreadPlacement&) = delete;
+  ThreadPlacement& operator=(const ThreadPlacement&) = delete;
+
+  bool active() const { return cpu_mask_ != 0 || nice_ != 0; }
+  uint64_t cpu_mask() const { return cpu_mask_; }
+
+  // Places the calling thread for good; for pool workers the engine owns.
+  void Apply();
+
+  void Snapshot(YoloThreadPlacement* out) const;
+
+ private:
+  friend class ScopedPlacement;
+
+  CorePlacement mode_ = CorePlacement::kOff;
+  uint64_t cpu_mask_ = 0;
+  int nice_ = 0;
+  int core_classes_ = 0;
+  std::atomic<int32_t> workers_pinned_{0};
+  std::atomic<int32_t> frame_thread_pinned_{0};
+  std::atomic<int32_t> priority_applied_{0};
+};
+
+// Places a borrowed thread (the caller's frame thread) for one scope and
+// puts its previous affinity and priority back after, so the engine leaves no
+// mark on threads it does not own. Costs a few syscalls when active and
+// nothing otherwise.
+class ScopedPlacement {
+ public:
+  explicit ScopedPlacement(ThreadPlacement* placement);
+  ~ScopedPlacement();
+
+  ScopedPlacement(const ScopedPlacement&) = delete;
+  ScopedPlacement& operator=(const ScopedPlacement&) = delete;
+
+ private:
+  bool restore_affinity_ = false;
+  bool restore_nice_ = false;
+  int previous_nice_ = 0;
+  // Large enough for the C library's cpu_set_t; kept inline so entering the
+  // engine does not allocate.
+  alignas(8) unsigned char previous_mask_[128];
+};
+
+}  // namespace yolo
@@ -0,0 +1,107 @@
+#include "thread_pool.h"
+
+#include <algorithm>
+
+#include "thread_placement.h"
+
+namespace yolo {
+
+ThreadPool::ThreadPool(int num_threads, ThreadPlacement* placement) {
+  const int workers = std::max(1, num_threads) - 1;
+  workers_.reserve(static_cast<size_t>(workers));
+  for (int i = 0; i < workers; ++i) {
+    workers_.emplace_back(&ThreadPool::WorkerLoop, this, placement);
+  }
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopping_ = true;
+  }
+  wake_.notify_all();
+  for (std::thread& worker : workers_) {
+    worker.join();
+  }
+}
+
+void ThreadPool::Run(int count, int grain, RangeFn fn, void* context) {
+  if (count <= 0) {
+    return;
+  }
+  grain = std::max(1, grain);
+  if (workers_.empty() || count <= grain) {
+    for (int begin = 0; begin < count; begin += grain) {
+      fn(context, begin, std::min(count, begin + grain));
+    }
+    return;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    fn_ = fn;
+    context_ = context;
+    count_ = count;
+    grain_ = grain;
+    next_band_.store(0, std::memory_order_relaxed);
+    active_workers_ = static_cast<int>(workers_.size());
+    ++generation_;
+  }
+  wake_.notify_all();
+
+  RunBands();
+
+  std::unique_lock<std::mutex> lock(mutex_);
+  done_.wait(lock, [this] { return active_workers_ == 0; });
+  fn_ = nullptr;
+  context_ = nullptr;
+}
+
+void ThreadPool::RunBands() {
+  const int bands = (count_ + grain_ - 1) / grain_;
+  for (;;) {
+    const int band = next_band_.fetch_add(1, std::memory_order_relaxed);
+    if (band >= bands) {
+      return;
+    }
+    const int begin = band * grain_;
+    fn_(context_, begin, std::min(count_, begin + grain_));
+  }
+}
+
+void ThreadPool::WorkerLoop(ThreadPlacement* placement) {
+  if (placement != nullptr) {
+    placement->Apply();
+  }
+  uint64_t seen_generation = 0;
+  for (;;) {
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      wake_.wait(lock, [&] { return stopping_ || generation_ != seen_generation; });
+      if (stopping_) {
+        return;
+      }
+      seen_generation = generation_;
+    }
+    RunBands();
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (--active_workers_ == 0) {
+        done_.notify_one();
+      }
+    }
+  }
+}
+
+int RowsPerBand(int row_bytes, int rows, int num_threads, int target_bytes) {
+  if (rows <= 0) {
+    return 1;
+  }
+  int band = std::max(1, target_bytes / std::max(1, row_bytes));
+  // At least a couple of bands per thread so a slow core does not stall the
+  // whole stage.
+  const int balanced = std::max(1, rows / (std::max(1, num_threads) * 2));
+  return std::min(band, balanced);
+}
+
+}  // namespace yolo
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace yolo {
+
+class ThreadPlacement;
+
+// Persistent fork/join pool for the CPU stages around the interpreter (colour
+// conversion, resize, decode). It is sized to the interpreter's thread count
+// and only runs while the interpreter is idle, so both share the same cores
+// instead of oversubscribing them. The calling thread always takes part, so a
+// pool of N threads owns N - 1 workers and a pool of one runs inline.
+//
+// Work is split into bands of |grain| items that threads claim with an atomic
+// increment, so faster cores simply take more bands. Callers write each
+// band's output to disjoint memory, which keeps results identical for any
+// pool size. ParallelFor never allocates. Only one thread may call
+// ParallelFor at a time.
+//
+// Workers place themselves with |placement| (which must outlive the pool)
+// when they start; the calling thread's placement is up to the caller.
+class ThreadPool {
+ public:
+  explicit ThreadPool(int num_threads, ThreadPlacement* placement = nullptr);
+  ~ThreadPool();
+
+  ThreadPool(const ThreadPool&) = delete;
+  ThreadPool& operator=(const ThreadPool&) = delete;
+
+  int num_threads() const { return static_cast<int>(workers_.size()) + 1; }
+
+  // Calls fn(begin, end) over [0, count) in bands of |grain| items and
+  // returns once every band has run.
+  template <typename Fn>
+  void ParallelFor(int count, int grain, const Fn& fn) {
+    Run(count, grain, &Thunk<Fn>, const_cast<Fn*>(&fn));
+  }
+
+ private:
+  using RangeFn = void (*)(void* context, int begin, int end);
+
+  template <typename Fn>
+  static void Thunk(void* context, int begin, int end) {
+    (*static_cast<const Fn*>(context))(begin, end);
+  }
+
+  void Run(int count, int grain, RangeFn fn, void* context);
+  void RunBands();
+  void WorkerLoop(ThreadPlacement* placement);
+
+  std::vector<std::thread> workers_;
+  std::mutex mutex_;
+  std::condition_variable wake_;
+  std::condition_variable done_;
+  uint64_t generation_ = 0;
+  int active_workers_ = 0;
+  bool stopping_ = false;
+
+  RangeFn fn_ = nullptr;
+  void* context_ = nullptr;
+  int count_ = 0;
+  int grain_ = 1;
+  std::atomic<int> next_band_{0};
+};
+
+// Rows per band so that one band touches roughly |target_bytes| of output;
+// keeps bands inside L2 while leaving enough of them to balance load.
+int RowsPerBand(int row_bytes, int rows, int num_threads, int target_bytes = 32 * 1024);
+
+}  // namespace yolo
@@ -0,0 +1,136 @@
+#include "trace_recorder.h"
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstdio>
+
+#if defined(__APPLE__)
+#include <pthread.h>
+#else
+#include <sys/syscall.h>
+#endif
+
+namespace yolo {
+
+namespace {
+
+const char* StageName(uint8_t stage) {
+  switch (static_cast<Stage>(stage)) {
+    case Stage::kYuvToRgb:
+      return "yuv_to_rgb";
+    case Stage::kRotate:
+      return "rotate";
+    case Stage::kResize:
+      return "resize";
+    case Stage::kInvoke:
+      return "invoke";
+    case Stage::kDecode:
+      return "decode";
+    case Stage::kTotal:
+      return "frame";
+    case Stage::kQueueWait:
+      return "queue_wait";
+    case Stage::kCaptureToResult:
+      return "capture_to_result";
+    case Stage::kTrack:
+      return "track";
+    case Stage::kClassify:
+      return "classify";
+    case Stage::kQuality:
+      return "quality";
+    default:
+      return "unknown";
+  }
+}
+
+}  // namespace
+
+uint32_t CurrentThreadId() {
+  thread_local uint32_t cached = 0;
+  if (cached == 0) {
+#if defined(__APPLE__)
+    uint64_t tid = 0;
+    pthread_threadid_np(nullptr, &tid);
+    cached = static_cast<uint32_t>(tid);
+#else
+    cached = static_cast<uint32_t>(::syscall(SYS_gettid));
+#endif
+  }
+  return cached;
+}
+
+void TraceRecorder::Start(size_t capacity) {
+  enabled_.store(false, std::memory_order_release);
+  if (capacity == 0) {
+    return;
+  }
+  if (capacity > allocated_) {
+    events_.reset(new Event[capacity]);
+    allocated_ = capacity;
+  } else {
+    for (size_t i = 0; i < capacity; ++i) {
+      events_[i].committed.store(false, std::memory_order_relaxed);
+    }
+  }
+  capacity_ = capacity;
+  next_.store(0, std::memory_order_relaxed);
+  dropped_.store(0, std::memory_order_relaxed);
+  enabled_.store(true, std::memory_order_release);
+}
+
+void TraceRecorder::Stop() {
+  enabled_.store(false, std::memory_order_release);
+}
+
+void TraceRecorder::Record(Stage stage, uint64_t frame_seq, uint64_t begin_ns, uint64_t end_ns) {
+  if (!enabled_.load(std::memory_order_relaxed)) {
+    return;
+  }
+  const size_t slot = next_.fetch_add(1, std::memory_order_relaxed);
+  if (slot >= capacity_) {
+    dropped_.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+  Event& event = events_[slot];
+  event.stage = static_cast<uint8_t>(stage);
+  event.thread_id = CurrentThreadId();
+  event.frame_seq = frame_seq;
+  event.begin_ns = begin_ns;
+  event.end_ns = end_ns;
+  event.committed.store(true, std::memory_order_release);
+}
+
+int64_t TraceRecorder::DumpJson(const std::string& path) const {
+  FILE* file = std::fopen(path.c_str(), "w");
+  if (file == nullptr) {
+    return -1;
+  }
+  const int pid = static_cast<int>(::getpid());
+  const size_t recorded = std::min(next_.load(std::memory_order_acquire), capacity_);
+  int64_t written = 0;
+  std::fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+  for (size_t i = 0; i < recorded; ++i) {
+    const Event& event = events_[i];
+    if (!event.committed.load(std::memory_order_acquire)) {
+      continue;
+    }
+    // Complete ("X") events carry both the begin timestamp and duration in us.
+    std::fprintf(file,
+                 "%s\n{\"name\":\"%s\",\"cat\":\"yolo\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,"
+                 "\"pid\":%d,\"tid\":%" PRIu32 ",\"args\":{\"frame\":%" PRIu64 "}}",
+                 written == 0 ? "" : ",", StageName(event.stage),
+                 static_cast<double>(event.begin_ns) / 1000.0,
+                 static_cast<double>(event.end_ns - event.begin_ns) / 1000.0, pid,
+                 event.thread_id, event.frame_seq);
+    ++written;
+  }
+  std::fprintf(file,
+               "\n],\"otherData\":{\"droppedSpans\":%" PRIu64 "}}\n",
+               dropped_.load(std::memory_order_relaxed));
+  std::fclose(file);
+  return written;
+}
+
+}  // namespace yolo
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "engine_stats.h"
+
+namespace yolo {
+
+uint32_t CurrentThreadId();
+
+// Optional timeline of pipeline spans exportable as Chrome/Perfetto trace-event
+// JSON. Slots are preallocated by Start() and claimed with a single atomic
+// increment, so recording never locks or allocates; spans arriving after the
+// buffer fills are counted and discarded. When tracing is off, Record() costs
+// one relaxed load.
+//
+// Start/Stop/Dump must be called from the frame thread between frames.
+class TraceRecorder {
+ public:
+  TraceRecorder() = default;
+  ~TraceRecorder() = default;
+
+  TraceRecorder(const TraceRecorder&) = delete;
+  TraceRecorder& operator=(const TraceRecorder&) = delete;
+
+  bool enabled() const { return enabled_.load(std::memory_order_relaxed); }
+
+  void Start(size_t capacity);
+  void Stop();
+  void Record(Stage stage, uint64_t frame_seq, uint64_t begin_ns, uint64_t end_ns);
+
+  // Writes the recorded spans to |path|. Returns the number of spans written,
+  // or -1 when the file cannot be opened.
+  int64_t DumpJson(const std::string& path) const;
+
+ private:
+  struct Event {
+    std::atomic<bool> committed{false};
+    uint8_t stage = 0;
+    uint32_t thread_id = 0;
+    uint64_t frame_seq = 0;
+    uint64_t begin_ns = 0;
+    uint64_t end_ns = 0;
+  };
+
+  std::unique_ptr<Event[]> events_;
+  // Slots allocated; kept across sessions so a smaller trace reuses them.
+  size_t allocated_ = 0;
+  // Spans this session records before dropping the rest.
+  size_t capacity_ = 0;
+  std::atomic<size_t> next_{0};
+  std::atomic<uint64_t> dropped_{0};
+  std::atomic<bool> enabled_{false};
+};
+
+// Times one stage into the stats histogram and, when tracing is on, records
+// the matching span tagged with the frame sequence number.
+class ScopedStageSpan {
+ public:
+  ScopedStageSpan(EngineStats* stats, TraceRecorder* trace, Stage stage, uint64_t frame_seq)
+      : stats_(stats),
+        trace_(trace),
+        stage_(stage),
+        frame_seq_(frame_seq),
+        start_ns_(MonotonicNanos()) {}
+  ~ScopedStageSpan() {
+    const uint64_t end_ns = MonotonicNanos();
+    stats_->RecordStage(stage_, end_ns - start_ns_);
+    trace_->Record(stage_, frame_seq_, start_ns_, end_ns);
+  }
+
+  ScopedStageSpan(const ScopedStageSpan&) = delete;
+  ScopedStageSpan& operator=(const ScopedStageSpan&) = delete;
+
+ private:
+  EngineStats* stats_;
+  TraceRecorder* trace_;
+  Stage stage_;
+  uint64_t frame_seq_;
+  uint64_t start_ns_;
+};
+
+}  // namespace yolo
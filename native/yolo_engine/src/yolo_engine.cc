@@ -1,39 +1,19 @@
 #include "yolo_engine.h"
 
 #include <algorithm>
-#include <cstdio>
+#include <cmath>
 #include <memory>
 #include <sstream>
 #include <utility>
 #include <vector>
 
 #include "image_utils.h"
+#include "log.h"
+#include "memory_usage.h"
 #include "postprocess.h"
 
-#if defined(__ANDROID__)
-#include <android/log.h>
-#include "tensorflow_lite/delegate.h"
-#include "tensorflow_lite/delegate_options.h"
-#elif defined(__APPLE__)
-#include <TargetConditionals.h>
-#if TARGET_OS_IOS
-#include "tensorflow_lite/metal_delegate.h"
-#endif
-#endif
-
 namespace {
 
-#if defined(__ANDROID__)
-constexpr char kLogTag[] = "YoloEngine";
-void LogMessage(const std::string& message) {
-  __android_log_print(ANDROID_LOG_INFO, kLogTag, "%s", message.c_str());
-}
-#else
-void LogMessage(const std::string& message) {
-  std::fprintf(stderr, "%s\n", message.c_str());
-}
-#endif
-
 void LogShape(const char* label, const std::vector<int>& shape) {
   std::ostringstream out;
   out << label << ": [";
@@ -44,200 +24,838 @@ void LogShape(const char* label, const std::vector<int>& shape) {
     out << shape[i];
   }
   out << ']';
-  LogMessage(out.str());
+  yolo::LogMessage(out.str());
 }
 
 }  // namespace
 
 namespace yolo {
 
-YoloEngine::YoloEngine(EngineOptions options, TfLiteModel* model,
-                       TfLiteInterpreterOptions* interpreter_options, TfLiteInterpreter* interpreter)
-    : options_(options),
-      model_(model),
-      interpreter_options_(interpreter_options),
-      interpreter_(interpreter) {}
+YoloEngine::YoloEngine(EngineOptions options, std::unique_ptr<ThreadPlacement> placement,
+                       ModelHandle model, std::unique_ptr<InferenceRuntime> runtime,
+                       TuningResult tuning)
+    : options_(std::move(options)),
+      placement_(std::move(placement)),
+      model_(std::move(model)),
+      runtime_(std::move(runtime)),
+      tuning_(tuning),
+      pool_(options_.num_threads, placement_.get()) {}
 
-YoloEngine::~YoloEngine() {
-#if defined(__ANDROID__)
-  if (gpu_delegate_ != nullptr) {
-    TfLiteGpuDelegateV2Delete(gpu_delegate_);
-    gpu_delegate_ = nullptr;
-  }
-#elif defined(__APPLE__) && TARGET_OS_IOS
-  if (gpu_delegate_ != nullptr) {
-    TFLGpuDelegateDelete(gpu_delegate_);
-    gpu_delegate_ = nullptr;
-  }
-#endif
-  if (interpreter_ != nullptr) {
-    TfLiteInterpreterDelete(interpreter_);
-    interpreter_ = nullptr;
-  }
-  if (interpreter_options_ != nullptr) {
-    TfLiteInterpreterOptionsDelete(interpreter_options_);
-    interpreter_options_ = nullptr;
-  }
-  if (model_ != nullptr) {
-    TfLiteModelDelete(model_);
-    model_ = nullptr;
-  }
-}
+YoloEngine::~YoloEngine() = default;
 
 std::unique_ptr<YoloEngine> YoloEngine::Create(const std::string& model_path,
                                                const EngineOptions& options) {
-  TfLiteModel* model = TfLiteModelCreateFromFile(model_path.c_str());
+  ModelHandle model = LoadModel(model_path);
   if (model == nullptr) {
     return nullptr;
   }
-  TfLiteInterpreterOptions* interpreter_options = TfLiteInterpreterOptionsCreate();
-  if (interpreter_options == nullptr) {
-    TfLiteModelDelete(model);
+
+  // Interpreter and delegate threads are spawned by whichever thread builds
+  // or first runs the runtime, and keep its affinity and priority, so the
+  // runtime is built (and tuned) from a placed thread.
+  auto placement = std::make_unique<ThreadPlacement>(options.core_placement, options.core_mask,
+                                                     options.thread_nice, options.num_threads);
+  ScopedPlacement placed(placement.get());
+
+  TuningResult tuning;
+  std::unique_ptr<InferenceRuntime> runtime;
+  if (options.auto_tune) {
+    runtime = AutoTuneRuntime(model, model_path, options, &tuning);
+    if (runtime) {
+      std::ostringstream log;
+      log << "autotune: selected " << DelegateName(tuning.config.delegate)
+          << " threads=" << tuning.config.num_threads << " medianUs=" << tuning.invoke_us
+          << (tuning.from_cache ? " (cached)" : "");
+      LogMessage(log.str());
+    }
+  }
+  if (!runtime && options.use_gpu) {
+    tuning.config.delegate = DelegateKind::kGpu;
+    tuning.config.num_threads = options.num_threads;
+    tuning.config.allow_fp16 = options.allow_fp16;
+    runtime = InferenceRuntime::Create(model, tuning.config);
+    if (!runtime) {
+      LogMessage("gpu delegate unavailable, falling back to cpu");
+    }
+  }
+  if (!runtime) {
+    tuning.config.delegate = DelegateKind::kCpu;
+    tuning.config.num_threads = options.num_threads;
+    tuning.config.allow_fp16 = options.allow_fp16;
+    runtime = InferenceRuntime::Create(model, tuning.config);
+  }
+  if (!runtime) {
     return nullptr;
   }
-  TfLiteInterpreterOptionsSetNumThreads(interpreter_options, options.num_threads);
 
-  TfLiteInterpreter* interpreter = TfLiteInterpreterCreate(model, interpreter_options);
-  if (interpreter == nullptr) {
-    TfLiteInterpreterOptionsDelete(interpreter_options);
-    TfLiteModelDelete(model);
-    return nullptr;
+  EngineOptions resolved = options;
+  resolved.num_threads = tuning.config.num_threads;
+  resolved.use_gpu = tuning.config.delegate == DelegateKind::kGpu;
+  auto engine = std::unique_ptr<YoloEngine>(new YoloEngine(
+      resolved, std::move(placement), std::move(model), std::move(runtime), tuning));
+  engine->model_bytes_ = FileSizeBytes(model_path);
+  engine->decode_settings_.confidence_threshold = options.confidence_threshold;
+  engine->decode_settings_.iou_threshold = options.iou_threshold;
+  engine->decode_settings_.max_detections = options.max_detections;
+  engine->ResolveOutputLayout();
+  if (options.governor) {
+    engine->governor_.Configure(options.cadence);
   }
+  if (options.result_channel) {
+    engine->results_ = std::make_unique<ResultChannel>();
+  }
+  engine->frame_ring_.Configure(static_cast<size_t>(std::max(0, options.frame_ring_size)));
+  if (!options.classifier_model_path.empty()) {
+    ModelHandle classifier_model = LoadModel(options.classifier_model_path);
+    engine->classifier_ =
+        CropClassifier::Create(classifier_model, tuning.config, options.classifier_top_k);
+    if (!engine->classifier_ && tuning.config.delegate != DelegateKind::kCpu) {
+      RuntimeConfig cpu = tuning.config;
+      cpu.delegate = DelegateKind::kCpu;
+      engine->classifier_ = CropClassifier::Create(classifier_model, cpu, options.classifier_top_k);
+    }
+    if (engine->classifier_) {
+      engine->model_bytes_ += FileSizeBytes(options.classifier_model_path);
+      std::ostringstream log;
+      log << "classifier: input=" << engine->classifier_->input_width() << 'x'
+          << engine->classifier_->input_height();
+      LogMessage(log.str());
+    } else {
+      LogMessage("classifier unavailable, running detector only");
+    }
+  }
+  return engine;
+}
 
-  auto engine =
-      std::unique_ptr<YoloEngine>(new YoloEngine(options, model, interpreter_options, interpreter));
-  if (!engine->InitializeDelegates()) {
-    return nullptr;
+int32_t FrameStatus(FrameResult result) {
+  switch (result) {
+    case FrameResult::kProcessed:
+      return 0;
+    case FrameResult::kExpired:
+      return YOLO_ENGINE_FRAME_EXPIRED;
+    case FrameResult::kLowQuality:
+      return YOLO_ENGINE_FRAME_LOW_QUALITY;
+    case FrameResult::kSuspended:
+      return YOLO_ENGINE_FRAME_SUSPENDED;
+    case FrameResult::kGoverned:
+      return YOLO_ENGINE_FRAME_GOVERNED;
+    case FrameResult::kFailed:
+      break;
   }
+  return -2;
+}
 
-  if (TfLiteInterpreterAllocateTensors(interpreter) != kTfLiteOk) {
-    return nullptr;
+FrameResult YoloEngine::ProcessFrame(const FrameMetadata& frame,
+                                     std::vector<YoloDetection>* detections,
+                                     FrameReport* report) {
+  const FrameResult result = RunFrame(frame, detections, report);
+  // After the frame is answered, so recording never delays a result; the
+  // caller's planes are still valid until this returns.
+  if (recorder_.recording() && detections != nullptr && report != nullptr) {
+    recorder_.Record(frame, frame_seq_, FrameStatus(result), *detections, decode_settings_,
+                     static_cast<int64_t>(report->receive_ns),
+                     static_cast<int64_t>(report->decode_end_ns), report->predicted);
   }
+  return result;
+}
 
-  return engine;
+bool YoloEngine::StartRecording(const std::string& path, uint64_t max_bytes) {
+  RecordingFileHeader header{};
+  header.input_width = options_.input_width;
+  header.input_height = options_.input_height;
+  header.num_threads = options_.num_threads;
+  header.max_detections = options_.max_detections;
+  header.confidence_threshold = options_.confidence_threshold;
+  header.iou_threshold = options_.iou_threshold;
+  header.inference_interval = options_.inference_interval;
+  header.min_track_confidence = options_.min_track_confidence;
+  header.quality_gate = static_cast<int32_t>(options_.quality_gate);
+  header.min_sharpness = options_.min_sharpness;
+  header.max_clipped_fraction = options_.max_clipped_fraction;
+  header.auto_zoom = options_.auto_zoom ? 1 : 0;
+  header.governor = options_.governor ? 1 : 0;
+  header.governor_max_fps = options_.cadence.max_fps;
+  header.governor_max_duty_cycle = options_.cadence.max_duty_cycle;
+  header.governor_max_cpu_ms_per_s = options_.cadence.max_cpu_ms_per_s;
+  header.governor_idle_after_ms = options_.cadence.idle_after_ms;
+  header.governor_idle_fps = options_.cadence.idle_fps;
+  header.classifier = options_.classifier_model_path.empty() ? 0 : 1;
+  header.classifier_top_k = options_.classifier_top_k;
+  header.classifier_min_score = options_.classifier_min_score;
+  header.use_gpu = options_.use_gpu ? 1 : 0;
+  return recorder_.Start(path, max_bytes, header);
 }
 
-bool YoloEngine::InitializeDelegates() {
-  if (!options_.use_gpu) {
-    return true;
+FrameResult YoloEngine::RunFrame(const FrameMetadata& frame,
+                                 std::vector<YoloDetection>* detections, FrameReport* report) {
+  if (detections == nullptr || report == nullptr) {
+    stats_.AddFramesDropped(1);
+    return FrameResult::kFailed;
+  }
+  if (suspended_) {
+    stats_.AddFramesDropped(1);
+    return FrameResult::kSuspended;
+  }
+  AdoptSwappedModel();
+  AdoptDecodeSettings();
+  frame_view_valid_ = false;
+  *report = FrameReport();
+  report->receive_ns = MonotonicNanos();
+  ++frame_seq_;
+  RecordLatency(Stage::kQueueWait, frame, report->receive_ns);
+  // A frame that sat in a queue past its deadline is worthless to the
+  // caller; drop it before paying for preprocessing.
+  if (Expired(frame)) {
+    stats_.AddFramesDropped(1);
+    stats_.AddFramesExpired(1);
+    return FrameResult::kExpired;
+  }
+  const bool inference_due = InferenceDue(report->receive_ns);
+  // With no boxes to move either, a governed frame costs nothing more.
+  if (!inference_due && governor_.enabled() && !tracker_.anchored()) {
+    stats_.AddFramesGoverned(1);
+    return FrameResult::kGoverned;
+  }
+  // Everything from here runs on the caller's thread plus the pool, so the
+  // caller's thread is placed with the workers until the frame is answered.
+  ScopedPlacement placed(placement_.get());
+  if (!CheckQuality(frame, report)) {
+    stats_.AddFramesDropped(1);
+    return FrameResult::kLowQuality;
+  }
+  if (!inference_due && TrackFrame(frame, detections, report)) {
+    // No preprocessing ran, so only remembered classifications apply.
+    ClassifyDetections(*detections);
+    PublishResults(frame, *detections, *report);
+    RecordLatency(Stage::kCaptureToResult, frame, report->decode_end_ns);
+    stats_.AddFramesTracked(1);
+    stats_.AddFramesProcessed(1);
+    if (governor_.enabled()) {
+      stats_.AddFramesGoverned(1);
+    }
+    return FrameResult::kProcessed;
+  }
+  // Lost tracking falls back to inference on a fixed interval, but the
+  // governor's budget holds; the previous boxes stand until it is due.
+  if (!inference_due && governor_.enabled()) {
+    stats_.AddFramesGoverned(1);
+    return FrameResult::kGoverned;
   }
 
-#if defined(__ANDROID__)
-  TfLiteGpuDelegateOptionsV2 gpu_options = TfLiteGpuDelegateOptionsV2Default();
-  gpu_options.inference_preference = TFLITE_GPU_INFERENCE_PREFERENCE_FAST_SINGLE_ANSWER;
-  gpu_options.is_precision_loss_allowed = options_.allow_fp16 ? 1 : 0;
-  gpu_delegate_ = reinterpret_cast<TfLiteDelegate*>(TfLiteGpuDelegateV2Create(&gpu_options));
-  if (gpu_delegate_ != nullptr) {
-    TfLiteInterpreterOptionsAddDelegate(interpreter_options_, gpu_delegate_);
+  bool ok = false;
+  bool expired = false;
+  const uint64_t start_ns = MonotonicNanos();
+  const uint64_t cpu_start_ns = governor_.enabled() ? ProcessCpuNanos() : 0;
+  last_invoke_ns_ = 0;
+  {
+    ScopedStageSpan total_span(&stats_, &trace_, Stage::kTotal, frame_seq_);
+    PrepareScratch(frame);
+    if (frame.format == PixelFormat::kYuv420) {
+      DetectStreamLayout(frame);
+    }
+    // A caller's region wins over auto zoom, which then stays out of the way.
+    const bool auto_zoom = options_.auto_zoom && frame.roi.full();
+    ok = PrepareInput(frame, auto_zoom ? zoom_.NextRoi() : frame.roi);
+    if (ok && pending_capture_id_ != 0) {
+      capture_writer_.Submit(pending_capture_id_, pending_capture_, frame_view_,
+                             options_.input_width, options_.input_height);
+      pending_capture_id_ = 0;
+    }
+    // Preprocessing can take long enough on its own to miss the deadline;
+    // inference is the expensive part, so check again before it.
+    expired = ok && Expired(frame);
+    if (ok && !expired) {
+      report->inference_start_ns = MonotonicNanos();
+      ok = InvokeInterpreter() && Decode(detections);
+      if (ok && !input_roi_.full()) {
+        MapFromRoi(input_roi_, options_.input_width, options_.input_height, detections);
+        stats_.AddFramesZoomed(1);
+      }
+      if (ok && auto_zoom) {
+        zoom_.Update(input_roi_, options_.input_width, options_.input_height,
+                     decode_settings_.iou_threshold, detections);
+        if (detections->size() > static_cast<size_t>(decode_settings_.max_detections)) {
+          detections->resize(static_cast<size_t>(decode_settings_.max_detections));
+        }
+      }
+      report->roi = input_roi_;
+      report->decode_end_ns = MonotonicNanos();
+      if (ok) {
+        ClassifyDetections(*detections);
+      }
+      if (ok && frame_ring_.enabled()) {
+        const int64_t time_ns = frame.capture_time_ns > 0
+                                    ? frame.capture_time_ns
+                                    : static_cast<int64_t>(report->receive_ns);
+        frame_ring_.Push(frame_view_, time_ns, *detections, options_.input_width,
+                         options_.input_height);
+      }
+    }
+  }
+  stats_.AddAllocations(scratch_.TakeAllocationCount());
+  if (ok && !expired && governor_.enabled()) {
+    governor_.RecordInference(start_ns, MonotonicNanos(), ProcessCpuNanos() - cpu_start_ns,
+                              last_invoke_ns_, detections->size());
   }
-#elif defined(__APPLE__) && TARGET_OS_IOS
-  TfLiteGpuDelegateOptions gpu_options = TfLiteGpuDelegateOptionsDefault();
-  gpu_options.allow_precision_loss = options_.allow_fp16 ? 1 : 0;
-  gpu_options.wait_type = TFLGpuDelegateWaitType::TFLGpuDelegateWaitTypePassive;
-  gpu_options.max_delegated_partitions = 1;
-  gpu_delegate_ = reinterpret_cast<TfLiteDelegate*>(TfLiteGpuDelegateCreate(&gpu_options));
-  if (gpu_delegate_ != nullptr) {
-    TfLiteInterpreterOptionsAddDelegate(interpreter_options_, gpu_delegate_);
+  if (expired) {
+    stats_.AddFramesDropped(1);
+    stats_.AddFramesExpired(1);
+    return FrameResult::kExpired;
   }
-#endif
+  if (!ok) {
+    stats_.AddFramesDropped(1);
+    return FrameResult::kFailed;
+  }
+  if (options_.inference_interval > 1 || governor_.enabled()) {
+    ScopedStageSpan span(&stats_, &trace_, Stage::kTrack, frame_seq_);
+    tracker_.Reset(frame, options_.input_width, options_.input_height, *detections);
+    frames_since_inference_ = 0;
+  }
+  PublishResults(frame, *detections, *report);
+  RecordLatency(Stage::kCaptureToResult, frame, report->decode_end_ns);
+  stats_.AddFramesProcessed(1);
+  return FrameResult::kProcessed;
+}
 
-  return true;
+bool YoloEngine::InferenceDue(uint64_t now_ns) const {
+  // A pending capture needs the full-resolution view only preprocessing
+  // builds, so that frame is inferred.
+  if (pending_capture_id_ != 0) {
+    return true;
+  }
+  if (governor_.enabled()) {
+    return governor_.Due(now_ns);
+  }
+  return options_.inference_interval <= 1 ||
+         frames_since_inference_ + 1 >= options_.inference_interval;
 }
 
-bool YoloEngine::ProcessFrame(const FrameMetadata& frame, std::vector<YoloDetection>* detections) {
-  if (detections == nullptr) {
+bool YoloEngine::TrackFrame(const FrameMetadata& frame, std::vector<YoloDetection>* detections,
+                            FrameReport* report) {
+  if (!tracker_.anchored()) {
     return false;
   }
-  std::vector<float> input_buffer;
-  if (!PrepareInput(frame, &input_buffer)) {
+  // Flow is only meaningful within one stream; a geometry change means the
+  // anchor frame is from a different one.
+  const int rotation = ((frame.rotation_degrees % 360) + 360) % 360;
+  if (frame.width != scratch_width_ || frame.height != scratch_height_ ||
+      rotation != scratch_rotation_ || frame.format != scratch_format_) {
+    tracker_.Clear();
     return false;
   }
-  std::vector<float> output_tensor;
-  std::vector<int> output_shape;
-  if (!InvokeInterpreter(input_buffer, &output_tensor, &output_shape)) {
+  float confidence = 0.0f;
+  bool tracked = false;
+  {
+    ScopedStageSpan span(&stats_, &trace_, Stage::kTrack, frame_seq_);
+    tracked = tracker_.Track(frame, detections, &confidence);
+  }
+  report->track_confidence = confidence;
+  // Below the threshold the caller gets a fresh inference on this same
+  // frame, which also re-anchors the tracker.
+  if (!tracked || confidence < options_.min_track_confidence) {
+    detections->clear();
     return false;
   }
-  auto decoded = yolo::DecodeDetections(output_tensor, output_shape, options_);
-  *detections = std::move(decoded);
+  ++frames_since_inference_;
+  report->predicted = true;
+  report->decode_end_ns = MonotonicNanos();
   return true;
 }
 
-bool YoloEngine::PrepareInput(const FrameMetadata& frame, std::vector<float>* input_buffer) {
-  if (input_buffer == nullptr) {
+bool YoloEngine::SwapModel(const std::string& model_path) {
+  // A swapped-in runtime would bring its arena back while suspended.
+  if (suspended_) {
     return false;
   }
-  Yuv420ToRgb(frame, &rgb_buffer_);
+  // The loader thread, and the interpreter threads it spawns, inherit the
+  // placement from this one.
+  ScopedPlacement placed(placement_.get());
+  return swapper_.Start(model_path, runtime_->config(), runtime_->input_shape());
+}
 
-  std::vector<uint8_t>* working_buffer = &rgb_buffer_;
-  int processed_width = frame.width;
-  int processed_height = frame.height;
+void YoloEngine::AdoptSwappedModel() {
+  ModelSwapper::Prepared prepared;
+  if (!swapper_.TakeReady(&prepared)) {
+    return;
+  }
+  const uint64_t start_ns = MonotonicNanos();
+  std::swap(model_, prepared.model);
+  std::swap(runtime_, prepared.runtime);
+  std::swap(model_bytes_, prepared.model_bytes);
+  // The output shape, and with it the decode scratch, may differ; forget the
+  // cached geometry so the next PrepareScratch() re-reserves. Tracked boxes
+  // belong to the old model's classes.
+  scratch_width_ = 0;
+  tracker_.Clear();
+  classification_cache_.Clear();
+  frame_ring_.Clear();
+  zoom_.Reset();
+  governor_.ResetBaseline();
+  ResolveOutputLayout();
+  logged_shapes_ = false;
+  swapper_.Retire(std::move(prepared), MonotonicNanos() - start_ns);
+}
 
-  const int rotation = ((frame.rotation_degrees % 360) + 360) % 360;
-  if (rotation != 0) {
-    RotateRgb(rgb_buffer_, frame.width, frame.height, rotation, &rotated_buffer_);
-    working_buffer = &rotated_buffer_;
-    if (rotation == 90 || rotation == 270) {
-      processed_width = frame.height;
-      processed_height = frame.width;
-    }
-  } else {
-    rotated_buffer_.clear();
+bool YoloEngine::Suspend() {
+  if (suspended_) {
+    return true;
+  }
+  // A finished swap is adopted first so the runtime released is the one that
+  // would serve the next frame.
+  AdoptSwappedModel();
+  YoloModelSwapInfo swap;
+  swapper_.GetInfo(&swap);
+  if (swap.state == kYoloModelSwapLoading) {
+    return false;
   }
+  const uint64_t start_ns = MonotonicNanos();
+  const size_t resident_before = ResidentMemoryBytes();
+  // The C API cannot free a live interpreter's arena, so the interpreter goes
+  // and the model (memory-mapped, so mostly clean pages the system can drop)
+  // and delegate stay for Resume().
+  runtime_->Release();
+  if (classifier_) {
+    classifier_->Release();
+  }
+  scratch_.Release();
+  resampler_.Clear();
+  // Forces PrepareScratch() to re-reserve and re-detect the stream.
+  scratch_width_ = 0;
+  frame_view_valid_ = false;
+  tracker_.Release();
+  frame_ring_.Release();
+  zoom_.Reset();
+  classification_cache_.Clear();
+  classifications_ = std::vector<YoloClassification>();
+  pending_crops_ = std::vector<size_t>();
+  suspended_ = true;
+  const size_t resident_after = ResidentMemoryBytes();
+  suspend_released_bytes_ = resident_before > resident_after ? resident_before - resident_after : 0;
+  suspend_ms_ = static_cast<float>(MonotonicNanos() - start_ns) / 1e6f;
+  return true;
+}
 
-  ResizeAndNormalize(*working_buffer, processed_width, processed_height, options_.input_width,
-                     options_.input_height, input_buffer);
+bool YoloEngine::Resume() {
+  if (!suspended_) {
+    return true;
+  }
+  const uint64_t start_ns = MonotonicNanos();
+  ScopedPlacement placed(placement_.get());
+  if (!runtime_->Restore() || (classifier_ && !classifier_->Restore())) {
+    runtime_->Release();
+    if (classifier_) {
+      classifier_->Release();
+    }
+    return false;
+  }
+  // The first invoke pays for delegate kernel compilation and first-touch of
+  // the arena; pay for it here rather than on the first live frame.
+  if (float* input = runtime_->MutableInput()) {
+    std::fill(input, input + runtime_->input_count(), 0.0f);
+    runtime_->Run();
+  }
+  governor_.ResetBaseline();
+  // Time spent suspended is not time without detections; without this the
+  // first inference after a long pause would find the stream idle.
+  governor_.ResetActivity();
+  suspended_ = false;
+  resume_ms_ = static_cast<float>(MonotonicNanos() - start_ns) / 1e6f;
   return true;
 }
 
-bool YoloEngine::InvokeInterpreter(const std::vector<float>& input_buffer,
-                                   std::vector<float>* output_buffer,
-                                   std::vector<int>* output_shape) {
-  if (output_buffer == nullptr || output_shape == nullptr) {
+int32_t YoloEngine::RequestCapture(CaptureRequest request) {
+  if (pending_capture_id_ != 0) {
+    return 0;
+  }
+  pending_capture_ = std::move(request);
+  pending_capture_id_ = ++last_capture_id_;
+  capture_writer_.Reserve(pending_capture_id_);
+  return pending_capture_id_;
+}
+
+int32_t YoloEngine::CancelCapture(int32_t id) {
+  if (id == pending_capture_id_) {
+    pending_capture_id_ = 0;
+  }
+  return capture_writer_.Cancel(id);
+}
+
+int32_t YoloEngine::CaptureBest(CaptureRequest request, int64_t window_ns) {
+  PixelView frame;
+  YoloDetection match{};
+  const int64_t since_ns = static_cast<int64_t>(MonotonicNanos()) - window_ns;
+  if (!frame_ring_.FindBest(request.box, since_ns, &frame, &match)) {
+    return RequestCapture(std::move(request));
+  }
+  // The stored box is where the object was in that frame; the request's box
+  // is where it is now.
+  request.box = match;
+  const int32_t id = ++last_capture_id_;
+  capture_writer_.Submit(id, request, frame, options_.input_width, options_.input_height);
+  return id;
+}
+
+bool YoloEngine::Expired(const FrameMetadata& frame) const {
+  return frame.deadline_ns > 0 && MonotonicNanos() > static_cast<uint64_t>(frame.deadline_ns);
+}
+
+bool YoloEngine::CheckQuality(const FrameMetadata& frame, FrameReport* report) {
+  if (options_.quality_gate == QualityGate::kOff) {
+    return true;
+  }
+  bool measured = false;
+  {
+    ScopedStageSpan span(&stats_, &trace_, Stage::kQuality, frame_seq_);
+    measured = MeasureFrameQuality(frame, std::max(options_.input_width, options_.input_height),
+                                   &report->quality);
+  }
+  if (!measured) {
+    return true;
+  }
+  const FrameQuality& quality = report->quality;
+  report->low_quality = quality.sharpness < options_.min_sharpness ||
+                        quality.dark_fraction > options_.max_clipped_fraction ||
+                        quality.bright_fraction > options_.max_clipped_fraction;
+  if (!report->low_quality) {
+    return true;
+  }
+  stats_.AddFramesLowQuality(1);
+  return options_.quality_gate != QualityGate::kSkip;
+}
+
+void YoloEngine::RecordLatency(Stage stage, const FrameMetadata& frame, uint64_t end_ns) {
+  if (frame.capture_time_ns <= 0) {
+    return;
+  }
+  const uint64_t capture_ns = static_cast<uint64_t>(frame.capture_time_ns);
+  if (end_ns < capture_ns) {
+    return;
+  }
+  stats_.RecordStage(stage, end_ns - capture_ns);
+  trace_.Record(stage, frame_seq_, capture_ns, end_ns);
+}
+
+void YoloEngine::PrepareScratch(const FrameMetadata& frame) {
+  const int rotation = ((frame.rotation_degrees % 360) + 360) % 360;
+  if (frame.width != scratch_width_ || frame.height != scratch_height_ ||
+      rotation != scratch_rotation_ || frame.format != scratch_format_) {
+    scratch_width_ = frame.width;
+    scratch_height_ = frame.height;
+    scratch_rotation_ = rotation;
+    scratch_format_ = frame.format;
+    // A new geometry means a new stream; classify its chroma layout afresh.
+    chroma_layout_ = ChromaLayout::kGeneric;
+    stream_layout_known_ = false;
+    zoom_.Reset();
+    const size_t rgb_bytes = ScratchArena::AlignUp(static_cast<size_t>(frame.width) *
+                                                   static_cast<size_t>(frame.height) * 3);
+    const size_t input_bytes = ScratchArena::AlignUp(static_cast<size_t>(options_.input_width) *
+                                                     options_.input_height * 3 * sizeof(float));
+    // Packed frames are read in place, so only YUV needs the RGB plane.
+    const bool yuv = frame.format == PixelFormat::kYuv420;
+    const size_t classifier_bytes =
+        classifier_ ? classifier_->ScratchBytes() +
+                          ScratchArena::AlignUp(static_cast<size_t>(options_.max_detections) *
+                                                sizeof(YoloDetection)) +
+                          ScratchArena::AlignUp(static_cast<size_t>(options_.max_detections) *
+                                                sizeof(YoloClassification))
+                    : 0;
+    // The upright copy only exists for the consumers of the full frame; see
+    // PrepareInput(). A capture on a stream without them grows the arena once.
+    const bool upright = rotation != 0 && (classifier_ != nullptr || frame_ring_.enabled());
+    scratch_.Reserve((yuv ? rgb_bytes : 0) + (upright ? rgb_bytes : 0) + input_bytes +
+                     DecodeScratchBytes(decode_layout_) + classifier_bytes);
+  }
+  scratch_.Reset();
+}
+
+void YoloEngine::DetectStreamLayout(const FrameMetadata& frame) {
+  // Classified on the first frame of a stream. The pointer check below is
+  // O(1), so if the caller stops handing over adjacent chroma planes the
+  // stream is reclassified instead of reading past a separate U/V copy.
+  if (stream_layout_known_ && ChromaLayoutMatches(frame, chroma_layout_)) {
+    return;
+  }
+  chroma_layout_ = DetectChromaLayout(frame);
+  stream_layout_known_ = true;
+  std::ostringstream log;
+  log << "chroma layout: " << ChromaLayoutName(chroma_layout_)
+      << " uvPixelStride=" << frame.uv_pixel_stride << " uvRowStride=" << frame.uv_row_stride;
+  LogMessage(log.str());
+}
+
+bool YoloEngine::PrepareInput(const FrameMetadata& frame, const Roi& roi) {
+  if (frame.width <= 0 || frame.height <= 0) {
     return false;
   }
-  TfLiteTensor* input_tensor = TfLiteInterpreterGetInputTensor(interpreter_, 0);
-  if (input_tensor == nullptr) {
+  const size_t rgb_bytes = static_cast<size_t>(frame.width) * frame.height * 3;
+  PixelView source;
+  if (frame.format == PixelFormat::kYuv420) {
+    auto* rgb = scratch_.Allocate<uint8_t>(rgb_bytes);
+    if (rgb == nullptr) {
+      return false;
+    }
+    ScopedStageSpan span(&stats_, &trace_, Stage::kYuvToRgb, frame_seq_);
+    Yuv420ToRgb(frame, chroma_layout_, rgb, &pool_);
+    source = RgbView(rgb, frame.width, frame.height);
+  } else if (!PackedFrameView(frame, &source)) {
     return false;
   }
-  if (!logged_shapes_) {
-    const int input_dims = TfLiteTensorNumDims(input_tensor);
-    std::vector<int> input_shape;
-    input_shape.reserve(input_dims);
-    for (int i = 0; i < input_dims; ++i) {
-      input_shape.push_back(TfLiteTensorDim(input_tensor, i));
+
+  const int rotation = ((frame.rotation_degrees % 360) + 360) % 360;
+  const bool transposed = rotation == 90 || rotation == 270;
+  // Captures, the classifier and the frame ring read the full-resolution
+  // upright frame. Without them the rotation is folded into the resample, so
+  // the frame is turned after it has been shrunk rather than before.
+  const bool upright_needed =
+      classifier_ != nullptr || frame_ring_.enabled() || pending_capture_id_ != 0;
+  int resample_rotation = 0;
+  if (rotation != 0 && upright_needed) {
+    auto* rotated = scratch_.Allocate<uint8_t>(rgb_bytes);
+    if (rotated == nullptr) {
+      return false;
     }
-    LogShape("inputTensorShape", input_shape);
+    ScopedStageSpan span(&stats_, &trace_, Stage::kRotate, frame_seq_);
+    RotateRgb(source, rotation, rotated, &pool_);
+    source = RgbView(rotated, transposed ? frame.height : frame.width,
+                     transposed ? frame.width : frame.height);
+  } else {
+    resample_rotation = rotation;
   }
-  const size_t input_bytes = input_buffer.size() * sizeof(float);
-  if (TfLiteTensorCopyFromBuffer(input_tensor, input_buffer.data(), input_bytes) != kTfLiteOk) {
-    return false;
+  if (resample_rotation == 0) {
+    frame_view_ = source;
+    frame_view_valid_ = true;
   }
-  if (TfLiteInterpreterInvoke(interpreter_) != kTfLiteOk) {
-    return false;
+
+  // Captures, the classifier and the frame ring keep the whole frame; only
+  // the model's input is cropped. The region is in upright coordinates and
+  // is mapped back onto the unrotated source when the rotation is folded.
+  input_roi_ = Roi();
+  if (!roi.full()) {
+    const bool swap_axes = resample_rotation == 90 || resample_rotation == 270;
+    const int upright_width = swap_axes ? source.height : source.width;
+    const int upright_height = swap_axes ? source.width : source.height;
+    // The size in pixels follows from the region's size alone, wherever it
+    // sits, so a crop that moves keeps hitting the same resampler plan.
+    const int crop_width = std::clamp(static_cast<int>(std::lround(roi.width() * upright_width)),
+                                      1, upright_width);
+    const int crop_height = std::clamp(
+        static_cast<int>(std::lround(roi.height() * upright_height)), 1, upright_height);
+    const int left = std::clamp(static_cast<int>(std::lround(roi.left * upright_width)), 0,
+                                upright_width - crop_width);
+    const int top = std::clamp(static_cast<int>(std::lround(roi.top * upright_height)), 0,
+                               upright_height - crop_height);
+    const int right = left + crop_width;
+    const int bottom = top + crop_height;
+    input_roi_.left = static_cast<float>(left) / upright_width;
+    input_roi_.top = static_cast<float>(top) / upright_height;
+    input_roi_.right = static_cast<float>(right) / upright_width;
+    input_roi_.bottom = static_cast<float>(bottom) / upright_height;
+    // Source rectangle [x0, x1) x [y0, y1) that turns into the upright one.
+    int x0 = left;
+    int x1 = right;
+    int y0 = top;
+    int y1 = bottom;
+    switch (resample_rotation) {
+      case 90:
+        x0 = top;
+        x1 = bottom;
+        y0 = source.height - right;
+        y1 = source.height - left;
+        break;
+      case 180:
+        x0 = source.width - right;
+        x1 = source.width - left;
+        y0 = source.height - bottom;
+        y1 = source.height - top;
+        break;
+      case 270:
+        x0 = source.width - bottom;
+        x1 = source.width - top;
+        y0 = left;
+        y1 = right;
+        break;
+      default:
+        break;
+    }
+    source.data += static_cast<size_t>(source.row_stride) * y0 +
+                   static_cast<size_t>(source.pixel_stride) * x0;
+    source.width = x1 - x0;
+    source.height = y1 - y0;
   }
-  const TfLiteTensor* output_tensor = TfLiteInterpreterGetOutputTensor(interpreter_, 0);
-  if (output_tensor == nullptr) {
-    return false;
+
+  // Resize straight into the interpreter's input tensor when it is float32
+  // of the expected size; otherwise stage in scratch and copy.
+  const size_t input_count =
+      static_cast<size_t>(options_.input_width) * options_.input_height * 3;
+  float* input = runtime_->MutableInput();
+  const bool staged = input == nullptr || runtime_->input_count() != input_count;
+  if (staged) {
+    input = scratch_.Allocate<float>(input_count);
+    if (input == nullptr) {
+      return false;
+    }
   }
-  const int dims_count = TfLiteTensorNumDims(output_tensor);
-  output_shape->resize(dims_count);
-  for (int i = 0; i < dims_count; ++i) {
-    (*output_shape)[i] = TfLiteTensorDim(output_tensor, i);
+  {
+    ScopedStageSpan span(&stats_, &trace_, Stage::kResize, frame_seq_);
+    ResamplePlan* plan =
+        resampler_.Get(source.width, source.height, source.pixel_stride, resample_rotation,
+                       options_.input_width, options_.input_height, pool_.num_threads());
+    if (plan == nullptr) {
+      return false;
+    }
+    plan->Run(source, input, &pool_);
   }
-  size_t output_size = 1;
-  for (int dim : *output_shape) {
-    output_size *= static_cast<size_t>(dim);
+  return !staged || runtime_->CopyInput(input, input_count);
+}
+
+bool YoloEngine::InvokeInterpreter() {
+  ScopedStageSpan span(&stats_, &trace_, Stage::kInvoke, frame_seq_);
+  if (!logged_shapes_) {
+    LogShape("inputTensorShape", runtime_->input_shape());
+  }
+  const uint64_t start_ns = MonotonicNanos();
+  if (!runtime_->Run()) {
+    return false;
   }
-  output_buffer->resize(output_size);
+  last_invoke_ns_ = MonotonicNanos() - start_ns;
   if (!logged_shapes_) {
-    LogShape("outputTensorShape", *output_shape);
+    LogShape("outputTensorShape", runtime_->output_shape());
     logged_shapes_ = true;
   }
-  if (TfLiteTensorCopyToBuffer(output_tensor, output_buffer->data(),
-                               output_size * sizeof(float)) != kTfLiteOk) {
+  return true;
+}
+
+void YoloEngine::ResolveOutputLayout() {
+  // An unusable shape is logged here once; such a model serves frames with
+  // no detections.
+  decode_layout_ = ResolveDecodeLayout(runtime_->output_shape());
+  decode_settings_.Resolve(decode_layout_.valid() ? decode_layout_.channels - 4 : 0);
+}
+
+void YoloEngine::AdoptDecodeSettings() {
+  std::unique_ptr<DecodeSettings> next = pending_settings_.Take();
+  if (!next) {
+    return;
+  }
+  decode_settings_ = std::move(*next);
+  decode_settings_.Resolve(decode_layout_.valid() ? decode_layout_.channels - 4 : 0);
+  // Remembered classifications and tracked boxes may belong to classes that
+  // are now masked.
+  classification_cache_.Clear();
+  tracker_.Clear();
+  zoom_.Reset();
+}
+
+bool YoloEngine::Decode(std::vector<YoloDetection>* detections) {
+  const float* output = runtime_->Output();
+  if (output == nullptr) {
     return false;
   }
+  DecodeStats decode_stats;
+  {
+    ScopedStageSpan span(&stats_, &trace_, Stage::kDecode, frame_seq_);
+    DecodeDetections(output, runtime_->output_count(), decode_layout_, options_, decode_settings_,
+                     &scratch_, detections, &pool_, &decode_stats);
+  }
+  stats_.AddCandidatesPreNms(decode_stats.candidates_pre_nms);
+  stats_.AddCandidatesPostNms(decode_stats.candidates_post_nms);
+  stats_.AddAllocations(decode_stats.allocations);
   return true;
 }
 
+void YoloEngine::ClassifyDetections(const std::vector<YoloDetection>& detections) {
+  classifications_.clear();
+  if (!classifier_) {
+    return;
+  }
+  classifications_.assign(detections.size(), YoloClassification{});
+  pending_crops_.clear();
+  uint64_t hits = 0;
+  for (size_t i = 0; i < detections.size(); ++i) {
+    if (detections[i].score < options_.classifier_min_score) {
+      continue;
+    }
+    if (const YoloClassification* cached = classification_cache_.Find(detections[i], frame_seq_)) {
+      classifications_[i] = *cached;
+      ++hits;
+    } else if (frame_view_valid_) {
+      pending_crops_.push_back(i);
+    }
+  }
+  stats_.AddClassificationCacheHits(hits);
+
+  const size_t count = pending_crops_.size();
+  auto* boxes = count > 0 ? scratch_.Allocate<YoloDetection>(count) : nullptr;
+  auto* results = count > 0 ? scratch_.Allocate<YoloClassification>(count) : nullptr;
+  if (boxes != nullptr && results != nullptr) {
+    for (size_t j = 0; j < count; ++j) {
+      boxes[j] = detections[pending_crops_[j]];
+    }
+    bool ok = false;
+    {
+      ScopedStageSpan span(&stats_, &trace_, Stage::kClassify, frame_seq_);
+      ok = classifier_->Classify(frame_view_, options_.input_width, options_.input_height, boxes,
+                                 count, &scratch_, &pool_, results);
+    }
+    if (ok) {
+      for (size_t j = 0; j < count; ++j) {
+        classifications_[pending_crops_[j]] = results[j];
+        classification_cache_.Insert(boxes[j], results[j], frame_seq_);
+      }
+      stats_.AddCropsClassified(count);
+    }
+  }
+  classification_cache_.Expire(frame_seq_);
+}
+
+void YoloEngine::PublishResults(const FrameMetadata& frame,
+                                const std::vector<YoloDetection>& detections,
+                                const FrameReport& report) {
+  if (!results_) {
+    return;
+  }
+  YoloResultFrame* out = results_->back();
+  // Decode emits boxes best first, so an oversized frame keeps its strongest.
+  const size_t count = std::min<size_t>(detections.size(), YOLO_RESULT_MAX_DETECTIONS);
+  std::copy_n(detections.begin(), count, out->detections);
+  out->has_classifications = classifier_ && classifications_.size() == detections.size() ? 1 : 0;
+  if (out->has_classifications != 0) {
+    std::copy_n(classifications_.begin(), count, out->classifications);
+  }
+  out->count = static_cast<int32_t>(count);
+  out->predicted = report.predicted ? 1 : 0;
+  out->track_confidence = report.track_confidence;
+  out->low_quality = report.low_quality ? 1 : 0;
+  out->capture_time_ns = frame.capture_time_ns;
+  out->receive_time_ns = static_cast<int64_t>(report.receive_ns);
+  out->inference_start_ns = static_cast<int64_t>(report.inference_start_ns);
+  out->decode_end_ns = static_cast<int64_t>(report.decode_end_ns);
+  out->roi_left = report.roi.left;
+  out->roi_top = report.roi.top;
+  out->roi_right = report.roi.right;
+  out->roi_bottom = report.roi.bottom;
+  results_->Publish();
+}
+
+void YoloEngine::GetMemoryStats(YoloMemoryStats* out) const {
+  out->scratch_bytes = scratch_.capacity() + resampler_.memory_bytes() +
+                       tracker_.memory_bytes() + frame_ring_.memory_bytes() +
+                       (results_ ? results_->memory_bytes() : 0);
+  out->scratch_peak_bytes = scratch_.peak();
+  out->tensor_arena_bytes =
+      runtime_->arena_bytes() + (classifier_ ? classifier_->arena_bytes() : 0);
+  out->model_bytes = model_bytes_;
+  out->steady_state_bytes = out->scratch_bytes + out->tensor_arena_bytes + out->model_bytes;
+  out->peak_bytes = out->scratch_peak_bytes + resampler_.memory_bytes() +
+                    tracker_.memory_bytes() + frame_ring_.memory_bytes() +
+                    (results_ ? results_->memory_bytes() : 0) + out->tensor_arena_bytes +
+                    out->model_bytes;
+  out->process_resident_bytes = ResidentMemoryBytes();
+  out->suspended = suspended_ ? 1 : 0;
+  out->suspend_ms = suspend_ms_;
+  out->resume_ms = resume_ms_;
+  out->suspend_released_bytes = suspend_released_bytes_;
+}
+
 }  // namespace yolo
@@ -5,8 +5,28 @@
 #include <string>
 #include <vector>
 
-#include "tensorflow_lite/c_api.h"
+#include "auto_tuner.h"
+#include "box_tracker.h"
+#include "cadence_governor.h"
+#include "crop_classifier.h"
+#include "engine_stats.h"
+#include "frame_capture.h"
+#include "frame_quality.h"
+#include "frame_recorder.h"
+#include "frame_ring.h"
+#include "image_utils.h"
+#include "inference_runtime.h"
+#include "latest_value.h"
+#include "model_swapper.h"
+#include "postprocess.h"
+#include "resampler.h"
+#include "result_channel.h"
+#include "scratch_arena.h"
+#include "thread_placement.h"
+#include "thread_pool.h"
+#include "trace_recorder.h"
 #include "yolo_engine_api.h"
+#include "zoom_controller.h"
 
 namespace yolo {
 
@@ -19,8 +39,52 @@ struct EngineOptions {
   float iou_threshold = 0.45f;
   bool use_gpu = false;
   bool allow_fp16 = true;
+  // Benchmarks delegates/thread counts on first run and caches the decision
+  // in |tuning_cache_path| (keyed by model hash, device fingerprint, input
+  // size, num_threads and use_gpu). num_threads caps the counts tried.
+  bool auto_tune = false;
+  std::string tuning_cache_path;
+  // Infer every Nth frame and track boxes in between; 1 disables tracking.
+  int inference_interval = 1;
+  // Tracked frames below this confidence are inferred instead.
+  float min_track_confidence = 0.5f;
+  // Optional second-stage crop classifier; empty disables it.
+  std::string classifier_model_path;
+  int classifier_top_k = 3;
+  float classifier_min_score = 0.5f;
+  // Recent inferred frames kept for YoloEngineCaptureBest(); 0 disables.
+  int frame_ring_size = 0;
+  // Blur/exposure pre-check. A frame is low quality when its sharpness is
+  // below |min_sharpness| or more than |max_clipped_fraction| of it is
+  // crushed to black or blown to white.
+  QualityGate quality_gate = QualityGate::kOff;
+  float min_sharpness = 30.0f;
+  float max_clipped_fraction = 0.5f;
+  // Alternate whole-frame passes with passes zoomed on a stable detection;
+  // see ZoomController.
+  bool auto_zoom = false;
+  // Publish results to a ResultChannel for YoloEngineAcquireResults().
+  bool result_channel = false;
+  // Space inferences to fit |cadence| rather than |inference_interval|; see
+  // CadenceGovernor.
+  bool governor = false;
+  CadenceBudget cadence;
+  // CPUs and priority for the engine's threads; see ThreadPlacement.
+  CorePlacement core_placement = CorePlacement::kOff;
+  uint64_t core_mask = 0;
+  int thread_nice = 0;
 };
 
+enum class PixelFormat : int {
+  kYuv420 = kYoloPixelFormatYuv420,
+  kRgb = kYoloPixelFormatRgb,
+  kRgba = kYoloPixelFormatRgba,
+  kBgra = kYoloPixelFormatBgra,
+  kBgr = kYoloPixelFormatBgr,
+};
+
+// One camera/desktop frame. YUV420 frames use all three planes; packed
+// formats only use |y_plane| (the interleaved pixels) and |y_row_stride|.
 struct FrameMetadata {
   const uint8_t* y_plane;
   const uint8_t* u_plane;
@@ -31,33 +95,189 @@ struct FrameMetadata {
   int uv_row_stride;
   int uv_pixel_stride;
   int rotation_degrees;
+  PixelFormat format = PixelFormat::kYuv420;
+  // MonotonicNanos() clock; 0 when unset.
+  int64_t capture_time_ns = 0;
+  int64_t deadline_ns = 0;
+  // Region of the upright frame to infer on; overrides auto zoom.
+  Roi roi;
+};
+
+// How one frame was answered. Timestamps are on the MonotonicNanos() clock;
+// tracked frames leave |inference_start_ns| at 0 and set |decode_end_ns| to
+// the end of tracking.
+struct FrameReport {
+  uint64_t receive_ns = 0;
+  uint64_t inference_start_ns = 0;
+  uint64_t decode_end_ns = 0;
+  bool predicted = false;
+  float track_confidence = 0.0f;
+  // Filled when the quality gate is on.
+  FrameQuality quality;
+  bool low_quality = false;
+  // Region the model ran on; the whole frame for tracked frames.
+  Roi roi;
 };
 
+enum class FrameResult {
+  kProcessed,
+  kExpired,
+  // Rejected by the quality gate before inference.
+  kLowQuality,
+  // Arrived while the engine was suspended.
+  kSuspended,
+  // Held back by the cadence governor with nothing to track.
+  kGoverned,
+  kFailed,
+};
+
+// The YoloEngineProcessFrame() status for |result|.
+int32_t FrameStatus(FrameResult result);
+
 class YoloEngine {
  public:
   static std::unique_ptr<YoloEngine> Create(const std::string& model_path,
                                             const EngineOptions& options);
   ~YoloEngine();
 
-  bool ProcessFrame(const FrameMetadata& frame, std::vector<YoloDetection>* detections);
+  FrameResult ProcessFrame(const FrameMetadata& frame, std::vector<YoloDetection>* detections,
+                           FrameReport* report);
+
+  EngineStats& stats() { return stats_; }
+  TraceRecorder& trace() { return trace_; }
+  const CadenceGovernor& governor() const { return governor_; }
+  const ThreadPlacement& placement() const { return *placement_; }
+  const TuningResult& tuning() const { return tuning_; }
+  void GetMemoryStats(YoloMemoryStats* out) const;
+  // Classifier results parallel to the last frame's detections; empty when
+  // no classifier is configured.
+  const std::vector<YoloClassification>& classifications() const { return classifications_; }
+
+  // Newest frame published to the result channel, or null when it is off.
+  // Safe from one reader thread while frames are being processed.
+  const YoloResultFrame* AcquireResults() { return results_ ? results_->Acquire() : nullptr; }
+
+  // Starts loading a replacement model in the background; see
+  // YoloEngineSwapModel(). Returns false while a previous swap is pending.
+  bool SwapModel(const std::string& model_path);
+  void GetModelSwapInfo(YoloModelSwapInfo* out) const { swapper_.GetInfo(out); }
+
+  // Queues a still from the next preprocessed frame; returns its id, or 0
+  // while an earlier request has not been served yet.
+  int32_t RequestCapture(CaptureRequest request);
+  // Captures |request.box| from the sharpest buffered frame containing it
+  // within the last |window_ns|, falling back to RequestCapture() when none
+  // qualifies.
+  int32_t CaptureBest(CaptureRequest request, int64_t window_ns);
+  int32_t TakeCaptureStatus(int32_t id) { return capture_writer_.TakeStatus(id); }
+  // Drops capture |id| and leaves none of its files behind unless it had
+  // already finished; see YoloEngineCancelCapture().
+  int32_t CancelCapture(int32_t id);
+
+  // Records submitted frames and their results to |path|; see
+  // YoloEngineStartRecording().
+  bool StartRecording(const std::string& path, uint64_t max_bytes);
+  void StopRecording() { recorder_.Stop(); }
+  void GetRecordingInfo(YoloRecordingInfo* out) const { recorder_.GetInfo(out); }
+
+  // Frees the tensor arenas and all per-stream buffers while keeping the
+  // model, delegates and tuning decision; see YoloEngineSuspend(). Fails
+  // while a model swap is loading.
+  bool Suspend();
+  // Rebuilds the interpreters and runs one warm-up invoke. On failure the
+  // engine stays suspended.
+  bool Resume();
+  bool suspended() const { return suspended_; }
+
+  // Replaces the thresholds and class filter from the start of the next
+  // frame. Safe from any thread, including while a frame is in progress.
+  void UpdateDecodeSettings(std::unique_ptr<DecodeSettings> settings) {
+    pending_settings_.Publish(std::move(settings));
+  }
 
  private:
-  YoloEngine(EngineOptions options, TfLiteModel* model,
-             TfLiteInterpreterOptions* interpreter_options, TfLiteInterpreter* interpreter);
+  YoloEngine(EngineOptions options, std::unique_ptr<ThreadPlacement> placement, ModelHandle model,
+             std::unique_ptr<InferenceRuntime> runtime, TuningResult tuning);
 
-  bool InitializeDelegates();
-  bool PrepareInput(const FrameMetadata& frame, std::vector<float>* input_buffer);
-  bool InvokeInterpreter(const std::vector<float>& input_buffer, std::vector<float>* output_buffer,
-                         std::vector<int>* output_shape);
+  FrameResult RunFrame(const FrameMetadata& frame, std::vector<YoloDetection>* detections,
+                       FrameReport* report);
+  void AdoptSwappedModel();
+  void PrepareScratch(const FrameMetadata& frame);
+  void DetectStreamLayout(const FrameMetadata& frame);
+  // Crops the upright frame to |roi| before the resize and stores the region
+  // actually used, snapped to whole pixels, in |input_roi_|.
+  bool PrepareInput(const FrameMetadata& frame, const Roi& roi);
+  bool InvokeInterpreter();
+  // Whether the frame arriving at |now_ns| should be inferred rather than
+  // tracked, per the governor or the fixed inference interval.
+  bool InferenceDue(uint64_t now_ns) const;
+  bool TrackFrame(const FrameMetadata& frame, std::vector<YoloDetection>* detections,
+                  FrameReport* report);
+  bool Expired(const FrameMetadata& frame) const;
+  bool CheckQuality(const FrameMetadata& frame, FrameReport* report);
+  void RecordLatency(Stage stage, const FrameMetadata& frame, uint64_t end_ns);
+  void ResolveOutputLayout();
+  void AdoptDecodeSettings();
+  bool Decode(std::vector<YoloDetection>* detections);
+  void ClassifyDetections(const std::vector<YoloDetection>& detections);
+  void PublishResults(const FrameMetadata& frame, const std::vector<YoloDetection>& detections,
+                      const FrameReport& report);
 
   EngineOptions options_;
-  TfLiteModel* model_ = nullptr;
-  TfLiteInterpreterOptions* interpreter_options_ = nullptr;
-  TfLiteInterpreter* interpreter_ = nullptr;
-  TfLiteDelegate* gpu_delegate_ = nullptr;
-  std::vector<uint8_t> rgb_buffer_;
-  std::vector<uint8_t> rotated_buffer_;
+  // Heap-allocated so Create() can place the threads that build the runtime
+  // before the engine exists; declared before |pool_|, whose workers use it.
+  std::unique_ptr<ThreadPlacement> placement_;
+  ModelHandle model_;
+  std::unique_ptr<InferenceRuntime> runtime_;
+  TuningResult tuning_;
+  ModelSwapper swapper_;
+  // Shares the interpreter's thread budget; idle while Run() is in progress.
+  ThreadPool pool_;
+  ScratchArena scratch_;
+  // Model-input resamplers for the geometries the stream has shown lately.
+  ResamplerCache resampler_;
+  int scratch_width_ = 0;
+  int scratch_height_ = 0;
+  int scratch_rotation_ = -1;
+  PixelFormat scratch_format_ = PixelFormat::kYuv420;
+  ChromaLayout chroma_layout_ = ChromaLayout::kGeneric;
+  bool stream_layout_known_ = false;
+  BoxTracker tracker_;
+  int frames_since_inference_ = 0;
+  CadenceGovernor governor_;
+  uint64_t last_invoke_ns_ = 0;
+  std::unique_ptr<CropClassifier> classifier_;
+  ClassificationCache classification_cache_;
+  std::vector<YoloClassification> classifications_;
+  std::vector<size_t> pending_crops_;
+  // Full-resolution, upright view of the current frame that preprocessing
+  // resized from; lives in |scratch_| until the next frame.
+  PixelView frame_view_;
+  bool frame_view_valid_ = false;
+  CaptureWriter capture_writer_;
+  CaptureRequest pending_capture_;
+  int32_t pending_capture_id_ = 0;
+  int32_t last_capture_id_ = 0;
+  FrameRing frame_ring_;
+  ZoomController zoom_;
+  Roi input_roi_;
+  size_t model_bytes_ = 0;
+  // Output tensor layout of |runtime_|'s model, resolved when it is created
+  // or swapped in.
+  DecodeLayout decode_layout_;
+  // Resolved for |decode_layout_|'s class count.
+  DecodeSettings decode_settings_;
+  LatestValue<DecodeSettings> pending_settings_;
+  std::unique_ptr<ResultChannel> results_;
   bool logged_shapes_ = false;
+  EngineStats stats_;
+  TraceRecorder trace_;
+  FrameRecorder recorder_;
+  uint64_t frame_seq_ = 0;
+  bool suspended_ = false;
+  float suspend_ms_ = 0.0f;
+  float resume_ms_ = 0.0f;
+  size_t suspend_released_bytes_ = 0;
 };
 
 }  // namespace yolo
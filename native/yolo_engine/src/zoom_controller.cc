@@ -0,0 +1,158 @@
+#include "zoom_controller.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "postprocess.h"
+
+namespace yolo {
+
+namespace {
+
+// Passes the target must survive, in the same place, before zooming on it.
+constexpr int kStablePasses = 3;
+constexpr float kMinMatchIoU = 0.4f;
+// The crop spans this multiple of the target's longer extent, so a moving
+// subject stays inside it until the next whole-frame pass recentres it.
+constexpr float kContext = 2.5f;
+constexpr float kMinSide = 0.3f;
+// Past this the crop gains too little resolution to be worth a pass.
+constexpr float kMaxSide = 0.75f;
+// The side is rounded up to a multiple of this many model pixels, so a
+// target drifting in size maps onto a few crop sizes and the resampler's
+// plans for them stay cached.
+constexpr int kSideStep = 32;
+
+// Sorts |detections| best-first and drops each box overlapping a
+// higher-scoring box of the same class by more than |iou_threshold|, as
+// DecodeDetections does. The stable sort keeps equal scores in pass order.
+void SuppressMerged(float iou_threshold, std::vector<YoloDetection>* detections) {
+  std::stable_sort(
+      detections->begin(), detections->end(),
+      [](const YoloDetection& a, const YoloDetection& b) { return a.score > b.score; });
+  size_t kept = 0;
+  for (size_t i = 0; i < detections->size(); ++i) {
+    const YoloDetection& box = (*detections)[i];
+    bool suppressed = false;
+    for (size_t k = 0; k < kept && !suppressed; ++k) {
+      const YoloDetection& other = (*detections)[k];
+      suppressed = other.class_index == box.class_index &&
+                   ComputeIoU(other, box) > iou_threshold;
+    }
+    if (!suppressed) {
+      (*detections)[kept++] = box;
+    }
+  }
+  detections->resize(kept);
+}
+
+}  // namespace
+
+void MapFromRoi(const Roi& roi, int model_width, int model_height,
+                std::vector<YoloDetection>* detections) {
+  const float offset_x = roi.left * model_width;
+  const float offset_y = roi.top * model_height;
+  const float scale_x = roi.width();
+  const float scale_y = roi.height();
+  for (YoloDetection& box : *detections) {
+    box.left = offset_x + box.left * scale_x;
+    box.top = offset_y + box.top * scale_y;
+    box.right = offset_x + box.right * scale_x;
+    box.bottom = offset_y + box.bottom * scale_y;
+  }
+}
+
+Roi ZoomController::NextRoi() const {
+  if (!has_target_ || stable_passes_ < kStablePasses || last_zoomed_) {
+    return Roi();
+  }
+  return zoom_roi_;
+}
+
+void ZoomController::Update(const Roi& roi, int model_width, int model_height,
+                            float iou_threshold, std::vector<YoloDetection>* detections) {
+  const bool zoomed = !roi.full();
+  const YoloDetection* match = has_target_ ? Match(*detections) : nullptr;
+  if (match != nullptr) {
+    target_ = *match;
+    ++stable_passes_;
+  } else if (zoomed) {
+    // Lost inside its own crop: it moved out or was never there.
+    has_target_ = false;
+    stable_passes_ = 0;
+  } else {
+    const auto best = std::max_element(
+        detections->begin(), detections->end(),
+        [](const YoloDetection& a, const YoloDetection& b) { return a.score < b.score; });
+    has_target_ = best != detections->end();
+    if (has_target_) {
+      target_ = *best;
+    }
+    stable_passes_ = has_target_ ? 1 : 0;
+  }
+
+  if (zoomed) {
+    const size_t found = detections->size();
+    for (const YoloDetection& box : full_pass_) {
+      const float center_x = (box.left + box.right) * 0.5f / model_width;
+      const float center_y = (box.top + box.bottom) * 0.5f / model_height;
+      if (center_x < roi.left || center_x >= roi.right || center_y < roi.top ||
+          center_y >= roi.bottom) {
+        detections->push_back(box);
+      }
+    }
+    if (detections->size() > found) {
+      SuppressMerged(iou_threshold, detections);
+    }
+  } else {
+    full_pass_.assign(detections->begin(), detections->end());
+  }
+  last_zoomed_ = zoomed;
+
+  zoom_roi_ = Roi();
+  if (!has_target_ || model_width <= 0 || model_height <= 0) {
+    return;
+  }
+  // Square in normalized coordinates, so the crop keeps the frame's aspect
+  // and the model sees the subject stretched exactly as on a full pass.
+  const float extent = std::max((target_.right - target_.left) / model_width,
+                                (target_.bottom - target_.top) / model_height);
+  const float step = static_cast<float>(kSideStep) / std::max(model_width, model_height);
+  // The slack keeps float error from pushing an exact multiple up a step.
+  const float side = std::ceil(std::max(extent * kContext, kMinSide) / step - 1e-3f) * step;
+  if (side > kMaxSide) {
+    return;
+  }
+  const float center_x = (target_.left + target_.right) * 0.5f / model_width;
+  const float center_y = (target_.top + target_.bottom) * 0.5f / model_height;
+  zoom_roi_.left = std::clamp(center_x - side * 0.5f, 0.0f, 1.0f - side);
+  zoom_roi_.top = std::clamp(center_y - side * 0.5f, 0.0f, 1.0f - side);
+  zoom_roi_.right = zoom_roi_.left + side;
+  zoom_roi_.bottom = zoom_roi_.top + side;
+}
+
+void ZoomController::Reset() {
+  has_target_ = false;
+  stable_passes_ = 0;
+  last_zoomed_ = false;
+  zoom_roi_ = Roi();
+  full_pass_.clear();
+}
+
+const YoloDetection* ZoomController::Match(const std::vector<YoloDetection>& detections) const {
+  const YoloDetection* match = nullptr;
+  float best_iou = kMinMatchIoU;
+  for (const YoloDetection& box : detections) {
+    if (box.class_index != target_.class_index) {
+      continue;
+    }
+    const float iou = ComputeIoU(box, target_);
+    if (iou >= best_iou) {
+      best_iou = iou;
+      match = &box;
+    }
+  }
+  return match;
+}
+
+}  // namespace yolo
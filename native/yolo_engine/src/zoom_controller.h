@@ -0,0 +1,64 @@
+#pragma once
+
+#include <vector>
+
+#include "yolo_engine_api.h"
+
+namespace yolo {
+
+// Normalized rectangle in upright frame coordinates; the default is the
+// whole frame.
+struct Roi {
+  float left = 0.0f;
+  float top = 0.0f;
+  float right = 1.0f;
+  float bottom = 1.0f;
+
+  bool full() const { return left <= 0.0f && top <= 0.0f && right >= 1.0f && bottom >= 1.0f; }
+  float width() const { return right - left; }
+  float height() const { return bottom - top; }
+};
+
+// Maps boxes detected on an |roi| crop (|model_width| x |model_height|
+// coordinates of the crop) back to the same coordinates of the full frame.
+void MapFromRoi(const Roi& roi, int model_width, int model_height,
+                std::vector<YoloDetection>* detections);
+
+// Chooses the region for each inferred frame in auto-zoom mode. Once the
+// best-scoring object has been found in the same place on several
+// consecutive passes, full-frame passes alternate with passes on a crop
+// centred on it, so the model sees the subject at a multiple of the
+// resolution it gets from the whole frame. Losing the subject on a zoomed
+// pass drops back to full frames until it is stable again.
+//
+// Zoomed passes only see their crop; detections from the last full pass that
+// lie outside it are carried over so other objects do not blink. The merged
+// set goes through class-wise NMS again and comes back best-first, like
+// DecodeDetections output.
+class ZoomController {
+ public:
+  ZoomController() = default;
+
+  // Region for the next inferred frame.
+  Roi NextRoi() const;
+  // Feeds the result of a pass over |roi| (already mapped to full-frame
+  // coordinates) and, for zoomed passes, merges in the carried-over
+  // detections, suppressing those overlapping a kept box of the same class
+  // by more than |iou_threshold|.
+  void Update(const Roi& roi, int model_width, int model_height, float iou_threshold,
+              std::vector<YoloDetection>* detections);
+  void Reset();
+
+ private:
+  // Finds the detection continuing the current target, if any.
+  const YoloDetection* Match(const std::vector<YoloDetection>& detections) const;
+
+  YoloDetection target_{};
+  bool has_target_ = false;
+  int stable_passes_ = 0;
+  bool last_zoomed_ = false;
+  Roi zoom_roi_;
+  std::vector<YoloDetection> full_pass_;
+};
+
+}  // namespace yolo
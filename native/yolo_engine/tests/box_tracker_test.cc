@@ -0,0 +1,137 @@
+// Tests for the box tracker (box_tracker.h): a textured frame shifted by a
+// known offset moves the tracked box by the same offset in model
+// coordinates, with and without a sensor rotation, and degenerate frames
+// neither anchor nor crash.
+//
+//   yolo_box_tracker_test
+
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include "box_tracker.h"
+#include "yolo_engine.h"
+
+namespace {
+
+#define CHECK(condition)                                                    \
+  do {                                                                      \
+    if (!(condition)) {                                                     \
+      std::fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, \
+                   #condition);                                             \
+      std::exit(1);                                                         \
+    }                                                                       \
+  } while (0)
+
+constexpr int kModelSize = 320;
+// Allowed error of the tracked centre, in model pixels.
+constexpr float kTolerance = 0.15f;
+
+// Smooth texture with corners everywhere, so every grid cell has features.
+double Texture(double x, double y) {
+  return 128.0 + 55.0 * std::sin(0.11 * x + 1.3 * std::sin(0.045 * y)) +
+         55.0 * std::cos(0.13 * y + 0.9 * std::sin(0.05 * x));
+}
+
+// YUV420 frame whose luma is the texture moved by (shift_x, shift_y) sensor
+// pixels; the tracker only reads luma.
+struct Frame {
+  std::vector<uint8_t> luma;
+  std::vector<uint8_t> chroma;
+  yolo::FrameMetadata metadata{};
+
+  Frame(int width, int height, int rotation, double shift_x, double shift_y)
+      : luma(static_cast<size_t>(width) * height),
+        chroma(static_cast<size_t>(width) * height / 2 + 2, 128) {
+    for (int y = 0; y < height; ++y) {
+      for (int x = 0; x < width; ++x) {
+        const double value = Texture(x - shift_x, y - shift_y);
+        luma[static_cast<size_t>(y) * width + x] =
+            static_cast<uint8_t>(std::lround(std::fmin(255.0, std::fmax(0.0, value))));
+      }
+    }
+    metadata.y_plane = luma.data();
+    metadata.u_plane = chroma.data();
+    metadata.v_plane = chroma.data() + 1;
+    metadata.width = width;
+    metadata.height = height;
+    metadata.y_row_stride = width;
+    metadata.uv_row_stride = width;
+    metadata.uv_pixel_stride = 2;
+    metadata.rotation_degrees = rotation;
+  }
+};
+
+YoloDetection Box(float left, float top, float right, float bottom) {
+  YoloDetection box{};
+  box.left = left;
+  box.top = top;
+  box.right = right;
+  box.bottom = bottom;
+  box.score = 0.9f;
+  box.class_index = 1;
+  return box;
+}
+
+// Tracks |box| from an unshifted frame onto one shifted by (shift_x,
+// shift_y) sensor pixels and checks it moved by (expect_x, expect_y) model
+// pixels at the same size.
+void CheckShift(int width, int height, int rotation, double shift_x, double shift_y,
+                float expect_x, float expect_y) {
+  const YoloDetection box = Box(100.0f, 90.0f, 200.0f, 210.0f);
+  const Frame anchor(width, height, rotation, 0.0, 0.0);
+  const Frame moved(width, height, rotation, shift_x, shift_y);
+  yolo::BoxTracker tracker;
+  tracker.Reset(anchor.metadata, kModelSize, kModelSize, {box});
+  CHECK(tracker.anchored());
+
+  std::vector<YoloDetection> tracked;
+  float confidence = 0.0f;
+  CHECK(tracker.Track(moved.metadata, &tracked, &confidence));
+  CHECK(tracked.size() == 1);
+  CHECK(confidence > 0.5f);
+  const YoloDetection& out = tracked[0];
+  CHECK(std::fabs(out.left - box.left - expect_x) < kTolerance);
+  CHECK(std::fabs(out.right - box.right - expect_x) < kTolerance);
+  CHECK(std::fabs(out.top - box.top - expect_y) < kTolerance);
+  CHECK(std::fabs(out.bottom - box.bottom - expect_y) < kTolerance);
+  CHECK(out.class_index == box.class_index && out.score == box.score);
+}
+
+void CheckDegenerateFrames() {
+  const std::vector<YoloDetection> boxes = {Box(10.0f, 10.0f, 50.0f, 50.0f)};
+  std::vector<YoloDetection> tracked;
+  float confidence = 1.0f;
+  yolo::BoxTracker tracker;
+
+  const Frame pixel(1, 1, 0, 0.0, 0.0);
+  tracker.Reset(pixel.metadata, kModelSize, kModelSize, boxes);
+  CHECK(!tracker.anchored());
+  CHECK(!tracker.Track(pixel.metadata, &tracked, &confidence));
+  CHECK(tracked.empty() && confidence == 0.0f);
+
+  // Anchored on a real frame, then handed a one-pixel-wide one.
+  const Frame anchor(64, 48, 90, 0.0, 0.0);
+  const Frame column(1, 48, 90, 0.0, 0.0);
+  tracker.Reset(anchor.metadata, kModelSize, kModelSize, boxes);
+  CHECK(tracker.anchored());
+  CHECK(tracker.Track(column.metadata, &tracked, &confidence));
+  CHECK(tracked.size() == 1);
+}
+
+}  // namespace
+
+int main() {
+  // 640x480 onto 320x320: half a model pixel per sensor pixel across,
+  // two thirds down.
+  CheckShift(640, 480, 0, 6.0, -4.5, 3.0f, -3.0f);
+  CheckShift(640, 480, 0, -3.0, 3.0, -1.5f, 2.0f);
+  // Rotated 90 degrees clockwise, sensor x runs down the upright frame and
+  // sensor y runs right to left across it.
+  CheckShift(640, 480, 90, 6.0, -4.5, 3.0f, 3.0f);
+  CheckDegenerateFrames();
+  std::puts("box tracker: ok");
+  return 0;
+}
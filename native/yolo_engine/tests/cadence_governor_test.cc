@@ -0,0 +1,171 @@
+// Tests for the cadence governor (cadence_governor.h) driven by synthetic
+// timestamps from a 30 fps camera: the fps and duty-cycle caps hold over a
+// long run, a spell without detections drops to the idle rate and a
+// detection snaps it back, drifting invoke latency throttles, and a stream
+// resumed after a long pause starts active rather than idle.
+//
+//   yolo_cadence_governor_test
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+
+#include "cadence_governor.h"
+
+namespace {
+
+#define CHECK(condition)                                                    \
+  do {                                                                      \
+    if (!(condition)) {                                                     \
+      std::fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, \
+                   #condition);                                             \
+      std::exit(1);                                                         \
+    }                                                                       \
+  } while (0)
+
+constexpr uint64_t kMs = 1'000'000ull;
+constexpr uint64_t kFrameNs = 33'333'333ull;
+
+// Camera frames and what the governor made of them.
+struct Stream {
+  yolo::CadenceGovernor* governor;
+  uint64_t now_ns = 1'000 * kMs;
+  uint64_t inference_ns = 20 * kMs;
+  uint64_t invoke_ns = 15 * kMs;
+  size_t detections = 1;
+
+  // Feeds |frames| camera frames; returns how many were inferred.
+  int Run(int frames) {
+    int inferred = 0;
+    for (int i = 0; i < frames; ++i, now_ns += kFrameNs) {
+      if (!governor->Due(now_ns)) {
+        continue;
+      }
+      governor->RecordInference(now_ns, now_ns + inference_ns, inference_ns, invoke_ns,
+                                detections);
+      ++inferred;
+    }
+    return inferred;
+  }
+};
+
+YoloGovernorState State(const yolo::CadenceGovernor& governor) {
+  YoloGovernorState state{};
+  governor.Snapshot(&state);
+  return state;
+}
+
+void TestFpsCap() {
+  yolo::CadenceBudget budget;
+  budget.max_fps = 10.0f;
+  yolo::CadenceGovernor governor;
+  governor.Configure(budget);
+  Stream stream{&governor};
+  // 20 s of camera frames.
+  const int inferred = stream.Run(600);
+  CHECK(inferred >= 190 && inferred <= 201);
+  const YoloGovernorState state = State(governor);
+  CHECK(state.mode == kYoloGovernorActive);
+  CHECK(state.limit == kYoloGovernorLimitMaxFps);
+}
+
+void TestDutyCycleCap() {
+  yolo::CadenceBudget budget;
+  budget.max_duty_cycle = 0.5f;
+  yolo::CadenceGovernor governor;
+  governor.Configure(budget);
+  Stream stream{&governor};
+  stream.inference_ns = 50 * kMs;
+  // 100 ms per inference at half the wall time: one every 100 ms.
+  const int inferred = stream.Run(600);
+  CHECK(inferred >= 190 && inferred <= 201);
+  CHECK(State(governor).limit == kYoloGovernorLimitDutyCycle);
+}
+
+void TestIdle() {
+  yolo::CadenceBudget budget;
+  budget.max_fps = 10.0f;
+  budget.idle_after_ms = 3000;
+  budget.idle_fps = 2.0f;
+  yolo::CadenceGovernor governor;
+  governor.Configure(budget);
+  Stream stream{&governor};
+  stream.Run(30);
+  stream.detections = 0;
+  // Still active until the idle delay has passed.
+  stream.Run(60);
+  CHECK(State(governor).mode == kYoloGovernorActive);
+  stream.Run(60);
+  CHECK(State(governor).mode == kYoloGovernorIdle);
+  CHECK(State(governor).limit == kYoloGovernorLimitIdle);
+  // 10 s idle at 2 fps.
+  const int idle = stream.Run(300);
+  CHECK(idle >= 19 && idle <= 21);
+  // A detection on the next idle inference snaps back to the active rate.
+  stream.detections = 1;
+  stream.Run(15);
+  CHECK(State(governor).mode == kYoloGovernorActive);
+  const int active = stream.Run(300);
+  CHECK(active >= 95 && active <= 101);
+}
+
+void TestThrottle() {
+  yolo::CadenceBudget budget;
+  budget.max_fps = 10.0f;
+  yolo::CadenceGovernor governor;
+  governor.Configure(budget);
+  Stream stream{&governor};
+  stream.Run(150);
+  CHECK(State(governor).mode == kYoloGovernorActive);
+  // Invoke latency doubles, as on a hot device.
+  stream.invoke_ns *= 2;
+  stream.Run(150);
+  YoloGovernorState state = State(governor);
+  CHECK(state.mode == kYoloGovernorThrottled);
+  CHECK(state.limit == kYoloGovernorLimitThermal);
+  CHECK(state.interval_ms > 150.0f);
+  // A new model starts from a fresh baseline.
+  governor.ResetBaseline();
+  stream.Run(150);
+  CHECK(State(governor).mode == kYoloGovernorActive);
+}
+
+void TestResumeAfterPause() {
+  yolo::CadenceBudget budget;
+  budget.max_fps = 10.0f;
+  budget.idle_after_ms = 3000;
+  budget.idle_fps = 2.0f;
+  yolo::CadenceGovernor governor;
+  governor.Configure(budget);
+  Stream stream{&governor};
+  stream.Run(90);
+  CHECK(State(governor).mode == kYoloGovernorActive);
+
+  // Suspended for a minute, then resumed into a scene with nothing in it.
+  stream.now_ns += 60'000 * kMs;
+  governor.ResetBaseline();
+  governor.ResetActivity();
+  CHECK(State(governor).mode == kYoloGovernorActive);
+  stream.detections = 0;
+  CHECK(stream.Run(1) == 1);
+  YoloGovernorState state = State(governor);
+  CHECK(state.mode == kYoloGovernorActive);
+  CHECK(state.limit == kYoloGovernorLimitMaxFps);
+  // The idle delay counts from the resume.
+  stream.Run(60);
+  CHECK(State(governor).mode == kYoloGovernorActive);
+  stream.Run(60);
+  CHECK(State(governor).mode == kYoloGovernorIdle);
+}
+
+}  // namespace
+
+int main() {
+  TestFpsCap();
+  TestDutyCycleCap();
+  TestIdle();
+  TestThrottle();
+  TestResumeAfterPause();
+  std::puts("cadence governor: ok");
+  return 0;
+}
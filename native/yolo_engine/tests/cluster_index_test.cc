@@ -0,0 +1,149 @@
+// Tests for the cluster index (cluster_index_api.h) against brute force:
+// every zoom accounts for every point exactly once, viewport and
+// antimeridian queries at point level return exactly the points inside,
+// and coincident points stay one cluster up to the deepest zoom.
+//
+//   yolo_cluster_index_test
+
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+#include "cluster_index_api.h"
+
+namespace {
+
+#define CHECK(condition)                                                    \
+  do {                                                                      \
+    if (!(condition)) {                                                     \
+      std::fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, \
+                   #condition);                                             \
+      std::exit(1);                                                         \
+    }                                                                       \
+  } while (0)
+
+constexpr int kPoints = 5000;
+constexpr int kDuplicates = 5;
+constexpr int kMaxZoom = 16;
+// Duplicate points sit here.
+constexpr double kDuplicateLatitude = 10.0;
+constexpr double kDuplicateLongitude = 20.0;
+
+struct Box {
+  double west;
+  double south;
+  double east;
+  double north;
+};
+
+bool Inside(const Box& box, double latitude, double longitude) {
+  if (latitude < box.south || latitude > box.north) {
+    return false;
+  }
+  if (box.west <= box.east) {
+    return longitude >= box.west && longitude <= box.east;
+  }
+  return longitude >= box.west || longitude <= box.east;
+}
+
+// Queries |query| at point level, where every marker is one point, and
+// checks that exactly the points inside |box| come back.
+void CheckPointLevel(void* index, const std::vector<double>& coordinates, const Box& query,
+                     const Box& box) {
+  const YoloCluster* clusters = nullptr;
+  const int32_t count = YoloClusterIndexQuery(index, query.west, query.south, query.east,
+                                              query.north, kMaxZoom + 1, &clusters);
+  CHECK(count >= 0);
+  std::vector<int> seen(coordinates.size() / 2, 0);
+  for (int32_t i = 0; i < count; ++i) {
+    CHECK(clusters[i].count == 1);
+    CHECK(clusters[i].point >= 0 && clusters[i].point < static_cast<int32_t>(seen.size()));
+    ++seen[clusters[i].point];
+  }
+  int expected = 0;
+  for (size_t point = 0; point < seen.size(); ++point) {
+    const bool inside = Inside(box, coordinates[2 * point], coordinates[2 * point + 1]);
+    CHECK(seen[point] == (inside ? 1 : 0));
+    expected += inside ? 1 : 0;
+  }
+  CHECK(count == expected);
+  CHECK(expected > 0);
+}
+
+void CheckPointLevel(void* index, const std::vector<double>& coordinates, const Box& box) {
+  CheckPointLevel(index, coordinates, box, box);
+}
+
+}  // namespace
+
+int main() {
+  std::mt19937 rng(3);
+  std::uniform_real_distribution<double> latitude(-60.0, 60.0);
+  std::uniform_real_distribution<double> longitude(-180.0, 180.0);
+  std::vector<double> coordinates;
+  for (int i = 0; i < kPoints; ++i) {
+    coordinates.push_back(latitude(rng));
+    coordinates.push_back(longitude(rng));
+  }
+  for (int i = 0; i < kDuplicates; ++i) {
+    coordinates.push_back(kDuplicateLatitude);
+    coordinates.push_back(kDuplicateLongitude);
+  }
+  const int located = kPoints + kDuplicates;
+  // Skipped by the index, but it keeps its position in the numbering.
+  coordinates.push_back(NAN);
+  coordinates.push_back(0.0);
+
+  void* index = YoloClusterIndexCreate(40.0f, 256, kMaxZoom);
+  CHECK(index != nullptr);
+  CHECK(YoloClusterIndexLoad(index, coordinates.data(),
+                             static_cast<int32_t>(coordinates.size() / 2)) == 0);
+
+  const YoloCluster* clusters = nullptr;
+  int32_t previous_markers = 0;
+  for (int zoom = 0; zoom <= kMaxZoom + 1; ++zoom) {
+    const int32_t count = YoloClusterIndexQuery(index, -180.0, -90.0, 180.0, 90.0, zoom, &clusters);
+    CHECK(count > 0);
+    int64_t points = 0;
+    for (int32_t i = 0; i < count; ++i) {
+      points += clusters[i].count;
+      // A cluster splits deeper; a lone point is a point at every zoom.
+      if (clusters[i].count > 1) {
+        CHECK(clusters[i].expansion_zoom > zoom && clusters[i].expansion_zoom <= kMaxZoom + 1);
+      } else {
+        CHECK(clusters[i].expansion_zoom == kMaxZoom + 1);
+      }
+    }
+    CHECK(points == located);
+    CHECK(count >= previous_markers);
+    previous_markers = count;
+  }
+
+  CheckPointLevel(index, coordinates, {10.0, 0.0, 30.0, 20.0});
+  CheckPointLevel(index, coordinates, {-75.5, -33.3, -60.25, -12.0});
+  CheckPointLevel(index, coordinates, {170.0, -10.0, -170.0, 10.0});
+  CheckPointLevel(index, coordinates, {179.5, -60.0, -179.5, 60.0});
+  // Unwrapped longitudes, as the map's padded window passes them.
+  CheckPointLevel(index, coordinates, {160.0, -10.0, 200.0, 10.0}, {160.0, -10.0, -160.0, 10.0});
+  CheckPointLevel(index, coordinates, {-200.0, 30.0, -150.0, 50.0}, {160.0, 30.0, -150.0, 50.0});
+
+  const int32_t count = YoloClusterIndexQuery(index, kDuplicateLongitude - 0.01,
+                                              kDuplicateLatitude - 0.01,
+                                              kDuplicateLongitude + 0.01,
+                                              kDuplicateLatitude + 0.01, kMaxZoom, &clusters);
+  CHECK(count == 1);
+  CHECK(clusters[0].count == kDuplicates);
+  CHECK(clusters[0].expansion_zoom == kMaxZoom + 1);
+  CHECK(std::fabs(clusters[0].latitude - kDuplicateLatitude) < 1e-9);
+  CHECK(std::fabs(clusters[0].longitude - kDuplicateLongitude) < 1e-9);
+
+  CHECK(YoloClusterIndexLoad(index, nullptr, 0) == 0);
+  CHECK(YoloClusterIndexQuery(index, -180.0, -90.0, 180.0, 90.0, 3, &clusters) == 0);
+  CHECK(YoloClusterIndexQuery(index, NAN, -90.0, 180.0, 90.0, 3, &clusters) == -1);
+  YoloClusterIndexDestroy(index);
+  std::puts("cluster index: ok");
+  return 0;
+}
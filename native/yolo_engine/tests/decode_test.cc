@@ -0,0 +1,218 @@
+// Tests for detection decoding (postprocess.h): output shapes resolve to the
+// right layout, and a hand-built tensor decodes to the same boxes in either
+// layout, for specialised and generic class counts, with or without a
+// thread pool, and classes masked out never show up or outscore an enabled
+// class.
+//
+//   yolo_decode_test
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include "postprocess.h"
+#include "scratch_arena.h"
+#include "thread_pool.h"
+#include "yolo_engine.h"
+
+namespace {
+
+#define CHECK(condition)                                                    \
+  do {                                                                      \
+    if (!(condition)) {                                                     \
+      std::fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, \
+                   #condition);                                             \
+      std::exit(1);                                                         \
+    }                                                                       \
+  } while (0)
+
+// Enough predictions for several decode bands on a pool.
+constexpr int kPredictions = 300;
+// Every class of every other prediction scores this, below any threshold.
+constexpr float kBackground = 0.01f;
+
+struct Prediction {
+  int index;
+  float cx;
+  float cy;
+  float w;
+  float h;
+  int class_index;
+  float score;
+};
+
+// Predictions in pixels of the default 640x640 input. 0 and 1 overlap with
+// the same class, so NMS keeps only 0; 2 overlaps 0 with another class and
+// survives; 3 is below the threshold.
+const std::vector<Prediction>& Predictions() {
+  static const std::vector<Prediction> predictions = {
+      {17, 100.0f, 100.0f, 80.0f, 60.0f, 1, 0.9f},
+      {140, 104.0f, 102.0f, 80.0f, 60.0f, 1, 0.7f},
+      {205, 102.0f, 101.0f, 80.0f, 60.0f, 2, 0.6f},
+      {260, 400.0f, 300.0f, 50.0f, 50.0f, 0, 0.2f},
+      {299, 500.0f, 520.0f, 120.0f, 90.0f, 0, 0.8f},
+  };
+  return predictions;
+}
+
+float& At(std::vector<float>* tensor, yolo::OutputLayout layout, int channels, int channel,
+          int prediction) {
+  const size_t index = layout == yolo::OutputLayout::kChannelMajor
+                           ? static_cast<size_t>(channel) * kPredictions + prediction
+                           : static_cast<size_t>(prediction) * channels + channel;
+  return (*tensor)[index];
+}
+
+std::vector<float> BuildTensor(yolo::OutputLayout layout, int classes) {
+  const int channels = 4 + classes;
+  std::vector<float> tensor(static_cast<size_t>(channels) * kPredictions, kBackground);
+  for (int i = 0; i < kPredictions; ++i) {
+    At(&tensor, layout, channels, 0, i) = 320.0f;
+    At(&tensor, layout, channels, 1, i) = 320.0f;
+    At(&tensor, layout, channels, 2, i) = 10.0f;
+    At(&tensor, layout, channels, 3, i) = 10.0f;
+  }
+  for (const Prediction& p : Predictions()) {
+    At(&tensor, layout, channels, 0, p.index) = p.cx;
+    At(&tensor, layout, channels, 1, p.index) = p.cy;
+    At(&tensor, layout, channels, 2, p.index) = p.w;
+    At(&tensor, layout, channels, 3, p.index) = p.h;
+    At(&tensor, layout, channels, 4 + p.class_index, p.index) = p.score;
+  }
+  return tensor;
+}
+
+std::vector<int> Shape(yolo::OutputLayout layout, int classes) {
+  if (layout == yolo::OutputLayout::kChannelMajor) {
+    return {1, 4 + classes, kPredictions};
+  }
+  return {1, kPredictions, 4 + classes};
+}
+
+std::vector<YoloDetection> Decode(yolo::OutputLayout layout, int classes,
+                                  const std::vector<float>& tensor,
+                                  const yolo::DecodeSettings& settings, yolo::ThreadPool* pool) {
+  const yolo::DecodeLayout resolved = yolo::ResolveDecodeLayout(Shape(layout, classes));
+  CHECK(resolved.valid());
+  yolo::ScratchArena arena;
+  arena.Reserve(yolo::DecodeScratchBytes(resolved));
+  std::vector<YoloDetection> results;
+  yolo::DecodeDetections(tensor.data(), tensor.size(), resolved, yolo::EngineOptions(), settings,
+                         &arena, &results, pool);
+  return results;
+}
+
+bool Same(const YoloDetection& a, const YoloDetection& b) {
+  return a.left == b.left && a.top == b.top && a.right == b.right && a.bottom == b.bottom &&
+         a.score == b.score && a.class_index == b.class_index;
+}
+
+void CheckBox(const YoloDetection& box, const Prediction& p) {
+  CHECK(box.class_index == p.class_index);
+  CHECK(box.score == p.score);
+  CHECK(std::fabs(box.left - (p.cx - p.w / 2)) < 1e-3f);
+  CHECK(std::fabs(box.top - (p.cy - p.h / 2)) < 1e-3f);
+  CHECK(std::fabs(box.right - (p.cx + p.w / 2)) < 1e-3f);
+  CHECK(std::fabs(box.bottom - (p.cy + p.h / 2)) < 1e-3f);
+}
+
+void TestResolve() {
+  yolo::DecodeLayout layout = yolo::ResolveDecodeLayout({1, 84, 8400});
+  CHECK(layout.valid() && layout.layout == yolo::OutputLayout::kChannelMajor);
+  CHECK(layout.channels == 84 && layout.num_pred == 8400);
+  layout = yolo::ResolveDecodeLayout({1, 8400, 84});
+  CHECK(layout.valid() && layout.layout == yolo::OutputLayout::kAnchorMajor);
+  CHECK(layout.channels == 84 && layout.num_pred == 8400);
+  // Unit axes are squeezed out.
+  layout = yolo::ResolveDecodeLayout({1, 1, 2100, 6});
+  CHECK(layout.valid() && layout.layout == yolo::OutputLayout::kAnchorMajor);
+  CHECK(layout.channels == 6 && layout.num_pred == 2100);
+  CHECK(!yolo::ResolveDecodeLayout({84, 8400}).valid());
+  CHECK(!yolo::ResolveDecodeLayout({1, 4, 8400}).valid());
+  CHECK(!yolo::ResolveDecodeLayout({1, 3, 84, 8400}).valid());
+  CHECK(yolo::DecodeScratchBytes(yolo::DecodeLayout()) == 0);
+}
+
+// 3 classes use a specialised kernel, 7 the generic one.
+void TestLayouts(int classes, yolo::ThreadPool* pool) {
+  const yolo::DecodeSettings settings;
+  const std::vector<YoloDetection> channel_major =
+      Decode(yolo::OutputLayout::kChannelMajor, classes,
+             BuildTensor(yolo::OutputLayout::kChannelMajor, classes), settings, nullptr);
+  const std::vector<YoloDetection> anchor_major =
+      Decode(yolo::OutputLayout::kAnchorMajor, classes,
+             BuildTensor(yolo::OutputLayout::kAnchorMajor, classes), settings, nullptr);
+  const std::vector<Prediction>& p = Predictions();
+  // Best first: 0, 4, then 2, which a different class keeps beside 0.
+  CHECK(channel_major.size() == 3);
+  CheckBox(channel_major[0], p[0]);
+  CheckBox(channel_major[1], p[4]);
+  CheckBox(channel_major[2], p[2]);
+  CHECK(anchor_major.size() == channel_major.size());
+  for (size_t i = 0; i < channel_major.size(); ++i) {
+    CHECK(Same(anchor_major[i], channel_major[i]));
+  }
+  // Split into bands across the pool, either layout decodes the same.
+  for (const yolo::OutputLayout layout :
+       {yolo::OutputLayout::kChannelMajor, yolo::OutputLayout::kAnchorMajor}) {
+    const std::vector<YoloDetection> banded =
+        Decode(layout, classes, BuildTensor(layout, classes), settings, pool);
+    CHECK(banded.size() == channel_major.size());
+    for (size_t i = 0; i < banded.size(); ++i) {
+      CHECK(Same(banded[i], channel_major[i]));
+    }
+  }
+}
+
+// Masks class 1 while prediction 0 also scores 0.5 for class 0: the
+// masked 0.9 must neither appear nor hide the enabled class behind it.
+void TestMask(yolo::OutputLayout layout, int classes, yolo::ThreadPool* pool) {
+  const int channels = 4 + classes;
+  const std::vector<Prediction>& p = Predictions();
+  std::vector<float> tensor = BuildTensor(layout, classes);
+  At(&tensor, layout, channels, 4 + 0, p[0].index) = 0.5f;
+
+  yolo::DecodeSettings settings;
+  settings.class_enabled.assign(static_cast<size_t>(classes), 1);
+  settings.class_enabled[1] = 0;
+  settings.Resolve(classes);
+  std::vector<YoloDetection> results = Decode(layout, classes, tensor, settings, pool);
+  CHECK(results.size() == 3);
+  CheckBox(results[0], p[4]);
+  CheckBox(results[1], p[2]);
+  Prediction relabelled = p[0];
+  relabelled.class_index = 0;
+  relabelled.score = 0.5f;
+  CheckBox(results[2], relabelled);
+
+  // An allow list shorter than the class count disables the rest, here
+  // class 2 and up.
+  settings.class_enabled = {1, 0};
+  settings.Resolve(classes);
+  results = Decode(layout, classes, tensor, settings, pool);
+  CHECK(results.size() == 2);
+  CheckBox(results[0], p[4]);
+  CheckBox(results[1], relabelled);
+  for (const YoloDetection& box : results) {
+    CHECK(box.class_index == 0);
+  }
+}
+
+}  // namespace
+
+int main() {
+  TestResolve();
+  yolo::ThreadPool pool(3);
+  TestLayouts(3, &pool);
+  TestLayouts(7, &pool);
+  for (const yolo::OutputLayout layout :
+       {yolo::OutputLayout::kChannelMajor, yolo::OutputLayout::kAnchorMajor}) {
+    for (const int classes : {3, 7}) {
+      TestMask(layout, classes, nullptr);
+      TestMask(layout, classes, &pool);
+    }
+  }
+  std::puts("decode: ok");
+  return 0;
+}
@@ -0,0 +1,289 @@
+// Tests for the observation store (observation_store_api.h): round trips of
+// the fixed fields, replacement and erasure, reopening from the clean-close
+// index, recovery from a torn tail, bulk erasure keeping the put order,
+// compaction and rejection of foreign files.
+//
+//   yolo_observation_store_test [scratch_dir]
+
+#include <unistd.h>
+
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "observation_store_api.h"
+
+namespace {
+
+#define CHECK(condition)                                                    \
+  do {                                                                      \
+    if (!(condition)) {                                                     \
+      std::fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, \
+                   #condition);                                             \
+      std::exit(1);                                                         \
+    }                                                                       \
+  } while (0)
+
+constexpr int kRecords = 500;
+
+std::string Key(int i) { return "obs-" + std::to_string(i); }
+
+YoloStoreRecord MakeRecord(int i) {
+  YoloStoreRecord record{};
+  record.created_at_us = 1700000000000000LL + i;
+  record.latitude = -45.0 + i * 0.125;
+  record.longitude = 170.0 - i * 0.25;
+  // Not representable as a float, so a narrowing store would show.
+  record.accuracy_meters = 3.0 + i / 3.0;
+  record.class_index = i % 7;
+  record.flags = YOLO_STORE_HAS_CLASS_INDEX | (i % 2 == 0 ? YOLO_STORE_HAS_LOCATION : 0u);
+  return record;
+}
+
+std::string Payload(int i, size_t bytes) {
+  return std::string(bytes, static_cast<char>('a' + i % 26));
+}
+
+void Put(void* store, int i, const YoloStoreRecord& record, const std::string& payload) {
+  const std::string key = Key(i);
+  CHECK(YoloStorePut(store, reinterpret_cast<const uint8_t*>(key.data()),
+                     static_cast<int32_t>(key.size()), &record,
+                     reinterpret_cast<const uint8_t*>(payload.data()),
+                     static_cast<int32_t>(payload.size())) == 0);
+}
+
+const YoloStoreEntry* Find(const YoloStoreEntry* entries, int32_t count, int i) {
+  const std::string key = Key(i);
+  for (int32_t e = 0; e < count; ++e) {
+    if (std::string(reinterpret_cast<const char*>(entries[e].key), entries[e].key_bytes) == key) {
+      return &entries[e];
+    }
+  }
+  return nullptr;
+}
+
+bool SameRecord(const YoloStoreRecord& a, const YoloStoreRecord& b) {
+  return a.created_at_us == b.created_at_us && a.latitude == b.latitude &&
+         a.longitude == b.longitude && a.accuracy_meters == b.accuracy_meters &&
+         a.class_index == b.class_index && a.flags == b.flags;
+}
+
+YoloStoreStats Stats(void* store) {
+  YoloStoreStats stats{};
+  CHECK(YoloStoreGetStats(store, &stats) == 0);
+  return stats;
+}
+
+std::string ReadFile(const std::string& path) {
+  std::ifstream in(path, std::ios::binary);
+  return std::string(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+}
+
+void WriteFile(const std::string& path, const std::string& bytes) {
+  std::ofstream out(path, std::ios::binary | std::ios::trunc);
+  out.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+}
+
+void TestRoundTrip(const std::string& path) {
+  unlink(path.c_str());
+  void* store = YoloStoreOpen(path.c_str());
+  CHECK(store != nullptr);
+  for (int i = 0; i < kRecords; ++i) {
+    Put(store, i, MakeRecord(i), Payload(i, 100));
+  }
+  YoloStoreRecord unknown = MakeRecord(kRecords);
+  unknown.accuracy_meters = NAN;
+  unknown.flags = 0;
+  Put(store, kRecords, unknown, "");
+
+  const YoloStoreEntry* entries = nullptr;
+  CHECK(YoloStoreAcquire(store, 0, &entries) == kRecords + 1);
+  CHECK(YoloStoreAcquire(store, YOLO_STORE_HAS_LOCATION, &entries) == kRecords / 2);
+  for (int32_t e = 0; e < kRecords / 2; ++e) {
+    CHECK(entries[e].record.flags & YOLO_STORE_HAS_LOCATION);
+  }
+  const int32_t count = YoloStoreAcquire(store, 0, &entries);
+  for (int i = 0; i < kRecords; ++i) {
+    const YoloStoreEntry* entry = Find(entries, count, i);
+    CHECK(entry != nullptr);
+    CHECK(SameRecord(entry->record, MakeRecord(i)));
+    CHECK(std::string(reinterpret_cast<const char*>(entry->payload), entry->payload_bytes) ==
+          Payload(i, 100));
+  }
+  const YoloStoreEntry* last = Find(entries, count, kRecords);
+  CHECK(last != nullptr && std::isnan(last->record.accuracy_meters) && last->payload_bytes == 0);
+  CHECK(Stats(store).opened_from_index == 0);
+  YoloStoreClose(store);
+
+  store = YoloStoreOpen(path.c_str());
+  CHECK(store != nullptr);
+  CHECK(Stats(store).opened_from_index == 1);
+  CHECK(YoloStoreAcquire(store, 0, &entries) == kRecords + 1);
+  const YoloStoreEntry* entry = Find(entries, kRecords + 1, kRecords - 1);
+  CHECK(entry != nullptr && SameRecord(entry->record, MakeRecord(kRecords - 1)));
+  YoloStoreClose(store);
+}
+
+void TestReplaceEraseAndTornTail(const std::string& path) {
+  void* store = YoloStoreOpen(path.c_str());
+  CHECK(store != nullptr);
+  YoloStoreRecord replaced = MakeRecord(3);
+  replaced.created_at_us = 42;
+  Put(store, 3, replaced, Payload(3, 50));
+  const std::string erased = Key(4);
+  CHECK(YoloStoreErase(store, reinterpret_cast<const uint8_t*>(erased.data()),
+                       static_cast<int32_t>(erased.size())) == 0);
+
+  const YoloStoreEntry* entries = nullptr;
+  int32_t count = YoloStoreAcquire(store, 0, &entries);
+  CHECK(count == kRecords);
+  CHECK(Find(entries, count, 4) == nullptr);
+  const YoloStoreEntry* entry = Find(entries, count, 3);
+  CHECK(entry != nullptr && entry->record.created_at_us == 42 && entry->payload_bytes == 50);
+
+  // A copy taken while the store is open has no index, as after a crash.
+  // Cutting into the erase record leaves it torn; the scan drops it.
+  const std::string torn_path = path + ".torn";
+  const std::string bytes = ReadFile(path);
+  WriteFile(torn_path, bytes.substr(0, bytes.size() - 30));
+  void* torn = YoloStoreOpen(torn_path.c_str());
+  CHECK(torn != nullptr);
+  const YoloStoreStats stats = Stats(torn);
+  CHECK(stats.opened_from_index == 0);
+  CHECK(stats.recovered_bytes > 0);
+  count = YoloStoreAcquire(torn, 0, &entries);
+  CHECK(count == kRecords + 1);
+  CHECK(Find(entries, count, 4) != nullptr);
+  entry = Find(entries, count, 3);
+  CHECK(entry != nullptr && entry->record.created_at_us == 42);
+  YoloStoreClose(torn);
+  unlink(torn_path.c_str());
+  YoloStoreClose(store);
+}
+
+void Erase(void* store, int i) {
+  const std::string key = Key(i);
+  CHECK(YoloStoreErase(store, reinterpret_cast<const uint8_t*>(key.data()),
+                       static_cast<int32_t>(key.size())) == 0);
+}
+
+// Entries must be the keys in |expected|, in that order.
+void CheckOrder(void* store, const std::vector<int>& expected) {
+  const YoloStoreEntry* entries = nullptr;
+  const int32_t count = YoloStoreAcquire(store, 0, &entries);
+  CHECK(count == static_cast<int32_t>(expected.size()));
+  for (int32_t e = 0; e < count; ++e) {
+    CHECK(std::string(reinterpret_cast<const char*>(entries[e].key), entries[e].key_bytes) ==
+          Key(expected[e]));
+  }
+}
+
+void TestBulkErase(const std::string& path) {
+  unlink(path.c_str());
+  void* store = YoloStoreOpen(path.c_str());
+  CHECK(store != nullptr);
+  constexpr int kBulk = 20000;
+  for (int i = 0; i < kBulk; ++i) {
+    Put(store, i, MakeRecord(i), "");
+  }
+  // Every key not a multiple of 3, so the erased slots are dropped several
+  // times along the way, then a replacement that keeps its place.
+  std::vector<int> expected;
+  for (int i = 0; i < kBulk; ++i) {
+    if (i % 3 == 0) {
+      expected.push_back(i);
+    } else {
+      Erase(store, i);
+    }
+  }
+  Put(store, 3, MakeRecord(3), "again");
+  CheckOrder(store, expected);
+  CHECK(Stats(store).live_records == static_cast<int64_t>(expected.size()));
+
+  // Reopened by a scan of a copy taken while open, then from the index.
+  const std::string copy_path = path + ".copy";
+  WriteFile(copy_path, ReadFile(path));
+  void* copy = YoloStoreOpen(copy_path.c_str());
+  CHECK(copy != nullptr);
+  CHECK(Stats(copy).opened_from_index == 0);
+  CheckOrder(copy, expected);
+  YoloStoreClose(copy);
+  unlink(copy_path.c_str());
+  YoloStoreClose(store);
+  store = YoloStoreOpen(path.c_str());
+  CHECK(store != nullptr);
+  CHECK(Stats(store).opened_from_index == 1);
+  CheckOrder(store, expected);
+  YoloStoreClose(store);
+  unlink(path.c_str());
+}
+
+void TestCompaction(const std::string& path) {
+  void* store = YoloStoreOpen(path.c_str());
+  CHECK(store != nullptr);
+  for (int round = 1; round <= 3; ++round) {
+    for (int i = 0; i < kRecords; ++i) {
+      YoloStoreRecord record = MakeRecord(i);
+      record.created_at_us += round;
+      Put(store, i, record, Payload(i + round, 200));
+    }
+  }
+  const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+  while (Stats(store).compactions == 0 && std::chrono::steady_clock::now() < deadline) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  CHECK(Stats(store).compactions > 0);
+  YoloStoreClose(store);
+
+  store = YoloStoreOpen(path.c_str());
+  CHECK(store != nullptr);
+  const YoloStoreEntry* entries = nullptr;
+  const int32_t count = YoloStoreAcquire(store, 0, &entries);
+  CHECK(count == kRecords + 1);
+  for (int i = 0; i < kRecords; ++i) {
+    const YoloStoreEntry* entry = Find(entries, count, i);
+    CHECK(entry != nullptr);
+    CHECK(entry->record.created_at_us == MakeRecord(i).created_at_us + 3);
+    CHECK(std::string(reinterpret_cast<const char*>(entry->payload), entry->payload_bytes) ==
+          Payload(i + 3, 200));
+  }
+
+  CHECK(YoloStoreClear(store) == 0);
+  CHECK(YoloStoreAcquire(store, 0, &entries) == 0);
+  Put(store, 7, MakeRecord(7), "x");
+  YoloStoreClose(store);
+  store = YoloStoreOpen(path.c_str());
+  CHECK(store != nullptr);
+  CHECK(YoloStoreAcquire(store, 0, &entries) == 1);
+  CHECK(SameRecord(entries[0].record, MakeRecord(7)));
+  YoloStoreClose(store);
+  unlink(path.c_str());
+}
+
+void TestRejectsForeignFile(const std::string& path) {
+  WriteFile(path, "not a record log");
+  CHECK(YoloStoreOpen(path.c_str()) == nullptr);
+  CHECK(ReadFile(path) == "not a record log");
+  unlink(path.c_str());
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  const std::string directory = argc > 1 ? argv[1] : ".";
+  const std::string path = directory + "/observation_store_test.log";
+  TestRoundTrip(path);
+  TestReplaceEraseAndTornTail(path);
+  TestBulkErase(directory + "/observation_store_test.bulk");
+  TestCompaction(path);
+  TestRejectsForeignFile(directory + "/observation_store_test.junk");
+  std::puts("observation store: ok");
+  return 0;
+}
@@ -0,0 +1,198 @@
+// Tests for the fixed-point resampler (resampler.h) against a reference area
+// filter in double precision: shrinking averages each output pixel's exact
+// source footprint, flat input comes out exact, a folded rotation only moves
+// pixels, and splitting the rows across a pool changes nothing.
+//
+//   yolo_resampler_test
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+#include "image_utils.h"
+#include "resampler.h"
+#include "thread_pool.h"
+
+namespace {
+
+#define CHECK(condition)                                                    \
+  do {                                                                      \
+    if (!(condition)) {                                                     \
+      std::fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, \
+                   #condition);                                             \
+      std::exit(1);                                                         \
+    }                                                                       \
+  } while (0)
+
+// 2.14 weights on both axes plus the 7-bit row rounding stay within a
+// twentieth of one 8-bit step; a wrong footprint is off by far more.
+constexpr double kTolerance = 0.05 / 255.0;
+
+struct Image {
+  int width;
+  int height;
+  int pixel_stride;
+  std::vector<uint8_t> bytes;
+
+  yolo::PixelView View() const {
+    yolo::PixelView view;
+    view.data = bytes.data();
+    view.width = width;
+    view.height = height;
+    view.row_stride = width * pixel_stride;
+    view.pixel_stride = pixel_stride;
+    // Four-byte pixels are BGRA, as camera frames are.
+    view.channel = pixel_stride == 4 ? std::array<int, 3>{2, 1, 0} : std::array<int, 3>{0, 1, 2};
+    return view;
+  }
+
+  int At(int x, int y, int c) const {
+    const yolo::PixelView view = View();
+    return bytes[static_cast<size_t>(y) * view.row_stride +
+                 static_cast<size_t>(x) * pixel_stride + view.channel[c]];
+  }
+};
+
+Image Noise(int width, int height, int pixel_stride, uint32_t seed) {
+  std::mt19937 rng(seed);
+  std::uniform_int_distribution<int> byte(0, 255);
+  Image image{width, height, pixel_stride, {}};
+  image.bytes.resize(static_cast<size_t>(width) * height * pixel_stride);
+  for (uint8_t& value : image.bytes) {
+    value = static_cast<uint8_t>(byte(rng));
+  }
+  return image;
+}
+
+// Share of source sample |s| in output sample |i| when |src| samples shrink
+// to |dst|: the overlap of [s, s + 1) with the footprint, over its length.
+double AreaWeight(int s, int i, int src, int dst) {
+  const double scale = static_cast<double>(src) / dst;
+  const double overlap = std::min<double>(s + 1, (i + 1) * scale) - std::max<double>(s, i * scale);
+  return std::max(0.0, overlap) / scale;
+}
+
+// Reference for channel |c| of unrotated output pixel (x, y), in [0, 1].
+double ReferenceArea(const Image& image, int dst_width, int dst_height, int x, int y, int c) {
+  double sum = 0.0;
+  for (int sy = 0; sy < image.height; ++sy) {
+    const double wy = AreaWeight(sy, y, image.height, dst_height);
+    if (wy == 0.0) {
+      continue;
+    }
+    for (int sx = 0; sx < image.width; ++sx) {
+      const double wx = AreaWeight(sx, x, image.width, dst_width);
+      if (wx != 0.0) {
+        sum += wx * wy * image.At(sx, sy, c);
+      }
+    }
+  }
+  return sum / 255.0;
+}
+
+std::vector<float> Run(const Image& image, int rotation, int dst_width, int dst_height,
+                       int threads, yolo::ThreadPool* pool) {
+  yolo::ResamplePlan plan(image.width, image.height, image.pixel_stride, rotation, dst_width,
+                          dst_height, threads);
+  std::vector<float> out(static_cast<size_t>(dst_width) * dst_height * 3, -1.0f);
+  plan.Run(image.View(), out.data(), pool);
+  return out;
+}
+
+void CheckAgainstReference(int src_width, int src_height, int pixel_stride, int dst_width,
+                           int dst_height) {
+  const Image image = Noise(src_width, src_height, pixel_stride, 7);
+  const std::vector<float> out = Run(image, 0, dst_width, dst_height, 1, nullptr);
+  double worst = 0.0;
+  for (int y = 0; y < dst_height; ++y) {
+    for (int x = 0; x < dst_width; ++x) {
+      for (int c = 0; c < 3; ++c) {
+        const double expected = ReferenceArea(image, dst_width, dst_height, x, y, c);
+        const double actual = out[(static_cast<size_t>(y) * dst_width + x) * 3 + c];
+        worst = std::max(worst, std::fabs(actual - expected));
+      }
+    }
+  }
+  CHECK(worst <= kTolerance);
+}
+
+void CheckFlat() {
+  Image image = Noise(301, 173, 3, 1);
+  for (size_t i = 0; i < image.bytes.size(); i += 3) {
+    image.bytes[i] = 0;
+    image.bytes[i + 1] = 128;
+    image.bytes[i + 2] = 255;
+  }
+  const std::vector<float> out = Run(image, 0, 64, 48, 1, nullptr);
+  for (size_t i = 0; i < out.size(); i += 3) {
+    CHECK(out[i] == 0.0f);
+    CHECK(std::fabs(out[i + 1] - 128.0f / 255.0f) < 1e-6f);
+    CHECK(std::fabs(out[i + 2] - 1.0f) < 1e-6f);
+  }
+}
+
+// A folded clockwise rotation writes the unrotated result turned in place.
+void CheckRotation(int rotation) {
+  const Image image = Noise(200, 120, 4, 11);
+  const int width = 50;
+  const int height = 30;
+  const std::vector<float> upright = Run(image, 0, width, height, 1, nullptr);
+  const bool transposed = rotation == 90 || rotation == 270;
+  const int out_width = transposed ? height : width;
+  const int out_height = transposed ? width : height;
+  const std::vector<float> rotated = Run(image, rotation, out_width, out_height, 1, nullptr);
+  for (int y = 0; y < height; ++y) {
+    for (int x = 0; x < width; ++x) {
+      int rx = x;
+      int ry = y;
+      switch (rotation) {
+        case 90:
+          rx = height - 1 - y;
+          ry = x;
+          break;
+        case 180:
+          rx = width - 1 - x;
+          ry = height - 1 - y;
+          break;
+        case 270:
+          rx = y;
+          ry = width - 1 - x;
+          break;
+        default:
+          break;
+      }
+      for (int c = 0; c < 3; ++c) {
+        CHECK(rotated[(static_cast<size_t>(ry) * out_width + rx) * 3 + c] ==
+              upright[(static_cast<size_t>(y) * width + x) * 3 + c]);
+      }
+    }
+  }
+}
+
+void CheckPoolInvariance() {
+  const Image image = Noise(640, 360, 3, 5);
+  yolo::ThreadPool pool(4);
+  CHECK(Run(image, 90, 96, 160, 1, nullptr) == Run(image, 90, 96, 160, 4, &pool));
+}
+
+}  // namespace
+
+int main() {
+  // Integer, fractional and mixed ratios, RGB and BGRA.
+  CheckAgainstReference(128, 96, 3, 32, 24);
+  CheckAgainstReference(301, 173, 3, 64, 48);
+  CheckAgainstReference(250, 250, 4, 96, 96);
+  CheckAgainstReference(160, 90, 4, 100, 60);
+  CheckFlat();
+  for (const int rotation : {0, 90, 180, 270}) {
+    CheckRotation(rotation);
+  }
+  CheckPoolInvariance();
+  std::puts("resampler: ok");
+  return 0;
+}
@@ -0,0 +1,178 @@
+// Latency-variance benchmark for core placement. Runs YUV conversion,
+// rotation and resize on synthetic 720p frames with an engine thread pool,
+// first unplaced and then placed (auto, or an explicit CPU mask), while
+// background threads keep the other cores busy the way a UI and camera
+// pipeline would. Prints the frame-time distribution for each run; placement
+// pays off in the tail and the spread rather than the median.
+//
+//   yolo_placement_benchmark [threads [iterations [cpu_mask_hex [nice]]]]
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "engine_stats.h"
+#include "image_utils.h"
+#include "thread_placement.h"
+#include "thread_pool.h"
+#include "yolo_engine.h"
+
+namespace {
+
+constexpr int kWidth = 1280;
+constexpr int kHeight = 720;
+constexpr int kModelSize = 320;
+constexpr int kWarmupIterations = 10;
+
+struct Distribution {
+  double p50 = 0.0;
+  double p90 = 0.0;
+  double p99 = 0.0;
+  double mean = 0.0;
+  double stddev = 0.0;
+};
+
+Distribution Summarize(std::vector<double> values) {
+  Distribution out;
+  if (values.empty()) {
+    return out;
+  }
+  std::sort(values.begin(), values.end());
+  auto at = [&](double q) {
+    return values[std::min(values.size() - 1, static_cast<size_t>(q * values.size()))];
+  };
+  out.p50 = at(0.5);
+  out.p90 = at(0.9);
+  out.p99 = at(0.99);
+  double sum = 0.0;
+  for (double value : values) sum += value;
+  out.mean = sum / values.size();
+  double squares = 0.0;
+  for (double value : values) squares += (value - out.mean) * (value - out.mean);
+  out.stddev = std::sqrt(squares / values.size());
+  return out;
+}
+
+// Alternates bursts of work with short sleeps, so the scheduler keeps
+// moving it (and whatever shares its core) around.
+void Spin(const std::atomic<bool>* stop) {
+  volatile uint64_t sink = 0;
+  while (!stop->load(std::memory_order_relaxed)) {
+    for (int i = 0; i < 200000; ++i) sink = sink * 31 + i;
+    std::this_thread::sleep_for(std::chrono::microseconds(500));
+  }
+}
+
+std::vector<double> RunFrames(const yolo::FrameMetadata& frame, int threads, int iterations,
+                              yolo::ThreadPlacement* placement) {
+  yolo::ThreadPool pool(threads, placement);
+  yolo::ScopedPlacement placed(placement);
+  const size_t rgb_bytes = static_cast<size_t>(kWidth) * kHeight * 3;
+  std::vector<uint8_t> rgb(rgb_bytes);
+  std::vector<uint8_t> rotated(rgb_bytes);
+  std::vector<float> input(static_cast<size_t>(kModelSize) * kModelSize * 3);
+  const yolo::ChromaLayout layout = yolo::DetectChromaLayout(frame);
+  std::vector<double> frame_ms;
+  for (int iteration = 0; iteration < kWarmupIterations + iterations; ++iteration) {
+    const uint64_t begin = yolo::MonotonicNanos();
+    yolo::Yuv420ToRgb(frame, layout, rgb.data(), &pool);
+    yolo::RotateRgb(yolo::RgbView(rgb.data(), kWidth, kHeight), 90, rotated.data(), &pool);
+    yolo::ResizeAndNormalize(yolo::RgbView(rotated.data(), kHeight, kWidth), kModelSize,
+                             kModelSize, input.data(), &pool);
+    if (iteration >= kWarmupIterations) {
+      frame_ms.push_back(static_cast<double>(yolo::MonotonicNanos() - begin) / 1e6);
+    }
+  }
+  return frame_ms;
+}
+
+void Print(const char* label, const Distribution& d) {
+  std::printf("%-10s p50 %7.3f  p90 %7.3f  p99 %7.3f  stddev %6.3f ms  cv %5.1f%%\n", label,
+              d.p50, d.p90, d.p99, d.stddev, d.mean > 0.0 ? 100.0 * d.stddev / d.mean : 0.0);
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  const int threads = argc > 1 ? std::atoi(argv[1]) : 4;
+  const int iterations = argc > 2 ? std::atoi(argv[2]) : 300;
+  const uint64_t mask = argc > 3 ? std::strtoull(argv[3], nullptr, 16) : 0;
+  const int nice = argc > 4 ? std::atoi(argv[4]) : 0;
+  if (threads <= 0 || iterations <= 0) {
+    std::fprintf(stderr, "usage: %s [threads [iterations [cpu_mask_hex [nice]]]]\n", argv[0]);
+    return 1;
+  }
+
+  std::mt19937 rng(42);
+  std::uniform_int_distribution<int> byte(0, 255);
+  std::vector<uint8_t> luma(static_cast<size_t>(kWidth) * kHeight);
+  std::vector<uint8_t> chroma(static_cast<size_t>(kWidth) * (kHeight / 2));
+  for (uint8_t& value : luma) value = static_cast<uint8_t>(byte(rng));
+  for (uint8_t& value : chroma) value = static_cast<uint8_t>(byte(rng));
+  yolo::FrameMetadata frame{};
+  frame.y_plane = luma.data();
+  frame.v_plane = chroma.data();
+  frame.u_plane = chroma.data() + 1;
+  frame.width = kWidth;
+  frame.height = kHeight;
+  frame.y_row_stride = kWidth;
+  frame.uv_row_stride = kWidth;
+  frame.uv_pixel_stride = 2;
+  frame.rotation_degrees = 90;
+
+  const std::vector<uint32_t> capacities = yolo::ReadCoreCapacities();
+  std::printf("cpus %u, capacities:", std::thread::hardware_concurrency());
+  for (uint32_t capacity : capacities) std::printf(" %u", capacity);
+  std::printf("%s\n", capacities.empty() ? " unreadable" : "");
+
+  yolo::ThreadPlacement placement(
+      mask != 0 ? yolo::CorePlacement::kMask : yolo::CorePlacement::kAuto, mask, nice, threads);
+  YoloThreadPlacement resolved{};
+  placement.Snapshot(&resolved);
+  std::printf("placement mask 0x%llx over %d core classes, nice %d\n",
+              static_cast<unsigned long long>(resolved.cpu_mask), resolved.core_classes,
+              resolved.nice);
+  if (std::thread::hardware_concurrency() < 2) {
+    std::printf("note: one CPU available; placed and unplaced runs share it, so any difference "
+                "below is noise\n");
+  }
+  if (!placement.active()) {
+    std::printf("note: nothing to place on this topology; pass a mask to force one\n");
+  }
+
+  std::atomic<bool> stop{false};
+  std::vector<std::thread> background;
+  const unsigned spinners = std::max(1u, std::thread::hardware_concurrency() / 2);
+  for (unsigned i = 0; i < spinners; ++i) {
+    background.emplace_back(Spin, &stop);
+  }
+  // Alternate the two configurations so thermal drift hits both alike.
+  std::vector<double> unplaced;
+  std::vector<double> placed;
+  for (int round = 0; round < 3; ++round) {
+    const int share = std::max(1, iterations / 3);
+    for (double ms : RunFrames(frame, threads, share, nullptr)) unplaced.push_back(ms);
+    for (double ms : RunFrames(frame, threads, share, &placement)) placed.push_back(ms);
+  }
+  stop.store(true, std::memory_order_relaxed);
+  for (std::thread& thread : background) {
+    thread.join();
+  }
+
+  std::printf("%d threads, %zu frames each, %u background spinners\n", threads, placed.size(),
+              spinners);
+  Print("unplaced", Summarize(unplaced));
+  Print("placed", Summarize(placed));
+  placement.Snapshot(&resolved);
+  std::printf("workers pinned %d, frame thread pinned %d, priority applied %d\n",
+              resolved.workers_pinned, resolved.frame_thread_pinned, resolved.priority_applied);
+  return 0;
+}
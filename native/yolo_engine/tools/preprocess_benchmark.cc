@@ -0,0 +1,308 @@
+// Scaling benchmark for the CPU stages around the interpreter. Runs YUV
+// conversion, rotation, resize and decode on synthetic data with engine
+// thread pools of 1, 2, 4 and 8 threads and prints the median time per stage
+// alongside the speedup over one thread. Outputs are checked against the
+// single-threaded run so banding bugs show up as mismatches, not speedups.
+// Decode is also run on a transposed (anchor-major) copy of the output and
+// checked against the channel-major result, and the model-input resample is
+// compared with plain bilinear for speed and for distance from an exact
+// area average.
+//
+//   yolo_preprocess_benchmark [width height [iterations]]
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "engine_stats.h"
+#include "image_utils.h"
+#include "postprocess.h"
+#include "resampler.h"
+#include "scratch_arena.h"
+#include "thread_pool.h"
+#include "yolo_engine.h"
+
+namespace {
+
+constexpr int kModelSize = 320;
+constexpr int kNumClasses = 170;
+constexpr int kNumPredictions = 2100;
+constexpr int kWarmupIterations = 5;
+
+struct StageTimes {
+  std::vector<double> yuv;
+  std::vector<double> rotate;
+  std::vector<double> resize;
+  std::vector<double> decode;
+};
+
+double Median(std::vector<double> values) {
+  if (values.empty()) {
+    return 0.0;
+  }
+  std::sort(values.begin(), values.end());
+  return values[values.size() / 2];
+}
+
+double ElapsedMs(uint64_t begin_ns) {
+  return static_cast<double>(yolo::MonotonicNanos() - begin_ns) / 1e6;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  const int width = argc > 2 ? std::atoi(argv[1]) : 1280;
+  const int height = argc > 2 ? std::atoi(argv[2]) : 720;
+  const int iterations = argc > 3 ? std::atoi(argv[3]) : 50;
+  if (width <= 0 || height <= 0 || (width & 1) || (height & 1) || iterations <= 0) {
+    std::fprintf(stderr, "usage: %s [width height [iterations]] (even dimensions)\n", argv[0]);
+    return 1;
+  }
+
+  // NV21-style camera frame: full-res luma plus interleaved chroma.
+  std::mt19937 rng(42);
+  std::uniform_int_distribution<int> byte(0, 255);
+  std::vector<uint8_t> luma(static_cast<size_t>(width) * height);
+  std::vector<uint8_t> chroma(static_cast<size_t>(width) * (height / 2));
+  for (uint8_t& value : luma) value = static_cast<uint8_t>(byte(rng));
+  for (uint8_t& value : chroma) value = static_cast<uint8_t>(byte(rng));
+
+  yolo::FrameMetadata frame{};
+  frame.y_plane = luma.data();
+  frame.v_plane = chroma.data();
+  frame.u_plane = chroma.data() + 1;
+  frame.width = width;
+  frame.height = height;
+  frame.y_row_stride = width;
+  frame.uv_row_stride = width;
+  frame.uv_pixel_stride = 2;
+  frame.rotation_degrees = 90;
+
+  // Channel-major [1, 4 + classes, predictions] output with a sprinkling of
+  // confident predictions so NMS has real work.
+  const std::vector<int> shape = {1, 4 + kNumClasses, kNumPredictions};
+  std::vector<float> tensor(static_cast<size_t>(4 + kNumClasses) * kNumPredictions);
+  std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+  for (int i = 0; i < kNumPredictions; ++i) {
+    tensor[0 * kNumPredictions + i] = unit(rng);
+    tensor[1 * kNumPredictions + i] = unit(rng);
+    tensor[2 * kNumPredictions + i] = 0.05f + 0.2f * unit(rng);
+    tensor[3 * kNumPredictions + i] = 0.05f + 0.2f * unit(rng);
+    for (int c = 0; c < kNumClasses; ++c) {
+      const float score = unit(rng);
+      tensor[static_cast<size_t>(4 + c) * kNumPredictions + i] =
+          score > 0.995f ? score : score * 0.2f;
+    }
+  }
+
+  yolo::EngineOptions options;
+  options.input_width = kModelSize;
+  options.input_height = kModelSize;
+
+  const size_t rgb_bytes = static_cast<size_t>(width) * height * 3;
+  const size_t input_count = static_cast<size_t>(kModelSize) * kModelSize * 3;
+  std::vector<uint8_t> rgb(rgb_bytes);
+  std::vector<uint8_t> rotated(rgb_bytes);
+  std::vector<float> input(input_count);
+  std::vector<YoloDetection> detections;
+  yolo::ScratchArena arena;
+  const yolo::DecodeLayout decode_layout = yolo::ResolveDecodeLayout(shape);
+  yolo::DecodeSettings settings;
+  settings.confidence_threshold = options.confidence_threshold;
+  settings.iou_threshold = options.iou_threshold;
+  settings.max_detections = options.max_detections;
+  settings.Resolve(kNumClasses);
+  arena.Reserve(yolo::DecodeScratchBytes(decode_layout));
+
+  std::vector<uint8_t> reference_rotated;
+  std::vector<float> reference_input;
+  std::vector<YoloDetection> reference_detections;
+  double baseline_total = 0.0;
+
+  // Per-layout cost of the colour conversion on one thread. The generic path
+  // is what frames with separately copied U/V planes used to take.
+  const yolo::ChromaLayout layout = yolo::DetectChromaLayout(frame);
+  {
+    std::vector<uint8_t> generic_rgb(rgb_bytes);
+    std::vector<double> generic_ms;
+    std::vector<double> specialized_ms;
+    for (int iteration = 0; iteration < kWarmupIterations + iterations; ++iteration) {
+      const bool timed = iteration >= kWarmupIterations;
+      uint64_t begin = yolo::MonotonicNanos();
+      yolo::Yuv420ToRgb(frame, yolo::ChromaLayout::kGeneric, generic_rgb.data());
+      if (timed) generic_ms.push_back(ElapsedMs(begin));
+      begin = yolo::MonotonicNanos();
+      yolo::Yuv420ToRgb(frame, layout, rgb.data());
+      if (timed) specialized_ms.push_back(ElapsedMs(begin));
+    }
+    std::printf("yuv %s vs generic: %.3f ms vs %.3f ms (%s)\n", yolo::ChromaLayoutName(layout),
+                Median(specialized_ms), Median(generic_ms),
+                generic_rgb == rgb ? "identical" : "MISMATCH");
+  }
+
+  // Model input: rotate then bilinear (the old path) against the area plan
+  // with the rotation folded in, both single-threaded. Quality is the RMS
+  // distance from an exact floating-point area average of the upright frame.
+  {
+    yolo::Yuv420ToRgb(frame, layout, rgb.data());
+    const yolo::PixelView upright = yolo::RgbView(rotated.data(), height, width);
+    yolo::RotateRgb(yolo::RgbView(rgb.data(), width, height), 90, rotated.data());
+    std::vector<uint8_t> area(input_count);
+    yolo::ResampleArea(upright, kModelSize, kModelSize, area.data());
+    yolo::ResamplePlan plan(width, height, 3, 90, kModelSize, kModelSize, 1);
+    std::vector<float> bilinear(input_count);
+    std::vector<double> bilinear_ms;
+    std::vector<double> plan_ms;
+    for (int iteration = 0; iteration < kWarmupIterations + iterations; ++iteration) {
+      const bool timed = iteration >= kWarmupIterations;
+      uint64_t begin = yolo::MonotonicNanos();
+      yolo::RotateRgb(yolo::RgbView(rgb.data(), width, height), 90, rotated.data());
+      yolo::ResizeAndNormalize(upright, kModelSize, kModelSize, bilinear.data());
+      if (timed) bilinear_ms.push_back(ElapsedMs(begin));
+      begin = yolo::MonotonicNanos();
+      plan.Run(yolo::RgbView(rgb.data(), width, height), input.data(), nullptr);
+      if (timed) plan_ms.push_back(ElapsedMs(begin));
+    }
+    auto rms = [&](const std::vector<float>& values) {
+      double sum = 0.0;
+      for (size_t i = 0; i < values.size(); ++i) {
+        const double error = values[i] - area[i] / 255.0;
+        sum += error * error;
+      }
+      return std::sqrt(sum / values.size());
+    };
+    std::printf("resize area plan vs rotate+bilinear: %.3f ms vs %.3f ms, "
+                "rms error %.4f vs %.4f\n",
+                Median(plan_ms), Median(bilinear_ms), rms(input), rms(bilinear));
+  }
+
+  // The same predictions exported anchor-major, [1, predictions, 4 + classes].
+  {
+    const int channels = 4 + kNumClasses;
+    std::vector<float> transposed(tensor.size());
+    for (int c = 0; c < channels; ++c) {
+      for (int i = 0; i < kNumPredictions; ++i) {
+        transposed[static_cast<size_t>(i) * channels + c] =
+            tensor[static_cast<size_t>(c) * kNumPredictions + i];
+      }
+    }
+    const yolo::DecodeLayout anchor_layout =
+        yolo::ResolveDecodeLayout({1, kNumPredictions, channels});
+    std::vector<YoloDetection> channel_detections;
+    std::vector<YoloDetection> anchor_detections;
+    std::vector<double> channel_ms;
+    std::vector<double> anchor_ms;
+    for (int iteration = 0; iteration < kWarmupIterations + iterations; ++iteration) {
+      const bool timed = iteration >= kWarmupIterations;
+      arena.Reset();
+      uint64_t begin = yolo::MonotonicNanos();
+      yolo::DecodeDetections(tensor.data(), tensor.size(), decode_layout, options, settings,
+                             &arena, &channel_detections);
+      if (timed) channel_ms.push_back(ElapsedMs(begin));
+      arena.Reset();
+      begin = yolo::MonotonicNanos();
+      yolo::DecodeDetections(transposed.data(), transposed.size(), anchor_layout, options,
+                             settings, &arena, &anchor_detections);
+      if (timed) anchor_ms.push_back(ElapsedMs(begin));
+    }
+    const bool identical =
+        channel_detections.size() == anchor_detections.size() &&
+        std::memcmp(channel_detections.data(), anchor_detections.data(),
+                    channel_detections.size() * sizeof(YoloDetection)) == 0;
+    std::printf("decode anchor-major vs channel-major: %.3f ms vs %.3f ms, %zu boxes (%s)\n",
+                Median(anchor_ms), Median(channel_ms), channel_detections.size(),
+                identical ? "identical" : "MISMATCH");
+  }
+
+  // A regional species list leaves most classes masked; the reduction then
+  // reads only the enabled classes' rows.
+  {
+    yolo::DecodeSettings masked = settings;
+    masked.class_enabled.assign(kNumClasses, 0);
+    for (int c = 0; c < kNumClasses; c += 10) {
+      masked.class_enabled[c] = 1;
+    }
+    masked.Resolve(kNumClasses);
+    std::vector<YoloDetection> all_detections;
+    std::vector<YoloDetection> masked_detections;
+    std::vector<double> all_ms;
+    std::vector<double> masked_ms;
+    for (int iteration = 0; iteration < kWarmupIterations + iterations; ++iteration) {
+      const bool timed = iteration >= kWarmupIterations;
+      arena.Reset();
+      uint64_t begin = yolo::MonotonicNanos();
+      yolo::DecodeDetections(tensor.data(), tensor.size(), decode_layout, options, settings,
+                             &arena, &all_detections);
+      if (timed) all_ms.push_back(ElapsedMs(begin));
+      arena.Reset();
+      begin = yolo::MonotonicNanos();
+      yolo::DecodeDetections(tensor.data(), tensor.size(), decode_layout, options, masked,
+                             &arena, &masked_detections);
+      if (timed) masked_ms.push_back(ElapsedMs(begin));
+    }
+    std::printf("decode %d classes vs %zu enabled: %.3f ms vs %.3f ms, %zu vs %zu boxes\n",
+                kNumClasses, masked.classes.size(), Median(all_ms), Median(masked_ms),
+                all_detections.size(), masked_detections.size());
+  }
+
+  std::printf("frame %dx%d -> %dx%d, %d classes x %d predictions, %d iterations\n", width,
+              height, kModelSize, kModelSize, kNumClasses, kNumPredictions, iterations);
+  std::printf("%7s %9s %9s %9s %9s %9s %8s %s\n", "threads", "yuv_ms", "rotate_ms", "resize_ms",
+              "decode_ms", "total_ms", "speedup", "check");
+
+  for (const int threads : {1, 2, 4, 8}) {
+    yolo::ThreadPool pool(threads);
+    yolo::ResamplePlan plan(height, width, 3, 0, kModelSize, kModelSize, threads);
+    StageTimes times;
+    for (int iteration = 0; iteration < kWarmupIterations + iterations; ++iteration) {
+      const bool timed = iteration >= kWarmupIterations;
+      uint64_t begin = yolo::MonotonicNanos();
+      yolo::Yuv420ToRgb(frame, layout, rgb.data(), &pool);
+      if (timed) times.yuv.push_back(ElapsedMs(begin));
+
+      begin = yolo::MonotonicNanos();
+      yolo::RotateRgb(yolo::RgbView(rgb.data(), width, height), frame.rotation_degrees,
+                      rotated.data(), &pool);
+      if (timed) times.rotate.push_back(ElapsedMs(begin));
+
+      begin = yolo::MonotonicNanos();
+      plan.Run(yolo::RgbView(rotated.data(), height, width), input.data(), &pool);
+      if (timed) times.resize.push_back(ElapsedMs(begin));
+
+      arena.Reset();
+      begin = yolo::MonotonicNanos();
+      yolo::DecodeDetections(tensor.data(), tensor.size(), decode_layout, options, settings,
+                             &arena, &detections, &pool);
+      if (timed) times.decode.push_back(ElapsedMs(begin));
+    }
+
+    const char* check = "ok";
+    if (threads == 1) {
+      reference_rotated = rotated;
+      reference_input = input;
+      reference_detections = detections;
+    } else if (rotated != reference_rotated || input != reference_input ||
+               detections.size() != reference_detections.size() ||
+               std::memcmp(detections.data(), reference_detections.data(),
+                           detections.size() * sizeof(YoloDetection)) != 0) {
+      check = "MISMATCH";
+    }
+
+    const double yuv = Median(times.yuv);
+    const double rotate = Median(times.rotate);
+    const double resize = Median(times.resize);
+    const double decode = Median(times.decode);
+    const double total = yuv + rotate + resize + decode;
+    if (threads == 1) {
+      baseline_total = total;
+    }
+    std::printf("%7d %9.3f %9.3f %9.3f %9.3f %9.3f %7.2fx %s\n", threads, yuv, rotate, resize,
+                decode, total, total > 0.0 ? baseline_total / total : 0.0, check);
+  }
+  return 0;
+}
@@ -0,0 +1,303 @@
+// Replays a recording made with YoloEngineStartRecording() through a fresh
+// engine on the host. Frames are mapped straight from the file and submitted
+// either at their recorded pace or back to back; the engine is created with
+// the options stored in the recording. Prints the per-frame latency
+// distribution next to the one measured on the device, and how the replayed
+// results differ from the recorded ones: status changes, boxes matched by
+// class and IoU, boxes only one side found, and score and position drift of
+// the matched ones. Recorded deadlines are dropped, since they belong to the
+// device's clock.
+//
+// Decode settings changed during the recording are applied at the frames
+// they took effect on. What the recording cannot reproduce is reported
+// before the replay starts: a crop classifier (its model is not recorded),
+// the GPU delegate, and a cadence governor at maximum pace, whose choices
+// follow wall time. Frames decoded with per-class thresholds or class
+// filters are replayed but left out of the comparison, since the recording
+// does not hold those settings.
+//
+//   yolo_replay model.tflite recording [realtime|max [threads [iou]]]
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "frame_recorder.h"
+#include "yolo_engine_api.h"
+
+namespace {
+
+// Frames whose differences are listed individually.
+constexpr int kMaxListedFrames = 10;
+
+struct Distribution {
+  double p50 = 0.0;
+  double p90 = 0.0;
+  double p99 = 0.0;
+  double max = 0.0;
+  double mean = 0.0;
+};
+
+Distribution Summarize(std::vector<double> values) {
+  Distribution out;
+  if (values.empty()) {
+    return out;
+  }
+  std::sort(values.begin(), values.end());
+  auto at = [&](double q) {
+    return values[std::min(values.size() - 1, static_cast<size_t>(q * values.size()))];
+  };
+  out.p50 = at(0.5);
+  out.p90 = at(0.9);
+  out.p99 = at(0.99);
+  out.max = values.back();
+  double sum = 0.0;
+  for (double value : values) sum += value;
+  out.mean = sum / values.size();
+  return out;
+}
+
+void Print(const char* label, const std::vector<double>& values) {
+  const Distribution d = Summarize(values);
+  std::printf("%-18s n %6zu  p50 %7.2f  p90 %7.2f  p99 %7.2f  max %7.2f  mean %7.2f ms\n", label,
+              values.size(), d.p50, d.p90, d.p99, d.max, d.mean);
+}
+
+float Iou(const YoloDetection& a, const YoloDetection& b) {
+  const float width = std::min(a.right, b.right) - std::max(a.left, b.left);
+  const float height = std::min(a.bottom, b.bottom) - std::max(a.top, b.top);
+  if (width <= 0.0f || height <= 0.0f) {
+    return 0.0f;
+  }
+  const float overlap = width * height;
+  const float area_a = (a.right - a.left) * (a.bottom - a.top);
+  const float area_b = (b.right - b.left) * (b.bottom - b.top);
+  return overlap / (area_a + area_b - overlap);
+}
+
+struct FrameDiff {
+  int matched = 0;
+  int missing = 0;
+  int extra = 0;
+  double iou_sum = 0.0;
+  double score_delta_sum = 0.0;
+  float max_score_delta = 0.0f;
+};
+
+// Greedy matching, best-overlapping pairs of the same class first.
+FrameDiff Compare(const YoloDetection* recorded, int recorded_count,
+                  const YoloDetection* replayed, int replayed_count, float min_iou) {
+  std::vector<std::pair<float, std::pair<int, int>>> pairs;
+  for (int i = 0; i < recorded_count; ++i) {
+    for (int j = 0; j < replayed_count; ++j) {
+      if (recorded[i].class_index != replayed[j].class_index) continue;
+      const float iou = Iou(recorded[i], replayed[j]);
+      if (iou >= min_iou) pairs.push_back({iou, {i, j}});
+    }
+  }
+  std::sort(pairs.begin(), pairs.end(),
+            [](const auto& a, const auto& b) { return a.first > b.first; });
+  std::vector<bool> recorded_used(static_cast<size_t>(recorded_count), false);
+  std::vector<bool> replayed_used(static_cast<size_t>(replayed_count), false);
+  FrameDiff diff;
+  for (const auto& pair : pairs) {
+    const int i = pair.second.first;
+    const int j = pair.second.second;
+    if (recorded_used[i] || replayed_used[j]) continue;
+    recorded_used[i] = replayed_used[j] = true;
+    ++diff.matched;
+    diff.iou_sum += pair.first;
+    const float delta = std::abs(recorded[i].score - replayed[j].score);
+    diff.score_delta_sum += delta;
+    diff.max_score_delta = std::max(diff.max_score_delta, delta);
+  }
+  diff.missing = recorded_count - diff.matched;
+  diff.extra = replayed_count - diff.matched;
+  return diff;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  if (argc < 3) {
+    std::fprintf(stderr, "usage: %s model.tflite recording [realtime|max [threads [iou]]]\n",
+                 argv[0]);
+    return 1;
+  }
+  const bool realtime = argc > 3 && std::strcmp(argv[3], "realtime") == 0;
+  const float min_iou = argc > 5 ? static_cast<float>(std::atof(argv[5])) : 0.5f;
+
+  yolo::RecordingReader reader;
+  if (!reader.Open(argv[2])) {
+    std::fprintf(stderr, "cannot read recording %s\n", argv[2]);
+    return 1;
+  }
+  const yolo::RecordingFileHeader& header = reader.header();
+  const std::vector<const yolo::RecordedFrameHeader*>& frames = reader.frames();
+  if (frames.empty()) {
+    std::fprintf(stderr, "%s holds no complete frames\n", argv[2]);
+    return 1;
+  }
+
+  YoloEngineConfig config;
+  YoloEngineConfigInitDefault(&config);
+  config.model_path = argv[1];
+  config.input_width = header.input_width;
+  config.input_height = header.input_height;
+  config.num_threads = argc > 4 ? std::atoi(argv[4]) : header.num_threads;
+  config.max_detections = header.max_detections;
+  config.confidence_threshold = header.confidence_threshold;
+  config.iou_threshold = header.iou_threshold;
+  config.inference_interval = std::max(1, header.inference_interval);
+  config.min_track_confidence = header.min_track_confidence;
+  config.quality_gate = header.quality_gate;
+  config.min_sharpness = header.min_sharpness;
+  config.max_clipped_fraction = header.max_clipped_fraction;
+  config.auto_zoom = header.auto_zoom;
+  config.governor = header.governor;
+  config.governor_max_fps = header.governor_max_fps;
+  config.governor_max_duty_cycle = header.governor_max_duty_cycle;
+  config.governor_max_cpu_ms_per_s = header.governor_max_cpu_ms_per_s;
+  config.governor_idle_after_ms = header.governor_idle_after_ms;
+  config.governor_idle_fps = header.governor_idle_fps;
+  void* engine = YoloEngineCreateWithConfig(&config);
+  if (engine == nullptr) {
+    std::fprintf(stderr, "cannot create engine for %s\n", argv[1]);
+    return 1;
+  }
+
+  uint64_t gaps = 0;
+  for (size_t i = 1; i < frames.size(); ++i) {
+    if (frames[i]->sequence > frames[i - 1]->sequence + 1) {
+      gaps += frames[i]->sequence - frames[i - 1]->sequence - 1;
+    }
+  }
+  std::printf("%zu frames, %dx%d model input, %d threads, %s pace\n", frames.size(),
+              header.input_width, header.input_height, config.num_threads,
+              realtime ? "recorded" : "maximum");
+  if (header.classifier != 0) {
+    std::printf("note: the recording ran a crop classifier, which is not replayed; device "
+                "latencies include it\n");
+  }
+  if (header.use_gpu != 0) {
+    std::printf("note: the recording ran on the GPU delegate; expect score and box drift on "
+                "the CPU\n");
+  }
+  if (header.governor != 0 && !realtime) {
+    std::printf("note: the cadence governor paces by wall time; replay at the recorded pace "
+                "(realtime) to reproduce its choices\n");
+  }
+  if (gaps > 0) {
+    std::printf("note: %llu frames are missing from the recording; tracking state may differ "
+                "around them\n",
+                static_cast<unsigned long long>(gaps));
+  }
+
+  std::vector<double> replay_inferred_ms;
+  std::vector<double> replay_tracked_ms;
+  std::vector<double> device_inferred_ms;
+  std::vector<double> device_tracked_ms;
+  std::map<std::pair<int32_t, int32_t>, int> status_changes;
+  FrameDiff total;
+  int compared = 0;
+  int differing = 0;
+  int listed = 0;
+  int class_filtered = 0;
+  YoloDecodeConfig decode{header.confidence_threshold, header.iou_threshold,
+                          header.max_detections, 0, nullptr, nullptr};
+
+  auto time_of = [](const yolo::RecordedFrameHeader& frame) {
+    return frame.capture_time_ns > 0 ? frame.capture_time_ns : frame.receive_time_ns;
+  };
+  const int64_t first_ns = time_of(*frames.front());
+  const auto replay_start = std::chrono::steady_clock::now();
+  for (const yolo::RecordedFrameHeader* recorded : frames) {
+    if (realtime && time_of(*recorded) > first_ns) {
+      std::this_thread::sleep_until(replay_start +
+                                    std::chrono::nanoseconds(time_of(*recorded) - first_ns));
+    }
+    if (recorded->confidence_threshold != decode.confidence_threshold ||
+        recorded->iou_threshold != decode.iou_threshold ||
+        recorded->max_detections != decode.max_detections) {
+      decode.confidence_threshold = recorded->confidence_threshold;
+      decode.iou_threshold = recorded->iou_threshold;
+      decode.max_detections = recorded->max_detections;
+      YoloEngineUpdateDecodeConfig(engine, &decode);
+    }
+    YoloFrameDescriptor descriptor = yolo::RecordingReader::Descriptor(*recorded);
+    descriptor.deadline_ns = 0;
+    descriptor.capture_time_ns = YoloEngineNowNs();
+    YoloDetections out{};
+    const int64_t begin_ns = YoloEngineNowNs();
+    const int32_t status = YoloEngineProcessFrame(engine, &descriptor, &out);
+    const double elapsed_ms = static_cast<double>(YoloEngineNowNs() - begin_ns) / 1e6;
+
+    if (status == 0) {
+      (out.predicted ? replay_tracked_ms : replay_inferred_ms).push_back(elapsed_ms);
+    }
+    if (recorded->status == 0 && recorded->decode_end_ns > recorded->receive_time_ns) {
+      const double device_ms =
+          static_cast<double>(recorded->decode_end_ns - recorded->receive_time_ns) / 1e6;
+      (recorded->predicted ? device_tracked_ms : device_inferred_ms).push_back(device_ms);
+    }
+    if ((recorded->decode_flags & yolo::kRecordedClassFilters) != 0) {
+      ++class_filtered;
+    } else if (status != recorded->status) {
+      ++status_changes[{recorded->status, status}];
+    } else if (status == 0) {
+      const FrameDiff diff = Compare(yolo::RecordingReader::Detections(*recorded),
+                                     recorded->detection_count, out.detections, out.count,
+                                     min_iou);
+      ++compared;
+      total.matched += diff.matched;
+      total.missing += diff.missing;
+      total.extra += diff.extra;
+      total.iou_sum += diff.iou_sum;
+      total.score_delta_sum += diff.score_delta_sum;
+      total.max_score_delta = std::max(total.max_score_delta, diff.max_score_delta);
+      if (diff.missing > 0 || diff.extra > 0) {
+        ++differing;
+        if (listed++ < kMaxListedFrames) {
+          std::printf("frame %llu: %d recorded, %d replayed, %d matched\n",
+                      static_cast<unsigned long long>(recorded->sequence),
+                      recorded->detection_count, out.count, diff.matched);
+        }
+      }
+    }
+    YoloEngineReleaseDetections(&out);
+  }
+  YoloEngineDestroy(engine);
+
+  std::printf("\nlatency, receive to results\n");
+  Print("replay inferred", replay_inferred_ms);
+  Print("replay tracked", replay_tracked_ms);
+  Print("device inferred", device_inferred_ms);
+  Print("device tracked", device_tracked_ms);
+
+  std::printf("\nresults against the recording (iou >= %.2f, same class)\n", min_iou);
+  std::printf("frames compared %d, with differing boxes %d\n", compared, differing);
+  if (class_filtered > 0) {
+    std::printf("frames not compared (per-class decode settings not recorded) %d\n",
+                class_filtered);
+  }
+  std::printf("boxes matched %d, recorded only %d, replayed only %d\n", total.matched,
+              total.missing, total.extra);
+  if (total.matched > 0) {
+    std::printf("matched mean iou %.4f, mean score delta %.4f, max %.4f\n",
+                total.iou_sum / total.matched, total.score_delta_sum / total.matched,
+                total.max_score_delta);
+  }
+  for (const auto& change : status_changes) {
+    std::printf("status %d recorded, %d replayed: %d frames\n", change.first.first,
+                change.first.second, change.second);
+  }
+  return 0;
+}
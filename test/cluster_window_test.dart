@@ -0,0 +1,95 @@
+import 'package:flutter_test/flutter_test.dart';
+import 'package:realtime_detection_app/utils/cluster_window.dart';
+
+void main() {
+  test('window pads the view by half its size on each side', () {
+    final ClusterWindow window = ClusterWindow.around(
+      west: 10,
+      south: 40,
+      east: 14,
+      north: 42,
+      zoom: 7,
+    );
+
+    expect(window.west, 8);
+    expect(window.east, 16);
+    expect(window.south, 39);
+    expect(window.north, 43);
+    expect(window.zoom, 7);
+  });
+
+  test('panning within the window keeps it, leaving it does not', () {
+    final ClusterWindow window = ClusterWindow.around(
+      west: 10,
+      south: 40,
+      east: 14,
+      north: 42,
+      zoom: 7,
+    );
+
+    expect(
+      window.covers(west: 11.5, south: 40.5, east: 15.5, north: 42.5, zoom: 7),
+      isTrue,
+    );
+    expect(
+      window.covers(west: 8, south: 39, east: 12, north: 41, zoom: 7),
+      isTrue,
+    );
+    expect(
+      window.covers(west: 12.5, south: 40, east: 16.5, north: 42, zoom: 7),
+      isFalse,
+    );
+    expect(
+      window.covers(west: 10, south: 41.5, east: 14, north: 43.5, zoom: 7),
+      isFalse,
+    );
+  });
+
+  test('a different zoom level always queries again', () {
+    final ClusterWindow window = ClusterWindow.around(
+      west: 10,
+      south: 40,
+      east: 14,
+      north: 42,
+      zoom: 7,
+    );
+
+    expect(
+      window.covers(west: 11, south: 40.5, east: 13, north: 41.5, zoom: 8),
+      isFalse,
+    );
+    expect(
+      window.covers(west: 10, south: 40, east: 14, north: 42, zoom: 6),
+      isFalse,
+    );
+  });
+
+  test('a view across the antimeridian gives an unwrapped window', () {
+    final ClusterWindow window = ClusterWindow.around(
+      west: 170,
+      south: -10,
+      east: -170,
+      north: 10,
+      zoom: 3,
+    );
+
+    expect(window.west, 160);
+    expect(window.east, 200);
+    expect(
+      window.covers(west: 175, south: -5, east: -175, north: 5, zoom: 3),
+      isTrue,
+    );
+    expect(
+      window.covers(west: -178, south: -5, east: -162, north: 5, zoom: 3),
+      isTrue,
+    );
+    expect(
+      window.covers(west: 162, south: -5, east: 178, north: 5, zoom: 3),
+      isTrue,
+    );
+    expect(
+      window.covers(west: -165, south: -5, east: -150, north: 5, zoom: 3),
+      isFalse,
+    );
+  });
+}
@@ -0,0 +1,154 @@
+import 'dart:typed_data';
+
+import 'package:flutter_test/flutter_test.dart';
+import 'package:realtime_detection_app/models/observation.dart';
+import 'package:realtime_detection_app/native/native_observation_store.dart';
+import 'package:realtime_detection_app/repositories/observation_codec.dart';
+
+Observation roundTrip(Observation observation) {
+  final NativeStoreRecord record = ObservationCodec.recordOf(observation);
+  final Uint8List payload = ObservationCodec.encode(observation);
+  return ObservationCodec.decode(record, payload);
+}
+
+void main() {
+  test('observation with every field survives a round trip', () {
+    final Observation observation = Observation(
+      id: 'obs-1',
+      speciesId: 'xanthoria',
+      classIndex: 12,
+      label: 'Xanthoria parietina',
+      confidence: 0.87,
+      top2Label: 'Candelaria concolor',
+      top2Confidence: 0.08,
+      top1VoteRatio: 0.9,
+      windowFrameCount: 30,
+      windowDurationMs: 1250,
+      stabilityWinCount: 9,
+      stabilityWindowSize: 10,
+      isLichen: true,
+      createdAt: DateTime.fromMicrosecondsSinceEpoch(1700000000123456),
+      photoPath: '/photos/obs-1.png',
+      latitude: 47.3769,
+      longitude: 8.5417,
+      accuracyMeters: 4.7,
+      capturedAt: DateTime.fromMicrosecondsSinceEpoch(1700000000000001),
+      locationSource: ObservationLocationSource.exifGps,
+      locationLabel: 'Zürich',
+      notes: 'On a birch, north side',
+    );
+
+    final Observation decoded = roundTrip(observation);
+
+    expect(decoded.toJson(), observation.toJson());
+    expect(decoded.accuracyMeters, 4.7);
+  });
+
+  test('absent optional fields stay absent', () {
+    final Observation observation = Observation(
+      id: 'obs-2',
+      speciesId: '',
+      classIndex: null,
+      label: '',
+      confidence: null,
+      createdAt: DateTime.fromMicrosecondsSinceEpoch(0),
+      photoPath: null,
+    );
+
+    final NativeStoreRecord record = ObservationCodec.recordOf(observation);
+    final Observation decoded = roundTrip(observation);
+
+    expect(record.hasLocation, isFalse);
+    expect(decoded.toJson(), observation.toJson());
+    expect(decoded.location, isNull);
+  });
+
+  test('UTC and local times keep their zone', () {
+    final Observation utc = Observation(
+      id: 'obs-utc',
+      speciesId: '1',
+      classIndex: 1,
+      label: 'a',
+      confidence: 0.5,
+      createdAt: DateTime.utc(2024, 3, 31, 1, 30, 0, 0, 250),
+      photoPath: null,
+      capturedAt: DateTime.utc(2024, 3, 31, 1, 29),
+    );
+    final Observation local = Observation(
+      id: 'obs-local',
+      speciesId: '1',
+      classIndex: 1,
+      label: 'a',
+      confidence: 0.5,
+      createdAt: DateTime(2024, 3, 31, 1, 30),
+      photoPath: null,
+      capturedAt: DateTime.utc(2024, 3, 31, 1, 29),
+    );
+
+    final Observation decodedUtc = roundTrip(utc);
+    final Observation decodedLocal = roundTrip(local);
+
+    expect(decodedUtc.createdAt.isUtc, isTrue);
+    expect(decodedUtc.createdAt, utc.createdAt);
+    expect(decodedUtc.capturedAt!.isUtc, isTrue);
+    expect(decodedUtc.toJson(), utc.toJson());
+    expect(decodedLocal.createdAt.isUtc, isFalse);
+    expect(decodedLocal.createdAt, local.createdAt);
+    expect(decodedLocal.capturedAt!.isUtc, isTrue);
+    expect(decodedLocal.toJson(), local.toJson());
+  });
+
+  test('legacy JSON observations import unchanged', () {
+    final List<Map<String, dynamic>> legacy = [
+      {
+        'speciesName': 'Parmelia sulcata',
+        'classIndex': 3,
+        'confidence': 0.71,
+        'timestamp': '2023-05-01T10:00:00.000',
+        'lat': -33.8688,
+        'lon': 151.2093,
+        'location': {'accuracyMeters': 12.5},
+      },
+      {
+        'label': 'Parmelia sulcata',
+        'classIndex': 3,
+        'confidence': 0.65,
+        'createdAt': '2023-05-01T10:00:05.000',
+      },
+    ];
+
+    final List<Observation> observations =
+        legacy.map(Observation.fromJson).toList();
+    final Set<String> keys =
+        observations.map(ObservationCodec.keyOf).toSet();
+
+    expect(keys, hasLength(2));
+    for (final Observation observation in observations) {
+      expect(roundTrip(observation).toJson(), observation.toJson());
+    }
+    expect(ObservationCodec.recordOf(observations[0]).hasLocation, isTrue);
+    expect(roundTrip(observations[0]).accuracyMeters, 12.5);
+  });
+
+  test('unknown payload version is rejected', () {
+    final Observation observation = Observation(
+      id: 'obs-3',
+      speciesId: '1',
+      classIndex: 1,
+      label: 'a',
+      confidence: 0.5,
+      createdAt: DateTime.fromMicrosecondsSinceEpoch(1),
+      photoPath: null,
+    );
+    final Uint8List payload = ObservationCodec.encode(observation);
+    payload[0] = 99;
+
+    expect(
+      () => ObservationCodec.decode(
+        ObservationCodec.recordOf(observation),
+        payload,
+      ),
+      throwsFormatException,
+    );
+  });
+}